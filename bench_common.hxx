@@ -0,0 +1,135 @@
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if WITH_VOLATILE
+#define INPUT volatile
+#else
+#define INPUT
+#endif
+
+#ifndef BENCH_OPTLEVEL
+#define BENCH_OPTLEVEL "?"
+#endif
+
+#define BENCH_NOINLINE __attribute__((noinline))
+
+// Keep the value alive without storing it to memory.
+template <class T>
+inline void bench_keep(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Test data: the MMIX linear congruential generator. next() returns
+// the new state; its low bits have short periods, so take the high
+// ones.
+struct rng {
+  std::uint64_t x;
+
+  std::uint64_t next()
+  {
+    x = x * 6364136223846793005ull + 1442695040888963407ull;
+    return x;
+  }
+};
+
+// Time stamp counter; 0 where not available.
+inline std::uint64_t bench_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+template <class T> inline const char *bench_type_name();
+template <> inline const char *bench_type_name<std::int8_t>() { return "int8"; }
+template <> inline const char *bench_type_name<std::uint8_t>() { return "uint8"; }
+template <> inline const char *bench_type_name<std::int16_t>() { return "int16"; }
+template <> inline const char *bench_type_name<std::uint16_t>() { return "uint16"; }
+template <> inline const char *bench_type_name<std::int32_t>() { return "int32"; }
+template <> inline const char *bench_type_name<std::uint32_t>() { return "uint32"; }
+template <> inline const char *bench_type_name<std::int64_t>() { return "int64"; }
+template <> inline const char *bench_type_name<std::uint64_t>() { return "uint64"; }
+#if defined(__SIZEOF_INT128__)
+template <> inline const char *bench_type_name<__int128>() { return "int128"; }
+template <> inline const char *bench_type_name<unsigned __int128>() { return "uint128"; }
+#endif
+
+// One measured case. Fields are what identifies it in the output:
+// group (benchmark file), op, mode (cx, cf, ... or raw for plain
+// operators), type and dataset (pattern of failing inputs).
+struct bench_case {
+  const char *group;
+  const char *op;
+  const char *mode;
+  const char *type;
+  const char *dataset;
+};
+
+// Selected by the command line filter.
+bool bench_selected(const bench_case& bc);
+
+// Output one result in the chosen format.
+void bench_record(const bench_case& bc, double ns_per_op, double ops_per_cycle);
+
+// Run fn() (which does nops operations) repeatedly and record
+// the best of several repetitions.
+template <class F>
+inline void bench_run(const bench_case& bc, double nops, F fn)
+{
+  if (!bench_selected(bc)) {
+    return;
+  }
+  constexpr int reps = 5;
+  constexpr int rounds = 50;
+  fn(); // warm up
+  double best_ns = 0;
+  double best_cycles = 0;
+  for (int rep = 0; rep < reps; ++rep) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::uint64_t c0 = bench_ticks();
+    for (int r = 0; r < rounds; ++r) {
+      fn();
+    }
+    std::uint64_t c1 = bench_ticks();
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    if (rep == 0 || ns < best_ns) {
+      best_ns = ns;
+      best_cycles = double(c1 - c0);
+    }
+  }
+  double total = nops * rounds;
+  bench_record(bc, best_ns / total, best_cycles > 0 ? total / best_cycles : 0.0);
+}
+
+void bench_cf_pair();
+void bench_ops();
+void bench_divider();
+void bench_batch();
+void bench_int128();
+void bench_telemetry();
+void bench_telemetry_off();
+void bench_fixed();
+void bench_parse();
+void bench_arena();
+void bench_range();
+void bench_bounded();
+void bench_atomic();
+void bench_math();
+void bench_muldiv();
+void bench_bitpack();
+void bench_result();
+void bench_expr();
@@ -0,0 +1,110 @@
+#include "bench_common.hxx"
+#include <safe_int_arena_80.hxx>
+#include <cstdlib>
+#include <memory_resource>
+#include <vector>
+
+// Small object allocation: arrays of 2..8 uint64_t (16..64 bytes),
+// each touched once, then all freed (malloc: free one by one;
+// the resources: release()). Time per allocation, release included.
+// Unchecked sizes (count * 8) for malloc and monotonic_buffer_resource;
+// the arena with cx_mul and alloc(), with alloc_array<T>() (one
+// widened compare), and through its memory_resource interface.
+// Datasets: heap (chunks from upstream each round) and buffer (a
+// 256 KiB initial buffer, so no upstream calls at all).
+
+namespace {
+
+  constexpr std::size_t n = 4096;
+
+  BENCH_NOINLINE void k_malloc(void **out, const unsigned char *counts)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      auto *p = static_cast<std::uint64_t *>(std::malloc(counts[i] * sizeof(std::uint64_t)));
+      p[0] = i;
+      out[i] = p;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      std::free(out[i]);
+    }
+  }
+
+  BENCH_NOINLINE void k_resource(std::pmr::memory_resource *mr, void **out,
+      const unsigned char *counts)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      auto *p = static_cast<std::uint64_t *>(
+          mr->allocate(counts[i] * sizeof(std::uint64_t), alignof(std::uint64_t)));
+      p[0] = i;
+      out[i] = p;
+    }
+  }
+
+  BENCH_NOINLINE void k_arena_cx(sia80::arena& a, void **out, const unsigned char *counts)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      auto *p = static_cast<std::uint64_t *>(
+          a.alloc(sia80::cx_mul(std::size_t(counts[i]), sizeof(std::uint64_t)),
+          alignof(std::uint64_t)));
+      p[0] = i;
+      out[i] = p;
+    }
+  }
+
+  BENCH_NOINLINE void k_arena_array(sia80::arena& a, void **out, const unsigned char *counts)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      std::uint64_t *p = a.alloc_array<std::uint64_t>(counts[i]);
+      p[0] = i;
+      out[i] = p;
+    }
+  }
+
+  void run(const char *ds, bool with_buffer)
+  {
+    std::vector<unsigned char> counts(n);
+    std::vector<void *> out(n);
+    rng r { 31 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      counts[i] = (unsigned char) (2 + (x >> 33) % 7);
+    }
+    std::vector<unsigned char> buf(with_buffer ? 256 * 1024 : 0);
+    const char *tn = "uint64";
+    if (!with_buffer) {
+      bench_run({ "arena", "malloc", "raw", tn, ds }, n, [&] {
+        k_malloc(out.data(), counts.data());
+      });
+    }
+    {
+      std::pmr::monotonic_buffer_resource mr = with_buffer ?
+          std::pmr::monotonic_buffer_resource(buf.data(), buf.size()) :
+          std::pmr::monotonic_buffer_resource(sia80::arena::default_chunk);
+      bench_run({ "arena", "monotonic", "raw", tn, ds }, n, [&] {
+        k_resource(&mr, out.data(), counts.data());
+        mr.release();
+      });
+    }
+    sia80::arena a = with_buffer ? sia80::arena(buf.data(), buf.size()) : sia80::arena();
+    bench_run({ "arena", "alloc", "cx", tn, ds }, n, [&] {
+      k_arena_cx(a, out.data(), counts.data());
+      a.release();
+    });
+    bench_run({ "arena", "alloc_array", "cx", tn, ds }, n, [&] {
+      k_arena_array(a, out.data(), counts.data());
+      a.release();
+    });
+    bench_run({ "arena", "pmr", "cx", tn, ds }, n, [&] {
+      k_resource(&a, out.data(), counts.data());
+      a.release();
+    });
+    bench_keep(out[n - 1]);
+  }
+
+} // namespace
+
+void bench_arena()
+{
+  run("heap", false);
+  run("buffer", true);
+}
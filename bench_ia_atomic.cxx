@@ -0,0 +1,112 @@
+#include "bench_common.hxx"
+#include <safe_int_atomic_80.hxx>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Shared counters under contention: T threads (1, 2, 4, ... up to the
+// number of hardware threads) each add 1 to one std::atomic<uint64_t>
+// 65536 times; time per add over all threads (so a scaling counter
+// gets faster with more threads). Modes: fetch_add ("raw", wrapping),
+// cf_fetch_add (a locked add with the check), cx_fetch_add and
+// sr_fetch_add (compare-and-swap with backoff), a compare-and-swap
+// loop around sr_add without backoff ("cas", as written by hand),
+// and sharded_counter::add ("sharded", saturating).
+// Thread start is included; it is small against the adds.
+
+namespace {
+
+  constexpr std::size_t per_thread = 65536;
+
+  template <class F>
+  void in_threads(unsigned nthreads, F fn)
+  {
+    std::atomic<bool> go { false };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < nthreads; ++t) {
+      threads.emplace_back([&go, &fn] {
+        while (!go.load(std::memory_order_acquire)) {
+          sia80::at_detail::cpu_relax();
+        }
+        fn();
+      });
+    }
+    go.store(true, std::memory_order_release);
+    for (std::thread& th : threads) {
+      th.join();
+    }
+  }
+
+  enum { k_raw, k_cf, k_cx, k_sr, k_cas };
+
+  template <int K>
+  BENCH_NOINLINE void k_add(std::atomic<std::uint64_t>& a)
+  {
+    int flag = 0;
+    for (std::size_t i = 0; i < per_thread; ++i) {
+      if constexpr(K == k_raw) {
+        a.fetch_add(1);
+      }
+      else if constexpr(K == k_cf) {
+        sia80::cf_fetch_add(a, 1, &flag);
+      }
+      else if constexpr(K == k_cx) {
+        sia80::cx_fetch_add(a, 1);
+      }
+      else if constexpr(K == k_sr) {
+        sia80::sr_fetch_add(a, 1);
+      }
+      else {
+        std::uint64_t old = a.load(std::memory_order_relaxed);
+        while (!a.compare_exchange_weak(old, sia80::sr_add(old, std::uint64_t(1)))) {
+        }
+      }
+    }
+    bench_keep(flag);
+  }
+
+  BENCH_NOINLINE void k_sharded(sia80::sharded_counter<std::uint64_t>& c)
+  {
+    for (std::size_t i = 0; i < per_thread; ++i) {
+      c.add(1);
+    }
+  }
+
+} // namespace
+
+void bench_atomic()
+{
+  const unsigned hw = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  std::vector<unsigned> counts;
+  for (unsigned t = 1; t < hw; t *= 2) {
+    counts.push_back(t);
+  }
+  counts.push_back(hw);
+  for (unsigned t : counts) {
+    char ds[16];
+    std::snprintf(ds, sizeof(ds), "t%u", t);
+    const double nops = double(per_thread) * t;
+    alignas(64) std::atomic<std::uint64_t> a { 0 };
+    bench_run({ "atomic", "fetch_add", "raw", "uint64", ds }, nops, [&] {
+      in_threads(t, [&a] { k_add<k_raw>(a); });
+    });
+    bench_run({ "atomic", "fetch_add", "cf", "uint64", ds }, nops, [&] {
+      in_threads(t, [&a] { k_add<k_cf>(a); });
+    });
+    bench_run({ "atomic", "fetch_add", "cx", "uint64", ds }, nops, [&] {
+      in_threads(t, [&a] { k_add<k_cx>(a); });
+    });
+    bench_run({ "atomic", "fetch_add", "sr", "uint64", ds }, nops, [&] {
+      in_threads(t, [&a] { k_add<k_sr>(a); });
+    });
+    bench_run({ "atomic", "fetch_add", "cas", "uint64", ds }, nops, [&] {
+      in_threads(t, [&a] { k_add<k_cas>(a); });
+    });
+    sia80::sharded_counter<std::uint64_t> c;
+    bench_run({ "atomic", "fetch_add", "sharded", "uint64", ds }, nops, [&] {
+      in_threads(t, [&c] { k_sharded(c); });
+    });
+    bench_keep(a);
+    bench_keep(c);
+  }
+}
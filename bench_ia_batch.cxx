@@ -0,0 +1,146 @@
+#include "bench_common.hxx"
+#include <safe_int_batch_80.hxx>
+#include <string>
+#include <vector>
+
+// Batch forms with each kernel the CPU can run (the mode is the
+// instruction set), and the cost of dispatch: "direct" calls
+// the best kernel without the dispatch switch. The dataset is
+// the array length; n16 shows the per call overhead. Conversions
+// are named by the types, as "int32>int16".
+
+namespace {
+
+  const char *isa_name(sia80::batch_isa isa)
+  {
+    switch (isa) {
+      case sia80::batch_isa::scalar:
+        return "scalar";
+      case sia80::batch_isa::sse2:
+        return "sse2";
+      case sia80::batch_isa::avx2:
+        return "avx2";
+      case sia80::batch_isa::avx512bw:
+        return "avx512bw";
+    }
+    return "?";
+  }
+
+  template <class T>
+  void run_type(std::size_t n, const char *ds)
+  {
+    using namespace sia80;
+    std::vector<T> a(n), b(n), out(n);
+    rng r { 12345 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      a[i] = T(x >> 20);
+      // Small, to keep sums mostly in range.
+      b[i] = T((x >> 40) % 201) - T(100);
+    }
+    const char *tn = bench_type_name<T>();
+    const batch_isa initial = batch_current_isa();
+    const batch_isa all[] = {
+      batch_isa::scalar, batch_isa::sse2, batch_isa::avx2, batch_isa::avx512bw
+    };
+    for (batch_isa isa : all) {
+      if (!batch_force_isa(isa)) {
+        continue;
+      }
+      const char *mode = isa_name(isa);
+      bench_run({ "batch", "sr_add_n", mode, tn, ds }, n, [&] {
+        sr_add_n(out.data(), a.data(), b.data(), n);
+        bench_keep(out[0]);
+      });
+      bench_run({ "batch", "sr_mul_n", mode, tn, ds }, n, [&] {
+        sr_mul_n(out.data(), a.data(), b.data(), n);
+        bench_keep(out[0]);
+      });
+      bench_run({ "batch", "sr_sum", mode, tn, ds }, n, [&] {
+        bench_keep(sr_sum(b.data(), n));
+      });
+    }
+    batch_force_isa(initial);
+#if SIA80_BATCH_DISPATCH
+    if (initial == batch_isa::avx512bw) {
+      bench_run({ "batch", "sr_add_n", "direct", tn, ds }, n, [&] {
+        batch_detail::kern_avx512bw::sr_op_n<batch_detail::op_add, T>(
+            out.data(), a.data(), b.data(), n);
+        bench_keep(out[0]);
+      });
+    }
+    else if (initial == batch_isa::avx2) {
+      bench_run({ "batch", "sr_add_n", "direct", tn, ds }, n, [&] {
+        batch_detail::kern_avx2::sr_op_n<batch_detail::op_add, T>(
+            out.data(), a.data(), b.data(), n);
+        bench_keep(out[0]);
+      });
+    }
+#endif
+  }
+
+  // Narrowing with sr_conv_n and cf_conv_n (values in range, as in
+  // sample buffers, but for one in 64 saturating), against a plain
+  // loop of static_cast ("raw").
+  template <class To, class From>
+  void run_conv(std::size_t n, const char *ds)
+  {
+    using namespace sia80;
+    std::vector<From> a(n);
+    std::vector<To> out(n);
+    rng r { 777 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      const unsigned bits = (x >> 58) == 0 ? sizeof(From) * 8 : sizeof(To) * 8 - 1;
+      a[i] = From(std::int64_t(x << 5) >> (64 - bits));
+    }
+    const std::string tn = std::string(bench_type_name<From>()) + ">" + bench_type_name<To>();
+    bench_run({ "batch", "conv_n", "raw", tn.c_str(), ds }, n, [&] {
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = To(a[i]);
+      }
+      bench_keep(out[0]);
+    });
+    const batch_isa initial = batch_current_isa();
+    const batch_isa all[] = {
+      batch_isa::scalar, batch_isa::sse2, batch_isa::avx2, batch_isa::avx512bw
+    };
+    for (batch_isa isa : all) {
+      if (!batch_force_isa(isa)) {
+        continue;
+      }
+      const char *mode = isa_name(isa);
+      bench_run({ "batch", "sr_conv_n", mode, tn.c_str(), ds }, n, [&] {
+        sr_conv_n(out.data(), a.data(), n);
+        bench_keep(out[0]);
+      });
+      bench_run({ "batch", "cf_conv_n", mode, tn.c_str(), ds }, n, [&] {
+        bench_keep(cf_conv_n(out.data(), a.data(), n));
+      });
+    }
+    batch_force_isa(initial);
+  }
+
+  template <class T>
+  void run_lengths()
+  {
+    run_type<T>(16, "n16");
+    run_type<T>(4096, "n4096");
+  }
+
+} // namespace
+
+void bench_batch()
+{
+  run_lengths<std::int8_t>();
+  run_lengths<std::int16_t>();
+  run_lengths<std::int32_t>();
+  run_lengths<std::uint32_t>();
+  run_lengths<std::int64_t>();
+  run_conv<std::int16_t, std::int32_t>(4096, "n4096");
+  run_conv<std::uint16_t, std::int32_t>(4096, "n4096");
+  run_conv<std::int8_t, std::int32_t>(4096, "n4096");
+  run_conv<std::uint8_t, std::int16_t>(4096, "n4096");
+  run_conv<std::int16_t, std::uint32_t>(4096, "n4096");
+  run_conv<std::int32_t, std::int64_t>(4096, "n4096");
+}
@@ -0,0 +1,104 @@
+#include "bench_common.hxx"
+#include <safe_int_arith_80.hxx>
+#include <safe_int_bitpack_80.hxx>
+#include <cstdio>
+#include <vector>
+
+// Packing n values into fields of N = 1..64 bits (dataset "bN"):
+//   "hand": cx_ufit (cx_sfit) on each value, then the same stream
+//     writer by hand, as an encoder without bitpack_xxx does;
+//   bitpack_ufit/sfit in cx (one check of the array) and sr mode;
+//   bitunpack_u/s back to the source type.
+// All values fit, as in a real stream; ns per value.
+
+namespace {
+
+  constexpr std::size_t n = 4096;
+
+  template <bool Sfit, typename T>
+  BENCH_NOINLINE void k_hand(std::uint64_t *dst, const T *src, unsigned nbits)
+  {
+    const std::uint64_t mask = nbits == 64 ? ~std::uint64_t(0) :
+        (std::uint64_t(1) << nbits) - 1;
+    std::uint64_t acc = 0;
+    unsigned fill = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      const T x = Sfit ? sia80::cx_sfit(src[i], nbits) : sia80::cx_ufit(src[i], nbits);
+      const std::uint64_t v = std::uint64_t(x) & mask;
+      acc |= v << fill;
+      fill += nbits;
+      if (fill >= 64) {
+        *dst++ = acc;
+        fill -= 64;
+        acc = fill != 0 ? v >> (nbits - fill) : 0;
+      }
+    }
+    if (fill != 0) {
+      *dst = acc;
+    }
+  }
+
+  template <bool Sfit, sia80::mode Mode, typename T>
+  BENCH_NOINLINE bool k_pack(std::uint64_t *dst, const T *src, unsigned nbits)
+  {
+    return Sfit ? sia80::bitpack_sfit<Mode>(dst, src, n, nbits) :
+        sia80::bitpack_ufit<Mode>(dst, src, n, nbits);
+  }
+
+  template <bool Sfit, typename T>
+  BENCH_NOINLINE bool k_unpack(T *dst, const std::uint64_t *src, unsigned nbits)
+  {
+    return Sfit ? sia80::bitunpack_s(dst, src, n, nbits) :
+        sia80::bitunpack_u(dst, src, n, nbits);
+  }
+
+  template <bool Sfit, typename T>
+  void bench_type()
+  {
+    const char *tn = bench_type_name<T>();
+    constexpr unsigned tbits = sizeof(T) * 8;
+    std::vector<T> src(n), back(n);
+    std::vector<std::uint64_t> buf(sia80::bitpack_words(n, 64));
+    for (unsigned nbits = 1; nbits <= tbits; ++nbits) {
+      rng r { 17 + nbits };
+      for (std::size_t i = 0; i < n; ++i) {
+        const std::uint64_t x = r.next();
+        src[i] = Sfit ? sia80::tr_sfit(T(x >> 7), nbits) : sia80::tr_ufit(T(x >> 7), nbits);
+        if constexpr(std::is_signed<T>::value) {
+          // The sign bit is out of reach of ufit.
+          src[i] = Sfit ? src[i] : T(src[i] & sia80::ia_limits<T>::max());
+        }
+        else if (Sfit) {
+          src[i] = T(src[i] >> 1);
+        }
+      }
+      char ds[8];
+      std::snprintf(ds, sizeof(ds), "b%u", nbits);
+      const char *op = Sfit ? "hand_sfit" : "hand_ufit";
+      bench_run({ "bitpack", op, "cx", tn, ds }, n, [&] {
+        k_hand<Sfit>(buf.data(), src.data(), nbits);
+      });
+      op = Sfit ? "bitpack_sfit" : "bitpack_ufit";
+      bench_run({ "bitpack", op, "cx", tn, ds }, n, [&] {
+        bench_keep(k_pack<Sfit, sia80::mode::cx>(buf.data(), src.data(), nbits));
+      });
+      bench_run({ "bitpack", op, "sr", tn, ds }, n, [&] {
+        bench_keep(k_pack<Sfit, sia80::mode::sr>(buf.data(), src.data(), nbits));
+      });
+      op = Sfit ? "bitunpack_s" : "bitunpack_u";
+      bench_run({ "bitpack", op, "cx", tn, ds }, n, [&] {
+        bench_keep(k_unpack<Sfit>(back.data(), buf.data(), nbits));
+      });
+      bench_keep(back[n - 1]);
+    }
+  }
+
+} // namespace
+
+void bench_bitpack()
+{
+  bench_type<false, std::uint64_t>();
+  bench_type<true, std::int64_t>();
+  bench_type<false, std::uint32_t>();
+  bench_type<false, std::uint16_t>();
+}
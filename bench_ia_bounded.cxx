@@ -0,0 +1,128 @@
+#include "bench_common.hxx"
+#include <safe_int_bounded_80.hxx>
+#include <vector>
+
+// Arithmetic on values with known ranges: a percentage markup of byte
+// values (in int, so that the compiler doesn't know the range itself),
+// out = a * (100 + p) / 100 with p in [0, 100], and a shift of uint8_t
+// values by a count in [0, 23]. With plain operators ("raw"), with cx_xxx
+// at each operation ("cx"), and with bounded operands ("bounded":
+// arrays of bounded, checked when they were filled; "bounded_in":
+// from plain arrays, with the construction check in the loop).
+
+namespace {
+
+  using byte_t = sia80::bounded<int, 0, 255>;
+  using pct_t = sia80::bounded<int, 0, 100>;
+  using cnt_t = sia80::bounded<std::uint8_t, 0, 23>;
+
+  constexpr std::size_t n = 4096;
+
+  template <int M>
+  BENCH_NOINLINE void k_markup(int *out, const int *a, const int *p)
+  {
+    using namespace sia80;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(M == 0) {
+        out[i] = a[i] * (100 + p[i]) / 100;
+      }
+      else if constexpr(M == 1) {
+        out[i] = cx_div(cx_mul(a[i], cx_add(100, p[i])), 100);
+      }
+      else {
+        out[i] = (byte_t(a[i]) * (bconst<100> + pct_t(p[i])) / bconst<100>).value();
+      }
+    }
+  }
+
+  BENCH_NOINLINE void k_markup_bounded(int *out, const byte_t *a, const pct_t *p)
+  {
+    using namespace sia80;
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = (a[i] * (bconst<100> + p[i]) / bconst<100>).value();
+    }
+  }
+
+  template <int M>
+  BENCH_NOINLINE void k_shift(std::uint32_t *out, const std::uint8_t *a, const std::uint8_t *c)
+  {
+    using namespace sia80;
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint32_t v = a[i];
+      if constexpr(M == 0) {
+        out[i] = v << c[i];
+      }
+      else if constexpr(M == 1) {
+        out[i] = cx_shl(v, c[i]);
+      }
+      else {
+        out[i] = (bounded<std::uint32_t, 0, 255>::unchecked(v) << cnt_t(c[i])).value();
+      }
+    }
+  }
+
+  BENCH_NOINLINE void k_shift_bounded(std::uint32_t *out, const std::uint8_t *a, const cnt_t *c)
+  {
+    using namespace sia80;
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint32_t v = a[i];
+      out[i] = (bounded<std::uint32_t, 0, 255>::unchecked(v) << c[i]).value();
+    }
+  }
+
+} // namespace
+
+void bench_bounded()
+{
+  std::vector<int> a(n), p(n);
+  std::vector<std::uint8_t> b(n), c(n);
+  std::vector<byte_t> ba;
+  std::vector<pct_t> bp;
+  std::vector<cnt_t> bc;
+  ba.reserve(n);
+  bp.reserve(n);
+  bc.reserve(n);
+  rng r { 17 };
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint64_t x = r.next();
+    a[i] = int(x >> 40) & 255;
+    b[i] = std::uint8_t(a[i]);
+    p[i] = int((x >> 20) % 101);
+    c[i] = std::uint8_t((x >> 50) % 24);
+    ba.push_back(byte_t(a[i]));
+    bp.push_back(pct_t(p[i]));
+    bc.push_back(cnt_t(c[i]));
+  }
+  {
+    std::vector<int> out(n);
+    bench_run({ "bounded", "markup", "raw", "int", "4096" }, n, [&] {
+      k_markup<0>(out.data(), a.data(), p.data());
+    });
+    bench_run({ "bounded", "markup", "cx", "int", "4096" }, n, [&] {
+      k_markup<1>(out.data(), a.data(), p.data());
+    });
+    bench_run({ "bounded", "markup", "bounded", "int", "4096" }, n, [&] {
+      k_markup_bounded(out.data(), ba.data(), bp.data());
+    });
+    bench_run({ "bounded", "markup", "bounded_in", "int", "4096" }, n, [&] {
+      k_markup<2>(out.data(), a.data(), p.data());
+    });
+    bench_keep(out[n - 1]);
+  }
+  {
+    std::vector<std::uint32_t> out(n);
+    bench_run({ "bounded", "shl", "raw", "uint32", "4096" }, n, [&] {
+      k_shift<0>(out.data(), b.data(), c.data());
+    });
+    bench_run({ "bounded", "shl", "cx", "uint32", "4096" }, n, [&] {
+      k_shift<1>(out.data(), b.data(), c.data());
+    });
+    bench_run({ "bounded", "shl", "bounded", "uint32", "4096" }, n, [&] {
+      k_shift_bounded(out.data(), b.data(), bc.data());
+    });
+    bench_run({ "bounded", "shl", "bounded_in", "uint32", "4096" }, n, [&] {
+      k_shift<2>(out.data(), b.data(), c.data());
+    });
+    bench_keep(out[n - 1]);
+  }
+}
@@ -0,0 +1,93 @@
+#include "bench_common.hxx"
+#include <vector>
+
+// cf_xxx with the flag pointer vs. pair-returning cf_xxx with
+// overflow_sticky, on loops of out[i] = a[i] + b[i] + c
+// and out[i] = a[i] * b[i] + c.
+// The flag pointer has the same type as the data, so the compiler
+// shall assume they alias: after each conditional store to *flag
+// it reloads, and the loop can't be vectorized.
+// To compare the code: make bench_ia_cf_pair.s
+
+BENCH_NOINLINE void k_add_flag_ptr(int *out, const int *a, const int *b,
+    std::size_t n, int c, int *flag)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = sia80::cf_add(sia80::cf_add(a[i], b[i], flag), c, flag);
+  }
+}
+
+BENCH_NOINLINE bool k_add_sticky(int *out, const int *a, const int *b,
+    std::size_t n, int c)
+{
+  sia80::overflow_sticky ovf;
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = ovf.add(ovf.add(a[i], b[i]), c);
+  }
+  return ovf.overflowed();
+}
+
+BENCH_NOINLINE void k_add_raw(int *out, const int *a, const int *b,
+    std::size_t n, int c)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = int(unsigned(a[i]) + unsigned(b[i]) + unsigned(c));
+  }
+}
+
+BENCH_NOINLINE void k_mul_flag_ptr(int *out, const int *a, const int *b,
+    std::size_t n, int c, int *flag)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = sia80::cf_add(sia80::cf_mul(a[i], b[i], flag), c, flag);
+  }
+}
+
+BENCH_NOINLINE bool k_mul_sticky(int *out, const int *a, const int *b,
+    std::size_t n, int c)
+{
+  sia80::overflow_sticky ovf;
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = ovf.add(ovf.mul(a[i], b[i]), c);
+  }
+  return ovf.overflowed();
+}
+
+BENCH_NOINLINE void k_mul_raw(int *out, const int *a, const int *b,
+    std::size_t n, int c)
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = int(unsigned(a[i]) * unsigned(b[i]) + unsigned(c));
+  }
+}
+
+void bench_cf_pair()
+{
+  constexpr std::size_t n = 4096;
+  std::vector<int> a(n), b(n), out(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    a[i] = int(i % 1000) - 500;
+    b[i] = int(i % 77) - 30;
+  }
+  int flag = 0;
+  int c = 0;
+  bench_run({ "cf_pair", "add_add", "raw", "int32", "none" }, n, [&] {
+    k_add_raw(out.data(), a.data(), b.data(), n, ++c);
+  });
+  bench_run({ "cf_pair", "add_add", "cf", "int32", "none" }, n, [&] {
+    k_add_flag_ptr(out.data(), a.data(), b.data(), n, ++c, &flag);
+  });
+  bench_run({ "cf_pair", "add_add", "cfp", "int32", "none" }, n, [&] {
+    flag |= k_add_sticky(out.data(), a.data(), b.data(), n, ++c);
+  });
+  bench_run({ "cf_pair", "mul_add", "raw", "int32", "none" }, n, [&] {
+    k_mul_raw(out.data(), a.data(), b.data(), n, ++c);
+  });
+  bench_run({ "cf_pair", "mul_add", "cf", "int32", "none" }, n, [&] {
+    k_mul_flag_ptr(out.data(), a.data(), b.data(), n, ++c, &flag);
+  });
+  bench_run({ "cf_pair", "mul_add", "cfp", "int32", "none" }, n, [&] {
+    flag |= k_mul_sticky(out.data(), a.data(), b.data(), n, ++c);
+  });
+  bench_keep(flag);
+}
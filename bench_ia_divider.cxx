@@ -0,0 +1,128 @@
+#include "bench_common.hxx"
+#include <safe_int_div_80.hxx>
+#include <vector>
+
+// Division by a runtime invariant divisor: plain operator ("raw"),
+// cx_div/cx_rem, and divider<T, Mode> per element and with div_n.
+// The dataset is the divisor: 7 and 641 take the multiply-add
+// path (for some types), 10 the multiply, 16 the shift.
+// The kernels get the divider by value, as a local object: through
+// a reference, stores to out[] could alias its fields and force
+// reloading them on each iteration.
+
+namespace {
+
+  template <class T, class R>
+  BENCH_NOINLINE void k_raw_div(R *out, const INPUT T *a, std::size_t n, T d)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = a[i] / d;
+    }
+  }
+
+  template <class T, class R>
+  BENCH_NOINLINE void k_raw_rem(R *out, const INPUT T *a, std::size_t n, T d)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = a[i] % d;
+    }
+  }
+
+  template <class T, class R>
+  BENCH_NOINLINE void k_cx_div(R *out, const INPUT T *a, std::size_t n, T d)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::cx_div(a[i], d);
+    }
+  }
+
+  template <class T, class R>
+  BENCH_NOINLINE void k_cx_rem(R *out, const INPUT T *a, std::size_t n, T d)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::cx_rem(a[i], d);
+    }
+  }
+
+  template <class D, class T, class R>
+  BENCH_NOINLINE void k_dv_div(R *out, const INPUT T *a, std::size_t n, D d)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = d.div(a[i]);
+    }
+  }
+
+  template <class D, class T, class R>
+  BENCH_NOINLINE void k_dv_rem(R *out, const INPUT T *a, std::size_t n, D d)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = d.rem(a[i]);
+    }
+  }
+
+  template <class T>
+  void run_type(T dvsr, const char *ds)
+  {
+    using namespace sia80;
+    using R = typename divider<T, mode::cx>::result_type;
+    constexpr std::size_t n = 4096;
+    std::vector<T> a(n);
+    std::vector<R> out(n);
+    rng r { 12345 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      a[i] = T(x >> 16);
+    }
+    INPUT T vd = dvsr;
+    const T d = vd;
+    const char *tn = bench_type_name<T>();
+    const divider<T, mode::cx> dcx(d);
+    const divider<T, mode::sr> dsr(d);
+    bench_run({ "divider", "div", "raw", tn, ds }, n, [&] {
+      k_raw_div(out.data(), a.data(), n, d);
+    });
+    bench_run({ "divider", "div", "cx", tn, ds }, n, [&] {
+      k_cx_div(out.data(), a.data(), n, d);
+    });
+    bench_run({ "divider", "div", "divider_cx", tn, ds }, n, [&] {
+      k_dv_div(out.data(), a.data(), n, dcx);
+    });
+    bench_run({ "divider", "div", "divider_sr", tn, ds }, n, [&] {
+      k_dv_div(out.data(), a.data(), n, dsr);
+    });
+    bench_run({ "divider", "div_n", "divider_cx", tn, ds }, n, [&] {
+      dcx.div_n(out.data(), a.data(), n);
+    });
+    bench_run({ "divider", "rem", "raw", tn, ds }, n, [&] {
+      k_raw_rem(out.data(), a.data(), n, d);
+    });
+    bench_run({ "divider", "rem", "cx", tn, ds }, n, [&] {
+      k_cx_rem(out.data(), a.data(), n, d);
+    });
+    bench_run({ "divider", "rem", "divider_cx", tn, ds }, n, [&] {
+      k_dv_rem(out.data(), a.data(), n, dcx);
+    });
+    bench_run({ "divider", "rem_n", "divider_cx", tn, ds }, n, [&] {
+      dcx.rem_n(out.data(), a.data(), n);
+    });
+    bench_keep(out[n - 1]);
+  }
+
+  template <class T>
+  void run_divisors()
+  {
+    run_type<T>(7, "dvsr7");
+    run_type<T>(10, "dvsr10");
+    run_type<T>(16, "dvsr16");
+    run_type<T>(641, "dvsr641");
+  }
+
+} // namespace
+
+void bench_divider()
+{
+  run_divisors<std::int32_t>();
+  run_divisors<std::uint32_t>();
+  run_divisors<std::int64_t>();
+  run_divisors<std::uint64_t>();
+}
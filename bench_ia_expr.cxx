@@ -0,0 +1,194 @@
+#include "bench_common.hxx"
+#include <safe_int_arith_80.hxx>
+#include <safe_int_expr_80.hxx>
+#include <vector>
+
+// Formulas of four int32 operands a, b, c, d, checked as a whole
+// (xx_eval) against the forms one would write without it:
+//   "raw": plain operators in the result type (int64 ops: the operands
+//     widened first), unchecked;
+//   "chain": cx_xxx at each step, in the result type;
+//   "cx", "sr": cx_eval, sr_eval.
+// Pricing:
+//   "dot2": a * b + c * d to int32 (in int64 for eval);
+//   "markup": a * (100 + p) / 100 to int32, p in [0, 100] (d, bounded);
+//   "notional": a * b + c to int64 (in int64).
+// Geometry:
+//   "cross": a * d - b * c to int64 (in int64);
+//   "dist2": (a - c) * (a - c) + (b - d) * (b - d) to int64 (in __int128);
+//   "dot3": a * c + b * d + c * d to int64 (in __int128).
+// Datasets: "s14" (|v| < 2^14: everything fits everywhere), "s30"
+// (|v| < 2^30; int64 results only, which still fit).
+
+namespace {
+
+  using pct_t = sia80::bounded<int, 0, 100>;
+
+  constexpr std::size_t n = 4096;
+
+  enum { k_raw, k_chain, k_cx, k_sr };
+
+  enum { o_dot2, o_markup, o_notional, o_cross, o_dist2, o_dot3 };
+
+  template <int O>
+  struct op_of;
+
+  template <>
+  struct op_of<o_dot2> {
+    using TR = std::int32_t;
+    static TR raw(int a, int b, int c, int d) { return a * b + c * d; }
+    static TR chain(int a, int b, int c, int d)
+    {
+      return sia80::cx_add(sia80::cx_mul(a, b), sia80::cx_mul(c, d));
+    }
+    static auto expr(int a, int b, int c, int d) { return sia80::xv(a) * b + sia80::xv(c) * d; }
+  };
+
+  template <>
+  struct op_of<o_markup> {
+    using TR = std::int32_t;
+    static TR raw(int a, int, int, int d) { return a * (100 + d) / 100; }
+    static TR chain(int a, int, int, int d)
+    {
+      return sia80::cx_div(sia80::cx_mul(a, sia80::cx_add(100, d)), 100);
+    }
+    static auto expr(int a, int, int, int d)
+    {
+      using sia80::xc;
+      return sia80::xv(a) * (xc<100> + sia80::xv(pct_t::unchecked(d))) / xc<100>;
+    }
+  };
+
+  template <>
+  struct op_of<o_notional> {
+    using TR = std::int64_t;
+    static TR raw(int a, int b, int c, int) { return TR(a) * b + c; }
+    static TR chain(int a, int b, int c, int)
+    {
+      return sia80::cx_add(sia80::cx_mul(TR(a), TR(b)), TR(c));
+    }
+    static auto expr(int a, int b, int c, int) { return sia80::xv(a) * b + c; }
+  };
+
+  template <>
+  struct op_of<o_cross> {
+    using TR = std::int64_t;
+    static TR raw(int a, int b, int c, int d) { return TR(a) * d - TR(b) * c; }
+    static TR chain(int a, int b, int c, int d)
+    {
+      return sia80::cx_sub(sia80::cx_mul(TR(a), TR(d)), sia80::cx_mul(TR(b), TR(c)));
+    }
+    static auto expr(int a, int b, int c, int d) { return sia80::xv(a) * d - sia80::xv(b) * c; }
+  };
+
+  template <>
+  struct op_of<o_dist2> {
+    using TR = std::int64_t;
+    static TR raw(int a, int b, int c, int d)
+    {
+      const TR dx = TR(a) - c;
+      const TR dy = TR(b) - d;
+      return dx * dx + dy * dy;
+    }
+    static TR chain(int a, int b, int c, int d)
+    {
+      const TR dx = sia80::cx_sub(TR(a), TR(c));
+      const TR dy = sia80::cx_sub(TR(b), TR(d));
+      return sia80::cx_add(sia80::cx_mul(dx, dx), sia80::cx_mul(dy, dy));
+    }
+    static auto expr(int a, int b, int c, int d)
+    {
+      using sia80::xv;
+      return (xv(a) - c) * (xv(a) - c) + (xv(b) - d) * (xv(b) - d);
+    }
+  };
+
+  template <>
+  struct op_of<o_dot3> {
+    using TR = std::int64_t;
+    static TR raw(int a, int b, int c, int d) { return TR(a) * c + TR(b) * d + TR(c) * d; }
+    static TR chain(int a, int b, int c, int d)
+    {
+      using sia80::cx_add;
+      using sia80::cx_mul;
+      return cx_add(cx_add(cx_mul(TR(a), TR(c)), cx_mul(TR(b), TR(d))), cx_mul(TR(c), TR(d)));
+    }
+    static auto expr(int a, int b, int c, int d)
+    {
+      using sia80::xv;
+      return xv(a) * c + xv(b) * d + xv(c) * d;
+    }
+  };
+
+  template <int K, int O>
+  BENCH_NOINLINE void k_run(typename op_of<O>::TR *out,
+      const int *a, const int *b, const int *c, const int *d)
+  {
+    using P = op_of<O>;
+    using TR = typename P::TR;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == k_raw) {
+        out[i] = P::raw(a[i], b[i], c[i], d[i]);
+      }
+      else if constexpr(K == k_chain) {
+        out[i] = P::chain(a[i], b[i], c[i], d[i]);
+      }
+      else if constexpr(K == k_cx) {
+        out[i] = sia80::cx_eval<TR>(P::expr(a[i], b[i], c[i], d[i]));
+      }
+      else {
+        out[i] = sia80::sr_eval<TR>(P::expr(a[i], b[i], c[i], d[i]));
+      }
+    }
+  }
+
+  template <int O>
+  void bench_op(const char *op)
+  {
+    using TR = typename op_of<O>::TR;
+    const char *tn = bench_type_name<TR>();
+    std::vector<int> a(n), b(n), c(n), d(n);
+    std::vector<TR> out(n);
+    for (unsigned bits : { 14, 30 }) {
+      if (bits == 30 && sizeof(TR) < 8) {
+        continue;
+      }
+      rng r { 17 + bits };
+      for (std::size_t i = 0; i < n; ++i) {
+        int *v[4] = { &a[i], &b[i], &c[i], &d[i] };
+        for (int *p : v) {
+          *p = int(std::int64_t(r.next()) >> (64 - bits - 1));
+        }
+        if (O == o_markup) {
+          d[i] = int((r.x >> 8) % 101);
+        }
+      }
+      char ds[8];
+      std::snprintf(ds, sizeof(ds), "s%u", bits);
+      bench_run({ "expr", op, "raw", tn, ds }, n, [&] {
+        k_run<k_raw, O>(out.data(), a.data(), b.data(), c.data(), d.data());
+      });
+      bench_run({ "expr", op, "chain", tn, ds }, n, [&] {
+        k_run<k_chain, O>(out.data(), a.data(), b.data(), c.data(), d.data());
+      });
+      bench_run({ "expr", op, "cx", tn, ds }, n, [&] {
+        k_run<k_cx, O>(out.data(), a.data(), b.data(), c.data(), d.data());
+      });
+      bench_run({ "expr", op, "sr", tn, ds }, n, [&] {
+        k_run<k_sr, O>(out.data(), a.data(), b.data(), c.data(), d.data());
+      });
+      bench_keep(out[n - 1]);
+    }
+  }
+
+} // namespace
+
+void bench_expr()
+{
+  bench_op<o_dot2>("dot2");
+  bench_op<o_markup>("markup");
+  bench_op<o_notional>("notional");
+  bench_op<o_cross>("cross");
+  bench_op<o_dist2>("dist2");
+  bench_op<o_dot3>("dot3");
+}
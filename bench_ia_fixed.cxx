@@ -0,0 +1,120 @@
+#include "bench_common.hxx"
+#include <safe_int_fixed_80.hxx>
+#include <vector>
+
+// Q multiplication (Q16.16 in int32_t, Q32.32 in int64_t): by hand
+// for int32_t as cx_conv(tr_shr(cx_mul(int64_t(a), b), F))
+// ("cx_mul_shr": checked, without rounding; in int32_t, the product
+// would overflow before the shift), per element with cx_qmul and
+// sr_qmul, and the array forms xx_qmul_n.
+// Datasets: none (all products fit) and rare (1% saturate).
+
+namespace {
+
+  template <unsigned F, class T>
+  BENCH_NOINLINE void k_hand(T *out, const INPUT T *a, const INPUT T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::cx_conv<T>(sia80::tr_shr(sia80::cx_mul(std::int64_t(a[i]), b[i]), F));
+    }
+  }
+
+  template <unsigned F, class T>
+  BENCH_NOINLINE void k_cx(T *out, const INPUT T *a, const INPUT T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::cx_qmul<F>(T(a[i]), T(b[i]));
+    }
+  }
+
+  template <unsigned F, class T>
+  BENCH_NOINLINE void k_sr(T *out, const INPUT T *a, const INPUT T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::sr_qmul<F>(T(a[i]), T(b[i]));
+    }
+  }
+
+  enum { n_cx, n_cf, n_tr, n_tr_even, n_sr };
+
+  // The array forms, not inlined into the repeating loop.
+  template <int K, unsigned F, class T>
+  BENCH_NOINLINE void k_n(T *out, const T *a, const T *b, std::size_t n, int *flag)
+  {
+    using namespace sia80;
+    if constexpr(K == n_cx) {
+      cx_qmul_n<F>(out, a, b, n);
+    }
+    else if constexpr(K == n_cf) {
+      cf_qmul_n<F>(out, a, b, n, flag);
+    }
+    else if constexpr(K == n_tr) {
+      tr_qmul_n<F>(out, a, b, n);
+    }
+    else if constexpr(K == n_tr_even) {
+      tr_qmul_n<F, rounding::even>(out, a, b, n);
+    }
+    else {
+      sr_qmul_n<F>(out, a, b, n);
+    }
+  }
+
+  template <unsigned F, class T>
+  void run_type(const char *ds, unsigned fail_per_1000)
+  {
+    constexpr std::size_t n = 4096;
+    std::vector<T> a(n), b(n), out(n);
+    rng r { 777 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      const bool fail = (x >> 33) % 1000 < fail_per_1000;
+      // Values below 128 with fraction bits, so products fit;
+      // a failure is half the maximum times 4.
+      const T v = T((x >> 20) & ((T(1) << (F + 7)) - 1));
+      a[i] = fail ? T(std::numeric_limits<T>::max() / 2) : v;
+      b[i] = fail ? T(T(4) << F) : T(v ^ (T(1) << F));
+    }
+    const char *tn = bench_type_name<T>();
+    int flag = 0;
+    // cx_ throws on the failing data.
+    if (fail_per_1000 == 0) {
+      if constexpr(sizeof(T) == 4) {
+        bench_run({ "fixed", "qmul", "cx_mul_shr", tn, ds }, n, [&] {
+          k_hand<F>(out.data(), a.data(), b.data(), n);
+        });
+      }
+      bench_run({ "fixed", "qmul", "cx", tn, ds }, n, [&] {
+        k_cx<F>(out.data(), a.data(), b.data(), n);
+      });
+      bench_run({ "fixed", "qmul_n", "cx", tn, ds }, n, [&] {
+        k_n<n_cx, F>(out.data(), a.data(), b.data(), n, &flag);
+      });
+    }
+    bench_run({ "fixed", "qmul", "sr", tn, ds }, n, [&] {
+      k_sr<F>(out.data(), a.data(), b.data(), n);
+    });
+    bench_run({ "fixed", "qmul_n", "sr", tn, ds }, n, [&] {
+      k_n<n_sr, F>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_run({ "fixed", "qmul_n", "cf", tn, ds }, n, [&] {
+      k_n<n_cf, F>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_run({ "fixed", "qmul_n", "tr", tn, ds }, n, [&] {
+      k_n<n_tr, F>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_run({ "fixed", "qmul_n_even", "tr", tn, ds }, n, [&] {
+      k_n<n_tr_even, F>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_keep(out[n - 1]);
+    bench_keep(flag);
+  }
+
+} // namespace
+
+void bench_fixed()
+{
+  run_type<16, std::int32_t>("none", 0);
+  run_type<16, std::int32_t>("rare", 10);
+  run_type<32, std::int64_t>("none", 0);
+  run_type<32, std::int64_t>("rare", 10);
+}
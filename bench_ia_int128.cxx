@@ -0,0 +1,215 @@
+#include "bench_common.hxx"
+#include <vector>
+
+// 128-bit multiply: the library (cx, cfp, sr) as configured by
+// SIA80_MUL128_HALVES, against the code of __builtin_mul_overflow
+// ("builtin_cx", "builtin_sr") and mul_detail::mul128_halves()
+// ("halves_cx", "halves_sr") with the same handling.
+// Datasets:
+//   small:  both operands fit in 64 bits;
+//   wide:   one operand is wider than 64 bits, no overflow;
+//   mixed:  small or wide at random, no overflow;
+//   p25:    overflows on 25% of elements, at random (not for cx).
+// mul_wide: the full 128-bit product of int64_t, as cx_mul_wide,
+// as cx_mul on operands converted to __int128, and as the plain
+// operator ("raw").
+
+#if defined(__SIZEOF_INT128__)
+
+namespace {
+
+  enum { ds_small, ds_wide, ds_mixed, ds_p25 };
+  const char *const ds_names[] = { "small", "wide", "mixed", "p25" };
+
+  template <class T>
+  BENCH_NOINLINE void k_builtin_cx(T *out, const T *a, const T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      T r = 0;
+      if (SIA80_UNLIKELY(__builtin_mul_overflow(a[i], b[i], &r))) {
+        throw std::overflow_error("mul");
+      }
+      out[i] = r;
+    }
+  }
+
+  template <class T>
+  BENCH_NOINLINE void k_halves_cx(T *out, const T *a, const T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      T r = 0;
+      if (SIA80_UNLIKELY(sia80::mul_detail::mul128_halves(a[i], b[i], &r))) {
+        throw std::overflow_error("mul");
+      }
+      out[i] = r;
+    }
+  }
+
+  template <class T>
+  BENCH_NOINLINE void k_cx(T *out, const T *a, const T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::cx_mul(a[i], b[i]);
+    }
+  }
+
+  template <class T>
+  BENCH_NOINLINE bool k_cfp(T *out, const T *a, const T *b, std::size_t n)
+  {
+    sia80::overflow_sticky ovf;
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = ovf.mul(a[i], b[i]);
+    }
+    return ovf.overflowed();
+  }
+
+  template <class T>
+  BENCH_NOINLINE void k_builtin_sr(T *out, const T *a, const T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      T r = 0;
+      if (SIA80_UNLIKELY(__builtin_mul_overflow(a[i], b[i], &r))) {
+        r = (a[i] < 0) != (b[i] < 0) ? sia80::ia_limits<T>::min() : sia80::ia_limits<T>::max();
+      }
+      out[i] = r;
+    }
+  }
+
+  template <class T>
+  BENCH_NOINLINE void k_halves_sr(T *out, const T *a, const T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      T r = 0;
+      if (SIA80_UNLIKELY(sia80::mul_detail::mul128_halves(a[i], b[i], &r))) {
+        r = (a[i] < 0) != (b[i] < 0) ? sia80::ia_limits<T>::min() : sia80::ia_limits<T>::max();
+      }
+      out[i] = r;
+    }
+  }
+
+  template <class T>
+  BENCH_NOINLINE void k_sr(T *out, const T *a, const T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::sr_mul(a[i], b[i]);
+    }
+  }
+
+  BENCH_NOINLINE void k_wide_raw(__int128 *out, const std::int64_t *a,
+      const std::int64_t *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = __int128(a[i]) * b[i];
+    }
+  }
+
+  BENCH_NOINLINE void k_wide(__int128 *out, const std::int64_t *a,
+      const std::int64_t *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::cx_mul_wide(a[i], b[i]);
+    }
+  }
+
+  BENCH_NOINLINE void k_wide_cx_mul(__int128 *out, const std::int64_t *a,
+      const std::int64_t *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = sia80::cx_mul(__int128(a[i]), b[i]);
+    }
+  }
+
+  template <class T>
+  void run_mul(int ds)
+  {
+    constexpr std::size_t n = 4096;
+    using U = unsigned __int128;
+    std::vector<T> a(n), b(n), out(n);
+    rng r { 12345 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      std::uint64_t y = x * 0x9E3779B97F4A7C15ull;
+      const bool neg = std::is_signed<T>::value && (x >> 63);
+      // Magnitudes: 30 and 33 bits fit in 64; 90 and 36 don't overflow
+      // 127; 90 and 60 do.
+      U ma = U(x >> 34), mb = U(y >> 31);
+      if (ds == ds_wide || (ds == ds_mixed && (x >> 40) % 2 != 0) ||
+          (ds == ds_p25 && (x >> 40) % 4 != 0))
+      {
+        ma = (U(x) << 26) | (y >> 38);
+        mb = U(y >> 28);
+      }
+      else if (ds == ds_p25) {
+        ma = (U(x) << 26) | (y >> 38);
+        mb = U(y >> 4) | (U(1) << 59);
+      }
+      a[i] = neg ? T(U(0) - ma) : T(ma);
+      b[i] = T(mb);
+    }
+    const char *tn = bench_type_name<T>();
+    const char *dn = ds_names[ds];
+    if (ds != ds_p25) {
+      bench_run({ "int128", "mul", "builtin_cx", tn, dn }, n, [&] {
+        k_builtin_cx(out.data(), a.data(), b.data(), n);
+      });
+      bench_run({ "int128", "mul", "halves_cx", tn, dn }, n, [&] {
+        k_halves_cx(out.data(), a.data(), b.data(), n);
+      });
+      bench_run({ "int128", "mul", "cx", tn, dn }, n, [&] {
+        k_cx(out.data(), a.data(), b.data(), n);
+      });
+    }
+    bench_run({ "int128", "mul", "cfp", tn, dn }, n, [&] {
+      bench_keep(k_cfp(out.data(), a.data(), b.data(), n));
+    });
+    bench_run({ "int128", "mul", "builtin_sr", tn, dn }, n, [&] {
+      k_builtin_sr(out.data(), a.data(), b.data(), n);
+    });
+    bench_run({ "int128", "mul", "halves_sr", tn, dn }, n, [&] {
+      k_halves_sr(out.data(), a.data(), b.data(), n);
+    });
+    bench_run({ "int128", "mul", "sr", tn, dn }, n, [&] {
+      k_sr(out.data(), a.data(), b.data(), n);
+    });
+  }
+
+  void run_wide()
+  {
+    constexpr std::size_t n = 4096;
+    std::vector<std::int64_t> a(n), b(n);
+    std::vector<__int128> out(n);
+    rng r { 12345 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      a[i] = std::int64_t(x);
+      b[i] = std::int64_t(x * 0x9E3779B97F4A7C15ull);
+    }
+    bench_run({ "int128", "mul_wide", "raw", "int64", "random" }, n, [&] {
+      k_wide_raw(out.data(), a.data(), b.data(), n);
+    });
+    bench_run({ "int128", "mul_wide", "cx", "int64", "random" }, n, [&] {
+      k_wide(out.data(), a.data(), b.data(), n);
+    });
+    bench_run({ "int128", "mul_wide", "cx_mul", "int64", "random" }, n, [&] {
+      k_wide_cx_mul(out.data(), a.data(), b.data(), n);
+    });
+  }
+
+} // namespace
+
+void bench_int128()
+{
+  for (int ds : { ds_small, ds_wide, ds_mixed, ds_p25 }) {
+    run_mul<__int128>(ds);
+    run_mul<unsigned __int128>(ds);
+  }
+  run_wide();
+}
+
+#else
+
+void bench_int128()
+{
+}
+
+#endif
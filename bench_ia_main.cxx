@@ -0,0 +1,95 @@
+#include "bench_common.hxx"
+#include <cstring>
+#include <string>
+
+// Usage: bench_ia [--json] [--no-header] [filter]
+// Output is CSV (default) or JSON, one record per measured case.
+// The filter is a substring of "group/op/mode/type/dataset",
+// e.g. "ops/mul/" or "/sr/int32/".
+// ops/cycle is counted in time stamp counter ticks, which may
+// differ from core cycles with frequency scaling.
+
+static bool opt_json = false;
+static bool opt_header = true;
+static const char *opt_filter = nullptr;
+static bool json_first = true;
+
+static std::string case_path(const bench_case& bc)
+{
+  return std::string(bc.group) + "/" + bc.op + "/" + bc.mode + "/" +
+      bc.type + "/" + bc.dataset;
+}
+
+bool bench_selected(const bench_case& bc)
+{
+  return !opt_filter || case_path(bc).find(opt_filter) != std::string::npos;
+}
+
+void bench_record(const bench_case& bc, double ns_per_op, double ops_per_cycle)
+{
+#if WITH_VOLATILE
+  const char *volatile_str = "1";
+#else
+  const char *volatile_str = "0";
+#endif
+  if (opt_json) {
+    std::printf("%s\n  {\"compiler\": \"%s\", \"optlevel\": \"%s\", "
+        "\"volatile\": %s, \"group\": \"%s\", \"op\": \"%s\", "
+        "\"mode\": \"%s\", \"type\": \"%s\", \"dataset\": \"%s\", "
+        "\"ns_per_op\": %.4f, \"ops_per_cycle\": %.4f}",
+        json_first ? "" : ",", __VERSION__, BENCH_OPTLEVEL,
+        volatile_str, bc.group, bc.op, bc.mode, bc.type, bc.dataset,
+        ns_per_op, ops_per_cycle);
+    json_first = false;
+  }
+  else {
+    std::printf("\"%s\",%s,%s,%s,%s,%s,%s,%s,%.4f,%.4f\n",
+        __VERSION__, BENCH_OPTLEVEL, volatile_str,
+        bc.group, bc.op, bc.mode, bc.type, bc.dataset,
+        ns_per_op, ops_per_cycle);
+  }
+  std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--json")) {
+      opt_json = true;
+    }
+    else if (!std::strcmp(argv[i], "--no-header")) {
+      opt_header = false;
+    }
+    else {
+      opt_filter = argv[i];
+    }
+  }
+  if (opt_json) {
+    std::printf("[");
+  }
+  else if (opt_header) {
+    std::printf("compiler,optlevel,volatile,group,op,mode,type,dataset,"
+        "ns_per_op,ops_per_cycle\n");
+  }
+  bench_ops();
+  bench_cf_pair();
+  bench_divider();
+  bench_batch();
+  bench_int128();
+  bench_telemetry_off();
+  bench_telemetry();
+  bench_fixed();
+  bench_parse();
+  bench_arena();
+  bench_range();
+  bench_bounded();
+  bench_atomic();
+  bench_math();
+  bench_muldiv();
+  bench_bitpack();
+  bench_result();
+  bench_expr();
+  if (opt_json) {
+    std::printf("\n]\n");
+  }
+}
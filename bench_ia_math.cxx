@@ -0,0 +1,242 @@
+#include "bench_common.hxx"
+#include <safe_int_math_80.hxx>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+// neg, abs, pow, gcd, lcm and midpoint against the chained forms one
+// would write with the scalar functions, and against the unchecked
+// ones ("raw": std:: functions and plain operators).
+//   pow: xx_pow against a loop of exp xx_mul ("pow_chain"), and the
+//     wrapping square-and-multiply ("raw"). exp in [0, 39], bases in
+//     [-3, 3] ("fit": all results fit int64) or in [-9, 9] ("mixed":
+//     about a third overflow; cx only on "fit").
+//   gcd: cx_gcd against the Euclid loop of % ("gcd_euclid", cx as
+//     it can't overflow on these) and std::gcd ("raw"), on uint64.
+//   lcm: cx_lcm against cx_mul(a, b) / gcd ("lcm_naive", which fails
+//     if a * b doesn't fit, even if the lcm does) and std::lcm ("raw");
+//     a and b below 2^31 with a common factor below 2^10.
+//   neg, abs: cx_xxx against cx_sub(0, x), and -x, std::abs ("raw").
+//   midpoint: against (a + b) / 2 ("raw", wrong on overflow) and, in
+//     C++20, std::midpoint, on int64.
+
+namespace {
+
+  constexpr std::size_t n = 4096;
+
+  enum { k_raw, k_cx, k_cf, k_sr, k_chain_cx, k_chain_cf, k_chain_sr };
+
+  template <int K>
+  BENCH_NOINLINE void k_pow(std::int64_t *out, const std::int64_t *b, const int *e)
+  {
+    using namespace sia80;
+    int flag = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == k_raw) {
+        out[i] = std::int64_t(mt_detail::upow(std::uint64_t(b[i]), unsigned(e[i])));
+      }
+      else if constexpr(K == k_cx) {
+        out[i] = cx_pow(b[i], e[i]);
+      }
+      else if constexpr(K == k_cf) {
+        out[i] = cf_pow(b[i], e[i], &flag);
+      }
+      else if constexpr(K == k_sr) {
+        out[i] = sr_pow(b[i], e[i]);
+      }
+      else {
+        std::int64_t r = 1;
+        for (int k = 0; k < e[i]; ++k) {
+          if constexpr(K == k_chain_cx) {
+            r = cx_mul(r, b[i]);
+          }
+          else if constexpr(K == k_chain_cf) {
+            r = cf_mul(r, b[i], &flag);
+          }
+          else {
+            r = sr_mul(r, b[i]);
+          }
+        }
+        out[i] = r;
+      }
+    }
+    bench_keep(flag);
+  }
+
+  enum { g_raw, g_lib, g_alt };
+
+  template <int K>
+  BENCH_NOINLINE void k_gcd(std::uint64_t *out, const std::uint64_t *a, const std::uint64_t *b)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == g_raw) {
+        out[i] = std::gcd(a[i], b[i]);
+      }
+      else if constexpr(K == g_lib) {
+        out[i] = sia80::cx_gcd(a[i], b[i]);
+      }
+      else {
+        std::uint64_t x = a[i], y = b[i];
+        while (y != 0) {
+          const std::uint64_t t = sia80::cx_rem(x, y);
+          x = y;
+          y = t;
+        }
+        out[i] = x;
+      }
+    }
+  }
+
+  template <int K>
+  BENCH_NOINLINE void k_lcm(std::int64_t *out, const std::int64_t *a, const std::int64_t *b)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == g_raw) {
+        out[i] = std::lcm(a[i], b[i]);
+      }
+      else if constexpr(K == g_lib) {
+        out[i] = sia80::cx_lcm(a[i], b[i]);
+      }
+      else {
+        out[i] = sia80::cx_div(sia80::cx_mul(a[i], b[i]), std::gcd(a[i], b[i]));
+      }
+    }
+  }
+
+  template <int Op, int K>
+  BENCH_NOINLINE void k_unary(std::int64_t *out, const std::int64_t *a)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == g_raw) {
+        out[i] = Op == 0 ? -a[i] : std::abs(a[i]);
+      }
+      else if constexpr(K == g_lib) {
+        out[i] = Op == 0 ? sia80::cx_neg(a[i]) : sia80::cx_abs(a[i]);
+      }
+      else if constexpr(Op == 0) {
+        out[i] = sia80::cx_sub(std::int64_t(0), a[i]);
+      }
+      else {
+        out[i] = a[i] < 0 ? sia80::cx_sub(std::int64_t(0), a[i]) : a[i];
+      }
+    }
+  }
+
+  template <int K>
+  BENCH_NOINLINE void k_midpoint(std::int64_t *out, const std::int64_t *a, const std::int64_t *b)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == g_raw) {
+        out[i] = (a[i] + b[i]) / 2;
+      }
+      else if constexpr(K == g_lib) {
+        out[i] = sia80::midpoint(a[i], b[i]);
+      }
+      else {
+#if defined(__cpp_lib_interpolate)
+        out[i] = std::midpoint(a[i], b[i]);
+#endif
+      }
+    }
+  }
+
+} // namespace
+
+void bench_math()
+{
+  std::vector<std::int64_t> pb_fit(n), pb_mixed(n), la(n), lb(n), sa(n), sb(n), out(n);
+  std::vector<int> pe(n);
+  std::vector<std::uint64_t> ga(n), gb(n), gout(n);
+  rng r { 29 };
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::int64_t sign = (r.next() >> 63) ? -1 : 1;
+    pb_fit[i] = std::int64_t(r.next() >> 62) * sign;
+    pb_mixed[i] = std::int64_t((r.next() >> 32) % 10) * sign;
+    pe[i] = int((r.next() >> 32) % 40);
+    const std::uint64_t f = (r.next() >> 54) + 1;
+    ga[i] = (r.next() >> 8) * f;
+    gb[i] = (r.next() >> 8) * f;
+    la[i] = std::int64_t((r.next() >> 43) * f);
+    lb[i] = std::int64_t((r.next() >> 43) * f);
+    sa[i] = std::int64_t(r.next() >> 1);
+    sb[i] = std::int64_t(r.next() >> 1) * ((r.next() >> 63) ? -1 : 1);
+  }
+
+  bench_run({ "math", "pow", "raw", "int64", "fit" }, n, [&] {
+    k_pow<k_raw>(out.data(), pb_fit.data(), pe.data());
+  });
+  bench_run({ "math", "pow", "cx", "int64", "fit" }, n, [&] {
+    k_pow<k_cx>(out.data(), pb_fit.data(), pe.data());
+  });
+  bench_run({ "math", "pow_chain", "cx", "int64", "fit" }, n, [&] {
+    k_pow<k_chain_cx>(out.data(), pb_fit.data(), pe.data());
+  });
+  for (const std::vector<std::int64_t> *pb : { &pb_fit, &pb_mixed }) {
+    const char *ds = pb == &pb_fit ? "fit" : "mixed";
+    bench_run({ "math", "pow", "cf", "int64", ds }, n, [&] {
+      k_pow<k_cf>(out.data(), pb->data(), pe.data());
+    });
+    bench_run({ "math", "pow_chain", "cf", "int64", ds }, n, [&] {
+      k_pow<k_chain_cf>(out.data(), pb->data(), pe.data());
+    });
+    bench_run({ "math", "pow", "sr", "int64", ds }, n, [&] {
+      k_pow<k_sr>(out.data(), pb->data(), pe.data());
+    });
+    bench_run({ "math", "pow_chain", "sr", "int64", ds }, n, [&] {
+      k_pow<k_chain_sr>(out.data(), pb->data(), pe.data());
+    });
+  }
+
+  bench_run({ "math", "gcd", "raw", "uint64", "none" }, n, [&] {
+    k_gcd<g_raw>(gout.data(), ga.data(), gb.data());
+  });
+  bench_run({ "math", "gcd", "cx", "uint64", "none" }, n, [&] {
+    k_gcd<g_lib>(gout.data(), ga.data(), gb.data());
+  });
+  bench_run({ "math", "gcd_euclid", "cx", "uint64", "none" }, n, [&] {
+    k_gcd<g_alt>(gout.data(), ga.data(), gb.data());
+  });
+  bench_keep(gout[n - 1]);
+
+  bench_run({ "math", "lcm", "raw", "int64", "none" }, n, [&] {
+    k_lcm<g_raw>(out.data(), la.data(), lb.data());
+  });
+  bench_run({ "math", "lcm", "cx", "int64", "none" }, n, [&] {
+    k_lcm<g_lib>(out.data(), la.data(), lb.data());
+  });
+  bench_run({ "math", "lcm_naive", "cx", "int64", "none" }, n, [&] {
+    k_lcm<g_alt>(out.data(), la.data(), lb.data());
+  });
+
+  bench_run({ "math", "neg", "raw", "int64", "none" }, n, [&] {
+    k_unary<0, g_raw>(out.data(), sb.data());
+  });
+  bench_run({ "math", "neg", "cx", "int64", "none" }, n, [&] {
+    k_unary<0, g_lib>(out.data(), sb.data());
+  });
+  bench_run({ "math", "neg_sub", "cx", "int64", "none" }, n, [&] {
+    k_unary<0, g_alt>(out.data(), sb.data());
+  });
+  bench_run({ "math", "abs", "raw", "int64", "none" }, n, [&] {
+    k_unary<1, g_raw>(out.data(), sb.data());
+  });
+  bench_run({ "math", "abs", "cx", "int64", "none" }, n, [&] {
+    k_unary<1, g_lib>(out.data(), sb.data());
+  });
+  bench_run({ "math", "abs_sub", "cx", "int64", "none" }, n, [&] {
+    k_unary<1, g_alt>(out.data(), sb.data());
+  });
+
+  bench_run({ "math", "midpoint", "raw", "int64", "none" }, n, [&] {
+    k_midpoint<g_raw>(out.data(), sa.data(), sb.data());
+  });
+  bench_run({ "math", "midpoint", "lib", "int64", "none" }, n, [&] {
+    k_midpoint<g_lib>(out.data(), sa.data(), sb.data());
+  });
+#if defined(__cpp_lib_interpolate)
+  bench_run({ "math", "midpoint_std", "raw", "int64", "none" }, n, [&] {
+    k_midpoint<g_alt>(out.data(), sa.data(), sb.data());
+  });
+#endif
+  bench_keep(out[n - 1]);
+}
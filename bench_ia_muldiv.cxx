@@ -0,0 +1,160 @@
+#include "bench_common.hxx"
+#include <safe_int_arith_80.hxx>
+#include <safe_int_muldiv_80.hxx>
+#include <vector>
+
+// xx_muldiv against the forms one would write without it:
+//   "chain": cx_div(cx_mul(a, b), c), which fails when a * b doesn't
+//     fit even if the quotient does (so only on "fit", where both fit);
+//   "raw": a * b / c, unchecked and wrong on the same;
+//   "wide": a * b / c in __int128, exact but with __divti3.
+// Datasets: "fit" (a * b fits, |a|, |b| < 2^31), "wide" (a * b doesn't
+// fit, the quotient does: c is near a). Rounding: trunc and nearest;
+// nearest against the chained form with the remainder. The array
+// forms (one divisor for all: the reciprocal) against the scalar loop.
+
+namespace {
+
+  constexpr std::size_t n = 4096;
+
+  enum { k_raw, k_wide, k_chain, k_cx, k_cf, k_sr, k_cx_near, k_chain_near };
+
+  template <int K, typename T>
+  BENCH_NOINLINE void k_muldiv(T *out, const T *a, const T *b, const T *c)
+  {
+    using namespace sia80;
+    int flag = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == k_raw) {
+        out[i] = T(a[i] * b[i] / c[i]);
+      }
+      else if constexpr(K == k_wide) {
+        using W = std::conditional_t<std::is_signed<T>::value, __int128, unsigned __int128>;
+        out[i] = T(W(a[i]) * b[i] / c[i]);
+      }
+      else if constexpr(K == k_chain) {
+        out[i] = cx_div(cx_mul(a[i], b[i]), c[i]);
+      }
+      else if constexpr(K == k_cx) {
+        out[i] = cx_muldiv(a[i], b[i], c[i]);
+      }
+      else if constexpr(K == k_cf) {
+        out[i] = cf_muldiv(a[i], b[i], c[i], &flag);
+      }
+      else if constexpr(K == k_sr) {
+        out[i] = sr_muldiv(a[i], b[i], c[i]);
+      }
+      else if constexpr(K == k_cx_near) {
+        out[i] = cx_muldiv<rounding::nearest>(a[i], b[i], c[i]);
+      }
+      else {
+        // Half away from zero, by the remainder.
+        const T p = cx_mul(a[i], b[i]);
+        const T q = cx_div(p, c[i]);
+        const T r = T(p - q * c[i]);
+        const T ar = r < 0 ? T(-r) : r;
+        const T ac = c[i] < 0 ? T(-c[i]) : c[i];
+        out[i] = ar >= ac - ar ? cx_add(q, T((p < 0) != (c[i] < 0) ? -1 : 1)) : q;
+      }
+    }
+    bench_keep(flag);
+  }
+
+  enum { n_loop_cx, n_loop_sr, n_cx, n_sr };
+
+  template <int K, typename T>
+  BENCH_NOINLINE void k_muldiv_n(T *out, const T *a, const T *b, T c)
+  {
+    if constexpr(K == n_loop_cx) {
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = sia80::cx_muldiv(a[i], b[i], c);
+      }
+    }
+    else if constexpr(K == n_loop_sr) {
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = sia80::sr_muldiv(a[i], b[i], c);
+      }
+    }
+    else if constexpr(K == n_cx) {
+      sia80::cx_muldiv_n(out, a, b, c, n);
+    }
+    else {
+      sia80::sr_muldiv_n(out, a, b, c, n);
+    }
+  }
+
+  template <typename T>
+  void bench_type(const char *tn)
+  {
+    std::vector<T> fa(n), fb(n), fc(n), wa(n), wb(n), wc(n), out(n);
+    rng r { 31 };
+    constexpr int half = std::numeric_limits<T>::digits / 2;
+    for (std::size_t i = 0; i < n; ++i) {
+      const bool sg = std::is_signed<T>::value && (r.next() >> 63);
+      fa[i] = T(r.next() >> (64 - half));
+      fb[i] = T(r.next() >> (64 - half));
+      fc[i] = T(T(r.next() >> (64 - half)) | 1);
+      fa[i] = sg ? T(-fa[i]) : fa[i];
+      wa[i] = T((r.next() >> 1) >> (64 - std::numeric_limits<T>::digits));
+      wb[i] = T(r.next() >> (64 - half)) | T(1);
+      // c in [a / 2, a]: the quotient is below 2 * b.
+      wc[i] = T(T(wa[i] - (wa[i] >> 1) * T((r.next() >> 11) % 2)) | 1);
+      wb[i] = sg ? T(-wb[i]) : wb[i];
+    }
+    for (int ds = 0; ds < 2; ++ds) {
+      const char *dn = ds == 0 ? "fit" : "wide";
+      const T *a = ds == 0 ? fa.data() : wa.data();
+      const T *b = ds == 0 ? fb.data() : wb.data();
+      const T *c = ds == 0 ? fc.data() : wc.data();
+      if (ds == 0) {
+        bench_run({ "muldiv", "muldiv", "raw", tn, dn }, n, [&] {
+          k_muldiv<k_raw>(out.data(), a, b, c);
+        });
+        bench_run({ "muldiv", "chain", "cx", tn, dn }, n, [&] {
+          k_muldiv<k_chain>(out.data(), a, b, c);
+        });
+        bench_run({ "muldiv", "chain_near", "cx", tn, dn }, n, [&] {
+          k_muldiv<k_chain_near>(out.data(), a, b, c);
+        });
+      }
+      bench_run({ "muldiv", "muldiv", "wide", tn, dn }, n, [&] {
+        k_muldiv<k_wide>(out.data(), a, b, c);
+      });
+      bench_run({ "muldiv", "muldiv", "cx", tn, dn }, n, [&] {
+        k_muldiv<k_cx>(out.data(), a, b, c);
+      });
+      bench_run({ "muldiv", "muldiv", "cf", tn, dn }, n, [&] {
+        k_muldiv<k_cf>(out.data(), a, b, c);
+      });
+      bench_run({ "muldiv", "muldiv", "sr", tn, dn }, n, [&] {
+        k_muldiv<k_sr>(out.data(), a, b, c);
+      });
+      bench_run({ "muldiv", "muldiv_near", "cx", tn, dn }, n, [&] {
+        k_muldiv<k_cx_near>(out.data(), a, b, c);
+      });
+    }
+    // One divisor: a * b below c * 2^(digits - 1).
+    const T c1 = T(fc[0] | (T(1) << (half - 1)));
+    bench_run({ "muldiv", "muldiv_loop", "cx", tn, "fit" }, n, [&] {
+      k_muldiv_n<n_loop_cx>(out.data(), fa.data(), fb.data(), c1);
+    });
+    bench_run({ "muldiv", "muldiv_n", "cx", tn, "fit" }, n, [&] {
+      k_muldiv_n<n_cx>(out.data(), fa.data(), fb.data(), c1);
+    });
+    bench_run({ "muldiv", "muldiv_loop", "sr", tn, "fit" }, n, [&] {
+      k_muldiv_n<n_loop_sr>(out.data(), fa.data(), fb.data(), c1);
+    });
+    bench_run({ "muldiv", "muldiv_n", "sr", tn, "fit" }, n, [&] {
+      k_muldiv_n<n_sr>(out.data(), fa.data(), fb.data(), c1);
+    });
+    bench_keep(out[n - 1]);
+  }
+
+} // namespace
+
+void bench_muldiv()
+{
+  bench_type<std::int32_t>("int32");
+  bench_type<std::int64_t>("int64");
+  bench_type<std::uint64_t>("uint64");
+}
@@ -0,0 +1,326 @@
+#include "bench_common.hxx"
+#include <vector>
+
+// Matrix of every op in every mode for 8..64 bit types, against
+// plain operators ("raw" mode).
+//
+// Datasets set the pattern of inputs on which the op fails
+// (overflow, division by 0, bad shift count, doesn't fit):
+//   none:   never fails;
+//   rare:   fails on 1% of elements, at random;
+//   p10:    fails on 10% of elements, at random;
+//   p25:    fails on 25% of elements, at random;
+//   alt:    fails on every other element, predictable for branches;
+//   random: fails on 50% of elements, at random.
+// cx_xxx are measured only on "none" (otherwise it would measure
+// exceptions), as well as raw division (would trap).
+//
+// NB For 8 and 16 bit types, add, sub, mul and shl are done in int
+// after integral promotion, so they don't overflow on any dataset;
+// the same as in the library.
+//
+// The mode "cfp" is pair-returning cf_xxx with overflow_sticky;
+// "srb" is sr_xxx(..., branchless), for add, sub, mul, shl and conv.
+
+namespace {
+
+  enum { op_add, op_sub, op_mul, op_div, op_rem, op_shl, op_shr,
+      op_conv, op_ufit, op_sfit };
+  const char *const op_names[] = { "add", "sub", "mul", "div", "rem",
+      "shl", "shr", "conv", "ufit", "sfit" };
+
+  enum { m_raw, m_cx, m_cf, m_cfp, m_tr, m_sr, m_srb };
+  const char *const mode_names[] = { "raw", "cx", "cf", "cfp", "tr", "sr", "srb" };
+
+  enum { ds_none, ds_rare, ds_p10, ds_p25, ds_alt, ds_random };
+  const char *const ds_names[] = { "none", "rare", "p10", "p25", "alt", "random" };
+
+  // Target of conv: the same width, the other signedness.
+  template <class T>
+  using conv_to = std::conditional_t<std::is_signed<T>::value,
+      std::make_unsigned_t<T>, std::make_signed_t<T>>;
+
+  template <int Op, int Mode>
+  constexpr bool op_exists()
+  {
+    if (Mode == m_srb) {
+      return Op == op_add || Op == op_sub || Op == op_mul ||
+          Op == op_shl || Op == op_conv;
+    }
+    return true;
+  }
+
+  template <class T>
+  constexpr unsigned type_bits = sizeof(T) * CHAR_BIT;
+
+#define BENCH_MODES(fn, ...) \
+    if constexpr(Mode == m_cx) { \
+      return sia80::cx_##fn(__VA_ARGS__); \
+    } \
+    else if constexpr(Mode == m_cf) { \
+      return sia80::cf_##fn(__VA_ARGS__, flag); \
+    } \
+    else if constexpr(Mode == m_cfp) { \
+      return st.take(sia80::cf_##fn(__VA_ARGS__)); \
+    } \
+    else if constexpr(Mode == m_tr) { \
+      return sia80::tr_##fn(__VA_ARGS__); \
+    } \
+    else if constexpr(Mode == m_sr) { \
+      return sia80::sr_##fn(__VA_ARGS__); \
+    } \
+    else { \
+      return sia80::sr_##fn(__VA_ARGS__, sia80::branchless); \
+    }
+
+  template <int Op, int Mode, class T>
+  inline auto apply(T a, T b, int *flag, sia80::overflow_sticky& st)
+  {
+    using U = std::make_unsigned_t<T>;
+    using UW = decltype(U() + 0u); // unsigned without promotion to int
+    using TP = decltype(+a); // type after promotion, for shifts
+    constexpr unsigned nbits = type_bits<T> / 2;
+    (void) flag;
+    (void) st;
+    if constexpr(Op == op_add) {
+      if constexpr(Mode == m_raw) {
+        return T(UW(a) + UW(b));
+      }
+      else {
+        BENCH_MODES(add, a, b)
+      }
+    }
+    else if constexpr(Op == op_sub) {
+      if constexpr(Mode == m_raw) {
+        return T(UW(a) - UW(b));
+      }
+      else {
+        BENCH_MODES(sub, a, b)
+      }
+    }
+    else if constexpr(Op == op_mul) {
+      if constexpr(Mode == m_raw) {
+        return T(UW(a) * UW(b));
+      }
+      else {
+        BENCH_MODES(mul, a, b)
+      }
+    }
+    else if constexpr(Op == op_div) {
+      if constexpr(Mode == m_raw) {
+        return a / b;
+      }
+      else {
+        BENCH_MODES(div, a, b)
+      }
+    }
+    else if constexpr(Op == op_rem) {
+      if constexpr(Mode == m_raw) {
+        return a % b;
+      }
+      else {
+        BENCH_MODES(rem, a, b)
+      }
+    }
+    else if constexpr(Op == op_shl) {
+      if constexpr(Mode == m_raw) {
+        return TP(UW(a) << (unsigned(b) & (type_bits<TP> - 1)));
+      }
+      else {
+        BENCH_MODES(shl, a, b)
+      }
+    }
+    else if constexpr(Op == op_shr) {
+      if constexpr(Mode == m_raw) {
+        return a >> (unsigned(b) & (type_bits<TP> - 1));
+      }
+      else {
+        BENCH_MODES(shr, a, b)
+      }
+    }
+    else if constexpr(Op == op_conv) {
+      if constexpr(Mode == m_raw) {
+        return conv_to<T>(a);
+      }
+      else {
+        BENCH_MODES(conv<conv_to<T>>, a)
+      }
+    }
+    else if constexpr(Op == op_ufit) {
+      if constexpr(Mode == m_raw) {
+        return T(U(a) & ((U(1) << nbits) - 1));
+      }
+      else {
+        BENCH_MODES(ufit, a, nbits)
+      }
+    }
+    else {
+      if constexpr(Mode == m_raw) {
+        // Sign extension from nbits.
+        return T(std::int64_t(std::uint64_t(a) << (64 - nbits)) >> (64 - nbits));
+      }
+      else {
+        BENCH_MODES(sfit, a, nbits)
+      }
+    }
+  }
+
+#undef BENCH_MODES
+
+  template <int Op, int Mode, class T, class R>
+  BENCH_NOINLINE bool kernel(R *out, const INPUT T *a, const INPUT T *b,
+      std::size_t n, int *flag)
+  {
+    sia80::overflow_sticky st;
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = apply<Op, Mode, T>(a[i], b[i], flag, st);
+    }
+    return st.overflowed();
+  }
+
+  // One pair of operands, failing or not.
+  template <int Op, class T>
+  void make_operands(rng& r, bool fail, T& a, T& b)
+  {
+    using TP = decltype(+a);
+    constexpr T tmax = std::numeric_limits<T>::max();
+    constexpr T tmin = std::numeric_limits<T>::min();
+    constexpr bool is_signed = std::is_signed<T>::value;
+    constexpr unsigned nbits = type_bits<T> / 2;
+    constexpr unsigned digits = std::numeric_limits<TP>::digits;
+    const std::uint64_t x = r.next() >> 16;
+    // Small operand, never overflows for add, sub and mul.
+    const T small = T(x % (std::uint64_t(1) << (nbits - 1)));
+    const T small2 = T((x >> 24) % (std::uint64_t(1) << (nbits - 1)));
+    switch (Op) {
+      case op_add:
+        a = fail ? T(tmax - small) : small;
+        b = fail ? T(small + 1) : small2;
+        break;
+      case op_sub:
+        a = fail ? T(tmin + small) : T(small + small2);
+        b = fail ? T(small + 1) : small2;
+        break;
+      case op_mul:
+        a = fail ? T(tmax / 2 + small) : small;
+        b = fail ? T(3) : small2;
+        break;
+      case op_div:
+      case op_rem:
+        a = T(x >> 8);
+        b = fail ? T(0) : T(small2 | 1);
+        if (is_signed && !fail && a == tmin) {
+          a = T(a + 1);
+        }
+        break;
+      case op_shl:
+        a = fail ? T(tmax / 2 + 1) : T(small >> 1);
+        b = T(fail ? 2 + small2 % 4 : small2 % (nbits - 1));
+        break;
+      case op_shr:
+        a = T(x >> 8);
+        // The library accepts counts below digits (31 for int).
+        b = T(fail ? digits + small2 % 8 : small2 % digits);
+        break;
+      case op_conv:
+        a = fail ? (is_signed ? T(-1 - small) : T(tmax - small)) : small;
+        b = 0;
+        break;
+      case op_ufit:
+        a = fail ? T(T(1) << nbits | small) : small;
+        b = 0;
+        break;
+      default: // sfit
+        a = fail ? T(T(1) << nbits | small) : is_signed ? T(small - small2) : small;
+        b = 0;
+        break;
+    }
+  }
+
+  template <int Op, int Mode, class T>
+  void run_case(int ds)
+  {
+    if constexpr(op_exists<Op, Mode>()) {
+      if (ds != ds_none && (Mode == m_cx ||
+          (Mode == m_raw && (Op == op_div || Op == op_rem))))
+      {
+        return;
+      }
+      constexpr std::size_t n = 4096;
+      std::vector<T> a(n), b(n);
+      rng r { std::uint64_t(Op * 1000 + ds) };
+      for (std::size_t i = 0; i < n; ++i) {
+        bool fail = false;
+        switch (ds) {
+          case ds_rare:
+            fail = (r.next() >> 16) % 100 == 0;
+            break;
+          case ds_p10:
+            fail = (r.next() >> 16) % 10 == 0;
+            break;
+          case ds_p25:
+            fail = (r.next() >> 16) % 4 == 0;
+            break;
+          case ds_alt:
+            fail = i % 2 != 0;
+            break;
+          case ds_random:
+            fail = (r.next() >> 16) % 2 != 0;
+            break;
+        }
+        make_operands<Op>(r, fail, a[i], b[i]);
+      }
+      sia80::overflow_sticky st;
+      using R = decltype(apply<Op, Mode, T>(T(), T(), nullptr, st));
+      std::vector<R> out(n);
+      int flag = 0;
+      bench_run({ "ops", op_names[Op], mode_names[Mode],
+          bench_type_name<T>(), ds_names[ds] }, n, [&] {
+        bench_keep(kernel<Op, Mode, T>(out.data(), a.data(), b.data(), n, &flag));
+      });
+      bench_keep(flag);
+    }
+  }
+
+  template <int Op, class T>
+  void run_op_type()
+  {
+    for (int ds = ds_none; ds <= ds_random; ++ds) {
+      run_case<Op, m_raw, T>(ds);
+      run_case<Op, m_cx, T>(ds);
+      run_case<Op, m_cf, T>(ds);
+      run_case<Op, m_cfp, T>(ds);
+      run_case<Op, m_tr, T>(ds);
+      run_case<Op, m_sr, T>(ds);
+      run_case<Op, m_srb, T>(ds);
+    }
+  }
+
+  template <int Op>
+  void run_op()
+  {
+    run_op_type<Op, std::int8_t>();
+    run_op_type<Op, std::uint8_t>();
+    run_op_type<Op, std::int16_t>();
+    run_op_type<Op, std::uint16_t>();
+    run_op_type<Op, std::int32_t>();
+    run_op_type<Op, std::uint32_t>();
+    run_op_type<Op, std::int64_t>();
+    run_op_type<Op, std::uint64_t>();
+  }
+
+} // namespace
+
+void bench_ops()
+{
+  run_op<op_add>();
+  run_op<op_sub>();
+  run_op<op_mul>();
+  run_op<op_div>();
+  run_op<op_rem>();
+  run_op<op_shl>();
+  run_op<op_shr>();
+  run_op<op_conv>();
+  run_op<op_ufit>();
+  run_op<op_sfit>();
+}
@@ -0,0 +1,135 @@
+#include "bench_common.hxx"
+#include <safe_int_parse_80.hxx>
+#include <charconv>
+#include <cstdlib>
+#include <string>
+
+// Parsing of numbers separated by spaces: parse<T, Mode> (cx and sr),
+// std::from_chars, std::from_chars to int64_t with cx_conv for int32_t
+// ("from_chars_conv", what a range checked parse did before), and
+// strtoll/strtoull (which also skips spaces and takes a sign, and
+// needs errno for the range).
+// Datasets: short (up to 3 digits), long (the full range of T) and
+// hex (the full range, base 16).
+
+namespace {
+
+  template <class T, sia80::mode Mode>
+  BENCH_NOINLINE T k_parse(const char *p, const char *end, int base)
+  {
+    T sum = 0;
+    while (p < end) {
+      const sia80::parse_result<T> r = sia80::parse<T, Mode>(p, end, base);
+      sum = T(sum ^ r.value);
+      p = r.ptr + 1;
+    }
+    return sum;
+  }
+
+  template <class T>
+  BENCH_NOINLINE T k_from_chars(const char *p, const char *end, int base)
+  {
+    T sum = 0;
+    while (p < end) {
+      T v = 0;
+      const std::from_chars_result r = std::from_chars(p, end, v, base);
+      sum = T(sum ^ v);
+      p = r.ptr + 1;
+    }
+    return sum;
+  }
+
+  template <class T>
+  BENCH_NOINLINE T k_from_chars_conv(const char *p, const char *end, int base)
+  {
+    using W = std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>;
+    T sum = 0;
+    while (p < end) {
+      W v = 0;
+      const std::from_chars_result r = std::from_chars(p, end, v, base);
+      sum = T(sum ^ sia80::cx_conv<T>(v));
+      p = r.ptr + 1;
+    }
+    return sum;
+  }
+
+  template <class T>
+  BENCH_NOINLINE T k_strtol(const char *p, const char *end, int base)
+  {
+    T sum = 0;
+    while (p < end) {
+      char *e;
+      if constexpr(std::is_signed<T>::value) {
+        sum = T(sum ^ T(std::strtoll(p, &e, base)));
+      }
+      else {
+        sum = T(sum ^ T(std::strtoull(p, &e, base)));
+      }
+      p = e + 1;
+    }
+    return sum;
+  }
+
+  template <class T>
+  void run_type(const char *ds, int base, bool full)
+  {
+    constexpr std::size_t n = 4096;
+    std::string text;
+    rng r { 555 };
+    char buf[80];
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      T v = full ? T(x >> 7) : T((x >> 33) % 1000);
+      if (std::is_signed<T>::value && (x & 0x100) != 0) {
+        v = T(-v);
+      }
+      if (v == std::numeric_limits<T>::min()) {
+        v = 0;
+      }
+      const std::to_chars_result r = std::to_chars(buf, buf + sizeof(buf), v, base);
+      text.append(buf, r.ptr);
+      text += ' ';
+    }
+    const char *p = text.data();
+    const char *end = p + text.size();
+    const char *tn = bench_type_name<T>();
+    INPUT int ibase = base;
+    T sum = 0;
+    // The kernels only read memory: bench_keep (with its memory
+    // clobber) stops GCC from calling them once for all repeats.
+    bench_run({ "parse", "parse", "cx", tn, ds }, n, [&] {
+      bench_keep(p);
+      sum = T(sum ^ k_parse<T, sia80::mode::cx>(p, end, ibase));
+    });
+    bench_run({ "parse", "parse", "sr", tn, ds }, n, [&] {
+      bench_keep(p);
+      sum = T(sum ^ k_parse<T, sia80::mode::sr>(p, end, ibase));
+    });
+    bench_run({ "parse", "from_chars", "raw", tn, ds }, n, [&] {
+      bench_keep(p);
+      sum = T(sum ^ k_from_chars<T>(p, end, ibase));
+    });
+    if constexpr(sizeof(T) < 8) {
+      bench_run({ "parse", "from_chars_conv", "cx", tn, ds }, n, [&] {
+        bench_keep(p);
+        sum = T(sum ^ k_from_chars_conv<T>(p, end, ibase));
+      });
+    }
+    bench_run({ "parse", "strtol", "raw", tn, ds }, n, [&] {
+      bench_keep(p);
+      sum = T(sum ^ k_strtol<T>(p, end, ibase));
+    });
+    bench_keep(sum);
+  }
+
+} // namespace
+
+void bench_parse()
+{
+  run_type<std::int32_t>("short", 10, false);
+  run_type<std::int32_t>("long", 10, true);
+  run_type<std::int64_t>("short", 10, false);
+  run_type<std::int64_t>("long", 10, true);
+  run_type<std::uint64_t>("long", 10, true);
+  run_type<std::uint64_t>("hex", 16, true);
+}
@@ -0,0 +1,116 @@
+#include "bench_common.hxx"
+#include <safe_int_range_80.hxx>
+#include <vector>
+
+// Stencils with computed offsets of index type T: 5 points on a 2D
+// grid and 7 points on a 3D grid, with plain operators ("raw", which
+// is undefined behaviour on overflow), cx_mul/cx_add at each access
+// ("cx") and a proven_index made before the loops ("tr", tr_mul and
+// tr_add inside).
+
+namespace {
+
+  template <int M, class T>
+  BENCH_NOINLINE void k_2d(float *out, const float *in, T rows, T cols)
+  {
+    using namespace sia80;
+    const T ld = cols;
+    const auto g = cx_prove_2d(rows, cols, ld);
+    for (T i = 1; i < rows - 1; ++i) {
+      for (T j = 1; j < cols - 1; ++j) {
+        if constexpr(M == 0) {
+          out[i * ld + j] = in[(i - 1) * ld + j] + in[(i + 1) * ld + j] +
+              in[i * ld + j - 1] + in[i * ld + j + 1] - 4 * in[i * ld + j];
+        }
+        else if constexpr(M == 1) {
+          out[cx_add(cx_mul(i, ld), j)] = in[cx_add(cx_mul(cx_sub(i, T(1)), ld), j)] +
+              in[cx_add(cx_mul(cx_add(i, T(1)), ld), j)] +
+              in[cx_add(cx_mul(i, ld), cx_sub(j, T(1)))] +
+              in[cx_add(cx_mul(i, ld), cx_add(j, T(1)))] -
+              4 * in[cx_add(cx_mul(i, ld), j)];
+        }
+        else {
+          out[g(i, j)] = in[g(i - 1, j)] + in[g(i + 1, j)] +
+              in[g(i, j - 1)] + in[g(i, j + 1)] - 4 * in[g(i, j)];
+        }
+      }
+    }
+  }
+
+  template <int M, class T>
+  BENCH_NOINLINE void k_3d(float *out, const float *in, T n)
+  {
+    using namespace sia80;
+    const T ldy = n;
+    const T ldz = n * n;
+    const auto g = cx_prove_3d(n, n, n, ldy, ldz);
+    auto cxi = [&](T k, T i, T j) {
+      return cx_add(cx_add(cx_mul(k, ldz), cx_mul(i, ldy)), j);
+    };
+    for (T k = 1; k < n - 1; ++k) {
+      for (T i = 1; i < n - 1; ++i) {
+        for (T j = 1; j < n - 1; ++j) {
+          if constexpr(M == 0) {
+            const T c = k * ldz + i * ldy + j;
+            out[c] = in[c - ldz] + in[c + ldz] + in[c - ldy] + in[c + ldy] +
+                in[c - 1] + in[c + 1] - 6 * in[c];
+          }
+          else if constexpr(M == 1) {
+            out[cxi(k, i, j)] = in[cxi(k - 1, i, j)] + in[cxi(k + 1, i, j)] +
+                in[cxi(k, i - 1, j)] + in[cxi(k, i + 1, j)] +
+                in[cxi(k, i, j - 1)] + in[cxi(k, i, j + 1)] - 6 * in[cxi(k, i, j)];
+          }
+          else {
+            out[g(k, i, j)] = in[g(k - 1, i, j)] + in[g(k + 1, i, j)] +
+                in[g(k, i - 1, j)] + in[g(k, i + 1, j)] +
+                in[g(k, i, j - 1)] + in[g(k, i, j + 1)] - 6 * in[g(k, i, j)];
+          }
+        }
+      }
+    }
+  }
+
+  template <class T>
+  void run_type()
+  {
+    const char *tn = bench_type_name<T>();
+    {
+      INPUT T rows = 256;
+      INPUT T cols = 256;
+      std::vector<float> in(std::size_t(rows) * cols, 1.5f), out(in.size());
+      const double nops = double(rows - 2) * (cols - 2);
+      bench_run({ "range", "stencil2d", "raw", tn, "256x256" }, nops, [&] {
+        k_2d<0>(out.data(), in.data(), T(rows), T(cols));
+      });
+      bench_run({ "range", "stencil2d", "cx", tn, "256x256" }, nops, [&] {
+        k_2d<1>(out.data(), in.data(), T(rows), T(cols));
+      });
+      bench_run({ "range", "stencil2d", "tr", tn, "256x256" }, nops, [&] {
+        k_2d<2>(out.data(), in.data(), T(rows), T(cols));
+      });
+      bench_keep(out[300]);
+    }
+    {
+      INPUT T n = 40;
+      std::vector<float> in(std::size_t(n) * n * n, 1.5f), out(in.size());
+      const double nops = double(n - 2) * (n - 2) * (n - 2);
+      bench_run({ "range", "stencil3d", "raw", tn, "40^3" }, nops, [&] {
+        k_3d<0>(out.data(), in.data(), T(n));
+      });
+      bench_run({ "range", "stencil3d", "cx", tn, "40^3" }, nops, [&] {
+        k_3d<1>(out.data(), in.data(), T(n));
+      });
+      bench_run({ "range", "stencil3d", "tr", tn, "40^3" }, nops, [&] {
+        k_3d<2>(out.data(), in.data(), T(n));
+      });
+      bench_keep(out[3000]);
+    }
+  }
+
+} // namespace
+
+void bench_range()
+{
+  run_type<std::int32_t>();
+  run_type<std::int64_t>();
+}
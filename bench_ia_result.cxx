@@ -0,0 +1,118 @@
+#include "bench_common.hxx"
+#include <safe_int_arith_80.hxx>
+#include <safe_int_result_80.hxx>
+#include <cstdio>
+#include <vector>
+
+// Cost of the failure path: each element is checked, a failed one
+// is replaced by 0 and counted, as a parser of hostile input does.
+//   "cx": cx_xxx in try/catch around each element;
+//   ex_xxx (result<T>), and cf_xxx (cf_result) for reference.
+// Ops: add of int32, div of int64 (failing by 0), conv int64 to int16.
+// Datasets "fN": N percent of the elements fail, spread evenly.
+
+namespace {
+
+  constexpr std::size_t n = 4096;
+
+  enum { k_cx, k_ex, k_cf };
+
+  enum { o_add, o_div, o_conv };
+
+  template <int O, typename T>
+  struct op_of;
+
+  template <typename T>
+  struct op_of<o_add, T> {
+    using TR = T;
+    static TR cx(T a, T b) { return sia80::cx_add(a, b); }
+    static sia80::result<TR> ex(T a, T b) { return sia80::ex_add(a, b); }
+    static sia80::cf_result<TR> cf(T a, T b) { return sia80::cf_add(a, b); }
+  };
+
+  template <typename T>
+  struct op_of<o_div, T> {
+    using TR = T;
+    static TR cx(T a, T b) { return sia80::cx_div(a, b); }
+    static sia80::result<TR> ex(T a, T b) { return sia80::ex_div(a, b); }
+    static sia80::cf_result<TR> cf(T a, T b) { return sia80::cf_div(a, b); }
+  };
+
+  template <typename T>
+  struct op_of<o_conv, T> {
+    using TR = std::int16_t;
+    static TR cx(T a, T) { return sia80::cx_conv<TR>(a); }
+    static sia80::result<TR> ex(T a, T) { return sia80::ex_conv<TR>(a); }
+    static sia80::cf_result<TR> cf(T a, T) { return sia80::cf_conv<TR>(a); }
+  };
+
+  template <int K, int O, typename T>
+  BENCH_NOINLINE std::size_t k_run(typename op_of<O, T>::TR *out, const T *a, const T *b)
+  {
+    using P = op_of<O, T>;
+    std::size_t nfail = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == k_cx) {
+        try {
+          out[i] = P::cx(a[i], b[i]);
+        }
+        catch (std::exception&) {
+          out[i] = 0;
+          ++nfail;
+        }
+      }
+      else if constexpr(K == k_ex) {
+        const auto r = P::ex(a[i], b[i]);
+        out[i] = r.value_or(0);
+        nfail += !r;
+      }
+      else {
+        const auto r = P::cf(a[i], b[i]);
+        out[i] = r.overflowed ? 0 : r.value;
+        nfail += r.overflowed;
+      }
+    }
+    return nfail;
+  }
+
+  template <int O, typename T>
+  void bench_op(const char *op)
+  {
+    using TR = typename op_of<O, T>::TR;
+    const char *tn = bench_type_name<T>();
+    std::vector<T> a(n), b(n);
+    std::vector<TR> out(n);
+    for (unsigned pct : { 0, 1, 10, 100 }) {
+      rng r { 11 + pct };
+      for (std::size_t i = 0; i < n; ++i) {
+        const std::uint64_t x = r.next();
+        const bool fail = i * pct / 100 != (i + 1) * pct / 100;
+        const T small = T(std::int64_t(x) >> 52);
+        a[i] = O == o_add && fail ? sia80::ia_limits<T>::max() - small / 2 :
+            O == o_conv && fail ? T((small | 1) * 100000) : small;
+        b[i] = O == o_div ? (fail ? T(0) : T(small | 1)) :
+            O == o_add && fail ? T(sia80::ia_limits<T>::max() / 2 + 2048) : T(small);
+      }
+      char ds[8];
+      std::snprintf(ds, sizeof(ds), "f%u", pct);
+      bench_run({ "result", op, "cx", tn, ds }, n, [&] {
+        bench_keep(k_run<k_cx, O>(out.data(), a.data(), b.data()));
+      });
+      bench_run({ "result", op, "ex", tn, ds }, n, [&] {
+        bench_keep(k_run<k_ex, O>(out.data(), a.data(), b.data()));
+      });
+      bench_run({ "result", op, "cf", tn, ds }, n, [&] {
+        bench_keep(k_run<k_cf, O>(out.data(), a.data(), b.data()));
+      });
+      bench_keep(out[n - 1]);
+    }
+  }
+
+} // namespace
+
+void bench_result()
+{
+  bench_op<o_add, std::int32_t>("add");
+  bench_op<o_div, std::int64_t>("div");
+  bench_op<o_conv, std::int64_t>("conv");
+}
@@ -0,0 +1,112 @@
+// Built twice: as is, with telemetry, and as bench_ia_telemetry_off.o
+// with -DSIA80_TELEMETRY=0 (see Makefile). The kernels are the same;
+// modes with telemetry are named tm_xxx.
+#ifndef SIA80_TELEMETRY
+#define SIA80_TELEMETRY 1
+#endif
+#include "bench_common.hxx"
+#include <vector>
+
+// Cost of overflow telemetry: sr_add, sr_add(..., branchless),
+// cf_add with the flag and with overflow_sticky ("cfp"), sr_mul,
+// on loops of out[i] = op(a[i], b[i]).
+// Datasets are the fraction of overflowing elements, at random:
+// none, rare (1%), p25, random (50%). On "none", the difference
+// is the cost of the instrumentation in the code; on the others,
+// that plus the counting of each event.
+
+namespace {
+
+  enum { k_sr, k_srb, k_cf, k_cfp, k_sr_mul };
+
+  template <int K, class T>
+  BENCH_NOINLINE bool kernel(T *out, const INPUT T *a, const INPUT T *b,
+      std::size_t n, int *flag)
+  {
+    sia80::overflow_sticky ovf;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(K == k_sr) {
+        out[i] = sia80::sr_add(a[i], b[i]);
+      }
+      else if constexpr(K == k_srb) {
+        out[i] = sia80::sr_add(a[i], b[i], sia80::branchless);
+      }
+      else if constexpr(K == k_cf) {
+        out[i] = sia80::cf_add(a[i], b[i], flag);
+      }
+      else if constexpr(K == k_cfp) {
+        out[i] = ovf.add(a[i], b[i]);
+      }
+      else {
+        out[i] = sia80::sr_mul(a[i], b[i]);
+      }
+    }
+    return ovf.overflowed();
+  }
+
+  template <class T>
+  void run_type(const char *ds, unsigned fail_per_1000)
+  {
+#if SIA80_TELEMETRY
+#define TM_MODE(m) "tm_" m
+#else
+#define TM_MODE(m) m
+#endif
+    constexpr std::size_t n = 4096;
+    std::vector<T> a(n), b(n), am(n), bm(n), out(n);
+    rng r { 777 };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      const bool fail = (x >> 33) % 1000 < fail_per_1000;
+      const T small = T((x >> 20) & 0xff);
+      // add: near the maximum plus more than the rest.
+      a[i] = fail ? T(std::numeric_limits<T>::max() - small) : small;
+      b[i] = fail ? T(small + 1000) : T(small + 1);
+      // mul: half width each, or more for a failure.
+      am[i] = fail ? T(std::numeric_limits<T>::max() / 4 + small) : small;
+      bm[i] = T(4);
+    }
+    const char *tn = bench_type_name<T>();
+    int flag = 0;
+    bool sticky = false;
+    bench_run({ "telemetry", "add", TM_MODE("sr"), tn, ds }, n, [&] {
+      kernel<k_sr>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_run({ "telemetry", "add", TM_MODE("srb"), tn, ds }, n, [&] {
+      kernel<k_srb>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_run({ "telemetry", "add", TM_MODE("cf"), tn, ds }, n, [&] {
+      kernel<k_cf>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_run({ "telemetry", "add", TM_MODE("cfp"), tn, ds }, n, [&] {
+      sticky |= kernel<k_cfp>(out.data(), a.data(), b.data(), n, &flag);
+    });
+    bench_run({ "telemetry", "mul", TM_MODE("sr"), tn, ds }, n, [&] {
+      kernel<k_sr_mul>(out.data(), am.data(), bm.data(), n, &flag);
+    });
+#undef TM_MODE
+    bench_keep(out[n - 1]);
+    bench_keep(flag);
+    bench_keep(sticky);
+  }
+
+  template <class T>
+  void run_datasets()
+  {
+    run_type<T>("none", 0);
+    run_type<T>("rare", 10);
+    run_type<T>("p25", 250);
+    run_type<T>("random", 500);
+  }
+
+} // namespace
+
+#if SIA80_TELEMETRY
+void bench_telemetry()
+#else
+void bench_telemetry_off()
+#endif
+{
+  run_datasets<std::int32_t>();
+  run_datasets<std::int64_t>();
+}
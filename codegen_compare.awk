@@ -0,0 +1,42 @@
+# Usage: awk -v label=... -f codegen_compare.awk baseline current
+# Both are codegen_count.awk output (the baseline may have # comments).
+# Fails if a function has more instructions, branches or calls than
+# its baseline, or is missing on either side.
+
+FNR == NR {
+  if ($0 !~ /^#/ && NF == 4) {
+    base[$1] = $2 " " $3 " " $4;
+  }
+  next;
+}
+
+{
+  ++total;
+  seen[$1] = 1;
+  if (!($1 in base)) {
+    printf "%s: %s: no baseline\n", label, $1;
+    ++failed;
+    next;
+  }
+  split(base[$1], b, " ");
+  if ($2 > b[1] || $3 > b[2] || $4 > b[3]) {
+    printf "%s: %s: insns/branches/calls %d/%d/%d, baseline %d/%d/%d\n",
+        label, $1, $2, $3, $4, b[1], b[2], b[3];
+    ++failed;
+  }
+  else if ($2 < b[1] || $3 < b[2] || $4 < b[3]) {
+    printf "%s: %s: better than baseline: %d/%d/%d, was %d/%d/%d\n",
+        label, $1, $2, $3, $4, b[1], b[2], b[3];
+  }
+}
+
+END {
+  for (f in base) {
+    if (!(f in seen)) {
+      printf "%s: %s: in baseline, not built\n", label, f;
+      ++failed;
+    }
+  }
+  printf "%s: %d functions, %d failed\n", label, total, failed;
+  exit failed > 0;
+}
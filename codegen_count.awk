@@ -0,0 +1,77 @@
+# Hot path shape of the cg_xxx functions in objdump -dr output:
+# one line "name insns branches calls" per function.
+#
+# The hot path is the code from the entry up to the last ret: GCC
+# moves unlikely paths to name.cold (not counted), Clang puts them
+# after the last ret. Without a ret (a tail call), all but the final
+# padding. Branches are all jumps; calls are calls and tail jumps to
+# other functions (by the relocation of the jump).
+
+function flush(    i, last, insns, branches, calls)
+{
+  if (fn == "") {
+    return;
+  }
+  last = 0;
+  for (i = 1; i <= n; ++i) {
+    if (op[i] ~ /^ret/) {
+      last = i;
+    }
+  }
+  if (last == 0) {
+    last = n;
+    while (last > 0 && (op[last] ~ /^(nop|int3|xchg|data16|cs)/)) {
+      --last;
+    }
+  }
+  insns = branches = calls = 0;
+  for (i = 1; i <= last; ++i) {
+    ++insns;
+    if (op[i] ~ /^call/ || (op[i] ~ /^jmp/ && ext[i])) {
+      ++calls;
+    }
+    else if (op[i] ~ /^j/) {
+      ++branches;
+    }
+  }
+  printf "%s %d %d %d\n", fn, insns, branches, calls;
+  fn = "";
+}
+
+/^[0-9a-f]+ <.*>:$/ {
+  flush();
+  name = $2;
+  gsub(/[<>:]/, "", name);
+  # Only our functions, not their .cold parts.
+  if (name ~ /^cg_/ && name !~ /\./) {
+    fn = name;
+    n = 0;
+  }
+  next;
+}
+
+fn != "" && /^ +[0-9a-f]+:\t/ {
+  text = $0;
+  sub(/^ +[0-9a-f]+:\t/, "", text);
+  split(text, w, /[ \t]+/);
+  k = 1;
+  while (w[k] ~ /^(bnd|notrack|rep|repz|repnz|lock|ds)$/) {
+    ++k;
+  }
+  op[++n] = w[k];
+  ext[n] = 0;
+  next;
+}
+
+# Relocation of the last instruction: a jump out of .text is a tail
+# call (jumps to .text.unlikely are branches to the cold part).
+fn != "" && /R_X86_64_(PLT32|PC32)/ {
+  if (n > 0 && op[n] ~ /^jmp/ && $3 !~ /^\.text/) {
+    ext[n] = 1;
+  }
+  next;
+}
+
+END {
+  flush();
+}
@@ -0,0 +1,218 @@
+// Instantiations whose code shape is pinned by make codegen-check:
+// each op in each mode for each type, as an extern "C" function
+// cg_<mode>_<op>_<type>, so the names in the disassembly are plain.
+// Modes: cx, cf (flag), cfp (cf_result), tr, sr, srb (branchless sr).
+// conv is to int16 (conv_s16) and uint16 (conv_u16); qmul is Q16.16
+// and Q32.32 (with rounding to nearest and to even); parse is
+// decimal, with the value only; bd_xxx are bounded operations, which
+// are plain (markup, shl) or fall back to cx_add and sr_add (add, sradd),
+// and the check of the construction (in); fetch_add is on std::atomic;
+// pow has an unsigned exp; muldiv truncates (muldiv_near: to nearest);
+// ex_xxx (mode ex) return result<T>; xp_xxx are xx_eval of a formula
+// of four operands to the same type (dot2: a * b + c * d, cross:
+// a * d - b * c, dot3: a * c + b * d + c * d) and the markup of
+// bounded operands.
+//
+// Only the hot path is counted (see codegen_count.awk): the throws
+// of cx_xxx and other unlikely paths should be out of it.
+#include <safe_int_arith_80.hxx>
+#include <safe_int_atomic_80.hxx>
+#include <safe_int_bounded_80.hxx>
+#include <safe_int_expr_80.hxx>
+#include <safe_int_fixed_80.hxx>
+#include <safe_int_math_80.hxx>
+#include <safe_int_muldiv_80.hxx>
+#include <safe_int_parse_80.hxx>
+#include <safe_int_result_80.hxx>
+#include <cstdint>
+
+using int32 = std::int32_t;
+using uint32 = std::uint32_t;
+using int64 = std::int64_t;
+using uint64 = std::uint64_t;
+#if defined(__SIZEOF_INT128__)
+using int128 = __int128;
+using uint128 = unsigned __int128;
+#endif
+
+using sia80::cf_result;
+using sia80::branchless;
+using sia80::result;
+using sia80::xc;
+using sia80::xv;
+
+// The expression is last, as it may have commas.
+#define CG_FN(mode, op, T, TR, args, ...) \
+  extern "C" TR cg_##mode##_##op##_##T args { return sia80::__VA_ARGS__; }
+
+// add, sub, mul: all modes.
+#define CG_ARITH(op, T) \
+  CG_FN(cx, op, T, T, (T a, T b), cx_##op(a, b)) \
+  CG_FN(cf, op, T, T, (T a, T b, int *flag), cf_##op(a, b, flag)) \
+  CG_FN(cfp, op, T, cf_result<T>, (T a, T b), cf_##op(a, b)) \
+  CG_FN(tr, op, T, T, (T a, T b), tr_##op(a, b)) \
+  CG_FN(sr, op, T, T, (T a, T b), sr_##op(a, b)) \
+  CG_FN(srb, op, T, T, (T a, T b), sr_##op(a, b, branchless))
+
+// div, rem: no branchless sr.
+#define CG_DIV(op, T) \
+  CG_FN(cx, op, T, T, (T a, T b), cx_##op(a, b)) \
+  CG_FN(cf, op, T, T, (T a, T b, int *flag), cf_##op(a, b, flag)) \
+  CG_FN(cfp, op, T, cf_result<T>, (T a, T b), cf_##op(a, b)) \
+  CG_FN(tr, op, T, T, (T a, T b), tr_##op(a, b)) \
+  CG_FN(sr, op, T, T, (T a, T b), sr_##op(a, b))
+
+#define CG_SHIFT(T) \
+  CG_FN(cx, shl, T, T, (T a, int c), cx_shl(a, c)) \
+  CG_FN(cf, shl, T, T, (T a, int c, int *flag), cf_shl(a, c, flag)) \
+  CG_FN(cfp, shl, T, cf_result<T>, (T a, int c), cf_shl(a, c)) \
+  CG_FN(tr, shl, T, T, (T a, int c), tr_shl(a, c)) \
+  CG_FN(sr, shl, T, T, (T a, int c), sr_shl(a, c)) \
+  CG_FN(srb, shl, T, T, (T a, int c), sr_shl(a, c, branchless)) \
+  CG_FN(cx, shr, T, T, (T a, int c), cx_shr(a, c)) \
+  CG_FN(cf, shr, T, T, (T a, int c, int *flag), cf_shr(a, c, flag)) \
+  CG_FN(cfp, shr, T, cf_result<T>, (T a, int c), cf_shr(a, c)) \
+  CG_FN(tr, shr, T, T, (T a, int c), tr_shr(a, c)) \
+  CG_FN(sr, shr, T, T, (T a, int c), sr_shr(a, c)) \
+  CG_FN(cx, shrx, T, T, (T a, int c), cx_shrx(a, c)) \
+  CG_FN(cf, shrx, T, T, (T a, int c, int *flag), cf_shrx(a, c, flag)) \
+  CG_FN(cfp, shrx, T, cf_result<T>, (T a, int c), cf_shrx(a, c)) \
+  CG_FN(tr, shrx, T, T, (T a, int c), tr_shrx(a, c))
+
+#define CG_CONV(T, name, TR) \
+  CG_FN(cx, name, T, TR, (T a), cx_conv<TR>(a)) \
+  CG_FN(cf, name, T, TR, (T a, int *flag), cf_conv<TR>(a, flag)) \
+  CG_FN(cfp, name, T, cf_result<TR>, (T a), cf_conv<TR>(a)) \
+  CG_FN(tr, name, T, TR, (T a), tr_conv<TR>(a)) \
+  CG_FN(sr, name, T, TR, (T a), sr_conv<TR>(a)) \
+  CG_FN(srb, name, T, TR, (T a), sr_conv<TR>(a, branchless))
+
+#define CG_FIT(T) \
+  CG_FN(cx, ufit, T, T, (T a, unsigned n), cx_ufit(a, n)) \
+  CG_FN(cf, ufit, T, T, (T a, unsigned n, int *flag), cf_ufit(a, n, flag)) \
+  CG_FN(cfp, ufit, T, cf_result<T>, (T a, unsigned n), cf_ufit(a, n)) \
+  CG_FN(tr, ufit, T, T, (T a, unsigned n), tr_ufit(a, n)) \
+  CG_FN(sr, ufit, T, T, (T a, unsigned n), sr_ufit(a, n)) \
+  CG_FN(cx, sfit, T, T, (T a, unsigned n), cx_sfit(a, n)) \
+  CG_FN(cf, sfit, T, T, (T a, unsigned n, int *flag), cf_sfit(a, n, flag)) \
+  CG_FN(cfp, sfit, T, cf_result<T>, (T a, unsigned n), cf_sfit(a, n)) \
+  CG_FN(tr, sfit, T, T, (T a, unsigned n), tr_sfit(a, n)) \
+  CG_FN(sr, sfit, T, T, (T a, unsigned n), sr_sfit(a, n))
+
+// Q multiplication with F = half width.
+#define CG_QMUL(T, F) \
+  CG_FN(cx, qmul, T, T, (T a, T b), cx_qmul<F>(a, b)) \
+  CG_FN(cf, qmul, T, T, (T a, T b, int *flag), cf_qmul<F>(a, b, flag)) \
+  CG_FN(cfp, qmul, T, cf_result<T>, (T a, T b), cf_qmul<F>(a, b)) \
+  CG_FN(tr, qmul, T, T, (T a, T b), tr_qmul<F>(a, b)) \
+  CG_FN(sr, qmul, T, T, (T a, T b), sr_qmul<F>(a, b)) \
+  CG_FN(srb, qmul, T, T, (T a, T b), sr_qmul<F>(a, b, branchless)) \
+  CG_FN(tr, qmul_even, T, T, (T a, T b), tr_qmul<F, sia80::rounding::even>(a, b))
+
+#define CG_PARSE(T) \
+  CG_FN(cx, parse, T, T, (const char *p, const char *e), parse<T>(p, e).value) \
+  CG_FN(sr, parse, T, T, (const char *p, const char *e), parse<T, sia80::mode::sr>(p, e).value)
+
+#define CG_ATOMIC(T) \
+  CG_FN(cx, fetch_add, T, T, (std::atomic<T>& a, T v), cx_fetch_add(a, v)) \
+  CG_FN(cf, fetch_add, T, T, (std::atomic<T>& a, T v, int *flag), cf_fetch_add(a, v, flag)) \
+  CG_FN(sr, fetch_add, T, T, (std::atomic<T>& a, T v), sr_fetch_add(a, v))
+
+// neg, abs, pow (with an unsigned exp), gcd, lcm: the modes whose
+// code differs.
+#define CG_MATH(T) \
+  CG_FN(cx, neg, T, T, (T a), cx_neg(a)) \
+  CG_FN(sr, neg, T, T, (T a), sr_neg(a)) \
+  CG_FN(cx, abs, T, T, (T a), cx_abs(a)) \
+  CG_FN(cx, pow, T, T, (T a, unsigned e), cx_pow(a, e)) \
+  CG_FN(cf, pow, T, T, (T a, unsigned e, int *flag), cf_pow(a, e, flag)) \
+  CG_FN(sr, pow, T, T, (T a, unsigned e), sr_pow(a, e)) \
+  CG_FN(cx, gcd, T, T, (T a, T b), cx_gcd(a, b)) \
+  CG_FN(cx, lcm, T, T, (T a, T b), cx_lcm(a, b)) \
+  CG_FN(sr, lcm, T, T, (T a, T b), sr_lcm(a, b))
+
+#define CG_MULDIV(T) \
+  CG_FN(cx, muldiv, T, T, (T a, T b, T c), cx_muldiv(a, b, c)) \
+  CG_FN(cf, muldiv, T, T, (T a, T b, T c, int *flag), cf_muldiv(a, b, c, flag)) \
+  CG_FN(sr, muldiv, T, T, (T a, T b, T c), sr_muldiv(a, b, c)) \
+  CG_FN(cx, muldiv_near, T, T, (T a, T b, T c), cx_muldiv<sia80::rounding::nearest>(a, b, c))
+
+// ex_xxx: an op of each kind of error.
+#define CG_EX(T) \
+  CG_FN(ex, add, T, result<T>, (T a, T b), ex_add(a, b)) \
+  CG_FN(ex, mul, T, result<T>, (T a, T b), ex_mul(a, b)) \
+  CG_FN(ex, div, T, result<T>, (T a, T b), ex_div(a, b)) \
+  CG_FN(ex, shl, T, result<T>, (T a, int c), ex_shl(a, c)) \
+  CG_FN(ex, shrx, T, result<T>, (T a, int c), ex_shrx(a, c)) \
+  CG_FN(ex, conv_s16, T, result<std::int16_t>, (T a), ex_conv<std::int16_t>(a)) \
+  CG_FN(ex, sfit, T, result<T>, (T a, unsigned n), ex_sfit(a, n))
+
+// xx_eval: of int32, cross in int64, dot2 with the int64 root, dot3 in
+// __int128; of int64, cross in __int128, dot2 and dot3 the fallback.
+#define CG_XP(T) \
+  CG_FN(cx, xp_dot2, T, T, (T a, T b, T c, T d), cx_eval<T>(xv(a) * b + xv(c) * d)) \
+  CG_FN(cf, xp_dot2, T, T, (T a, T b, T c, T d, int *flag), \
+      cf_eval<T>(xv(a) * b + xv(c) * d, flag)) \
+  CG_FN(sr, xp_dot2, T, T, (T a, T b, T c, T d), sr_eval<T>(xv(a) * b + xv(c) * d)) \
+  CG_FN(cx, xp_cross, T, T, (T a, T b, T c, T d), cx_eval<T>(xv(a) * d - xv(b) * c)) \
+  CG_FN(cx, xp_dot3, T, T, (T a, T b, T c, T d), cx_eval<T>(xv(a) * c + xv(b) * d + xv(c) * d))
+
+#define CG_BD(op, T, args, ...) \
+  extern "C" T cg_bd_##op##_##T args { return (__VA_ARGS__).value(); }
+
+using bd_byte = sia80::bounded<int32, 0, 255>;
+using bd_pct = sia80::bounded<int32, 0, 100>;
+using bd_cnt = sia80::bounded<int32, 0, 23>;
+using bd_big = sia80::bounded<int32, 0, INT32_MAX>;
+using bd_srbig = sia80::bounded<int32, 0, INT32_MAX, sia80::mode::sr>;
+using bd_srpct = sia80::bounded<int32, 0, 100, sia80::mode::sr>;
+
+#define CG_TYPE(T) \
+  CG_ARITH(add, T) \
+  CG_ARITH(sub, T) \
+  CG_ARITH(mul, T) \
+  CG_DIV(div, T) \
+  CG_DIV(rem, T) \
+  CG_SHIFT(T) \
+  CG_CONV(T, conv_s16, std::int16_t) \
+  CG_CONV(T, conv_u16, std::uint16_t) \
+  CG_FIT(T)
+
+CG_TYPE(int32)
+CG_TYPE(uint32)
+CG_TYPE(int64)
+CG_TYPE(uint64)
+CG_QMUL(int32, 16)
+CG_QMUL(uint32, 16)
+CG_QMUL(int64, 32)
+CG_QMUL(uint64, 32)
+CG_PARSE(int32)
+CG_PARSE(uint32)
+CG_PARSE(int64)
+CG_PARSE(uint64)
+CG_ATOMIC(int32)
+CG_ATOMIC(uint64)
+CG_MATH(int64)
+CG_MATH(uint64)
+CG_MULDIV(int32)
+CG_MULDIV(int64)
+CG_MULDIV(uint64)
+CG_EX(int32)
+CG_EX(uint32)
+CG_EX(int64)
+CG_EX(uint64)
+CG_BD(markup, int32, (int32 a, int32 p),
+    bd_byte::unchecked(a) * (sia80::bconst<100> + bd_pct::unchecked(p)) / sia80::bconst<100>)
+CG_BD(shl, uint32, (uint32 v, int32 c),
+    sia80::bounded<uint32, 0, 255>::unchecked(v) << bd_cnt::unchecked(c))
+CG_BD(add, int32, (int32 a, int32 b), bd_big::unchecked(a) + bd_pct::unchecked(b))
+CG_BD(sradd, int32, (int32 a, int32 b), bd_srbig::unchecked(a) + bd_srpct::unchecked(b))
+CG_BD(in, int32, (int32 v), bd_pct(v))
+CG_XP(int32)
+CG_XP(int64)
+CG_FN(cx, xp_markup, int32, int32, (int32 a, int32 p),
+    cx_eval<int32>(xv(bd_byte::unchecked(a)) * (xc<100> + xv(bd_pct::unchecked(p))) / xc<100>))
+#if defined(__SIZEOF_INT128__)
+CG_TYPE(int128)
+CG_TYPE(uint128)
+#endif
@@ -0,0 +1,240 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+// Arena (bump) allocator with checked size arithmetic.
+//
+//   sia80::arena a;
+//   int *v = a.alloc_array<int>(n);   // std::bad_array_new_length
+//                                     // if n * sizeof(int) overflows
+//   std::pmr::vector<int> w(&a);      // as a memory_resource
+//   a.release();                      // everything at once
+//
+// Memory is taken from an upstream memory_resource in chunks (the
+// first one may be a buffer given to the constructor) and handed out
+// in order; deallocation does nothing, release() returns all chunks.
+// Chunk sizes double from chunk_size up to max_chunk, and a larger
+// request gets a chunk of its own size.
+//
+// alloc(bytes, align): bytes aligned by align (a power of 2).
+// alloc_array<T>(n): uninitialized room for n objects of T.
+//   The fast path is one comparison: n * sizeof(T) plus the alignment
+//   padding, in a type twice as wide as size_t (where there is one),
+//   against the room left in the chunk; so it both checks overflow
+//   and fit. An arena with no room (at the start, it has no buffer)
+//   always refills, so that even alloc(0) is not null.
+// alloc_flex<H, T>(n): room for H followed by n objects of T (a header
+//   with a trailing array), returned as H *; the tail is at
+//   flex_tail<H, T>(h).
+// All sizes (count * size, + header, + padding, chunk size) are
+// computed with cf_xxx; an overflow throws std::bad_array_new_length
+// (a std::bad_alloc, as allocators are expected to throw). Failures
+// of the upstream resource pass through.
+//
+// Not thread safe: one arena per thread or per task.
+
+namespace sia80 {
+
+  class arena : public std::pmr::memory_resource {
+  public:
+    static constexpr std::size_t default_chunk = 4096;
+    static constexpr std::size_t max_chunk = std::size_t(1) << 24;
+
+    explicit arena(std::size_t chunk_size = default_chunk,
+        std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : upstream_(upstream)
+      , buf_(nullptr)
+      , buf_end_(nullptr)
+      , cur_(nullptr)
+      , end_(nullptr)
+      , next_size_(chunk_size < min_chunk ? min_chunk : chunk_size)
+      , first_size_(next_size_)
+    {
+    }
+
+    // The buffer is used first; it is not freed.
+    arena(void *buf, std::size_t size,
+        std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+      : upstream_(upstream)
+      , buf_(static_cast<char *>(buf))
+      , buf_end_(static_cast<char *>(buf) + size)
+      , cur_(buf_)
+      , end_(buf_end_)
+      , next_size_(size < default_chunk ? default_chunk : size)
+      , first_size_(next_size_)
+    {
+    }
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    ~arena() override
+    {
+      release();
+    }
+
+    void *alloc(std::size_t bytes, std::size_t align = alignof(std::max_align_t))
+    {
+      const std::size_t pad = padding(align);
+      const std::size_t room = std::size_t(end_ - cur_);
+      // pad <= room first, so room - pad doesn't wrap. No room at all
+      // (also the null pointers of an empty arena) always refills, so
+      // that even alloc(0) is not null.
+      if (SIA80_UNLIKELY((pad > room) | (bytes > room - pad) | (room == 0))) {
+        return refill(bytes, align);
+      }
+      char *p = cur_ + pad;
+      cur_ = p + bytes;
+      return p;
+    }
+
+    template <typename T>
+    T *alloc_array(std::size_t n)
+    {
+      const std::size_t pad = padding(alignof(T));
+      const std::size_t room = std::size_t(end_ - cur_);
+#if defined(__SIZEOF_INT128__) || SIZE_MAX <= UINT32_MAX
+      using W = std::conditional_t<(sizeof(std::size_t) <= 4), std::uint64_t, unsigned __int128>;
+      // Neither the product nor the sum can overflow W.
+      if (SIA80_UNLIKELY((W(n) * sizeof(T) + pad > room) | (room == 0))) {
+        return static_cast<T *>(refill(array_bytes<T>(n), alignof(T)));
+      }
+      char *p = cur_ + pad;
+      cur_ = p + n * sizeof(T);
+      return reinterpret_cast<T *>(p);
+#else
+      return static_cast<T *>(alloc(array_bytes<T>(n), alignof(T)));
+#endif
+    }
+
+    template <typename H, typename T>
+    H *alloc_flex(std::size_t n)
+    {
+      int flag = 0;
+      const std::size_t bytes = cf_add(flex_offset<H, T>(), cf_mul(n, sizeof(T), &flag), &flag);
+      if (SIA80_UNLIKELY(flag)) {
+        SIA80_CX_FAIL(bad_array_new_length, "arena: size overflow");
+      }
+      constexpr std::size_t align = alignof(H) > alignof(T) ? alignof(H) : alignof(T);
+      return static_cast<H *>(alloc(bytes, align));
+    }
+
+    template <typename H, typename T>
+    static T *flex_tail(H *h)
+    {
+      return reinterpret_cast<T *>(reinterpret_cast<char *>(h) + flex_offset<H, T>());
+    }
+
+    // Returns all chunks to upstream; the initial buffer is reused.
+    void release() noexcept
+    {
+      while (chunks_) {
+        chunk *c = chunks_;
+        chunks_ = c->prev;
+        upstream_->deallocate(c, c->size, alignof(chunk));
+      }
+      cur_ = buf_;
+      end_ = buf_end_;
+      next_size_ = first_size_;
+      upstream_bytes_ = 0;
+    }
+
+    // Bytes currently taken from upstream.
+    std::size_t upstream_bytes() const noexcept { return upstream_bytes_; }
+
+    std::pmr::memory_resource *upstream_resource() const noexcept { return upstream_; }
+
+  protected:
+    void *do_allocate(std::size_t bytes, std::size_t align) override
+    {
+      return alloc(bytes, align);
+    }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+      return this == &other;
+    }
+
+  private:
+    struct alignas(std::max_align_t) chunk {
+      chunk *prev;
+      std::size_t size;
+    };
+
+    static constexpr std::size_t min_chunk = 4 * sizeof(chunk);
+
+    std::size_t padding(std::size_t align) const
+    {
+      return std::size_t(0 - reinterpret_cast<std::uintptr_t>(cur_)) & (align - 1);
+    }
+
+    template <typename T>
+    static std::size_t array_bytes(std::size_t n)
+    {
+      const cf_result<std::size_t> r = cf_mul(n, sizeof(T));
+      if (SIA80_UNLIKELY(r.overflowed)) {
+        SIA80_CX_FAIL(bad_array_new_length, "arena: size overflow");
+      }
+      return r.value;
+    }
+
+    // H rounded up to the alignment of T.
+    template <typename H, typename T>
+    static constexpr std::size_t flex_offset()
+    {
+      return (sizeof(H) + alignof(T) - 1) & ~(alignof(T) - 1);
+    }
+
+    // A new chunk with room for bytes aligned by align, then the
+    // allocation from it.
+    [[gnu::noinline]] void *refill(std::size_t bytes, std::size_t align)
+    {
+      // Padding beyond the chunk alignment is at most align - 1.
+      int flag = 0;
+      const std::size_t extra = align > alignof(chunk) ? align - 1 : 0;
+      const std::size_t need = cf_add(cf_add(bytes, extra, &flag), sizeof(chunk), &flag);
+      if (SIA80_UNLIKELY(flag)) {
+        SIA80_CX_FAIL(bad_array_new_length, "arena: size overflow");
+      }
+      const std::size_t size = need > next_size_ ? need : next_size_;
+      chunk *c = static_cast<chunk *>(upstream_->allocate(size, alignof(chunk)));
+      c->prev = chunks_;
+      c->size = size;
+      chunks_ = c;
+      upstream_bytes_ += size;
+      if (next_size_ < max_chunk) {
+        const std::size_t twice = sr_mul(next_size_, std::size_t(2));
+        next_size_ = twice < max_chunk ? twice : max_chunk;
+      }
+      cur_ = reinterpret_cast<char *>(c + 1);
+      end_ = reinterpret_cast<char *>(c) + size;
+      char *p = cur_ + padding(align);
+      cur_ = p + bytes;
+      return p;
+    }
+
+    std::pmr::memory_resource *upstream_;
+    char *buf_;
+    char *buf_end_;
+    char *cur_;
+    char *end_;
+    chunk *chunks_ = nullptr;
+    std::size_t next_size_;
+    std::size_t first_size_;
+    std::size_t upstream_bytes_ = 0;
+  };
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
@@ -3,269 +3,804 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstring>
+#if __cplusplus >= 202002L && __has_include(<bit>)
+#include <bit>
+#endif
 #include <limits>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
 
 #define SIA80_UNLIKELY(x) __builtin_expect(long(x), 0)
 
+// Overflow telemetry (see safe_int_telemetry_80.hxx): with
+// SIA80_TELEMETRY defined to 1, cf_xxx and sr_xxx take the call site
+// as a trailing defaulted parameter and count their events.
+#ifndef SIA80_TELEMETRY
+#define SIA80_TELEMETRY 0
+#endif
+#if SIA80_TELEMETRY
+#include <safe_int_telemetry_80.hxx>
+#define SIA80_TM_SITE , ::sia80::tm_site tm_where = ::sia80::tm_site::current()
+#define SIA80_TM_PASS , tm_where
+#define SIA80_TM_EVENT(happened, op, md) \
+  ::sia80::tm_detail::event((happened), ::sia80::tm_op::op, ::sia80::mode::md, tm_where)
+#else
+#define SIA80_TM_SITE
+#define SIA80_TM_PASS
+#define SIA80_TM_EVENT(happened, op, md) ((void) 0)
+#endif
+
+// Failure policy of cx_xxx and of the other forms which throw (parse,
+// bounded, divider etc.), the same for the whole program:
+//   -DSIA80_CX_POLICY=SIA80_CX_THROW: throw the std exception, the
+//     default with exceptions enabled;
+//   SIA80_CX_TRAP: __builtin_trap() in place (ud2 on x86), the default
+//     with -fno-exceptions; the hot path is the op, jo and the trap;
+//   SIA80_CX_HANDLER: call sia80::cx_failure(kind, what), which the
+//     program defines and which doesn't return (abort, longjmp...);
+//   SIA80_CX_HOOK: call the function set by sia80::set_cx_hook(), e.g.
+//     to log; then (or without one) throw, or trap without exceptions.
+// Except for the trap, a failure is a call of a noinline cold function
+// with the kind (the std exception, as cx_fail) and the message; the
+// exception isn't constructed at the call site.
+#define SIA80_CX_THROW 0
+#define SIA80_CX_TRAP 1
+#define SIA80_CX_HANDLER 2
+#define SIA80_CX_HOOK 3
+#ifndef SIA80_CX_POLICY
+#if defined(__cpp_exceptions)
+#define SIA80_CX_POLICY SIA80_CX_THROW
+#else
+#define SIA80_CX_POLICY SIA80_CX_TRAP
+#endif
+#endif
+#if SIA80_CX_POLICY == SIA80_CX_THROW && !defined(__cpp_exceptions)
+#error "SIA80_CX_POLICY: SIA80_CX_THROW without exceptions"
+#endif
+#if SIA80_CX_POLICY == SIA80_CX_TRAP
+#define SIA80_CX_FAIL(kind, what) ((void) (what), __builtin_trap())
+#else
+#define SIA80_CX_FAIL(kind, what) ::sia80::cx_detail::fail<::sia80::cx_fail::kind>(what)
+#endif
+#if SIA80_CX_POLICY == SIA80_CX_HOOK
+#include <atomic>
+#endif
+
 // cx_xxx: checked versions - generate exception on error.
 // cf_xxx: checked-with-flag versions - set flag to 1 on error,
 //   the main result as for truncating.
+//   Without the flag argument, return cf_result {value, overflowed}
+//   instead; this keeps the flag in a register and doesn't make
+//   the compiler assume a store aliasing other data.
 // tr_xxx: truncating (wrapping) versions - maximum tolerance,
 //   return truncated version of infinitely precise value.
 // sr_xxx: saturating versions - maximum tolerance,
 //   return the closest value to the infinitely precise one.
+// sr_xxx(..., branchless): saturating versions without branches on
+//   overflow, for data where saturation is frequent and unpredictable
+//   (for sr_add, sr_sub, sr_mul, sr_conv, sr_shl). The result is the
+//   same. With SIA80_SR_BRANCHLESS defined to 1, these are used for
+//   sr_xxx without the tag as well.
+//   Measured on x86-64 (bench_ia ops/): add, sub, mul win from about
+//   25% of saturating inputs; conv and shl don't win at any rate.
+// Operands may be __int128 and unsigned __int128 (where the compiler
+// has them), also in strict standard modes: type checks use ia_xxx
+// traits instead of std::is_integral etc.
+// All of them are constexpr. In a constant expression, an error
+// in cx_xxx (that would throw) makes a compile error:
+//   static_assert(sia80::cx_mul(4096, 4096) == 1 << 24);
+//   constexpr int bad = sia80::cx_shl(1, 31); // error
 
 // xx_add: addition of two values.
 // xx_sub: subtraction of two values.
 // xx_mul: multiplication of two values.
+// cx_mul_wide: full 128-bit product of two values of 64 bits at most.
 // xx_div: T-division of two values, quotient of the result.
 // xx_rem: T-division of two values, remainder of the result.
 // xx_shl: left shift of the first value.
 //   Overflow depends on the first value type (signed or unsigned).
 // xx_shr: right shift of the first value.
 //   Shift type depends on the first value type (signed or unsigned).
+// xx_shrx: right shift as exact division by a power of 2: rounds
+//   toward zero; shifting out non-zero bits is an error.
 // xx_conv: conversion to the target type.
 //   Example: tr_conv<int8_t>(val)
 // xx_ufit: fitting to the specified number of bits as unsigned.
 // xx_sfit: fitting to the specified number of bits as signed.
+//   For both, tr_ gives the value a field of nbits holds after
+//   storing (the low bits; sign-extended for sfit), sr_ the bound
+//   of the field range. Nothing fits in 0 bits as signed.
 
 namespace sia80 {
 
-  // TODO: Add cf_xxx 2-argument variants with a thread-local flag.
   // TODO: Add sf_xxx Saturation with flag setting (explicit or thread-local).
-  // TODO: Add xx_shrx Exact division interpretation.
 
-  // Got from cppreference.com.
-  // Requires C++17. Not needed since C++20.
-  // TODO Use conditional include on C++ version.
+  // Type traits as std::is_integral, std::is_signed, std::make_unsigned
+  // and std::numeric_limits, which also know __int128 and unsigned
+  // __int128. The standard ones don't in strict modes (-std=c++17 as
+  // opposed to -std=gnu++17), and numeric_limits isn't specialized
+  // for them by all standard libraries.
+  template <typename T>
+  struct ia_is_integral : std::is_integral<T> {};
+  template <typename T>
+  struct ia_is_signed : std::is_signed<T> {};
+  template <typename T>
+  struct ia_make_unsigned : std::make_unsigned<T> {};
+  template <typename T>
+  struct ia_limits : std::numeric_limits<T> {};
+
+#if defined(__SIZEOF_INT128__)
+  template <>
+  struct ia_is_integral<__int128> : std::true_type {};
+  template <>
+  struct ia_is_integral<unsigned __int128> : std::true_type {};
+  template <>
+  struct ia_is_signed<__int128> : std::true_type {};
+  template <>
+  struct ia_is_signed<unsigned __int128> : std::false_type {};
+  template <>
+  struct ia_make_unsigned<__int128> { using type = unsigned __int128; };
+  template <>
+  struct ia_make_unsigned<unsigned __int128> { using type = unsigned __int128; };
+
+  template <>
+  struct ia_limits<unsigned __int128> {
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = false;
+    static constexpr int digits = 128;
+    static constexpr unsigned __int128 min() { return 0; }
+    static constexpr unsigned __int128 max() { return ~(unsigned __int128) 0; }
+  };
+
+  template <>
+  struct ia_limits<__int128> {
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr int digits = 127;
+    static constexpr __int128 min() { return -max() - 1; }
+    static constexpr __int128 max() { return __int128(~(unsigned __int128) 0 >> 1); }
+  };
+#endif
+
+  template <typename T>
+  using ia_make_unsigned_t = typename ia_make_unsigned<T>::type;
+
+  // Reinterpret the same-sized object representation.
+  // The shift paths use it only between integers of the same width:
+  // there, before C++20 std::bit_cast, plain conversion does the same
+  // (modular since C++20 and in all supported compilers before),
+  // and is allowed in constant expressions unlike memcpy.
   template<class To, class From>
-  std::enable_if_t<
+  constexpr std::enable_if_t<
       sizeof(To) == sizeof(From) &&
       std::is_trivially_copyable_v<From> &&
       std::is_trivially_copyable_v<To>,
       To>
-  // constexpr support needs compiler magic
-  inline ia_bit_cast(const From& src) noexcept
+  ia_bit_cast(const From& src) noexcept
   {
+#if defined(__cpp_lib_bit_cast)
+    return std::bit_cast<To>(src);
+#else
+    if constexpr(ia_is_integral<To>::value && ia_is_integral<From>::value) {
+      return static_cast<To>(src);
+    }
+    else {
       static_assert(std::is_trivially_constructible_v<To>,
           "This implementation additionally requires "
           "destination type to be trivially constructible");
       To dst;
       std::memcpy(&dst, &src, sizeof(To));
       return dst;
+    }
+#endif
   }
 
+  // Result of cf_xxx without flag argument.
+  // Usage: auto [value, overflowed] = cf_add(a, b);
+  template <typename T>
+  struct cf_result {
+    T value;
+    bool overflowed;
+  };
+
+  // The std exception of a cx_xxx failure, for the failure policies.
+  enum class cx_fail : unsigned char {
+    overflow_error, domain_error, out_of_range, range_error,
+    invalid_argument, bad_array_new_length
+  };
+
+#if SIA80_CX_POLICY == SIA80_CX_HANDLER
+  // Defined by the program.
+  [[noreturn]] __attribute__((cold, noinline))
+  void cx_failure(cx_fail kind, const char *what);
+#elif SIA80_CX_POLICY == SIA80_CX_HOOK
+  using cx_hook_t = void (*)(cx_fail kind, const char *what);
+#endif
+
+  namespace cx_detail {
+
+#if SIA80_CX_POLICY == SIA80_CX_HOOK
+    inline std::atomic<cx_hook_t> hook { nullptr };
+#endif
+
+    template <cx_fail Kind>
+    [[noreturn]] __attribute__((cold, noinline))
+    void fail(const char *what)
+    {
+#if SIA80_CX_POLICY == SIA80_CX_HANDLER
+      cx_failure(Kind, what);
+#else
+#if SIA80_CX_POLICY == SIA80_CX_HOOK
+      if (const cx_hook_t h = hook.load(std::memory_order_relaxed)) {
+        h(Kind, what);
+      }
+#endif
+#if defined(__cpp_exceptions)
+      switch (Kind) {
+      case cx_fail::overflow_error:
+        throw std::overflow_error(what);
+      case cx_fail::domain_error:
+        throw std::domain_error(what);
+      case cx_fail::out_of_range:
+        throw std::out_of_range(what);
+      case cx_fail::range_error:
+        throw std::range_error(what);
+      case cx_fail::invalid_argument:
+        throw std::invalid_argument(what);
+      case cx_fail::bad_array_new_length:
+        throw std::bad_array_new_length();
+      }
+#endif
+      __builtin_trap();
+#endif
+    }
+
+  } // namespace cx_detail
+
+#if SIA80_CX_POLICY == SIA80_CX_HOOK
+  // Returns the previous hook; nullptr for none.
+  inline cx_hook_t set_cx_hook(cx_hook_t h)
+  {
+    return cx_detail::hook.exchange(h);
+  }
+#endif
+
+  // Mode as a template argument, for classes and functions
+  // parameterized by the error handling (e.g. divider<int, mode::sr>).
+  enum class mode { cx, cf, tr, sr };
+
+  // Tag to select the branchless saturating versions:
+  //   sia80::sr_add(a, b, sia80::branchless)
+  struct branchless_t {};
+  inline constexpr branchless_t branchless {};
+
+#ifndef SIA80_SR_BRANCHLESS
+#define SIA80_SR_BRANCHLESS 0
+#endif
+
+  namespace bl_detail {
+
+    // min if neg, max otherwise.
+    template <typename TR>
+    constexpr TR sat_bound(bool neg)
+    {
+      using UTR = ia_make_unsigned_t<TR>;
+      if constexpr(ia_is_signed<TR>::value) {
+        // max + 1 wraps to min.
+        return ia_bit_cast<TR>(UTR(UTR(ia_limits<TR>::max()) + UTR(neg)));
+      }
+      else {
+        return TR(UTR(0) - UTR(!neg));
+      }
+    }
+
+    // c ? a : b, with a mask instead of a branch. (GCC turns
+    // the plain conditional operator here back into a branch.)
+    template <typename TR>
+    constexpr TR select(bool c, TR a, TR b)
+    {
+      using UTR = ia_make_unsigned_t<TR>;
+      const UTR mask = UTR(0) - UTR(c);
+      return ia_bit_cast<TR>(UTR(UTR(b) ^ ((UTR(a) ^ UTR(b)) & mask)));
+    }
+
+  } // namespace bl_detail
+
+  // Checked multiply with a 128-bit result: with 1, by 64-bit halves
+  // (mul_detail::mul128_halves()); with 0, __builtin_mul_overflow.
+  // GCC expands the builtin inline with fast paths for operands
+  // of 64 bits, and it is faster (see bench_ia int128/); Clang may
+  // call __muloti4 from its runtime library, which libgcc lacks.
+#ifndef SIA80_MUL128_HALVES
+#if defined(__clang__)
+#define SIA80_MUL128_HALVES 1
+#else
+#define SIA80_MUL128_HALVES 0
+#endif
+#endif
+
+  namespace mul_detail {
+
+#if defined(__SIZEOF_INT128__)
+    using u64 = std::uint64_t;
+    using u128 = unsigned __int128;
+
+    // Product of 128-bit magnitudes: the low 128 bits to *res,
+    // and whether it doesn't fit in 128 bits. Only multiplies
+    // of 64-bit halves (mul, or mulx with BMI2, and imul for the
+    // low halves of cross products). If both high halves are
+    // nonzero, it overflows anyway; otherwise the only nonzero
+    // cross product is taken in full to check its high half.
+    constexpr bool umul128(u128 a, u128 b, u128 *res)
+    {
+      const u64 a1 = u64(a >> 64), a0 = u64(a);
+      const u64 b1 = u64(b >> 64), b0 = u64(b);
+      const u128 lo = u128(a0) * b0;
+      const u128 cross = u128(a1 | b1) * (a1 != 0 ? b0 : a0);
+      const u64 lohi = u64(lo >> 64);
+      // Right also when both a1 and b1 are nonzero.
+      const u64 hi = lohi + a1 * b0 + a0 * b1;
+      *res = (u128(hi) << 64) | u64(lo);
+      return ((a1 != 0) & (b1 != 0)) | (u64(cross >> 64) != 0) |
+          (u64(lohi + u64(cross)) < lohi);
+    }
+
+    // __builtin_mul_overflow(v1, v2, res) for a 128-bit result,
+    // via umul128() on magnitudes. The operands are of their own types,
+    // as for the builtin (e.g. uint64_t and __int128).
+    template <typename TR, typename T1, typename T2>
+    constexpr bool mul128_halves(T1 v1, T2 v2, TR *res)
+    {
+      static_assert(sizeof(TR) == sizeof(u128), "mul128_halves: 128-bit result only");
+      using i128 = __int128;
+      using W1 = std::conditional_t<ia_is_signed<T1>::value, i128, u128>;
+      using W2 = std::conditional_t<ia_is_signed<T2>::value, i128, u128>;
+      const W1 w1 = v1;
+      const W2 w2 = v2;
+      // Fast paths: both operands fit in 64 bits, as unsigned or as
+      // signed, so one widening multiply is exact. The same as the
+      // builtin does; for typical data, these branches are predictable.
+      const bool u1 = u128(w1) >> 64 == 0;
+      const bool u2 = u128(w2) >> 64 == 0;
+      if (u1 & u2) {
+        const u128 p = u128(u64(w1)) * u64(w2);
+        *res = ia_bit_cast<TR>(p);
+        return ia_is_signed<TR>::value && (p >> 127) != 0;
+      }
+      const bool s1 = i128(w1) == std::int64_t(w1) && (ia_is_signed<T1>::value || u1);
+      const bool s2 = i128(w2) == std::int64_t(w2) && (ia_is_signed<T2>::value || u2);
+      if (s1 & s2) {
+        const i128 p = i128(std::int64_t(w1)) * std::int64_t(w2);
+        *res = ia_bit_cast<TR>(p);
+        return !ia_is_signed<TR>::value && p < 0;
+      }
+      // Magnitudes and the result sign with masks, not branches:
+      // the signs of data are often unpredictable.
+      const bool n1 = w1 < 0;
+      const bool n2 = w2 < 0;
+      const u128 m1s = u128(0) - u128(n1);
+      const u128 m2s = u128(0) - u128(n2);
+      const u128 m1 = (u128(w1) ^ m1s) - m1s;
+      const u128 m2 = (u128(w2) ^ m2s) - m2s;
+      u128 mag = 0;
+      bool ovf = umul128(m1, m2, &mag);
+      const bool neg = n1 != n2;
+      const u128 sr = m1s ^ m2s;
+      if constexpr(ia_is_signed<TR>::value) {
+        // The negative range has one more value.
+        ovf |= mag > u128(ia_limits<TR>::max()) + neg;
+      }
+      else {
+        ovf |= neg & (mag != 0);
+      }
+      *res = ia_bit_cast<TR>(u128((mag ^ sr) - sr));
+      return ovf;
+    }
+#endif
+
+    template <typename TR, typename T1, typename T2>
+    constexpr bool mul_overflow(T1 v1, T2 v2, TR *res)
+    {
+#if defined(__SIZEOF_INT128__) && SIA80_MUL128_HALVES
+      if constexpr(sizeof(TR) == 16) {
+        return mul128_halves(v1, v2, res);
+      }
+      else
+#endif
+      {
+        return __builtin_mul_overflow(v1, v2, res);
+      }
+    }
+
+  } // namespace mul_detail
+
   //-- add -----------------------------------------------------
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cx_add(T1 v1, T2 v2) -> decltype(v1+v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_add(T1 v1, T2 v2) -> decltype(v1+v2)
   {
     using TR = decltype(v1+v2);
-    TR result;
+    TR result = 0;
     bool ovf = __builtin_add_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
-      throw std::overflow_error("cx_add");
+      SIA80_CX_FAIL(overflow_error, "cx_add");
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cf_add(T1 v1, T2 v2, int *flag) -> decltype(v1+v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_add(T1 v1, T2 v2, int *flag SIA80_TM_SITE) -> decltype(v1+v2)
   {
     using TR = decltype(v1+v2);
-    TR result;
+    TR result = 0;
     bool ovf = __builtin_add_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, add, cf);
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto tr_add(T1 v1, T2 v2) -> decltype(v1+v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_add(T1 v1, T2 v2 SIA80_TM_SITE) -> cf_result<decltype(v1+v2)>
   {
+    // Unlike the builtin, the plain formulas can be vectorized
+    // when the result is accumulated in a loop (see overflow_sticky).
+    // They are exact only when both operands are already of TR.
     using TR = decltype(v1+v2);
-    TR result;
+    if constexpr(std::is_same<decltype(+v1), TR>::value &&
+        std::is_same<decltype(+v2), TR>::value)
+    {
+      using UTR = ia_make_unsigned_t<TR>;
+      TR result = TR(UTR(v1) + UTR(v2));
+      if constexpr(ia_is_signed<TR>::value) {
+        bool ovf = ((v1 ^ result) & (v2 ^ result)) < 0;
+        SIA80_TM_EVENT(ovf, add, cf);
+        return { result, ovf };
+      }
+      else {
+        bool ovf = result < v1;
+        SIA80_TM_EVENT(ovf, add, cf);
+        return { result, ovf };
+      }
+    }
+    else {
+      TR result = 0;
+      bool ovf = __builtin_add_overflow(v1, v2, &result);
+      SIA80_TM_EVENT(ovf, add, cf);
+      return { result, ovf };
+    }
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_add(T1 v1, T2 v2) -> decltype(v1+v2)
+  {
+    using TR = decltype(v1+v2);
+    TR result = 0;
     __builtin_add_overflow(v1, v2, &result);
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto sr_add(T1 v1, T2 v2) -> decltype(v1+v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_add(T1 v1, T2 v2, branchless_t SIA80_TM_SITE) -> decltype(v1+v2)
+  {
+    using TR = decltype(v1+v2);
+    TR result = 0;
+    bool ovf = __builtin_add_overflow(v1, v2, &result);
+    // See sr_add() for the direction of saturation.
+    bool neg = ia_is_signed<TR>::value ? v1 < 0 : (v1 < 0) | (v2 < 0);
+    SIA80_TM_EVENT(ovf, add, sr);
+    return bl_detail::select(ovf, bl_detail::sat_bound<TR>(neg), result);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_add(T1 v1, T2 v2 SIA80_TM_SITE) -> decltype(v1+v2)
   {
+#if SIA80_SR_BRANCHLESS
+    return sr_add(v1, v2, branchless SIA80_TM_PASS);
+#else
     using TR = decltype(v1+v2);
-    TR result;
+    TR result = 0;
     bool ovf = __builtin_add_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
-      if (v1 < 0) {
-        return std::numeric_limits<TR>::min();
+      SIA80_TM_EVENT(true, add, sr);
+      // For signed TR, overflow needs both operands of the same sign.
+      // For unsigned TR, any negative operand means going below 0.
+      if (v1 < 0 || v2 < 0) {
+        return ia_limits<TR>::min();
       }
-      return std::numeric_limits<TR>::max();
+      return ia_limits<TR>::max();
     }
     return result;
+#endif
   }
 
   //-- sub -----------------------------------------------------
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cx_sub(T1 v1, T2 v2) -> decltype(v1-v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_sub(T1 v1, T2 v2) -> decltype(v1-v2)
   {
     using TR = decltype(v1-v2);
-    TR result;
+    TR result = 0;
     bool ovf = __builtin_sub_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
-      throw std::overflow_error("cx_sub");
+      SIA80_CX_FAIL(overflow_error, "cx_sub");
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cf_sub(T1 v1, T2 v2, int *flag) -> decltype(v1-v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_sub(T1 v1, T2 v2, int *flag SIA80_TM_SITE) -> decltype(v1-v2)
   {
     using TR = decltype(v1-v2);
-    TR result;
+    TR result = 0;
     bool ovf = __builtin_sub_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, sub, cf);
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto tr_sub(T1 v1, T2 v2) -> decltype(v1-v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_sub(T1 v1, T2 v2 SIA80_TM_SITE) -> cf_result<decltype(v1-v2)>
   {
+    // See note for cf_add() without flag.
     using TR = decltype(v1-v2);
-    TR result;
+    if constexpr(std::is_same<decltype(+v1), TR>::value &&
+        std::is_same<decltype(+v2), TR>::value)
+    {
+      using UTR = ia_make_unsigned_t<TR>;
+      TR result = TR(UTR(v1) - UTR(v2));
+      if constexpr(ia_is_signed<TR>::value) {
+        bool ovf = ((v1 ^ v2) & (v1 ^ result)) < 0;
+        SIA80_TM_EVENT(ovf, sub, cf);
+        return { result, ovf };
+      }
+      else {
+        bool ovf = v1 < v2;
+        SIA80_TM_EVENT(ovf, sub, cf);
+        return { result, ovf };
+      }
+    }
+    else {
+      TR result = 0;
+      bool ovf = __builtin_sub_overflow(v1, v2, &result);
+      SIA80_TM_EVENT(ovf, sub, cf);
+      return { result, ovf };
+    }
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_sub(T1 v1, T2 v2) -> decltype(v1-v2)
+  {
+    using TR = decltype(v1-v2);
+    TR result = 0;
     __builtin_sub_overflow(v1, v2, &result);
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto sr_sub(T1 v1, T2 v2) -> decltype(v1-v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_sub(T1 v1, T2 v2, branchless_t SIA80_TM_SITE) -> decltype(v1-v2)
+  {
+    using TR = decltype(v1-v2);
+    TR result = 0;
+    bool ovf = __builtin_sub_overflow(v1, v2, &result);
+    // See sr_sub() for the direction of saturation.
+    bool neg = ia_is_signed<TR>::value ? v1 < 0 : !(v2 < 0);
+    SIA80_TM_EVENT(ovf, sub, sr);
+    return bl_detail::select(ovf, bl_detail::sat_bound<TR>(neg), result);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_sub(T1 v1, T2 v2 SIA80_TM_SITE) -> decltype(v1-v2)
   {
+#if SIA80_SR_BRANCHLESS
+    return sr_sub(v1, v2, branchless SIA80_TM_PASS);
+#else
     using TR = decltype(v1-v2);
-    TR result;
+    TR result = 0;
     bool ovf = __builtin_sub_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
-      if (v1 < 0) {
-        return std::numeric_limits<TR>::min();
+      SIA80_TM_EVENT(true, sub, sr);
+      // For unsigned TR, the result can go above maximum only
+      // with negative v2; otherwise it went below 0.
+      if (ia_is_signed<TR>::value ? v1 < 0 : !(v2 < 0)) {
+        return ia_limits<TR>::min();
       }
-      return std::numeric_limits<TR>::max();
+      return ia_limits<TR>::max();
     }
     return result;
+#endif
   }
 
   //-- mul -----------------------------------------------------
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cx_mul(T1 v1, T2 v2) -> decltype(v1*v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_mul(T1 v1, T2 v2) -> decltype(v1*v2)
   {
     using TR = decltype(v1*v2);
-    TR result;
-    bool ovf = __builtin_mul_overflow(v1, v2, &result);
+    TR result = 0;
+    bool ovf = mul_detail::mul_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
-      throw std::overflow_error("cx_mul");
+      SIA80_CX_FAIL(overflow_error, "cx_mul");
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cf_mul(T1 v1, T2 v2, int *flag) -> decltype(v1*v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_mul(T1 v1, T2 v2, int *flag SIA80_TM_SITE) -> decltype(v1*v2)
   {
     using TR = decltype(v1*v2);
-    TR result;
-    bool ovf = __builtin_mul_overflow(v1, v2, &result);
+    TR result = 0;
+    bool ovf = mul_detail::mul_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, mul, cf);
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto tr_mul(T1 v1, T2 v2) -> decltype(v1*v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_mul(T1 v1, T2 v2 SIA80_TM_SITE) -> cf_result<decltype(v1*v2)>
   {
+    // See note for cf_add() without flag. Here the product is
+    // taken in the double width type, if it is 64 bits at most.
     using TR = decltype(v1*v2);
-    TR result;
+    if constexpr(std::is_same<decltype(+v1), TR>::value &&
+        std::is_same<decltype(+v2), TR>::value && sizeof(TR) <= 4)
+    {
+      using WTR = std::conditional_t<ia_is_signed<TR>::value,
+          std::int64_t, std::uint64_t>;
+      WTR wresult = WTR(v1) * WTR(v2);
+      TR result = TR(wresult);
+      bool ovf = wresult != WTR(result);
+      SIA80_TM_EVENT(ovf, mul, cf);
+      return { result, ovf };
+    }
+    else {
+      TR result = 0;
+      bool ovf = mul_detail::mul_overflow(v1, v2, &result);
+      SIA80_TM_EVENT(ovf, mul, cf);
+      return { result, ovf };
+    }
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_mul(T1 v1, T2 v2) -> decltype(v1*v2)
+  {
+    using TR = decltype(v1*v2);
+    TR result = 0;
     __builtin_mul_overflow(v1, v2, &result);
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto sr_mul(T1 v1, T2 v2) -> decltype(v1*v2)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_mul(T1 v1, T2 v2, branchless_t SIA80_TM_SITE) -> decltype(v1*v2)
   {
     using TR = decltype(v1*v2);
-    TR result;
-    bool ovf = __builtin_mul_overflow(v1, v2, &result);
+    TR result = 0;
+    bool ovf = mul_detail::mul_overflow(v1, v2, &result);
+    bool neg = (v1 < 0) != (v2 < 0);
+    SIA80_TM_EVENT(ovf, mul, sr);
+    return bl_detail::select(ovf, bl_detail::sat_bound<TR>(neg), result);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_mul(T1 v1, T2 v2 SIA80_TM_SITE) -> decltype(v1*v2)
+  {
+#if SIA80_SR_BRANCHLESS
+    return sr_mul(v1, v2, branchless SIA80_TM_PASS);
+#else
+    using TR = decltype(v1*v2);
+    TR result = 0;
+    bool ovf = mul_detail::mul_overflow(v1, v2, &result);
     if (SIA80_UNLIKELY(ovf)) {
+      SIA80_TM_EVENT(true, mul, sr);
       if ((v1 < 0 && v2 >= 0) || (v1 >= 0 && v2 < 0)) {
-        return std::numeric_limits<TR>::min();
+        return ia_limits<TR>::min();
       }
-      return std::numeric_limits<TR>::max();
+      return ia_limits<TR>::max();
     }
     return result;
+#endif
+  }
+
+#if defined(__SIZEOF_INT128__)
+  //-- mul_wide ------------------------------------------------
+
+  // Full product of two values of 64 bits at most; never overflows.
+  // The result is __int128 if any operand is signed, unsigned __int128
+  // otherwise. For int64_t or uint64_t operands, it is one widening
+  // multiply instruction.
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value && sizeof(T1) <= 8, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value && sizeof(T2) <= 8, bool> = true>
+  constexpr auto cx_mul_wide(T1 v1, T2 v2)
+      -> std::conditional_t<ia_is_signed<T1>::value || ia_is_signed<T2>::value,
+          __int128, unsigned __int128>
+  {
+    using W = std::conditional_t<ia_is_signed<T1>::value || ia_is_signed<T2>::value,
+        __int128, unsigned __int128>;
+    return W(v1) * W(v2);
   }
 
+#endif
   //-- div -----------------------------------------------------
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cx_div(T1 ddnd, T2 dvsr) -> decltype(ddnd/dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_div(T1 ddnd, T2 dvsr) -> decltype(ddnd/dvsr)
   {
     using TR = decltype(ddnd/dvsr);
     if (SIA80_UNLIKELY(dvsr == 0)) {
-      throw std::domain_error("cx_div divisor 0");
+      SIA80_CX_FAIL(domain_error, "cx_div divisor 0");
     }
-    if constexpr(std::is_signed<T2>::value) {
-      constexpr TR rvmin = std::numeric_limits<TR>::min();
+    if constexpr(ia_is_signed<T2>::value) {
+      constexpr TR rvmin = ia_limits<TR>::min();
       if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
-        throw std::overflow_error("cx_div min neg");
+        SIA80_CX_FAIL(overflow_error, "cx_div min neg");
       }
     }
     return ddnd / dvsr;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cf_div(T1 ddnd, T2 dvsr, int *flag) -> decltype(ddnd/dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_div(T1 ddnd, T2 dvsr, int *flag SIA80_TM_SITE) -> decltype(ddnd/dvsr)
   {
     using TR = decltype(ddnd/dvsr);
     if (SIA80_UNLIKELY(dvsr == 0)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, div, cf);
       return ~TR(0);
     }
-    if constexpr(std::is_signed<T2>::value) {
-      constexpr TR rvmin = std::numeric_limits<TR>::min();
+    if constexpr(ia_is_signed<T2>::value) {
+      constexpr TR rvmin = ia_limits<TR>::min();
       if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
         *flag = 1;
+        SIA80_TM_EVENT(true, div, cf);
         return rvmin;
       }
     }
@@ -273,16 +808,36 @@ namespace sia80 {
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto tr_div(T1 ddnd, T2 dvsr) -> decltype(ddnd/dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_div(T1 ddnd, T2 dvsr SIA80_TM_SITE) -> cf_result<decltype(ddnd/dvsr)>
+  {
+    using TR = decltype(ddnd/dvsr);
+    if (SIA80_UNLIKELY(dvsr == 0)) {
+      SIA80_TM_EVENT(true, div, cf);
+      return { ~TR(0), true };
+    }
+    if constexpr(ia_is_signed<T2>::value) {
+      constexpr TR rvmin = ia_limits<TR>::min();
+      if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
+        SIA80_TM_EVENT(true, div, cf);
+        return { rvmin, true };
+      }
+    }
+    return { ddnd / dvsr, false };
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_div(T1 ddnd, T2 dvsr) -> decltype(ddnd/dvsr)
   {
     using TR = decltype(ddnd/dvsr);
     if (SIA80_UNLIKELY(dvsr == 0)) {
       return ~TR(0);
     }
-    if constexpr(std::is_signed<T2>::value) {
-      const TR rvmin = std::numeric_limits<TR>::min();
+    if constexpr(ia_is_signed<T2>::value) {
+      const TR rvmin = ia_limits<TR>::min();
       if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
         return rvmin;
       }
@@ -291,21 +846,23 @@ namespace sia80 {
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto sr_div(T1 ddnd, T2 dvsr) -> decltype(ddnd/dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_div(T1 ddnd, T2 dvsr SIA80_TM_SITE) -> decltype(ddnd/dvsr)
   {
     using TR = decltype(ddnd/dvsr);
-    const TR rvmax = std::numeric_limits<TR>::max();
-    const TR rvmin = std::numeric_limits<TR>::min();
+    const TR rvmax = ia_limits<TR>::max();
+    const TR rvmin = ia_limits<TR>::min();
     if (SIA80_UNLIKELY(dvsr == 0)) {
+      SIA80_TM_EVENT(true, div, sr);
       if (ddnd < 0) {
         return rvmin;
       }
       return rvmax;
     }
-    if constexpr(std::is_signed<T2>::value) {
+    if constexpr(ia_is_signed<T2>::value) {
       if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
+        SIA80_TM_EVENT(true, div, sr);
         return rvmax;
       }
     }
@@ -315,30 +872,30 @@ namespace sia80 {
   //-- rem -----------------------------------------------------
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cx_rem(T1 ddnd, T2 dvsr) -> decltype(ddnd%dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_rem(T1 ddnd, T2 dvsr) -> decltype(ddnd%dvsr)
   {
     // We avoid the division operation even if formally
     // there is no overflow for the remainder itself.
     // This pertains to both special cases (x/0 and MIN/-1).
     using TR = decltype(ddnd%dvsr);
     if (SIA80_UNLIKELY(dvsr == 0)) {
-      throw std::domain_error("cx_rem divisor 0");
+      SIA80_CX_FAIL(domain_error, "cx_rem divisor 0");
     }
-    if constexpr(std::is_signed<T2>::value) {
-      const TR rvmin = std::numeric_limits<TR>::min();
+    if constexpr(ia_is_signed<T2>::value) {
+      const TR rvmin = ia_limits<TR>::min();
       if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
-        throw std::overflow_error("cx_rem min neg");
+        SIA80_CX_FAIL(overflow_error, "cx_rem min neg");
       }
     }
     return ddnd % dvsr;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cf_rem(T1 ddnd, T2 dvsr, int *flag) -> decltype(ddnd%dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_rem(T1 ddnd, T2 dvsr, int *flag SIA80_TM_SITE) -> decltype(ddnd%dvsr)
   {
     // We report the division operation even if formally
     // there is no overflow for the remainder itself.
@@ -346,12 +903,14 @@ namespace sia80 {
     using TR = decltype(ddnd%dvsr);
     if (SIA80_UNLIKELY(dvsr == 0)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, rem, cf);
       return 0;
     }
-    if constexpr(std::is_signed<T2>::value) {
-      const TR rvmin = std::numeric_limits<TR>::min();
+    if constexpr(ia_is_signed<T2>::value) {
+      const TR rvmin = ia_limits<TR>::min();
       if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
         *flag = 1;
+        SIA80_TM_EVENT(true, rem, cf);
         return 0;
       }
     }
@@ -359,16 +918,39 @@ namespace sia80 {
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto tr_rem(T1 ddnd, T2 dvsr) -> decltype(ddnd%dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_rem(T1 ddnd, T2 dvsr SIA80_TM_SITE) -> cf_result<decltype(ddnd%dvsr)>
+  {
+    // We report the division operation even if formally
+    // there is no overflow for the remainder itself.
+    // This pertains to both special cases (x/0 and MIN/-1).
+    using TR = decltype(ddnd%dvsr);
+    if (SIA80_UNLIKELY(dvsr == 0)) {
+      SIA80_TM_EVENT(true, rem, cf);
+      return { 0, true };
+    }
+    if constexpr(ia_is_signed<T2>::value) {
+      const TR rvmin = ia_limits<TR>::min();
+      if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
+        SIA80_TM_EVENT(true, rem, cf);
+        return { 0, true };
+      }
+    }
+    return { ddnd % dvsr, false };
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_rem(T1 ddnd, T2 dvsr) -> decltype(ddnd%dvsr)
   {
     using TR = decltype(ddnd%dvsr);
     if (SIA80_UNLIKELY(dvsr == 0)) {
       return 0;
     }
-    if constexpr(std::is_signed<T2>::value) {
-      const TR rvmin = std::numeric_limits<TR>::min();
+    if constexpr(ia_is_signed<T2>::value) {
+      const TR rvmin = ia_limits<TR>::min();
       if (SIA80_UNLIKELY(dvsr == -1 && ddnd == rvmin)) {
         return 0;
       }
@@ -377,9 +959,9 @@ namespace sia80 {
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto sr_rem(T1 ddnd, T2 dvsr) -> decltype(ddnd%dvsr)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_rem(T1 ddnd, T2 dvsr) -> decltype(ddnd%dvsr)
   {
     return tr_rem(ddnd, dvsr);
   }
@@ -387,15 +969,15 @@ namespace sia80 {
   //-- shl
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cx_shl(T1 v1, T2 shcnt) -> decltype(v1 << shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_shl(T1 v1, T2 shcnt) -> decltype(v1 << shcnt)
   {
     // Notice: integral promotion can widen the value to width of TR.
     // We check against TR, not T1.
     using TR = decltype(v1 << shcnt);
-    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= std::numeric_limits<TR>::digits)) {
-      throw std::out_of_range("cx_shl shift count");
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
+      SIA80_CX_FAIL(out_of_range, "cx_shl shift count");
     }
     // Criterion for the check: value correctly shifts back to
     // the original one. But the first shift left shall be done
@@ -404,68 +986,122 @@ namespace sia80 {
     // original (if differ) for right shift.
     // As integral promotion is in effect before any real shift,
     // operate in its types (TR, UTR).
-    using UTR = std::make_unsigned_t<TR>;
+    using UTR = ia_make_unsigned_t<TR>;
     UTR xv1 = v1;
     UTR uresult = xv1 << shcnt;
     TR result = ia_bit_cast<TR>(uresult);
     TR checkback = result >> shcnt;
     if (SIA80_UNLIKELY(v1 != checkback)) {
-      throw std::overflow_error("cx_shl overflow");
+      SIA80_CX_FAIL(overflow_error, "cx_shl overflow");
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cf_shl(T1 v1, T2 shcnt, int *flag) -> decltype(v1 << shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_shl(T1 v1, T2 shcnt, int *flag SIA80_TM_SITE) -> decltype(v1 << shcnt)
   {
     // Notice: integral promotion can widen the value to width of TR.
     // We check against TR, not T1.
     using TR = decltype(v1 << shcnt);
-    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= std::numeric_limits<TR>::digits)) {
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, shl, cf);
       return 0;
     }
     // See note for cx_shl().
-    using UTR = std::make_unsigned_t<TR>;
+    using UTR = ia_make_unsigned_t<TR>;
     UTR xv1 = v1;
     UTR uresult = xv1 << shcnt;
     TR result = ia_bit_cast<TR>(uresult);
     TR checkback = result >> shcnt;
     if (SIA80_UNLIKELY(v1 != checkback)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, shl, cf);
     }
     return result;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto tr_shl(T1 v1, T2 shcnt) -> decltype(v1 << shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_shl(T1 v1, T2 shcnt SIA80_TM_SITE) -> cf_result<decltype(v1 << shcnt)>
+  {
+    // Notice: integral promotion can widen the value to width of TR.
+    // We check against TR, not T1.
+    using TR = decltype(v1 << shcnt);
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
+      SIA80_TM_EVENT(true, shl, cf);
+      return { 0, true };
+    }
+    // See note for cx_shl().
+    using UTR = ia_make_unsigned_t<TR>;
+    UTR xv1 = v1;
+    UTR uresult = xv1 << shcnt;
+    TR result = ia_bit_cast<TR>(uresult);
+    TR checkback = result >> shcnt;
+    bool ovf = v1 != checkback;
+    SIA80_TM_EVENT(ovf, shl, cf);
+    return { result, ovf };
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_shl(T1 v1, T2 shcnt) -> decltype(v1 << shcnt)
   {
     using TR = decltype(v1 << shcnt);
-    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= std::numeric_limits<TR>::digits)) {
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
       return 0;
     }
     // See note for cx_shl().
-    using UTR = std::make_unsigned_t<TR>;
-    UTR xv1 = ia_bit_cast<UTR>(v1);
+    using UTR = ia_make_unsigned_t<TR>;
+    UTR xv1 = v1;
     UTR uresult = xv1 << shcnt;
     return ia_bit_cast<TR>(uresult);
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto sr_shl(T1 v1, T2 shcnt) -> decltype(v1 << shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_shl(T1 v1, T2 shcnt, branchless_t SIA80_TM_SITE) -> decltype(v1 << shcnt)
   {
+    // See note for cx_shl(). A bad shift count is masked (as the
+    // hardware does anyway) to get a defined shift, and its result
+    // is overridden.
+    using TR = decltype(v1 << shcnt);
+    using UTR = ia_make_unsigned_t<TR>;
+    using UT2 = ia_make_unsigned_t<decltype(+shcnt)>;
+    constexpr unsigned tbits = sizeof(TR) * 8;
+    // Negative counts become big after conversion to unsigned.
+    const bool bad_cnt = UT2(shcnt) >= UT2(ia_limits<TR>::digits);
+    const unsigned sc = unsigned(shcnt) & (tbits - 1);
+    UTR xv1 = v1;
+    UTR uresult = xv1 << sc;
+    TR result = ia_bit_cast<TR>(uresult);
+    TR checkback = result >> sc;
+    // 0 stays 0 with any count.
+    bool ovf = (v1 != checkback) | (bad_cnt & (v1 != 0));
+    SIA80_TM_EVENT(ovf, shl, sr);
+    return bl_detail::select(ovf, bl_detail::sat_bound<TR>(v1 < 0), result);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_shl(T1 v1, T2 shcnt SIA80_TM_SITE) -> decltype(v1 << shcnt)
+  {
+#if SIA80_SR_BRANCHLESS
+    return sr_shl(v1, shcnt, branchless SIA80_TM_PASS);
+#else
     // Notice: integral promotion can widen the value to width of TR.
     // We check against TR, not T1.
     using TR = decltype(v1 << shcnt);
-    const TR rvmax = std::numeric_limits<TR>::max();
-    const TR rvmin = std::numeric_limits<TR>::min();
-    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= std::numeric_limits<TR>::digits)) {
+    const TR rvmax = ia_limits<TR>::max();
+    const TR rvmin = ia_limits<TR>::min();
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
+      SIA80_TM_EVENT(v1 != 0, shl, sr);
       if (v1 < 0) {
         return rvmin;
       }
@@ -477,46 +1113,49 @@ namespace sia80 {
       }
     }
     // See note for cx_shl().
-    using UTR = std::make_unsigned_t<TR>;
+    using UTR = ia_make_unsigned_t<TR>;
     UTR xv1 = v1;
     UTR uresult = xv1 << shcnt;
     TR result = ia_bit_cast<TR>(uresult);
     TR checkback = result >> shcnt;
     if (SIA80_UNLIKELY(v1 != checkback)) {
+      SIA80_TM_EVENT(true, shl, sr);
       if (v1 < 0) {
         return rvmin;
       }
       return rvmax;
     }
     return result;
+#endif
   }
 
   //-- shr
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cx_shr(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_shr(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
   {
     // Notice: integral promotion can widen the value to width of TR.
     // We check against TR, not T1.
     using TR = decltype(v1 >> shcnt);
-    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= std::numeric_limits<TR>::digits)) {
-      throw std::out_of_range("cx_shr shift count");
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
+      SIA80_CX_FAIL(out_of_range, "cx_shr shift count");
     }
     return v1 >> shcnt;
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto cf_shr(T1 v1, T2 shcnt, int *flag) -> decltype(v1 >> shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_shr(T1 v1, T2 shcnt, int *flag SIA80_TM_SITE) -> decltype(v1 >> shcnt)
   {
     // Notice: integral promotion can widen the value to width of TR.
     // We check against TR, not T1.
     using TR = decltype(v1 >> shcnt);
-    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= std::numeric_limits<TR>::digits)) {
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, shr, cf);
       if (v1 < 0) {
         return ~TR(0);
       }
@@ -526,12 +1165,30 @@ namespace sia80 {
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto tr_shr(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_shr(T1 v1, T2 shcnt SIA80_TM_SITE) -> cf_result<decltype(v1 >> shcnt)>
+  {
+    // Notice: integral promotion can widen the value to width of TR.
+    // We check against TR, not T1.
+    using TR = decltype(v1 >> shcnt);
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
+      SIA80_TM_EVENT(true, shr, cf);
+      if (v1 < 0) {
+        return { ~TR(0), true };
+      }
+      return { 0, true };
+    }
+    return { v1 >> shcnt, false };
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_shr(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
   {
     using TR = decltype(v1 >> shcnt);
-    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= std::numeric_limits<TR>::digits)) {
+    if (SIA80_UNLIKELY(shcnt < 0 || shcnt >= ia_limits<TR>::digits)) {
       if (v1 < 0) {
         return ~TR(0);
       }
@@ -541,80 +1198,213 @@ namespace sia80 {
   }
 
   template <typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline auto sr_shr(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_shr(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
   {
     return tr_shr(v1, shcnt);
   }
 
+  //-- shrx
+
+  // Right shift as division by 2^shcnt: the quotient is rounded
+  // toward zero, as v1 / 2^shcnt (v1 >> shcnt rounds a negative v1
+  // toward minus infinity), and the division must be exact: a non-zero
+  // bit shifted out is an error. A bad shift count is an error as for
+  // xx_shr; the quotient is 0 then.
+  // The quotient and the check are computed without branches.
+
+  namespace shrx_detail {
+
+    // Quotient toward zero; inexact if non-zero bits are shifted out.
+    // Requires 0 <= shcnt < digits of TR.
+    template <typename TR, typename T2>
+    constexpr TR quot(TR v, T2 shcnt, bool& inexact)
+    {
+      using UTR = ia_make_unsigned_t<TR>;
+      const UTR mask = (UTR(1) << shcnt) - 1;
+      inexact = (UTR(v) & mask) != 0;
+      return TR((v >> shcnt) + TR((v < 0) & inexact));
+    }
+
+    template <typename TR, typename T2>
+    constexpr bool bad_count(T2 shcnt)
+    {
+      return shcnt < 0 || shcnt >= ia_limits<TR>::digits;
+    }
+
+  } // namespace shrx_detail
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_shrx(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
+  {
+    using TR = decltype(v1 >> shcnt);
+    if (SIA80_UNLIKELY(shrx_detail::bad_count<TR>(shcnt))) {
+      SIA80_CX_FAIL(out_of_range, "cx_shrx shift count");
+    }
+    bool inexact = false;
+    TR result = shrx_detail::quot<TR>(v1, shcnt, inexact);
+    if (SIA80_UNLIKELY(inexact)) {
+      SIA80_CX_FAIL(range_error, "cx_shrx: inexact");
+    }
+    return result;
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_shrx(T1 v1, T2 shcnt, int *flag SIA80_TM_SITE) -> decltype(v1 >> shcnt)
+  {
+    using TR = decltype(v1 >> shcnt);
+    if (SIA80_UNLIKELY(shrx_detail::bad_count<TR>(shcnt))) {
+      *flag = 1;
+      SIA80_TM_EVENT(true, shrx, cf);
+      return 0;
+    }
+    bool inexact = false;
+    TR result = shrx_detail::quot<TR>(v1, shcnt, inexact);
+    if (SIA80_UNLIKELY(inexact)) {
+      *flag = 1;
+      SIA80_TM_EVENT(true, shrx, cf);
+    }
+    return result;
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_shrx(T1 v1, T2 shcnt SIA80_TM_SITE) -> cf_result<decltype(v1 >> shcnt)>
+  {
+    using TR = decltype(v1 >> shcnt);
+    if (SIA80_UNLIKELY(shrx_detail::bad_count<TR>(shcnt))) {
+      SIA80_TM_EVENT(true, shrx, cf);
+      return { 0, true };
+    }
+    bool inexact = false;
+    TR result = shrx_detail::quot<TR>(v1, shcnt, inexact);
+    SIA80_TM_EVENT(inexact, shrx, cf);
+    return { result, inexact };
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_shrx(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
+  {
+    using TR = decltype(v1 >> shcnt);
+    if (SIA80_UNLIKELY(shrx_detail::bad_count<TR>(shcnt))) {
+      return 0;
+    }
+    bool inexact = false;
+    return shrx_detail::quot<TR>(v1, shcnt, inexact);
+  }
+
+  // The quotient toward zero can't exceed the range; the same as tr_shrx.
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_shrx(T1 v1, T2 shcnt) -> decltype(v1 >> shcnt)
+  {
+    return tr_shrx(v1, shcnt);
+  }
+
   //-- conv
 
   template<typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline T1 cx_conv(T2 ival)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr T1 cx_conv(T2 ival)
   {
-    T1 result;
+    T1 result = 0;
     bool ovf = __builtin_add_overflow(ival, 0, &result);
     if (SIA80_UNLIKELY(ovf)) {
-      throw std::range_error("cx_conv");
+      SIA80_CX_FAIL(range_error, "cx_conv");
     }
     return result;
   }
 
   template<typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline T1 cf_conv(T2 ival, int *flag)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr T1 cf_conv(T2 ival, int *flag SIA80_TM_SITE)
   {
-    T1 result;
+    T1 result = 0;
     bool ovf = __builtin_add_overflow(ival, 0, &result);
     if (SIA80_UNLIKELY(ovf)) {
       *flag = 1;
+      SIA80_TM_EVENT(true, conv, cf);
     }
     return result;
   }
 
   template<typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline T1 tr_conv(T2 ival)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr cf_result<T1> cf_conv(T2 ival SIA80_TM_SITE)
+  {
+    T1 result = 0;
+    bool ovf = __builtin_add_overflow(ival, 0, &result);
+    SIA80_TM_EVENT(ovf, conv, cf);
+    return { result, ovf };
+  }
+
+  template<typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr T1 tr_conv(T2 ival)
   {
-    T1 result;
+    T1 result = 0;
     __builtin_add_overflow(ival, 0, &result);
     return result;
   }
 
   template<typename T1, typename T2,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_integral<T2>::value, bool> = true>
-  inline T1 sr_conv(T2 ival)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr T1 sr_conv(T2 ival, branchless_t SIA80_TM_SITE)
   {
-    T1 result;
-    const T1 rvmax = std::numeric_limits<T1>::max();
-    const T1 rvmin = std::numeric_limits<T1>::min();
+    T1 result = 0;
+    bool ovf = __builtin_add_overflow(ival, 0, &result);
+    SIA80_TM_EVENT(ovf, conv, sr);
+    return bl_detail::select(ovf, bl_detail::sat_bound<T1>(ival < 0), result);
+  }
+
+  template<typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr T1 sr_conv(T2 ival SIA80_TM_SITE)
+  {
+#if SIA80_SR_BRANCHLESS
+    return sr_conv<T1>(ival, branchless SIA80_TM_PASS);
+#else
+    T1 result = 0;
+    const T1 rvmax = ia_limits<T1>::max();
+    const T1 rvmin = ia_limits<T1>::min();
     bool ovf = __builtin_add_overflow(ival, 0, &result);
     if (SIA80_UNLIKELY(ovf)) {
+      SIA80_TM_EVENT(true, conv, sr);
       if (ival < 0) {
         return rvmin;
       }
       return rvmax;
     }
     return result;
+#endif
   }
 
   //-- ufit ----------------------------------------------------
 
   template<typename T1,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true>
-  inline T1 cx_ufit(T1 ival, unsigned nbits)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr T1 cx_ufit(T1 ival, unsigned nbits)
   {
     if (SIA80_UNLIKELY(ival < 0)) {
-      throw std::range_error("cx_ufit: negative");
+      SIA80_CX_FAIL(range_error, "cx_ufit: negative");
     }
     // FFR: With C++20, use consteval.
-    constexpr unsigned tbits = std::numeric_limits<T1>::digits;
+    constexpr unsigned tbits = ia_limits<T1>::digits;
     // NB We check in T1 size. For example, tbits is 32 for uint32_t and
     // 31 for int32_t. We can always shift 1 left by value strictly less
     // than tbits. If nbits >= tbits, value fits except T1_min case, but
@@ -626,14 +1416,14 @@ namespace sia80 {
     using T1X = decltype(ival + 0); // integral promotion
     const T1X limit = T1X(1) << nbits;
     if (SIA80_UNLIKELY(ival >= limit)) {
-      throw std::range_error("cx_ufit: too big");
+      SIA80_CX_FAIL(range_error, "cx_ufit: too big");
     }
     return ival;
   }
 
   template<typename T1,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true>
-  inline T1 cf_ufit(T1 ival, unsigned nbits, int *flag)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr T1 cf_ufit(T1 ival, unsigned nbits, int *flag SIA80_TM_SITE)
   {
     if (SIA80_UNLIKELY(ival < 0)) {
       *flag = 1;
@@ -641,8 +1431,9 @@ namespace sia80 {
       // needed bits.
     }
     // FFR: With C++20, use consteval.
-    constexpr unsigned tbits = std::numeric_limits<T1>::digits;
+    constexpr unsigned tbits = ia_limits<T1>::digits;
     if (nbits >= tbits) {
+      SIA80_TM_EVENT(ival < 0, ufit, cf);
       return ival;
     }
     using T1X = decltype(ival + 0); // integral promotion
@@ -650,16 +1441,38 @@ namespace sia80 {
     T1X ret = T1X(ival) & mask;
     if (ret != ival) {
       *flag = 1;
+      SIA80_TM_EVENT(true, ufit, cf);
     }
     return ret;
   }
 
   template<typename T1,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true>
-  inline T1 tr_ufit(T1 ival, unsigned nbits)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr cf_result<T1> cf_ufit(T1 ival, unsigned nbits SIA80_TM_SITE)
+  {
+    // NB We don't exit on negative input. Future masking will
+    // extract only needed bits.
+    bool ovf = ival < 0;
+    // FFR: With C++20, use consteval.
+    constexpr unsigned tbits = ia_limits<T1>::digits;
+    if (nbits >= tbits) {
+      SIA80_TM_EVENT(ovf, ufit, cf);
+      return { ival, ovf };
+    }
+    using T1X = decltype(ival + 0); // integral promotion
+    const T1X mask = (T1X(1) << nbits) - 1;
+    T1X ret = T1X(ival) & mask;
+    ovf |= ret != ival;
+    SIA80_TM_EVENT(ovf, ufit, cf);
+    return { T1(ret), ovf };
+  }
+
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr T1 tr_ufit(T1 ival, unsigned nbits)
   {
     // FFR: With C++20, use consteval.
-    constexpr unsigned tbits = std::numeric_limits<T1>::digits;
+    constexpr unsigned tbits = ia_limits<T1>::digits;
     if (nbits >= tbits) {
       return ival;
     }
@@ -667,14 +1480,35 @@ namespace sia80 {
     const T1X mask = (T1X(1u) << nbits) - 1;
     return T1X(ival) & mask;
   }
-  // TODO sr_ufit
+
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr T1 sr_ufit(T1 ival, unsigned nbits SIA80_TM_SITE)
+  {
+    if (SIA80_UNLIKELY(ival < 0)) {
+      SIA80_TM_EVENT(true, ufit, sr);
+      return 0;
+    }
+    // FFR: With C++20, use consteval.
+    constexpr unsigned tbits = ia_limits<T1>::digits;
+    if (nbits >= tbits) {
+      return ival;
+    }
+    using T1X = decltype(ival + 0); // integral promotion
+    const T1X limit = T1X(1) << nbits;
+    if (SIA80_UNLIKELY(ival >= limit)) {
+      SIA80_TM_EVENT(true, ufit, sr);
+      return T1(limit - 1);
+    }
+    return ival;
+  }
 
   //-- sfit ----------------------------------------------------
 
   template<typename T1,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_signed<T1>::value, bool> = true>
-  inline T1 cx_sfit(T1 ival, unsigned nbits)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_signed<T1>::value, bool> = true>
+  constexpr T1 cx_sfit(T1 ival, unsigned nbits)
   {
     // The logic to detect bounds is:
     // Example:
@@ -684,22 +1518,22 @@ namespace sia80 {
     // If nbits < 31, we can form limits with trivial shifts.
     // Example: to fit in 4 bits, value shall be in [-8..7], so, in [~7..7].
     // FFR: With C++20, use consteval.
-    constexpr unsigned ftbits = std::numeric_limits<T1>::digits + 1;
+    constexpr unsigned ftbits = ia_limits<T1>::digits + 1;
     if (nbits >= ftbits) {
       return ival;
     }
     // NB For signed, nothing fits in 0 bits unless we artificially
     // define a special case (but we don't need to).
     if (SIA80_UNLIKELY(nbits == 0)) {
-      throw std::range_error("cx_sfit: nbits==0");
+      SIA80_CX_FAIL(range_error, "cx_sfit: nbits==0");
     }
     using T1X = decltype(ival + 0); // integral promotion
     const T1X tmax = (T1X(1) << (nbits - 1)) - 1;
     if (SIA80_UNLIKELY(ival > tmax)) {
-      throw std::range_error("cx_sfit: too big");
+      SIA80_CX_FAIL(range_error, "cx_sfit: too big");
     }
     if (SIA80_UNLIKELY(ival < ~tmax)) {
-      throw std::range_error("cx_sfit: too small");
+      SIA80_CX_FAIL(range_error, "cx_sfit: too small");
     }
     return ival;
   }
@@ -707,32 +1541,189 @@ namespace sia80 {
   // Difference from signed T1: promotion to unsigned;
   // no check for negative input.
   template<typename T1,
-      std::enable_if_t<std::is_integral<T1>::value, bool> = true,
-      std::enable_if_t<std::is_unsigned<T1>::value, bool> = true>
-  inline T1 cx_sfit(T1 ival, unsigned nbits)
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<!ia_is_signed<T1>::value, bool> = true>
+  constexpr T1 cx_sfit(T1 ival, unsigned nbits)
   {
     // A strange case of request to fit an unsigned value into
     // a signed field...
     // We need at least one bit more than for full value.
-    constexpr unsigned ubits = std::numeric_limits<T1>::digits;
+    constexpr unsigned ubits = ia_limits<T1>::digits;
     if (nbits >= ubits + 1) {
       return ival;
     }
     if (SIA80_UNLIKELY(nbits == 0)) {
-      throw std::range_error("cx_sfit: nbits==0");
+      SIA80_CX_FAIL(range_error, "cx_sfit: nbits==0");
     }
     // Now shift by nbits guaranteedly fits into T1.
     using T1X = decltype(ival + 0u); // integral promotion
     const T1X tmax = (T1X(1u) << (nbits - 1)) - 1;
     if (SIA80_UNLIKELY(ival > tmax)) {
-      throw std::range_error("cx_sfit: too big");
+      SIA80_CX_FAIL(range_error, "cx_sfit: too big");
     }
     return ival;
   }
 
-  // TODO cf_sfit
-  // TODO tr_sfit
-  // TODO sr_sfit
+  // The low nbits of ival, sign-extended: the value which a field
+  // of nbits holds after storing ival into it. For unsigned T1, a
+  // negative field value wraps. Nothing is stored in 0 bits, so
+  // the result is 0.
+  // Same for signed and unsigned T1: a field of digits+1 bits or
+  // wider holds any value.
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr T1 tr_sfit(T1 ival, unsigned nbits)
+  {
+    // FFR: With C++20, use consteval.
+    constexpr unsigned ftbits = ia_limits<T1>::digits + 1;
+    if (nbits >= ftbits) {
+      return ival;
+    }
+    if (nbits == 0) {
+      return 0;
+    }
+    // Sign extension as (x ^ sign) - sign in the unsigned
+    // promoted type: no shifts of negative values.
+    using U = ia_make_unsigned_t<decltype(ival + 0)>;
+    const U sbit = U(1u) << (nbits - 1);
+    const U mask = sbit + (sbit - 1);
+    return T1(((U(ival) & mask) ^ sbit) - sbit);
+  }
+
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr cf_result<T1> cf_sfit(T1 ival, unsigned nbits SIA80_TM_SITE)
+  {
+    const T1 ret = tr_sfit(ival, nbits);
+    // NB For signed, nothing fits in 0 bits (see cx_sfit).
+    bool ovf = ret != ival || nbits == 0;
+    if constexpr(!ia_is_signed<T1>::value) {
+      // A negative field value may wrap back to ival: 255 in 1 bit
+      // is -1, that is 255 again for uint8_t.
+      ovf |= nbits <= ia_limits<T1>::digits && ival > (ia_limits<T1>::max() >> 1);
+    }
+    SIA80_TM_EVENT(ovf, sfit, cf);
+    return { ret, ovf };
+  }
+
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr T1 cf_sfit(T1 ival, unsigned nbits, int *flag SIA80_TM_SITE)
+  {
+    const cf_result<T1> r = cf_sfit(ival, nbits SIA80_TM_PASS);
+    if (r.overflowed) {
+      *flag = 1;
+    }
+    return r.value;
+  }
+
+  // Saturated to [-2^(nbits-1), 2^(nbits-1)-1]. The range is empty
+  // for 0 bits; the result is 0 then, as of tr_sfit.
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_signed<T1>::value, bool> = true>
+  constexpr T1 sr_sfit(T1 ival, unsigned nbits SIA80_TM_SITE)
+  {
+    // FFR: With C++20, use consteval.
+    constexpr unsigned ftbits = ia_limits<T1>::digits + 1;
+    if (nbits >= ftbits) {
+      return ival;
+    }
+    if (SIA80_UNLIKELY(nbits == 0)) {
+      SIA80_TM_EVENT(true, sfit, sr);
+      return 0;
+    }
+    using T1X = decltype(ival + 0); // integral promotion
+    const T1X tmax = (T1X(1) << (nbits - 1)) - 1;
+    if (SIA80_UNLIKELY(ival > tmax)) {
+      SIA80_TM_EVENT(true, sfit, sr);
+      return T1(tmax);
+    }
+    if (SIA80_UNLIKELY(ival < ~tmax)) {
+      SIA80_TM_EVENT(true, sfit, sr);
+      return T1(~tmax);
+    }
+    return ival;
+  }
+
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<!ia_is_signed<T1>::value, bool> = true>
+  constexpr T1 sr_sfit(T1 ival, unsigned nbits SIA80_TM_SITE)
+  {
+    constexpr unsigned ubits = ia_limits<T1>::digits;
+    if (nbits >= ubits + 1) {
+      return ival;
+    }
+    if (SIA80_UNLIKELY(nbits == 0)) {
+      SIA80_TM_EVENT(true, sfit, sr);
+      return 0;
+    }
+    using T1X = decltype(ival + 0u); // integral promotion
+    const T1X tmax = (T1X(1u) << (nbits - 1)) - 1;
+    if (SIA80_UNLIKELY(ival > tmax)) {
+      SIA80_TM_EVENT(true, sfit, sr);
+      return T1(tmax);
+    }
+    return ival;
+  }
+
+  //-- overflow_sticky -----------------------------------------
+
+  // Accumulator of the overflow flag for a chain of cf_xxx operations.
+  // Each method returns the value as the cf_xxx function; the flag
+  // is merged without branches and tested once at the end:
+  //   sia80::overflow_sticky ovf;
+  //   auto x = ovf.add(ovf.mul(a, b), c);
+  //   if (ovf) { ... }
+  // A local object stays in a register unless its address escapes.
+  class overflow_sticky {
+  public:
+    constexpr bool overflowed() const { return ovf; }
+    constexpr explicit operator bool() const { return ovf; }
+    constexpr void reset() { ovf = false; }
+    // Merge an external result; useful with cf_xxx not wrapped here.
+    template <typename T>
+    constexpr T take(cf_result<T> r) { ovf |= r.overflowed; return r.value; }
+
+    template <typename T1, typename T2>
+    constexpr auto add(T1 v1, T2 v2 SIA80_TM_SITE)
+    { return take(cf_add(v1, v2 SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr auto sub(T1 v1, T2 v2 SIA80_TM_SITE)
+    { return take(cf_sub(v1, v2 SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr auto mul(T1 v1, T2 v2 SIA80_TM_SITE)
+    { return take(cf_mul(v1, v2 SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr auto div(T1 ddnd, T2 dvsr SIA80_TM_SITE)
+    { return take(cf_div(ddnd, dvsr SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr auto rem(T1 ddnd, T2 dvsr SIA80_TM_SITE)
+    { return take(cf_rem(ddnd, dvsr SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr auto shl(T1 v1, T2 shcnt SIA80_TM_SITE)
+    { return take(cf_shl(v1, shcnt SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr auto shr(T1 v1, T2 shcnt SIA80_TM_SITE)
+    { return take(cf_shr(v1, shcnt SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr auto shrx(T1 v1, T2 shcnt SIA80_TM_SITE)
+    { return take(cf_shrx(v1, shcnt SIA80_TM_PASS)); }
+    template <typename T1, typename T2>
+    constexpr T1 conv(T2 ival SIA80_TM_SITE)
+    { return take(cf_conv<T1>(ival SIA80_TM_PASS)); }
+    template <typename T1>
+    constexpr T1 ufit(T1 ival, unsigned nbits SIA80_TM_SITE)
+    { return take(cf_ufit(ival, nbits SIA80_TM_PASS)); }
+    template <typename T1>
+    constexpr T1 sfit(T1 ival, unsigned nbits SIA80_TM_SITE)
+    { return take(cf_sfit(ival, nbits SIA80_TM_PASS)); }
+
+  private:
+    // Not bool: OR-ing into an integer lets loops be vectorized.
+    unsigned ovf = 0;
+  };
 
 } // namespace sia80
 // vim: ts=2 sts=2 sw=2 et :
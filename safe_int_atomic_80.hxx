@@ -0,0 +1,345 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+// Checked and saturating read-modify-write on std::atomic<T>, for
+// counters shared between threads.
+//
+//   std::atomic<std::uint32_t> used { 0 };
+//   // never wraps, stays at UINT32_MAX
+//   sia80::sr_fetch_add(used, n);
+//   // throws std::overflow_error, used is unchanged
+//   sia80::cx_fetch_add(used, n);
+//
+// xx_fetch_add(a, v), xx_fetch_sub(a, v), xx_fetch_mul(a, v), with
+// an optional std::memory_order (std::memory_order_seq_cst by
+// default): atomically replace the value of a with a op v, computed
+// in T, and return the previous value, as std::atomic::fetch_add.
+//   cx_fetch_xxx: if a op v doesn't fit T, a is unchanged and
+//     std::overflow_error is thrown.
+//   cf_fetch_xxx(a, v, &flag): stores the truncated value and sets
+//     the flag on overflow; cf_fetch_xxx(a, v) returns cf_result with
+//     the previous value.
+//   sr_fetch_xxx: stores the saturated value.
+// The truncating versions are those of std::atomic (fetch_add and
+// fetch_sub) and are not repeated here.
+//
+// cf_fetch_add and cf_fetch_sub are a single locked add (lock xadd on
+// x86): the atomic wraps anyway, and the overflow is found from the
+// returned previous value. The others must not store a wrong value
+// even for a moment, so they are compare-and-swap loops; on a failed
+// exchange the loop backs off (pause instructions, doubling up to 64,
+// then yield), which keeps the cache line from bouncing between cores
+// on every retry.
+//
+// sharded_counter<T>: an add-only saturating counter of an unsigned T
+// for write-heavy use by many threads (quota and rate counters).
+//   sharded_counter<T> c(limit, shards): counts up to limit (at most
+//     max of T / 2, std::domain_error otherwise; that by default);
+//     shards is rounded up to a power of 2, by default to that of
+//     std::thread::hardware_concurrency().
+//   c.add(v): to the shard of the calling thread (threads take shards
+//     in turn), each in its own cache line. For v <= max of T / 2^16,
+//     a single locked add; if the shard goes over limit, it is
+//     clamped back with a compare-and-swap. This can't wrap unless
+//     2^15 threads add to one shard at once. Larger v use the loop.
+//   c.value(): min(limit, sum of the adds), reading the shards one by
+//     one; it is exact when no add runs concurrently, and never
+//     decreases while adds run. c.saturated(): value() == limit.
+//   c.reset(): all shards to 0; adds running concurrently may or may
+//     not be kept.
+// Atomics of T wider than the machine word may be implemented with
+// locks (and need -latomic).
+
+namespace sia80 {
+
+  namespace at_detail {
+
+    enum class aop { add, sub, mul };
+
+    template <aop Op, typename T>
+    constexpr bool op_overflow(T a, T b, T *res)
+    {
+      if constexpr(Op == aop::add) {
+        return __builtin_add_overflow(a, b, res);
+      }
+      else if constexpr(Op == aop::sub) {
+        return __builtin_sub_overflow(a, b, res);
+      }
+      else {
+        return __builtin_mul_overflow(a, b, res);
+      }
+    }
+
+    // The bound an overflowed a op b saturates to.
+    template <aop Op, typename T>
+    constexpr T sat_value(T a, T b)
+    {
+      bool neg = Op == aop::sub;
+      if constexpr(ia_is_signed<T>::value) {
+        neg = Op == aop::add ? b < 0 : Op == aop::sub ? b > 0 : (a < 0) != (b < 0);
+      }
+      return bl_detail::sat_bound<T>(neg);
+    }
+
+    inline void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__)
+      asm volatile("yield");
+#endif
+    }
+
+    class backoff {
+    public:
+      void pause()
+      {
+        for (unsigned i = 0; i < spins_; ++i) {
+          cpu_relax();
+        }
+        if (spins_ < max_spins) {
+          spins_ *= 2;
+        }
+        else {
+          std::this_thread::yield();
+        }
+      }
+
+    private:
+      static constexpr unsigned max_spins = 64;
+      unsigned spins_ = 1;
+    };
+
+    // The retries of update(), out of the hot path.
+    template <typename T, typename F>
+    [[gnu::noinline, gnu::cold]] T update_retry(std::atomic<T>& a, F next,
+        T old, std::memory_order order)
+    {
+      backoff bo;
+      for (;;) {
+        bo.pause();
+        if (a.compare_exchange_weak(old, next(old), order, std::memory_order_relaxed)) {
+          return old;
+        }
+      }
+    }
+
+    // Replace the value with next(old) by compare-and-swap; next may
+    // throw, leaving it unchanged. Returns the previous value.
+    template <typename T, typename F>
+    inline T update(std::atomic<T>& a, F next, std::memory_order order)
+    {
+      T old = a.load(std::memory_order_relaxed);
+      if (SIA80_UNLIKELY(!a.compare_exchange_weak(old, next(old), order,
+              std::memory_order_relaxed)))
+      {
+        return update_retry(a, next, old, order);
+      }
+      return old;
+    }
+
+    template <aop Op, typename T>
+    inline T cx_fetch(std::atomic<T>& a, T v, std::memory_order order)
+    {
+      return update(a, [v](T old) {
+        T res = 0;
+        if (SIA80_UNLIKELY(op_overflow<Op>(old, v, &res))) {
+          SIA80_CX_FAIL(overflow_error, Op == aop::add ? "cx_fetch_add overflow" :
+              Op == aop::sub ? "cx_fetch_sub overflow" : "cx_fetch_mul overflow");
+        }
+        return res;
+      }, order);
+    }
+
+    template <aop Op, typename T>
+    inline cf_result<T> cf_fetch(std::atomic<T>& a, T v, std::memory_order order)
+    {
+      if constexpr(Op == aop::mul) {
+        bool ovf = false;
+        const T old = update(a, [v, &ovf](T o) {
+          T r = 0;
+          ovf = op_overflow<Op>(o, v, &r);
+          return r;
+        }, order);
+        return { old, ovf };
+      }
+      else {
+        const T old = Op == aop::add ? a.fetch_add(v, order) : a.fetch_sub(v, order);
+        T res = 0;
+        return { old, op_overflow<Op>(old, v, &res) };
+      }
+    }
+
+    template <aop Op, typename T>
+    inline T sr_fetch(std::atomic<T>& a, T v, std::memory_order order)
+    {
+      return update(a, [v](T old) {
+        T res = 0;
+        if (SIA80_UNLIKELY(op_overflow<Op>(old, v, &res))) {
+          res = sat_value<Op>(old, v);
+        }
+        return res;
+      }, order);
+    }
+
+    template <typename T>
+    constexpr bool usable = ia_is_integral<T>::value && !std::is_same<T, bool>::value;
+
+    inline std::atomic<unsigned> next_shard { 0 };
+
+    inline unsigned thread_shard()
+    {
+      static thread_local const unsigned shard =
+          next_shard.fetch_add(1, std::memory_order_relaxed);
+      return shard;
+    }
+
+  } // namespace at_detail
+
+// The forms of one op; std::atomic<T>::value_type keeps v out of
+// the deduction, so that any integer converts to T.
+#define SIA80_AT_OPS(op)                                                      \
+  template <typename T, std::enable_if_t<at_detail::usable<T>, bool> = true>  \
+  inline T cx_fetch_##op(std::atomic<T>& a,                                   \
+      typename std::atomic<T>::value_type v,                                  \
+      std::memory_order order = std::memory_order_seq_cst)                    \
+  {                                                                           \
+    return at_detail::cx_fetch<at_detail::aop::op>(a, v, order);              \
+  }                                                                           \
+                                                                              \
+  template <typename T, std::enable_if_t<at_detail::usable<T>, bool> = true>  \
+  inline T cf_fetch_##op(std::atomic<T>& a,                                   \
+      typename std::atomic<T>::value_type v, int *flag,                       \
+      std::memory_order order = std::memory_order_seq_cst)                    \
+  {                                                                           \
+    const cf_result<T> r = at_detail::cf_fetch<at_detail::aop::op>(a, v, order); \
+    if (SIA80_UNLIKELY(r.overflowed)) {                                       \
+      *flag = 1;                                                              \
+    }                                                                         \
+    return r.value;                                                           \
+  }                                                                           \
+                                                                              \
+  template <typename T, std::enable_if_t<at_detail::usable<T>, bool> = true>  \
+  inline cf_result<T> cf_fetch_##op(std::atomic<T>& a,                        \
+      typename std::atomic<T>::value_type v,                                  \
+      std::memory_order order = std::memory_order_seq_cst)                    \
+  {                                                                           \
+    return at_detail::cf_fetch<at_detail::aop::op>(a, v, order);              \
+  }                                                                           \
+                                                                              \
+  template <typename T, std::enable_if_t<at_detail::usable<T>, bool> = true>  \
+  inline T sr_fetch_##op(std::atomic<T>& a,                                   \
+      typename std::atomic<T>::value_type v,                                  \
+      std::memory_order order = std::memory_order_seq_cst)                    \
+  {                                                                           \
+    return at_detail::sr_fetch<at_detail::aop::op>(a, v, order);              \
+  }
+
+  SIA80_AT_OPS(add)
+  SIA80_AT_OPS(sub)
+  SIA80_AT_OPS(mul)
+
+#undef SIA80_AT_OPS
+
+  template <typename T>
+  class sharded_counter {
+    static_assert(ia_is_integral<T>::value && !ia_is_signed<T>::value,
+        "sharded_counter needs an unsigned type");
+
+  public:
+    explicit sharded_counter(T limit = ia_limits<T>::max() / 2, unsigned shards = 0)
+      : limit_(limit)
+    {
+      if (limit > ia_limits<T>::max() / 2) {
+        SIA80_CX_FAIL(domain_error, "sharded_counter: limit over max / 2");
+      }
+      if (shards == 0) {
+        shards = std::thread::hardware_concurrency();
+      }
+      unsigned n = 1;
+      while (n < shards && n < max_shards) {
+        n *= 2;
+      }
+      mask_ = n - 1;
+      slots_.reset(new slot[n]);
+    }
+
+    void add(T v)
+    {
+      std::atomic<T>& s = slots_[at_detail::thread_shard() & mask_].v;
+      if (SIA80_UNLIKELY(v > small)) {
+        add_slow(s, v);
+        return;
+      }
+      const T now = T(s.fetch_add(v, std::memory_order_relaxed) + v);
+      if (SIA80_UNLIKELY(now > limit_)) {
+        clamp(s, now);
+      }
+    }
+
+    T value() const
+    {
+      // Each term and the sum are at most limit <= max / 2.
+      T sum = 0;
+      for (unsigned i = 0; i <= mask_; ++i) {
+        const T s = slots_[i].v.load(std::memory_order_relaxed);
+        sum = T(sum + (s < limit_ ? s : limit_));
+        sum = sum < limit_ ? sum : limit_;
+      }
+      return sum;
+    }
+
+    bool saturated() const { return value() == limit_; }
+
+    void reset()
+    {
+      for (unsigned i = 0; i <= mask_; ++i) {
+        slots_[i].v.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    T limit() const { return limit_; }
+    unsigned shards() const { return mask_ + 1; }
+
+  private:
+    struct alignas(64) slot {
+      std::atomic<T> v { 0 };
+    };
+
+    static constexpr unsigned max_shards = 1024;
+    // Adds up to this are a locked add; 2^15 of them in flight on top
+    // of max / 2 still don't wrap.
+    static constexpr T small = T(ia_limits<T>::max() >> 16);
+
+    [[gnu::noinline]] void clamp(std::atomic<T>& s, T cur)
+    {
+      while (cur > limit_ &&
+          !s.compare_exchange_weak(cur, limit_, std::memory_order_relaxed))
+      {
+      }
+    }
+
+    [[gnu::noinline]] void add_slow(std::atomic<T>& s, T v)
+    {
+      at_detail::update(s, [this, v](T old) {
+        T res = 0;
+        return __builtin_add_overflow(old, v, &res) || res > limit_ ? limit_ : res;
+      }, std::memory_order_relaxed);
+    }
+
+    std::unique_ptr<slot[]> slots_;
+    unsigned mask_ = 0;
+    T limit_;
+  };
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
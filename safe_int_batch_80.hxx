@@ -0,0 +1,697 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Array (batch) forms of some operations from safe_int_arith_80.hxx.
+//
+// xx_yyy_n(dst, a, b, n): for i in [0, n), dst[i] = xx_yyy(a[i], b[i])
+//   narrowed to the element type T the same way as xx_conv<T>().
+//   For T of int rank and wider, it is exactly xx_yyy(a[i], b[i]);
+//   for narrower T, integral promotion makes the scalar operation
+//   never overflow, so the result is xx_conv<T>(xx_yyy(a[i], b[i])).
+//   Example: sr_add_n() on int8_t gives 127 for 100+100,
+//   as sr_conv<int8_t>(sr_add(100, 100)).
+//   dst may be the same as a or b; other overlaps are not allowed.
+//
+// sr_add_n, sr_sub_n: use saturating instructions (padds/paddus
+//   and psubs/psubus) for 8 and 16 bit elements, compare-and-blend
+//   sequences for 32 and 64 bit elements.
+// sr_mul_n: vectorized for 16 bit elements (pmullw + pmulhw);
+//   other widths are done element-wise with the scalar sr_mul().
+//
+// sr_conv_n<To>(dst, src, n): dst[i] = sr_conv<To>(src[i]).
+// cf_conv_n<To>(dst, src, n): dst[i] = cf_conv<To>(src[i]) (truncated
+//   on failure), and returns the index of the first src[i] which
+//   doesn't fit To, or n if all do.
+//   Narrowing from 16 and 32 bit elements is vectorized: lanes are
+//   clamped to the range of To (min/max in the source width), then
+//   packed with packsswb/packssdw, which can't saturate any more; so
+//   signed to unsigned and unsigned to signed are the same as the
+//   scalar sr_conv. With AVX-512, also from 64 bit elements, and with
+//   vpmovs*/vpmovus* directly when both types have the same
+//   signedness. Other pairs are element-wise. dst and src shall not
+//   overlap.
+//
+// cx_sum, cf_sum, sr_sum: sum of an array, the same as chaining
+//   acc = xx_add(acc, a[i]) from acc = 0, including the exception
+//   thrown by cx_sum(), the flag of cf_sum() and intermediate
+//   saturation of sr_sum(). The result type is that of a[0] + a[0].
+//   Elements are summed block-wise in a wider type, and the bounds
+//   of all partial sums of a block are checked once per block. For
+//   32 and 64 bit elements, a cheap bound from the maximal magnitude
+//   is tried first, then the exact one. Only a block which can
+//   really overflow is rescanned with the scalar xx_add().
+//
+// The instruction set: on x86-64 with GCC or Clang, kernels for
+// SSE2, AVX2 and AVX-512BW are all compiled (with target pragmas,
+// regardless of -m options), and the best one supported by the CPU
+// is chosen at the first call (__builtin_cpu_supports). The choice
+// is kept in a global; further calls cost a load and a switch.
+// With SIA80_BATCH_DISPATCH defined to 0, the instruction set is
+// chosen at compile time instead: the best of AVX-512BW, AVX2, SSE2
+// which is enabled by compiler options. Without any of them (or on
+// non-x86), only scalar code is used.
+//
+// batch_isa_supported(isa): whether the kernel for isa is present
+//   and the CPU can run it. batch_isa::scalar is the plain loop
+//   over scalar functions, always supported with dispatch.
+// batch_force_isa(isa): use the kernel for isa from now on, if it is
+//   supported; returns false (and changes nothing) otherwise.
+//   For tests and benchmarks; calls already running in other threads
+//   finish with the previous kernel. With SIA80_BATCH_DISPATCH=0,
+//   only the kernel chosen at compile time is supported.
+// batch_current_isa(): the kernel in use.
+
+namespace sia80 {
+
+  namespace batch_detail {
+
+    enum { op_add, op_sub, op_mul };
+
+    // Scalar reference for one element. Used for array tails
+    // and where no vector form exists.
+    template <int Op, typename T>
+    inline T sop(T a, T b)
+    {
+      if constexpr(Op == op_add) {
+        return sr_conv<T>(sr_add(a, b));
+      }
+      else if constexpr(Op == op_sub) {
+        return sr_conv<T>(sr_sub(a, b));
+      }
+      else {
+        return sr_conv<T>(sr_mul(a, b));
+      }
+    }
+
+    template <int Op, typename T>
+    inline void sr_op_n_scalar(T *dst, const T *a, const T *b, std::size_t n)
+    {
+      for (std::size_t i = 0; i < n; ++i) {
+        dst[i] = sop<Op, T>(a[i], b[i]);
+      }
+    }
+
+    //-- narrowing conversions ---------------------------------
+
+    // Index of the first of p[0..n) which doesn't fit To, or n.
+    template <typename To, typename From>
+    inline std::size_t conv_first_bad(const From *p, std::size_t n)
+    {
+      std::size_t i = 0;
+      while (i < n && !cf_conv<To>(p[i]).overflowed) {
+        ++i;
+      }
+      return i;
+    }
+
+    // Elements [i, n) of xx_conv_n, and the index of the first which
+    // doesn't fit, or first if it is already less than n.
+    template <bool Cf, typename To, typename From>
+    inline std::size_t conv_n_scalar(To *dst, const From *src, std::size_t i,
+        std::size_t n, std::size_t first)
+    {
+      for (; i < n; ++i) {
+        if constexpr(Cf) {
+          const cf_result<To> r = cf_conv<To>(src[i]);
+          dst[i] = r.value;
+          if (SIA80_UNLIKELY(r.overflowed) && first == n) {
+            first = i;
+          }
+        }
+        else {
+          dst[i] = sr_conv<To>(src[i], branchless);
+        }
+      }
+      return first;
+    }
+
+    //-- bit fields --------------------------------------------
+
+    // Bitwise OR of p[0..n); with Magn, of x ^ (x << 1) for signed
+    // T (see vmagn() in the kernels).
+    template <bool Magn, typename T>
+    inline std::make_unsigned_t<T> or_n_scalar(const T *p, std::size_t n)
+    {
+      using U = std::make_unsigned_t<T>;
+      U r = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        const U x = U(p[i]);
+        r |= Magn && std::is_signed<T>::value ? U(x ^ U(x << 1)) : x;
+      }
+      return r;
+    }
+
+    //-- sum helpers -------------------------------------------
+
+    enum { mode_cx, mode_cf, mode_sr };
+
+    // Small enough to rescan from L1 cache on a suspected overflow;
+    // large enough to make the per-block check negligible.
+    constexpr std::size_t sum_block = 1024;
+
+    // Summary of a block of up to sum_block elements: all partial
+    // sums of the block are in [lo, hi]; sum is the exact total.
+    // With exact == true, lo and hi are the sums of negative and
+    // positive elements, the tightest bounds for a block; otherwise
+    // they are cheaper conservative bounds.
+    template <typename T>
+    struct block_sums {
+      // Signed for narrow T: the accumulator type after promotion
+      // may be signed even for unsigned T.
+#if defined(__SIZEOF_INT128__)
+      using W = std::conditional_t<sizeof(T) <= 4, std::int64_t,
+          std::conditional_t<std::is_signed<T>::value, __int128, unsigned __int128>>;
+#else
+      using W = std::conditional_t<sizeof(T) <= 4, std::int64_t, std::uint64_t>;
+#endif
+      W lo;
+      W hi;
+      W sum;
+      bool exact;
+    };
+
+    template <typename T>
+    inline block_sums<T> get_block_sums(const T *p, std::size_t n)
+    {
+      using W = typename block_sums<T>::W;
+      if constexpr(sizeof(T) <= 4 && std::is_signed<T>::value) {
+        std::int64_t sn = 0, sp = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+          T x = p[i];
+          sn += x < 0 ? x : 0;
+          sp += x > 0 ? x : 0;
+        }
+        return { sn, sp, sn + sp, true };
+      }
+      else if constexpr(sizeof(T) <= 4) {
+        std::int64_t sp = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+          sp += p[i];
+        }
+        return { 0, sp, sp, true };
+      }
+      else if constexpr(std::is_signed<T>::value) {
+        // No vector 128-bit adds: sum signed upper and unsigned
+        // lower 32-bit halves separately, each fits in 64 bits.
+        std::int64_t nh = 0, ph = 0;
+        std::uint64_t nl = 0, pl = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+          std::int64_t x = p[i];
+          std::int64_t xn = x < 0 ? x : 0;
+          std::int64_t xp = x > 0 ? x : 0;
+          nh += xn >> 32;
+          nl += std::uint32_t(xn);
+          ph += xp >> 32;
+          pl += std::uint32_t(xp);
+        }
+        const W k = W(1) << 32;
+        const W sn = W(nh) * k + W(nl);
+        const W sp = W(ph) * k + W(pl);
+        return { sn, sp, sn + sp, true };
+      }
+      else {
+        std::uint64_t ph = 0, pl = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+          std::uint64_t x = p[i];
+          ph += x >> 32;
+          pl += std::uint32_t(x);
+        }
+        const W sp = (W(ph) << 32) + W(pl);
+        return { 0, sp, sp, true };
+      }
+    }
+
+    // Block summary functions of one kernel: cheap bounds (may be
+    // inexact) and exact sums.
+    template <typename T>
+    struct block_fns {
+      block_sums<T> (*bound)(const T *p, std::size_t n);
+      block_sums<T> (*sums)(const T *p, std::size_t n);
+    };
+
+  } // namespace batch_detail
+
+} // namespace sia80
+
+#if !defined(SIA80_BATCH_DISPATCH)
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SIA80_BATCH_DISPATCH 1
+#else
+#define SIA80_BATCH_DISPATCH 0
+#endif
+#endif
+
+namespace sia80 {
+
+  enum class batch_isa { scalar, sse2, avx2, avx512bw };
+
+} // namespace sia80
+
+#if SIA80_BATCH_DISPATCH
+
+// Each kernel is compiled for its own instruction set. Clang ignores
+// the GCC target pragma and has its own way to apply the attribute.
+
+#define SIA80_KNS kern_sse2
+#define SIA80_KBITS 128
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+#include <safe_int_batch_80_kern.hxx>
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#undef SIA80_KNS
+#undef SIA80_KBITS
+
+#define SIA80_KNS kern_avx2
+#define SIA80_KBITS 256
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#include <safe_int_batch_80_kern.hxx>
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#undef SIA80_KNS
+#undef SIA80_KBITS
+
+#define SIA80_KNS kern_avx512bw
+#define SIA80_KBITS 512
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f,avx512bw"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+#endif
+#include <safe_int_batch_80_kern.hxx>
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#undef SIA80_KNS
+#undef SIA80_KBITS
+
+namespace sia80 {
+
+  namespace batch_detail {
+
+    // -1 until the first call.
+    inline std::atomic<int> isa_choice { -1 };
+
+    inline bool cpu_has_isa(batch_isa isa)
+    {
+      __builtin_cpu_init();
+      switch (isa) {
+        case batch_isa::scalar:
+        case batch_isa::sse2:
+          return true;
+        case batch_isa::avx2:
+          return __builtin_cpu_supports("avx2");
+        case batch_isa::avx512bw:
+          return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+      }
+      return false;
+    }
+
+    inline batch_isa best_isa()
+    {
+      if (cpu_has_isa(batch_isa::avx512bw)) {
+        return batch_isa::avx512bw;
+      }
+      if (cpu_has_isa(batch_isa::avx2)) {
+        return batch_isa::avx2;
+      }
+      return batch_isa::sse2;
+    }
+
+    inline batch_isa current_isa()
+    {
+      int c = isa_choice.load(std::memory_order_relaxed);
+      if (SIA80_UNLIKELY(c < 0)) {
+        c = int(best_isa());
+        isa_choice.store(c, std::memory_order_relaxed);
+      }
+      return batch_isa(c);
+    }
+
+  } // namespace batch_detail
+
+  inline bool batch_isa_supported(batch_isa isa)
+  {
+    return batch_detail::cpu_has_isa(isa);
+  }
+
+} // namespace sia80
+
+namespace sia80 {
+
+  namespace batch_detail {
+
+    template <int Op, typename T>
+    inline void sel_op_n(T *dst, const T *a, const T *b, std::size_t n)
+    {
+      switch (current_isa()) {
+        case batch_isa::avx512bw:
+          kern_avx512bw::sr_op_n<Op, T>(dst, a, b, n);
+          return;
+        case batch_isa::avx2:
+          kern_avx2::sr_op_n<Op, T>(dst, a, b, n);
+          return;
+        case batch_isa::sse2:
+          kern_sse2::sr_op_n<Op, T>(dst, a, b, n);
+          return;
+        default:
+          sr_op_n_scalar<Op, T>(dst, a, b, n);
+          return;
+      }
+    }
+
+    template <bool Cf, typename To, typename From>
+    inline std::size_t sel_conv_n(To *dst, const From *src, std::size_t n)
+    {
+      switch (current_isa()) {
+        case batch_isa::avx512bw:
+          return kern_avx512bw::conv_n<Cf>(dst, src, n);
+        case batch_isa::avx2:
+          return kern_avx2::conv_n<Cf>(dst, src, n);
+        case batch_isa::sse2:
+          return kern_sse2::conv_n<Cf>(dst, src, n);
+        default:
+          return conv_n_scalar<Cf>(dst, src, 0, n, n);
+      }
+    }
+
+    template <bool Magn, typename T>
+    inline std::make_unsigned_t<T> sel_or_n(const T *p, std::size_t n)
+    {
+      switch (current_isa()) {
+        case batch_isa::avx512bw:
+          return kern_avx512bw::or_n<Magn>(p, n);
+        case batch_isa::avx2:
+          return kern_avx2::or_n<Magn>(p, n);
+        case batch_isa::sse2:
+          return kern_sse2::or_n<Magn>(p, n);
+        default:
+          return or_n_scalar<Magn>(p, n);
+      }
+    }
+
+    template <typename T>
+    inline block_fns<T> sel_block_fns()
+    {
+      switch (current_isa()) {
+        case batch_isa::avx512bw:
+          return { kern_avx512bw::vblock_bound<T>, kern_avx512bw::vblock_sums<T> };
+        case batch_isa::avx2:
+          return { kern_avx2::vblock_bound<T>, kern_avx2::vblock_sums<T> };
+        case batch_isa::sse2:
+          return { kern_sse2::vblock_bound<T>, kern_sse2::vblock_sums<T> };
+        default:
+          return { get_block_sums<T>, get_block_sums<T> };
+      }
+    }
+
+  } // namespace batch_detail
+
+} // namespace sia80
+
+#else // !SIA80_BATCH_DISPATCH
+
+#if defined(__x86_64__) && defined(__AVX512BW__)
+#define SIA80_KNS kern_avx512bw
+#define SIA80_KBITS 512
+#define SIA80_KISA batch_isa::avx512bw
+#elif defined(__x86_64__) && defined(__AVX2__)
+#define SIA80_KNS kern_avx2
+#define SIA80_KBITS 256
+#define SIA80_KISA batch_isa::avx2
+#elif defined(__x86_64__) && defined(__SSE2__)
+#define SIA80_KNS kern_sse2
+#define SIA80_KBITS 128
+#define SIA80_KISA batch_isa::sse2
+#endif
+
+#if defined(SIA80_KNS)
+#include <safe_int_batch_80_kern.hxx>
+#else
+#define SIA80_KISA batch_isa::scalar
+#endif
+
+namespace sia80 {
+
+  namespace batch_detail {
+
+    inline batch_isa current_isa()
+    {
+      return SIA80_KISA;
+    }
+
+    template <int Op, typename T>
+    inline void sel_op_n(T *dst, const T *a, const T *b, std::size_t n)
+    {
+#if defined(SIA80_KNS)
+      SIA80_KNS::sr_op_n<Op, T>(dst, a, b, n);
+#else
+      sr_op_n_scalar<Op, T>(dst, a, b, n);
+#endif
+    }
+
+    template <bool Cf, typename To, typename From>
+    inline std::size_t sel_conv_n(To *dst, const From *src, std::size_t n)
+    {
+#if defined(SIA80_KNS)
+      return SIA80_KNS::conv_n<Cf>(dst, src, n);
+#else
+      return conv_n_scalar<Cf>(dst, src, 0, n, n);
+#endif
+    }
+
+    template <bool Magn, typename T>
+    inline std::make_unsigned_t<T> sel_or_n(const T *p, std::size_t n)
+    {
+#if defined(SIA80_KNS)
+      return SIA80_KNS::or_n<Magn>(p, n);
+#else
+      return or_n_scalar<Magn>(p, n);
+#endif
+    }
+
+    template <typename T>
+    inline block_fns<T> sel_block_fns()
+    {
+#if defined(SIA80_KNS)
+      return { SIA80_KNS::vblock_bound<T>, SIA80_KNS::vblock_sums<T> };
+#else
+      return { get_block_sums<T>, get_block_sums<T> };
+#endif
+    }
+
+  } // namespace batch_detail
+
+  // Only the kernel chosen at compile time is present.
+  inline bool batch_isa_supported(batch_isa isa)
+  {
+    return isa == SIA80_KISA;
+  }
+
+} // namespace sia80
+
+#undef SIA80_KNS
+#undef SIA80_KBITS
+#undef SIA80_KISA
+
+#endif // SIA80_BATCH_DISPATCH
+
+namespace sia80 {
+
+  inline batch_isa batch_current_isa()
+  {
+    return batch_detail::current_isa();
+  }
+
+  inline bool batch_force_isa(batch_isa isa)
+  {
+    if (!batch_isa_supported(isa)) {
+      return false;
+    }
+#if SIA80_BATCH_DISPATCH
+    batch_detail::isa_choice.store(int(isa), std::memory_order_relaxed);
+#endif
+    return true;
+  }
+
+} // namespace sia80
+
+namespace sia80 {
+
+  namespace batch_detail {
+
+    template <int Mode, typename T>
+    inline auto sum_n(const T *p, std::size_t n, int *flag) -> decltype(p[0] + p[0])
+    {
+      using TR = decltype(p[0] + p[0]);
+      TR acc = 0;
+      std::size_t i = 0;
+#if !defined(__SIZEOF_INT128__)
+      if constexpr(sizeof(T) <= 4)
+#endif
+      {
+        using W = typename block_sums<T>::W;
+        const block_fns<T> fns = sel_block_fns<T>();
+        constexpr W rvmin = std::numeric_limits<TR>::min();
+        constexpr W rvmax = std::numeric_limits<TR>::max();
+        for (; i < n; i += sum_block) {
+          std::size_t m = n - i < sum_block ? n - i : sum_block;
+          block_sums<T> bs = fns.bound(p + i, m);
+          if (!bs.exact && (W(acc) + bs.lo < rvmin || W(acc) + bs.hi > rvmax)) {
+            bs = fns.sums(p + i, m);
+          }
+          if (!(W(acc) + bs.lo < rvmin || W(acc) + bs.hi > rvmax)) {
+            acc = TR(W(acc) + bs.sum);
+            continue;
+          }
+          // Some partial sum may overflow: rescan the block.
+          for (std::size_t j = i; j < i + m; ++j) {
+            if constexpr(Mode == mode_cx) {
+              acc = cx_add(acc, p[j]);
+            }
+            else if constexpr(Mode == mode_cf) {
+              acc = cf_add(acc, p[j], flag);
+            }
+            else {
+              acc = sr_add(acc, p[j]);
+            }
+          }
+        }
+      }
+      for (; i < n; ++i) {
+        if constexpr(Mode == mode_cx) {
+          acc = cx_add(acc, p[i]);
+        }
+        else if constexpr(Mode == mode_cf) {
+          acc = cf_add(acc, p[i], flag);
+        }
+        else {
+          acc = sr_add(acc, p[i]);
+        }
+      }
+      return acc;
+    }
+
+  } // namespace batch_detail
+
+  //-- sr_add_n ------------------------------------------------
+
+  template <typename T,
+      std::enable_if_t<std::is_integral<T>::value, bool> = true>
+  inline void sr_add_n(T *dst, const T *a, const T *b, std::size_t n)
+  {
+    batch_detail::sel_op_n<batch_detail::op_add, T>(dst, a, b, n);
+  }
+
+  //-- sr_sub_n ------------------------------------------------
+
+  template <typename T,
+      std::enable_if_t<std::is_integral<T>::value, bool> = true>
+  inline void sr_sub_n(T *dst, const T *a, const T *b, std::size_t n)
+  {
+    batch_detail::sel_op_n<batch_detail::op_sub, T>(dst, a, b, n);
+  }
+
+  //-- sr_mul_n ------------------------------------------------
+
+  template <typename T,
+      std::enable_if_t<std::is_integral<T>::value, bool> = true>
+  inline void sr_mul_n(T *dst, const T *a, const T *b, std::size_t n)
+  {
+    batch_detail::sel_op_n<batch_detail::op_mul, T>(dst, a, b, n);
+  }
+
+  //-- sr_conv_n, cf_conv_n ------------------------------------
+
+  template <typename To, typename From,
+      std::enable_if_t<std::is_integral<To>::value, bool> = true,
+      std::enable_if_t<std::is_integral<From>::value, bool> = true>
+  inline void sr_conv_n(To *dst, const From *src, std::size_t n)
+  {
+    batch_detail::sel_conv_n<false>(dst, src, n);
+  }
+
+  template <typename To, typename From,
+      std::enable_if_t<std::is_integral<To>::value, bool> = true,
+      std::enable_if_t<std::is_integral<From>::value, bool> = true>
+  inline std::size_t cf_conv_n(To *dst, const From *src, std::size_t n)
+  {
+    return batch_detail::sel_conv_n<true>(dst, src, n);
+  }
+
+  //-- sum -----------------------------------------------------
+
+  template <typename T,
+      std::enable_if_t<std::is_integral<T>::value, bool> = true>
+  inline auto cx_sum(const T *p, std::size_t n) -> decltype(p[0] + p[0])
+  {
+    return batch_detail::sum_n<batch_detail::mode_cx>(p, n, nullptr);
+  }
+
+  template <typename T,
+      std::enable_if_t<std::is_integral<T>::value, bool> = true>
+  inline auto cf_sum(const T *p, std::size_t n, int *flag) -> decltype(p[0] + p[0])
+  {
+    return batch_detail::sum_n<batch_detail::mode_cf>(p, n, flag);
+  }
+
+  template <typename T,
+      std::enable_if_t<std::is_integral<T>::value, bool> = true>
+  inline auto sr_sum(const T *p, std::size_t n) -> decltype(p[0] + p[0])
+  {
+    return batch_detail::sum_n<batch_detail::mode_sr>(p, n, nullptr);
+  }
+
+  // Versions for contiguous ranges: arrays, std::vector, std::array etc.
+
+  template <typename C>
+  inline auto cx_sum(const C& c) -> decltype(cx_sum(std::data(c), std::size(c)))
+  {
+    return cx_sum(std::data(c), std::size(c));
+  }
+
+  template <typename C>
+  inline auto cf_sum(const C& c, int *flag) -> decltype(cf_sum(std::data(c), std::size(c), flag))
+  {
+    return cf_sum(std::data(c), std::size(c), flag);
+  }
+
+  template <typename C>
+  inline auto sr_sum(const C& c) -> decltype(sr_sum(std::data(c), std::size(c)))
+  {
+    return sr_sum(std::data(c), std::size(c));
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
@@ -0,0 +1,743 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+// Vector kernels for safe_int_batch_80.hxx.
+// NB No include guard: this file is included once per instruction set,
+// with SIA80_KNS (namespace name) and SIA80_KBITS (128, 256 or 512)
+// defined by the includer. Don't include it directly.
+
+#if !defined(SIA80_KNS) || !defined(SIA80_KBITS)
+#error "safe_int_batch_80_kern.hxx is internal to safe_int_batch_80.hxx"
+#endif
+
+#if SIA80_KBITS == 128
+#define SIA80_KMM(op) _mm_##op
+#define SIA80_KSI(op) _mm_##op##_si128
+#elif SIA80_KBITS == 256
+#define SIA80_KMM(op) _mm256_##op
+#define SIA80_KSI(op) _mm256_##op##_si256
+#elif SIA80_KBITS == 512
+#define SIA80_KMM(op) _mm512_##op
+#define SIA80_KSI(op) _mm512_##op##_si512
+#else
+#error "SIA80_KBITS shall be 128, 256 or 512"
+#endif
+
+#if SIA80_KBITS == 512 && defined(__GNUC__) && !defined(__clang__)
+// GCC 12 AVX-512 intrinsics warn on their own _mm512_undefined_epi32().
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+
+namespace sia80 {
+namespace batch_detail {
+namespace SIA80_KNS {
+
+#if SIA80_KBITS == 128
+  using V = __m128i;
+#elif SIA80_KBITS == 256
+  using V = __m256i;
+#else
+  using V = __m512i;
+#endif
+
+  constexpr std::size_t vbytes = SIA80_KBITS / 8;
+
+  //-- primitives ----------------------------------------------
+
+  inline V vload(const void *p) { return SIA80_KSI(loadu)((const V *) p); }
+  inline void vstore(void *p, V v) { SIA80_KSI(storeu)((V *) p, v); }
+  inline V vand(V a, V b) { return SIA80_KSI(and)(a, b); }
+  inline V vor(V a, V b) { return SIA80_KSI(or)(a, b); }
+  inline V vxor(V a, V b) { return SIA80_KSI(xor)(a, b); }
+  // ~a & b, as the instruction does.
+  inline V vandnot(V a, V b) { return SIA80_KSI(andnot)(a, b); }
+  // Per lane: mask ? x : y. Mask lanes are all-zeros or all-ones.
+  inline V vblend(V mask, V x, V y) { return vor(vand(mask, x), vandnot(mask, y)); }
+
+  template <typename T>
+  inline V vset1(T x)
+  {
+    if constexpr(sizeof(T) == 1) {
+      return SIA80_KMM(set1_epi8)(char(x));
+    }
+    else if constexpr(sizeof(T) == 2) {
+      return SIA80_KMM(set1_epi16)(short(x));
+    }
+    else if constexpr(sizeof(T) == 4) {
+      return SIA80_KMM(set1_epi32)(int(x));
+    }
+    else {
+#if SIA80_KBITS == 512
+      return _mm512_set1_epi64((long long) x);
+#else
+      return SIA80_KMM(set1_epi64x)((long long) x);
+#endif
+    }
+  }
+
+  template <typename T>
+  inline V vadd(V a, V b)
+  {
+    if constexpr(sizeof(T) == 1) {
+      return SIA80_KMM(add_epi8)(a, b);
+    }
+    else if constexpr(sizeof(T) == 2) {
+      return SIA80_KMM(add_epi16)(a, b);
+    }
+    else if constexpr(sizeof(T) == 4) {
+      return SIA80_KMM(add_epi32)(a, b);
+    }
+    else {
+      return SIA80_KMM(add_epi64)(a, b);
+    }
+  }
+
+  template <typename T>
+  inline V vsub(V a, V b)
+  {
+    if constexpr(sizeof(T) == 1) {
+      return SIA80_KMM(sub_epi8)(a, b);
+    }
+    else if constexpr(sizeof(T) == 2) {
+      return SIA80_KMM(sub_epi16)(a, b);
+    }
+    else if constexpr(sizeof(T) == 4) {
+      return SIA80_KMM(sub_epi32)(a, b);
+    }
+    else {
+      return SIA80_KMM(sub_epi64)(a, b);
+    }
+  }
+
+  // Broadcast of the lane sign bit to the whole lane.
+  // Only for 2, 4 and 8 byte lanes.
+  template <typename T>
+  inline V vsign(V a)
+  {
+    if constexpr(sizeof(T) == 2) {
+      return SIA80_KMM(srai_epi16)(a, 15);
+    }
+    else if constexpr(sizeof(T) == 4) {
+      return SIA80_KMM(srai_epi32)(a, 31);
+    }
+    else {
+#if SIA80_KBITS == 512
+      return _mm512_srai_epi64(a, 63);
+#else
+      // No 64-bit arithmetic shift before AVX-512: spread
+      // the sign of the upper halves to both halves.
+      return SIA80_KMM(shuffle_epi32)(SIA80_KMM(srai_epi32)(a, 31), 0xF5);
+#endif
+    }
+  }
+
+  inline V vcmpgt8(V a, V b)
+  {
+#if SIA80_KBITS == 512
+    return _mm512_movm_epi8(_mm512_cmpgt_epi8_mask(a, b));
+#else
+    return SIA80_KMM(cmpgt_epi8)(a, b);
+#endif
+  }
+
+  inline V vcmpeq16(V a, V b)
+  {
+#if SIA80_KBITS == 512
+    return _mm512_movm_epi16(_mm512_cmpeq_epi16_mask(a, b));
+#else
+    return SIA80_KMM(cmpeq_epi16)(a, b);
+#endif
+  }
+
+  //-- saturating operations -----------------------------------
+
+  // Lanes of 1 and 2 bytes have direct saturating instructions.
+  // For 4 and 8 byte lanes, the wrapped result is checked with
+  // the classic sign-bit formulas (Hacker's Delight, 2-13) and
+  // the saturated value is blended in.
+
+  template <typename T>
+  inline V vsr_add(V a, V b)
+  {
+    if constexpr(sizeof(T) == 1 && std::is_signed<T>::value) {
+      return SIA80_KMM(adds_epi8)(a, b);
+    }
+    else if constexpr(sizeof(T) == 1) {
+      return SIA80_KMM(adds_epu8)(a, b);
+    }
+    else if constexpr(sizeof(T) == 2 && std::is_signed<T>::value) {
+      return SIA80_KMM(adds_epi16)(a, b);
+    }
+    else if constexpr(sizeof(T) == 2) {
+      return SIA80_KMM(adds_epu16)(a, b);
+    }
+    else if constexpr(std::is_signed<T>::value) {
+      V s = vadd<T>(a, b);
+      V ovf = vsign<T>(vand(vxor(a, s), vxor(b, s)));
+      V sat = vxor(vsign<T>(a), vset1<T>(std::numeric_limits<T>::max()));
+      return vblend(ovf, sat, s);
+    }
+    else {
+      V s = vadd<T>(a, b);
+      V carry = vsign<T>(vor(vand(a, b), vandnot(s, vor(a, b))));
+      return vor(s, carry);
+    }
+  }
+
+  template <typename T>
+  inline V vsr_sub(V a, V b)
+  {
+    if constexpr(sizeof(T) == 1 && std::is_signed<T>::value) {
+      return SIA80_KMM(subs_epi8)(a, b);
+    }
+    else if constexpr(sizeof(T) == 1) {
+      return SIA80_KMM(subs_epu8)(a, b);
+    }
+    else if constexpr(sizeof(T) == 2 && std::is_signed<T>::value) {
+      return SIA80_KMM(subs_epi16)(a, b);
+    }
+    else if constexpr(sizeof(T) == 2) {
+      return SIA80_KMM(subs_epu16)(a, b);
+    }
+    else if constexpr(std::is_signed<T>::value) {
+      V d = vsub<T>(a, b);
+      V ovf = vsign<T>(vand(vxor(a, b), vxor(a, d)));
+      V sat = vxor(vsign<T>(a), vset1<T>(std::numeric_limits<T>::max()));
+      return vblend(ovf, sat, d);
+    }
+    else {
+      V d = vsub<T>(a, b);
+      V borrow = vsign<T>(vor(vandnot(a, b), vandnot(vxor(a, b), d)));
+      return vandnot(borrow, d);
+    }
+  }
+
+  // Only 2 byte lanes: the high half of the product is available
+  // directly. Other widths go the scalar way.
+  template <typename T>
+  inline V vsr_mul(V a, V b)
+  {
+    static_assert(sizeof(T) == 2, "vsr_mul: only 16-bit lanes");
+    V lo = SIA80_KMM(mullo_epi16)(a, b);
+    if constexpr(std::is_signed<T>::value) {
+      V hi = SIA80_KMM(mulhi_epi16)(a, b);
+      V fits = vcmpeq16(hi, vsign<T>(lo));
+      V sat = vxor(vsign<T>(vxor(a, b)), vset1<T>(std::numeric_limits<T>::max()));
+      return vblend(fits, lo, sat);
+    }
+    else {
+      V hi = SIA80_KMM(mulhi_epu16)(a, b);
+      V fits = vcmpeq16(hi, SIA80_KSI(setzero)());
+      return vblend(fits, lo, vset1<T>(std::numeric_limits<T>::max()));
+    }
+  }
+
+  //-- block sums ----------------------------------------------
+
+  // Sum of lanes of type L.
+  template <typename L>
+  inline L vhsum(V v)
+  {
+    L buf[vbytes / sizeof(L)];
+    vstore(buf, v);
+    L s = 0;
+    for (L x : buf) {
+      s += x;
+    }
+    return s;
+  }
+
+  // Vector version of batch_detail::get_block_sums().
+  // Negative and positive parts are separated by the sign mask and
+  // summed in lanes wide enough for sum_block elements: 64-bit lanes
+  // via psadbw for 8-bit elements, 32-bit lanes via pmaddwd for
+  // 16-bit elements. 32 and 64 bit elements are split into 32-bit
+  // halves, each summed in 64-bit lanes.
+  template <typename T>
+  inline block_sums<T> vblock_sums(const T *p, std::size_t n)
+  {
+    using W = typename block_sums<T>::W;
+    constexpr std::size_t lanes = vbytes / sizeof(T);
+    const std::size_t nv = n - n % lanes;
+    const V zero = SIA80_KSI(setzero)();
+    const V lo32 = vset1<std::uint64_t>(0xFFFFFFFFu);
+    const V ones16 = vset1<std::int16_t>(1);
+    V acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+    for (std::size_t i = 0; i < nv; i += lanes) {
+      V x = vload(p + i);
+      if constexpr(sizeof(T) == 1 && std::is_signed<T>::value) {
+        V s = vcmpgt8(zero, x);
+        acc0 = vadd<std::int64_t>(acc0, SIA80_KMM(sad_epu8)(vandnot(s, x), zero));
+        V m = vsub<T>(zero, vand(s, x));
+        acc1 = vadd<std::int64_t>(acc1, SIA80_KMM(sad_epu8)(m, zero));
+      }
+      else if constexpr(sizeof(T) == 1) {
+        acc0 = vadd<std::int64_t>(acc0, SIA80_KMM(sad_epu8)(x, zero));
+      }
+      else if constexpr(sizeof(T) == 2 && std::is_signed<T>::value) {
+        V s = vsign<T>(x);
+        acc0 = vadd<std::int32_t>(acc0, SIA80_KMM(madd_epi16)(vandnot(s, x), ones16));
+        acc1 = vadd<std::int32_t>(acc1, SIA80_KMM(madd_epi16)(vand(s, x), ones16));
+      }
+      else if constexpr(sizeof(T) == 2) {
+        acc0 = vadd<std::int32_t>(acc0, SIA80_KMM(srli_epi32)(x, 16));
+        acc1 = vadd<std::int32_t>(acc1, vand(x, vset1<std::int32_t>(0xFFFF)));
+      }
+      else if constexpr(sizeof(T) == 4 && std::is_signed<T>::value) {
+        V s = vsign<T>(x);
+        V xp = vandnot(s, x);
+        V xm = vsub<T>(zero, vand(s, x));
+        acc0 = vadd<std::int64_t>(acc0,
+            vadd<std::int64_t>(vand(xp, lo32), SIA80_KMM(srli_epi64)(xp, 32)));
+        acc1 = vadd<std::int64_t>(acc1,
+            vadd<std::int64_t>(vand(xm, lo32), SIA80_KMM(srli_epi64)(xm, 32)));
+      }
+      else if constexpr(sizeof(T) == 4) {
+        acc0 = vadd<std::int64_t>(acc0,
+            vadd<std::int64_t>(vand(x, lo32), SIA80_KMM(srli_epi64)(x, 32)));
+      }
+      else if constexpr(std::is_signed<T>::value) {
+        V s = vsign<T>(x);
+        V xp = vandnot(s, x);
+        V xm = vsub<T>(zero, vand(s, x));
+        acc0 = vadd<T>(acc0, vand(xp, lo32));
+        acc1 = vadd<T>(acc1, SIA80_KMM(srli_epi64)(xp, 32));
+        acc2 = vadd<T>(acc2, vand(xm, lo32));
+        acc3 = vadd<T>(acc3, SIA80_KMM(srli_epi64)(xm, 32));
+      }
+      else {
+        acc0 = vadd<T>(acc0, vand(x, lo32));
+        acc1 = vadd<T>(acc1, SIA80_KMM(srli_epi64)(x, 32));
+      }
+    }
+    block_sums<T> r = get_block_sums(p + nv, n - nv);
+    W neg = 0, pos = 0;
+    if constexpr(sizeof(T) == 1 && std::is_signed<T>::value) {
+      pos = W(vhsum<std::uint64_t>(acc0));
+      neg = -W(vhsum<std::uint64_t>(acc1));
+    }
+    else if constexpr(sizeof(T) == 1 || sizeof(T) == 4) {
+      if constexpr(std::is_signed<T>::value) {
+        neg = -W(vhsum<std::uint64_t>(acc1));
+      }
+      pos = W(vhsum<std::uint64_t>(acc0));
+    }
+    else if constexpr(sizeof(T) == 2 && std::is_signed<T>::value) {
+      pos = W(vhsum<std::int32_t>(acc0));
+      neg = W(vhsum<std::int32_t>(acc1));
+    }
+    else if constexpr(sizeof(T) == 2) {
+      pos = W(vhsum<std::int32_t>(acc0)) + W(vhsum<std::int32_t>(acc1));
+    }
+    else {
+      // 64-bit halves: the low ones may exceed 32 bits in sum,
+      // so combine in W.
+      if constexpr(std::is_signed<T>::value) {
+        neg = -(W(vhsum<std::uint64_t>(acc3)) * (W(1) << 32) + W(vhsum<std::uint64_t>(acc2)));
+      }
+      pos = W(vhsum<std::uint64_t>(acc1)) * (W(1) << 32) + W(vhsum<std::uint64_t>(acc0));
+    }
+    r.lo += neg;
+    r.hi += pos;
+    r.sum += neg + pos;
+    return r;
+  }
+
+  // Magnitude bits for vblock_bound() and or_n(). For signed lanes,
+  // x ^ (x << 1) is below 2^k only if bits k..top of x are copies of
+  // the sign, that is, x in [-2^k, 2^k); so |x| never exceeds it.
+  template <typename T>
+  inline V vmagn(V x)
+  {
+    if constexpr(!std::is_signed<T>::value) {
+      return x;
+    }
+    else if constexpr(sizeof(T) == 1) {
+      return vxor(x, vadd<T>(x, x));
+    }
+    else if constexpr(sizeof(T) == 2) {
+      return vxor(x, SIA80_KMM(slli_epi16)(x, 1));
+    }
+    else if constexpr(sizeof(T) == 4) {
+      return vxor(x, SIA80_KMM(slli_epi32)(x, 1));
+    }
+    else {
+      return vxor(x, SIA80_KMM(slli_epi64)(x, 1));
+    }
+  }
+
+  // Cheap bounds for 32 and 64 bit elements: only the sum in
+  // the element type and the bitwise OR of magnitudes. If the
+  // block size times the maximal magnitude fits in T, the sum
+  // can't have wrapped, and partial sums are within its range.
+  // Otherwise, and for narrower elements, the same as vblock_sums().
+  template <typename T>
+  inline block_sums<T> vblock_bound(const T *p, std::size_t n)
+  {
+    if constexpr(sizeof(T) < 4) {
+      return vblock_sums(p, n);
+    }
+    else {
+      using W = typename block_sums<T>::W;
+      using U = std::make_unsigned_t<T>;
+      constexpr std::size_t lanes = vbytes / sizeof(T);
+      const std::size_t nv = n - n % lanes;
+      const std::size_t nv2 = n - n % (2 * lanes);
+      V vsum0 = SIA80_KSI(setzero)();
+      V vsum1 = vsum0, vmag0 = vsum0, vmag1 = vsum0;
+      // Two chains to hide latency of adds.
+      for (std::size_t i = 0; i < nv; i += lanes) {
+        V x0 = vload(p + i);
+        vsum0 = vadd<T>(vsum0, x0);
+        vmag0 = vor(vmag0, vmagn<T>(x0));
+        if (i < nv2) {
+          i += lanes;
+          V x1 = vload(p + i);
+          vsum1 = vadd<T>(vsum1, x1);
+          vmag1 = vor(vmag1, vmagn<T>(x1));
+        }
+      }
+      U sum = vhsum<U>(vadd<T>(vsum0, vsum1));
+      U mag = 0;
+      {
+        U buf[lanes];
+        vstore(buf, vor(vmag0, vmag1));
+        for (U x : buf) {
+          mag |= x;
+        }
+      }
+      for (std::size_t i = nv; i < n; ++i) {
+        U x = U(p[i]);
+        sum += x;
+        mag |= std::is_signed<T>::value ? U(x ^ (x << 1)) : x;
+      }
+      const W bound = W(mag) * W(n);
+      if (bound > W(std::numeric_limits<T>::max())) {
+        return vblock_sums(p, n);
+      }
+      const W wsum = W(T(sum));
+      if constexpr(std::is_signed<T>::value) {
+        return { -bound, bound, wsum, false };
+      }
+      else {
+        return { 0, wsum, wsum, true };
+      }
+    }
+  }
+
+  //-- array loops ---------------------------------------------
+
+  template <int Op, typename T>
+  inline constexpr bool has_vop =
+      Op != op_mul || sizeof(T) == 2;
+
+  template <int Op, typename T>
+  inline V vop(V a, V b)
+  {
+    if constexpr(Op == op_add) {
+      return vsr_add<T>(a, b);
+    }
+    else if constexpr(Op == op_sub) {
+      return vsr_sub<T>(a, b);
+    }
+    else {
+      return vsr_mul<T>(a, b);
+    }
+  }
+
+  template <int Op, typename T>
+  inline void sr_op_n(T *dst, const T *a, const T *b, std::size_t n)
+  {
+    std::size_t i = 0;
+    if constexpr(has_vop<Op, T>) {
+      constexpr std::size_t lanes = vbytes / sizeof(T);
+      for (; i + lanes <= n; i += lanes) {
+        V va = vload(a + i);
+        V vb = vload(b + i);
+        vstore(dst + i, vop<Op, T>(va, vb));
+      }
+    }
+    for (; i < n; ++i) {
+      dst[i] = sop<Op, T>(a[i], b[i]);
+    }
+  }
+
+  //-- narrowing conversions -----------------------------------
+
+  // Lane min and max of type L, for the clamp below. Without SSE4.1,
+  // 32 bit lanes are compared and blended (unsigned ones with the sign
+  // bits flipped); the unsigned 16 bit min is a - (a -sat b) in all
+  // kernels. 64 bit lanes are only in the AVX-512 kernel.
+  template <typename L>
+  inline V vmin(V a, V b)
+  {
+    if constexpr(sizeof(L) == 2 && std::is_signed<L>::value) {
+      return SIA80_KMM(min_epi16)(a, b);
+    }
+    else if constexpr(sizeof(L) == 2) {
+      return vsub<L>(a, SIA80_KMM(subs_epu16)(a, b));
+    }
+#if SIA80_KBITS == 128
+    else if constexpr(std::is_signed<L>::value) {
+      return vblend(_mm_cmpgt_epi32(a, b), b, a);
+    }
+    else {
+      const V s = vset1<L>(0x80000000u);
+      return vblend(_mm_cmpgt_epi32(vxor(a, s), vxor(b, s)), b, a);
+    }
+#else
+    else if constexpr(sizeof(L) == 4 && std::is_signed<L>::value) {
+      return SIA80_KMM(min_epi32)(a, b);
+    }
+    else if constexpr(sizeof(L) == 4) {
+      return SIA80_KMM(min_epu32)(a, b);
+    }
+#if SIA80_KBITS == 512
+    else if constexpr(std::is_signed<L>::value) {
+      return _mm512_min_epi64(a, b);
+    }
+    else {
+      return _mm512_min_epu64(a, b);
+    }
+#endif
+#endif
+  }
+
+  // Only signed L.
+  template <typename L>
+  inline V vmax(V a, V b)
+  {
+    if constexpr(sizeof(L) == 2) {
+      return SIA80_KMM(max_epi16)(a, b);
+    }
+#if SIA80_KBITS == 128
+    else {
+      return vblend(_mm_cmpgt_epi32(a, b), a, b);
+    }
+#else
+    else if constexpr(sizeof(L) == 4) {
+      return SIA80_KMM(max_epi32)(a, b);
+    }
+#if SIA80_KBITS == 512
+    else {
+      return _mm512_max_epi64(a, b);
+    }
+#endif
+#endif
+  }
+
+  // Lanes of From clamped to the range of To: the lanes of the
+  // saturated result, as sr_conv<To>() gives them.
+  template <typename To, typename From>
+  inline V vclamp(V x)
+  {
+    const V hi = vset1<From>(From(std::numeric_limits<To>::max()));
+    if constexpr(std::is_signed<From>::value) {
+      const V lo = vset1<From>(From(std::numeric_limits<To>::min()));
+      return vmin<From>(vmax<From>(x, lo), hi);
+    }
+    else {
+      return vmin<From>(x, hi);
+    }
+  }
+
+  // Whether any bit of v is set.
+  inline bool vany(V v)
+  {
+#if SIA80_KBITS == 128
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF;
+#elif SIA80_KBITS == 256
+    return !_mm256_testz_si256(v, v);
+#else
+    return _mm512_test_epi64_mask(v, v) != 0;
+#endif
+  }
+
+  // 16 and 32 bit sources in all kernels; 64 bit ones need vpmov*q*
+  // (AVX-512), or they go the scalar way.
+  template <typename To, typename From>
+  inline constexpr bool has_vconv = sizeof(To) < sizeof(From) &&
+      (SIA80_KBITS == 512 || sizeof(From) <= 4);
+
+#if SIA80_KBITS == 512
+
+  // vpmov (Sat 0: truncating), vpmovs (1: signed saturation), vpmovus
+  // (2: unsigned) of a vector of From to To at d.
+  template <int Sat, typename To, typename From>
+  inline void vpmov_store(To *d, V x)
+  {
+#define SIA80_KPMOV(f, t) (Sat == 0 ? _mm512_cvtepi##f##_epi##t(x) : \
+    Sat == 1 ? _mm512_cvtsepi##f##_epi##t(x) : _mm512_cvtusepi##f##_epi##t(x))
+    if constexpr(sizeof(From) == 2) {
+      _mm256_storeu_si256((__m256i *) d, SIA80_KPMOV(16, 8));
+    }
+    else if constexpr(sizeof(From) == 4 && sizeof(To) == 2) {
+      _mm256_storeu_si256((__m256i *) d, SIA80_KPMOV(32, 16));
+    }
+    else if constexpr(sizeof(From) == 4) {
+      _mm_storeu_si128((__m128i *) d, SIA80_KPMOV(32, 8));
+    }
+    else if constexpr(sizeof(To) == 4) {
+      _mm256_storeu_si256((__m256i *) d, SIA80_KPMOV(64, 32));
+    }
+    else if constexpr(sizeof(To) == 2) {
+      _mm_storeu_si128((__m128i *) d, SIA80_KPMOV(64, 16));
+    }
+    else {
+      _mm_storel_epi64((__m128i *) d, SIA80_KPMOV(64, 8));
+    }
+#undef SIA80_KPMOV
+  }
+
+#else
+
+  // Lanes of From, each the sign extension of its low To part, packed
+  // into lanes of To with signed saturation (packsswb, packssdw): no
+  // lane saturates, so this is the truncation. 256 and 512 bit packs
+  // work in 128 bit parts, so the order is restored with a permute.
+  template <typename From>
+  inline V vpack2(V a, V b)
+  {
+    V p;
+    if constexpr(sizeof(From) == 2) {
+      p = SIA80_KMM(packs_epi16)(a, b);
+    }
+    else {
+      p = SIA80_KMM(packs_epi32)(a, b);
+    }
+#if SIA80_KBITS == 256
+    p = _mm256_permute4x64_epi64(p, 0xD8);
+#endif
+    return p;
+  }
+
+  template <typename To, typename From>
+  inline V vsext_low(V x)
+  {
+    constexpr int k = int(sizeof(From) - sizeof(To)) * 8;
+    if constexpr(sizeof(From) == 2) {
+      return SIA80_KMM(srai_epi16)(SIA80_KMM(slli_epi16)(x, k), k);
+    }
+    else {
+      return SIA80_KMM(srai_epi32)(SIA80_KMM(slli_epi32)(x, k), k);
+    }
+  }
+
+#endif
+
+  // The array loop of sr_conv_n (Cf false) and cf_conv_n (Cf true:
+  // truncated values, and the index of the first element which
+  // doesn't fit, or n, is returned).
+  template <bool Cf, typename To, typename From>
+  inline std::size_t conv_n(To *dst, const From *src, std::size_t n)
+  {
+    std::size_t first = n;
+    std::size_t i = 0;
+    if constexpr(has_vconv<To, From>) {
+      constexpr std::size_t lanes = vbytes / sizeof(From);
+#if SIA80_KBITS == 512
+      constexpr int sat = std::is_signed<From>::value != std::is_signed<To>::value ? 0 :
+          std::is_signed<From>::value ? 1 : 2;
+      for (; i + lanes <= n; i += lanes) {
+        const V x = vload(src + i);
+        if constexpr(Cf) {
+          if (first == n && vany(vxor(vclamp<To, From>(x), x))) {
+            first = i + conv_first_bad<To>(src + i, lanes);
+          }
+          vpmov_store<0, To, From>(dst + i, x);
+        }
+        else if constexpr(sat != 0) {
+          vpmov_store<sat, To, From>(dst + i, x);
+        }
+        else {
+          vpmov_store<0, To, From>(dst + i, vclamp<To, From>(x));
+        }
+      }
+#else
+      // r vectors of From make one of To.
+      constexpr std::size_t r = sizeof(From) / sizeof(To);
+      for (; i + r * lanes <= n; i += r * lanes) {
+        V y[r];
+        V diff = SIA80_KSI(setzero)();
+        for (std::size_t k = 0; k < r; ++k) {
+          const V x = vload(src + i + k * lanes);
+          const V c = vclamp<To, From>(x);
+          if constexpr(Cf) {
+            diff = vor(diff, vxor(c, x));
+          }
+          y[k] = vsext_low<To, From>(Cf ? x : c);
+        }
+        if constexpr(Cf) {
+          if (first == n && vany(diff)) {
+            first = i + conv_first_bad<To>(src + i, r * lanes);
+          }
+        }
+        if constexpr(r == 2) {
+          vstore(dst + i, vpack2<From>(y[0], y[1]));
+        }
+        else {
+          vstore(dst + i, vpack2<std::int16_t>(vpack2<From>(y[0], y[1]),
+              vpack2<From>(y[2], y[3])));
+        }
+      }
+#endif
+    }
+    return conv_n_scalar<Cf>(dst, src, i, n, first);
+  }
+
+  //-- bit fields ----------------------------------------------
+
+  template <bool Magn, typename T>
+  inline V vbits(V x)
+  {
+    if constexpr(Magn) {
+      return vmagn<T>(x);
+    }
+    else {
+      return x;
+    }
+  }
+
+  // Bitwise OR of p[0..n), of vmagn() of them with Magn: whether all
+  // fit a field of k bits is one test of the result.
+  template <bool Magn, typename T>
+  inline std::make_unsigned_t<T> or_n(const T *p, std::size_t n)
+  {
+    using U = std::make_unsigned_t<T>;
+    constexpr std::size_t lanes = vbytes / sizeof(T);
+    V acc0 = SIA80_KSI(setzero)();
+    V acc1 = acc0;
+    std::size_t i = 0;
+    // Two loads a cycle.
+    for (; i + 2 * lanes <= n; i += 2 * lanes) {
+      acc0 = vor(acc0, vbits<Magn, T>(vload(p + i)));
+      acc1 = vor(acc1, vbits<Magn, T>(vload(p + i + lanes)));
+    }
+    if (i + lanes <= n) {
+      acc0 = vor(acc0, vbits<Magn, T>(vload(p + i)));
+      i += lanes;
+    }
+    U r = 0;
+    {
+      U buf[lanes];
+      vstore(buf, vor(acc0, acc1));
+      for (U x : buf) {
+        r |= x;
+      }
+    }
+    return U(r | or_n_scalar<Magn>(p + i, n - i));
+  }
+
+} // namespace SIA80_KNS
+} // namespace batch_detail
+} // namespace sia80
+
+#if SIA80_KBITS == 512 && defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#undef SIA80_KMM
+#undef SIA80_KSI
+// vim: ts=2 sts=2 sw=2 et :
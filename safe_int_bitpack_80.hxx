@@ -0,0 +1,394 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <safe_int_batch_80.hxx>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+// Packing of integer arrays into streams of fixed-width bit fields,
+// with the field width checked as by xx_ufit and xx_sfit:
+//
+//   std::vector<std::uint64_t> buf(sia80::bitpack_words(n, 12));
+//   sia80::bitpack_ufit(buf.data(), src, n, 12); // range_error unless all in [0, 4096)
+//   sia80::bitunpack_u(dst, buf.data(), n, 12);
+//
+// The stream: field i takes bits [i * nbits, (i + 1) * nbits) of it,
+// bit k of the stream being bit k % 64 of word k / 64. Bits of the
+// last word after the last field are 0. nbits is 0..64 (otherwise
+// std::invalid_argument in all modes); bitpack_words(n, nbits) words
+// hold n fields.
+//
+// bitpack_ufit<Mode>(dst, src, n, nbits): packs xx_ufit(src[i], nbits)
+//   as of Mode:
+//   mode::cx (default): std::range_error if any src[i] doesn't fit;
+//     nothing is written then;
+//   mode::cf, mode::tr: the low nbits (as of tr_ufit);
+//   mode::sr: saturated (as of sr_ufit).
+//   Returns whether any src[i] didn't fit (always false for cx).
+// bitpack_sfit<Mode>: the same with xx_sfit; fields are in two's
+//   complement.
+// The fit is checked once for the whole array: the bitwise OR of all
+// elements (for sfit of signed T, of x ^ (x << 1), which is below
+// 2^nbits only if x fits nbits as signed) is taken by the batch
+// kernels (safe_int_batch_80.hxx), and its bits from nbits up are
+// tested. Only for mode::sr with some element out of range, the
+// elements are fitted one by one. Fields are then packed with no
+// checks.
+//
+// bitunpack_u<Mode>(dst, src, n, nbits): dst[i] = xx_conv<T>(field i),
+//   the field being unsigned; bitunpack_s: sign-extended. If all
+//   values of a field fit T (nbits up to the digits of T for
+//   bitunpack_u; digits + 1 for bitunpack_s of signed T; never for
+//   bitunpack_s of unsigned T but with 0 bits), there are no
+//   checks; otherwise each field is converted by Mode (cx throws at
+//   the first which doesn't fit, after the preceding are written).
+//   Returns whether any didn't fit T.
+//
+// Both directions work in groups of 64 fields (nbits words): for
+// each nbits, there is a group function with constant shifts and
+// word indices, unrolled (a table of 64 of them for packing and two
+// for unpacking, about 100 KB of code each, shared by all T). Fields
+// after the last whole group go one at a time.
+//
+// T is any integral type of 64 bits or less but bool.
+
+namespace sia80 {
+
+  constexpr std::size_t bitpack_words(std::size_t n, unsigned nbits)
+  {
+    // n * nbits may not fit for huge n.
+    return n / 64 * nbits + (n % 64 * nbits + 63) / 64;
+  }
+
+  namespace bitpack_detail {
+
+    template <typename T>
+    constexpr bool is_field_type = ia_is_integral<T>::value &&
+        !std::is_same<T, bool>::value && sizeof(T) <= 8;
+
+    inline void check_nbits(unsigned nbits)
+    {
+      if (SIA80_UNLIKELY(nbits > 64)) {
+        SIA80_CX_FAIL(invalid_argument, "bitpack: nbits > 64");
+      }
+    }
+
+    // Whether all of src[0..n) fit nbits, as of cx_ufit (Sfit false)
+    // or cx_sfit (true).
+    template <bool Sfit, typename T>
+    inline bool all_fit(const T *src, std::size_t n, unsigned nbits)
+    {
+      constexpr unsigned tbits = sizeof(T) * 8;
+      constexpr bool sgn = ia_is_signed<T>::value;
+      if (n == 0) {
+        return true;
+      }
+      if constexpr(Sfit) {
+        // The high nbits of an unsigned value shall be 0 but the
+        // top one; of a signed one, copies of the sign.
+        if (nbits == 0) {
+          return false;
+        }
+        if (nbits >= tbits + !sgn) {
+          return true;
+        }
+        return (batch_detail::sel_or_n<true>(src, n) >> (sgn ? nbits : nbits - 1)) == 0;
+      }
+      else {
+        // The sign bit of signed T stays in the tested bits for any
+        // nbits: negative values never fit.
+        constexpr unsigned digits = ia_limits<T>::digits;
+        if (!sgn && nbits >= tbits) {
+          return true;
+        }
+        return (batch_detail::sel_or_n<false>(src, n) >> (nbits < digits ? nbits : digits)) == 0;
+      }
+    }
+
+    template <unsigned N>
+    constexpr std::uint64_t field_mask = N == 64 ? ~std::uint64_t(0) :
+        (std::uint64_t(1) << N) - 1;
+
+    // 64 fields of N bits make N words. With N known at compile time,
+    // a group is unrolled, and word indices and shifts are constants.
+    // Group functions take and give 64-bit values (the low N bits,
+    // sign-extended for Sfit of unpacking).
+    template <unsigned N, std::size_t I>
+    inline void put_field(std::uint64_t *w, const std::uint64_t *src)
+    {
+      constexpr std::size_t k = I * N / 64;
+      constexpr unsigned off = I * N % 64;
+      const std::uint64_t v = src[I] & field_mask<N>;
+      w[k] |= v << off;
+      if constexpr(off + N > 64) {
+        w[k + 1] |= v >> (64 - off);
+      }
+    }
+
+    template <unsigned N, std::size_t... I>
+    inline void pack_group(std::uint64_t *dst, const std::uint64_t *src, std::index_sequence<I...>)
+    {
+      std::uint64_t w[N] = {};
+      (put_field<N, I>(w, src), ...);
+      for (unsigned k = 0; k < N; ++k) {
+        dst[k] = w[k];
+      }
+    }
+
+    template <unsigned N>
+    void pack_groups(std::uint64_t *dst, const std::uint64_t *src, std::size_t ngroups)
+    {
+      for (std::size_t g = 0; g < ngroups; ++g) {
+        pack_group<N>(dst + g * N, src + g * 64, std::make_index_sequence<64>());
+      }
+    }
+
+    template <bool Sfit, unsigned N, std::size_t I>
+    inline void get_field(std::uint64_t *dst, const std::uint64_t *w)
+    {
+      constexpr std::size_t k = I * N / 64;
+      constexpr unsigned off = I * N % 64;
+      std::uint64_t v = w[k] >> off;
+      if constexpr(off + N > 64) {
+        v |= w[k + 1] << (64 - off);
+      }
+      if constexpr(Sfit) {
+        dst[I] = std::uint64_t(ia_bit_cast<std::int64_t>(v << (64 - N)) >> (64 - N));
+      }
+      else {
+        dst[I] = v & field_mask<N>;
+      }
+    }
+
+    template <bool Sfit, unsigned N, std::size_t... I>
+    inline void unpack_group(std::uint64_t *dst, const std::uint64_t *src, std::index_sequence<I...>)
+    {
+      (get_field<Sfit, N, I>(dst, src), ...);
+    }
+
+    template <bool Sfit, unsigned N>
+    void unpack_groups(std::uint64_t *dst, const std::uint64_t *src, std::size_t ngroups)
+    {
+      for (std::size_t g = 0; g < ngroups; ++g) {
+        unpack_group<Sfit, N>(dst + g * 64, src + g * N, std::make_index_sequence<64>());
+      }
+    }
+
+    // Group functions of nbits = 1..64.
+    using groups_fn = void (*)(std::uint64_t *dst, const std::uint64_t *src, std::size_t ngroups);
+
+    template <std::size_t... N>
+    inline groups_fn pack_groups_of(unsigned nbits, std::index_sequence<N...>)
+    {
+      static constexpr groups_fn fns[] = { pack_groups<unsigned(N + 1)>... };
+      return fns[nbits - 1];
+    }
+
+    template <bool Sfit, std::size_t... N>
+    inline groups_fn unpack_groups_of(unsigned nbits, std::index_sequence<N...>)
+    {
+      static constexpr groups_fn fns[] = { unpack_groups<Sfit, unsigned(N + 1)>... };
+      return fns[nbits - 1];
+    }
+
+    // 64-bit elements go to group functions directly, narrower ones
+    // through a buffer of a group (the widening and narrowing loops
+    // are vectorized): one set of group functions serves all T.
+    template <typename T>
+    constexpr bool is_u64_alias = std::is_same<ia_make_unsigned_t<T>, std::uint64_t>::value;
+
+    template <typename T>
+    inline void pack_whole(std::uint64_t *dst, const T *src, std::size_t ngroups, unsigned nbits)
+    {
+      const groups_fn fn = pack_groups_of(nbits, std::make_index_sequence<64>());
+      if constexpr(is_u64_alias<T>) {
+        fn(dst, reinterpret_cast<const std::uint64_t *>(src), ngroups);
+      }
+      else {
+        std::uint64_t buf[64];
+        for (std::size_t g = 0; g < ngroups; ++g) {
+          for (std::size_t i = 0; i < 64; ++i) {
+            buf[i] = std::uint64_t(src[g * 64 + i]);
+          }
+          fn(dst + g * nbits, buf, 1);
+        }
+      }
+    }
+
+    template <bool Sfit, typename T>
+    inline void unpack_whole(T *dst, const std::uint64_t *src, std::size_t ngroups, unsigned nbits)
+    {
+      const groups_fn fn = unpack_groups_of<Sfit>(nbits, std::make_index_sequence<64>());
+      if constexpr(is_u64_alias<T>) {
+        fn(reinterpret_cast<std::uint64_t *>(dst), src, ngroups);
+      }
+      else {
+        std::uint64_t buf[64];
+        for (std::size_t g = 0; g < ngroups; ++g) {
+          fn(buf, src + g * nbits, 1);
+          for (std::size_t i = 0; i < 64; ++i) {
+            dst[g * 64 + i] = T(buf[i]);
+          }
+        }
+      }
+    }
+
+    // The stream writer: each value is masked to nbits, so the
+    // truncation of tr_ufit and tr_sfit is for free. Used for the
+    // tail after whole groups, and for values which need fitting.
+    template <typename T, typename F>
+    inline void pack(std::uint64_t *dst, const T *src, std::size_t n, unsigned nbits, F fit)
+    {
+      const std::uint64_t mask = nbits == 64 ? ~std::uint64_t(0) :
+          (std::uint64_t(1) << nbits) - 1;
+      std::uint64_t acc = 0;
+      unsigned fill = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        const std::uint64_t v = std::uint64_t(fit(src[i])) & mask;
+        acc |= v << fill;
+        fill += nbits;
+        if (fill >= 64) {
+          *dst++ = acc;
+          fill -= 64;
+          // The part of v which didn't fit the word (none if
+          // fill is 0; shifting by 64 is not allowed).
+          acc = fill != 0 ? v >> (nbits - fill) : 0;
+        }
+      }
+      if (fill != 0) {
+        *dst = acc;
+      }
+    }
+
+    template <mode Mode, bool Sfit, typename T>
+    inline bool pack_fit(std::uint64_t *dst, const T *src, std::size_t n, unsigned nbits)
+    {
+      check_nbits(nbits);
+      const bool fit = all_fit<Sfit>(src, n, nbits);
+      if (fit || Mode == mode::cf || Mode == mode::tr) {
+        if (nbits != 0) {
+          const std::size_t ng = n / 64;
+          pack_whole(dst, src, ng, nbits);
+          pack(dst + ng * nbits, src + ng * 64, n % 64, nbits, [](T x) { return x; });
+        }
+        return !fit;
+      }
+      if constexpr(Mode == mode::cx) {
+        SIA80_CX_FAIL(range_error, Sfit ? "bitpack_sfit: out of range" : "bitpack_ufit: out of range");
+      }
+      else if constexpr(Sfit) {
+        pack(dst, src, n, nbits, [nbits](T x) { return sr_sfit(x, nbits); });
+      }
+      else {
+        pack(dst, src, n, nbits, [nbits](T x) { return sr_ufit(x, nbits); });
+      }
+      return true;
+    }
+
+    template <mode Mode, typename T, typename W>
+    inline T conv(W v, bool& ovf)
+    {
+      if constexpr(Mode == mode::cx) {
+        return cx_conv<T>(v);
+      }
+      else if constexpr(Mode == mode::sr) {
+        const cf_result<T> r = cf_conv<T>(v);
+        ovf |= r.overflowed;
+        return sr_conv<T>(v);
+      }
+      else {
+        const cf_result<T> r = cf_conv<T>(v);
+        ovf |= r.overflowed;
+        return r.value;
+      }
+    }
+
+    template <mode Mode, bool Sfit, typename T>
+    inline bool unpack(T *dst, const std::uint64_t *src, std::size_t n, unsigned nbits)
+    {
+      check_nbits(nbits);
+      if (nbits == 0) {
+        // No words to read; 0 fits any T.
+        for (std::size_t i = 0; i < n; ++i) {
+          dst[i] = 0;
+        }
+        return false;
+      }
+      using W = std::conditional_t<Sfit, std::int64_t, std::uint64_t>;
+      const std::uint64_t mask = nbits == 64 ? ~std::uint64_t(0) :
+          (std::uint64_t(1) << nbits) - 1;
+      // Sign extension as (x ^ sign) - sign.
+      const std::uint64_t sbit = Sfit ? std::uint64_t(1) << (nbits - 1) : 0;
+      // Some field values don't fit T: negative ones never fit
+      // unsigned T.
+      constexpr bool neg_fit = !Sfit || ia_is_signed<T>::value;
+      const bool wide = !neg_fit || nbits > unsigned(ia_limits<T>::digits) + Sfit;
+      bool ovf = false;
+      std::size_t w = 0;
+      unsigned off = 0;
+      std::size_t i = 0;
+      if (!wide) {
+        const std::size_t ng = n / 64;
+        unpack_whole<Sfit>(dst, src, ng, nbits);
+        i = ng * 64;
+        w = ng * nbits;
+      }
+      for (; i < n; ++i) {
+        std::uint64_t v = src[w] >> off;
+        // off isn't 0 here, as nbits <= 64.
+        if (off + nbits > 64) {
+          v |= src[w + 1] << (64 - off);
+        }
+        v &= mask;
+        const W x = ia_bit_cast<W>(std::uint64_t((v ^ sbit) - sbit));
+        if (!wide) {
+          dst[i] = T(x);
+        }
+        else {
+          dst[i] = conv<Mode, T>(x, ovf);
+        }
+        off += nbits;
+        w += off / 64;
+        off %= 64;
+      }
+      return ovf;
+    }
+
+  } // namespace bitpack_detail
+
+  template <mode Mode = mode::cx, typename T,
+      std::enable_if_t<bitpack_detail::is_field_type<T>, bool> = true>
+  inline bool bitpack_ufit(std::uint64_t *dst, const T *src, std::size_t n, unsigned nbits)
+  {
+    return bitpack_detail::pack_fit<Mode, false>(dst, src, n, nbits);
+  }
+
+  template <mode Mode = mode::cx, typename T,
+      std::enable_if_t<bitpack_detail::is_field_type<T>, bool> = true>
+  inline bool bitpack_sfit(std::uint64_t *dst, const T *src, std::size_t n, unsigned nbits)
+  {
+    return bitpack_detail::pack_fit<Mode, true>(dst, src, n, nbits);
+  }
+
+  template <mode Mode = mode::cx, typename T,
+      std::enable_if_t<bitpack_detail::is_field_type<T>, bool> = true>
+  inline bool bitunpack_u(T *dst, const std::uint64_t *src, std::size_t n, unsigned nbits)
+  {
+    return bitpack_detail::unpack<Mode, false>(dst, src, n, nbits);
+  }
+
+  template <mode Mode = mode::cx, typename T,
+      std::enable_if_t<bitpack_detail::is_field_type<T>, bool> = true>
+  inline bool bitunpack_s(T *dst, const std::uint64_t *src, std::size_t n, unsigned nbits)
+  {
+    return bitpack_detail::unpack<Mode, true>(dst, src, n, nbits);
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
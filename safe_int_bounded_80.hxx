@@ -0,0 +1,329 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <stdexcept>
+
+// Integers with a range known at compile time: bounded<T, Lo, Hi, Mode>
+// holds a value of T in [Lo, Hi]. Arithmetic on them computes the
+// range of the result at compile time; if it fits the result type,
+// the operation is tr_xxx without any check, otherwise it is cx_xxx
+// (mode::cx, the default) or sr_xxx (mode::sr).
+//
+//   using pct = sia80::bounded<int, 0, 100>;
+//   using byte = sia80::bounded<unsigned, 0, 255>;
+//   // [0, 25500]: no check
+//   auto scaled = byte(b) * pct(p);
+//   // [0, 255]: no check either, the divisor can't be 0
+//   auto back = scaled / sia80::bconst<100>;
+//   // 255 << 31 doesn't fit unsigned, so this is cx_shl
+//   auto big = byte(b) << sia80::bounded<int, 0, 31>(n);
+//
+// The check is moved to the construction from a plain value, once:
+//   bounded<T, Lo, Hi, Mode>(v): v of any integer type; mode::cx
+//     throws std::range_error if v is out of [Lo, Hi], mode::sr clamps
+//     it to the range.
+//   bounded<...>::unchecked(v): no check; v must be in the range.
+//   bounded(): Lo.
+//   A bounded with a range inside [Lo, Hi] converts implicitly.
+//   bconst<V> (bconst<V, Mode>): the constant V as bounded<decltype(V),
+//     V, V, Mode>.
+// b.value() (or explicit conversion to T) tells the compiler that
+// the value is in the range, so checks on it in the code after that
+// (e.g. the shift count check of tr_shl) can be dropped as well.
+//
+// Operators: + - * / << and unary -, on operands of the same Mode.
+// The result type is that of the operation on plain values (int for
+// narrower types, as by the integral promotion); its range is the
+// exact range of the result, clamped to the result type in the
+// fallback case (cx_xxx throws and sr_xxx saturates outside of it).
+// Division is unchecked only if the divisor range doesn't contain 0
+// (both ranges as converted to the result type, as the division is:
+// int in [-10, 10] divided by unsigned is in [0, UINT_MAX]);
+// a shift, only if the count range is in [0, digits of the result
+// type). Comparisons compare the values, also of different types,
+// as numbers.
+//
+// T is of 64 bits at most (32 bits without __int128); the ranges are
+// computed in __int128 (long long), and a range which doesn't fit
+// there just takes the fallback.
+
+namespace sia80 {
+
+  namespace bd_detail {
+
+#if defined(__SIZEOF_INT128__)
+    using wide = __int128;
+#else
+    using wide = long long;
+#endif
+
+    // The range of a result; ok == false if it isn't known (doesn't
+    // fit wide, or the operation may fail for the operand ranges).
+    struct span {
+      wide lo;
+      wide hi;
+      bool ok;
+    };
+
+    constexpr span corners(wide a, wide b, wide c, wide d, bool ok)
+    {
+      wide lo = a < b ? a : b;
+      wide hi = a < b ? b : a;
+      lo = lo < c ? lo : c;
+      hi = hi < c ? c : hi;
+      lo = lo < d ? lo : d;
+      hi = hi < d ? d : hi;
+      return { lo, hi, ok };
+    }
+
+    constexpr span add(wide alo, wide ahi, wide blo, wide bhi)
+    {
+      span s = { 0, 0, true };
+      s.ok = !__builtin_add_overflow(alo, blo, &s.lo) &&
+          !__builtin_add_overflow(ahi, bhi, &s.hi);
+      return s;
+    }
+
+    constexpr span sub(wide alo, wide ahi, wide blo, wide bhi)
+    {
+      span s = { 0, 0, true };
+      s.ok = !__builtin_sub_overflow(alo, bhi, &s.lo) &&
+          !__builtin_sub_overflow(ahi, blo, &s.hi);
+      return s;
+    }
+
+    constexpr span mul(wide alo, wide ahi, wide blo, wide bhi)
+    {
+      wide p[4] = { 0, 0, 0, 0 };
+      bool ok = !__builtin_mul_overflow(alo, blo, &p[0]) &&
+          !__builtin_mul_overflow(alo, bhi, &p[1]) &&
+          !__builtin_mul_overflow(ahi, blo, &p[2]) &&
+          !__builtin_mul_overflow(ahi, bhi, &p[3]);
+      return corners(p[0], p[1], p[2], p[3], ok);
+    }
+
+    // An operand range as converted to TR by the usual arithmetic
+    // conversions: only a signed operand of an unsigned TR changes.
+    // A range across 0 wraps into two pieces; take their hull.
+    template <typename TR>
+    constexpr void to_tr(wide& lo, wide& hi)
+    {
+      if (!ia_is_signed<TR>::value && lo < 0) {
+        const wide m = wide(ia_limits<TR>::max()) + 1;
+        if (hi < 0) {
+          lo += m;
+          hi += m;
+        }
+        else {
+          lo = 0;
+          hi = m - 1;
+        }
+      }
+    }
+
+    // T-division: for a divisor of one sign, the quotient is monotone
+    // in both operands.
+    constexpr span div(wide alo, wide ahi, wide blo, wide bhi)
+    {
+      if (blo <= 0 && bhi >= 0) {
+        return { 0, 0, false };
+      }
+      return corners(alo / blo, alo / bhi, ahi / blo, ahi / bhi, true);
+    }
+
+    // Division in TR. Unlike + - * (where a range which fits TR makes
+    // the wrapping operation exact), it is done on the operands
+    // converted to TR, so the range is of those.
+    template <typename TR>
+    constexpr span div_in(wide alo, wide ahi, wide blo, wide bhi)
+    {
+      to_tr<TR>(alo, ahi);
+      to_tr<TR>(blo, bhi);
+      return div(alo, ahi, blo, bhi);
+    }
+
+    // a * 2^c for c in [clo, chi], which must be valid counts for TR.
+    template <typename TR>
+    constexpr span shl(wide alo, wide ahi, wide clo, wide chi)
+    {
+      if (clo < 0 || chi >= ia_limits<TR>::digits) {
+        return { 0, 0, false };
+      }
+      return mul(alo, ahi, wide(1) << clo, wide(1) << chi);
+    }
+
+    template <typename TR>
+    constexpr bool fits(span s)
+    {
+      return s.ok && s.lo >= wide(ia_limits<TR>::min()) &&
+          s.hi <= wide(ia_limits<TR>::max());
+    }
+
+    // Bounds of the result type: the span clamped to TR.
+    template <typename TR>
+    constexpr TR lo_in(span s)
+    {
+      return s.ok && s.lo > wide(ia_limits<TR>::min()) ?
+          (s.lo > wide(ia_limits<TR>::max()) ? ia_limits<TR>::max() : TR(s.lo)) :
+          ia_limits<TR>::min();
+    }
+
+    template <typename TR>
+    constexpr TR hi_in(span s)
+    {
+      return s.ok && s.hi < wide(ia_limits<TR>::max()) ?
+          (s.hi < wide(ia_limits<TR>::min()) ? ia_limits<TR>::min() : TR(s.hi)) :
+          ia_limits<TR>::max();
+    }
+
+    template <typename T>
+    constexpr bool wide_enough = ia_limits<T>::digits <= ia_limits<wide>::digits;
+
+    // For comparisons of values of T1 and T2 as numbers: long long
+    // if it holds both, as a compare in wide is longer.
+    template <typename T1, typename T2>
+    using cmp_t = std::conditional_t<
+        (ia_limits<T1>::digits <= ia_limits<long long>::digits &&
+         ia_limits<T2>::digits <= ia_limits<long long>::digits),
+        long long, wide>;
+
+  } // namespace bd_detail
+
+  template <typename T, T Lo, T Hi, mode Mode = mode::cx>
+  class bounded {
+    static_assert(ia_is_integral<T>::value, "bounded needs an integral type");
+    static_assert(bd_detail::wide_enough<T>, "bounded: T is too wide");
+    static_assert(Lo <= Hi, "bounded: empty range");
+    static_assert(Mode == mode::cx || Mode == mode::sr,
+        "bounded: mode::cx or mode::sr");
+
+  public:
+    using value_type = T;
+    static constexpr T lo = Lo;
+    static constexpr T hi = Hi;
+
+    constexpr bounded() = default;
+
+    template <typename U,
+        std::enable_if_t<ia_is_integral<U>::value, bool> = true>
+    constexpr explicit bounded(U v)
+    {
+      static_assert(bd_detail::wide_enough<U>, "bounded: U is too wide");
+      using C = bd_detail::cmp_t<T, U>;
+      const C w = v;
+      if constexpr(Mode == mode::cx) {
+        if (SIA80_UNLIKELY(w < C(Lo) || w > C(Hi))) {
+          SIA80_CX_FAIL(range_error, "bounded: value out of range");
+        }
+        v_ = T(v);
+      }
+      else {
+        v_ = w < C(Lo) ? Lo : w > C(Hi) ? Hi : T(v);
+      }
+    }
+
+    // From a narrower range: no check.
+    template <typename U, U L2, U H2,
+        std::enable_if_t<(bd_detail::wide(L2) >= bd_detail::wide(Lo) &&
+            bd_detail::wide(H2) <= bd_detail::wide(Hi)), bool> = true>
+    constexpr bounded(bounded<U, L2, H2, Mode> b) : v_(T(b.value())) {}
+
+    static constexpr bounded unchecked(T v)
+    {
+      bounded b;
+      b.v_ = v;
+      return b;
+    }
+
+    constexpr T value() const
+    {
+      if (bd_detail::wide(v_) < bd_detail::wide(Lo) ||
+          bd_detail::wide(v_) > bd_detail::wide(Hi))
+      {
+        __builtin_unreachable();
+      }
+      return v_;
+    }
+
+    constexpr explicit operator T() const { return value(); }
+
+  private:
+    T v_ = Lo;
+  };
+
+  template <auto V, mode Mode = mode::cx>
+  inline constexpr bounded<decltype(V), V, V, Mode> bconst =
+      bounded<decltype(V), V, V, Mode>::unchecked(V);
+
+// One binary operator: the span at compile time, then tr_xxx if it
+// fits and the Mode function otherwise.
+#define SIA80_BD_BINARY(oper, op, spanfn)                                     \
+  template <typename T1, T1 L1, T1 H1, typename T2, T2 L2, T2 H2, mode Mode>  \
+  constexpr auto operator oper(bounded<T1, L1, H1, Mode> a,                   \
+      bounded<T2, L2, H2, Mode> b)                                            \
+  {                                                                           \
+    using TR = decltype(a.value() oper b.value());                            \
+    constexpr bd_detail::span s = bd_detail::spanfn(L1, H1, L2, H2);          \
+    using B = bounded<TR, bd_detail::lo_in<TR>(s), bd_detail::hi_in<TR>(s),   \
+        Mode>;                                                                \
+    if constexpr(bd_detail::fits<TR>(s)) {                                    \
+      return B::unchecked(tr_##op(a.value(), b.value()));                     \
+    }                                                                         \
+    else if constexpr(Mode == mode::sr) {                                     \
+      return B::unchecked(sr_##op(a.value(), b.value()));                     \
+    }                                                                         \
+    else {                                                                    \
+      return B::unchecked(cx_##op(a.value(), b.value()));                     \
+    }                                                                         \
+  }
+
+  SIA80_BD_BINARY(+, add, add)
+  SIA80_BD_BINARY(-, sub, sub)
+  SIA80_BD_BINARY(*, mul, mul)
+  SIA80_BD_BINARY(/, div, div_in<TR>)
+  SIA80_BD_BINARY(<<, shl, shl<TR>)
+
+#undef SIA80_BD_BINARY
+
+  template <typename T, T Lo, T Hi, mode Mode>
+  constexpr auto operator-(bounded<T, Lo, Hi, Mode> a)
+  {
+    using TR = decltype(-a.value());
+    constexpr bd_detail::span s = bd_detail::sub(0, 0, Lo, Hi);
+    using B = bounded<TR, bd_detail::lo_in<TR>(s), bd_detail::hi_in<TR>(s), Mode>;
+    if constexpr(bd_detail::fits<TR>(s)) {
+      return B::unchecked(tr_sub(TR(0), a.value()));
+    }
+    else if constexpr(Mode == mode::sr) {
+      return B::unchecked(sr_sub(TR(0), a.value()));
+    }
+    else {
+      return B::unchecked(cx_sub(TR(0), a.value()));
+    }
+  }
+
+#define SIA80_BD_COMPARE(oper)                                                \
+  template <typename T1, T1 L1, T1 H1, mode M1,                               \
+      typename T2, T2 L2, T2 H2, mode M2>                                     \
+  constexpr bool operator oper(bounded<T1, L1, H1, M1> a,                     \
+      bounded<T2, L2, H2, M2> b)                                              \
+  {                                                                           \
+    using C = bd_detail::cmp_t<T1, T2>;                                       \
+    return C(a.value()) oper C(b.value());                                    \
+  }
+
+  SIA80_BD_COMPARE(==)
+  SIA80_BD_COMPARE(!=)
+  SIA80_BD_COMPARE(<)
+  SIA80_BD_COMPARE(<=)
+  SIA80_BD_COMPARE(>)
+  SIA80_BD_COMPARE(>=)
+
+#undef SIA80_BD_COMPARE
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
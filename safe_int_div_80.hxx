@@ -0,0 +1,430 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <cstddef>
+#include <cstdint>
+
+// Division by an invariant divisor: divider<T, Mode>.
+//
+//   sia80::divider<int, sia80::mode::cx> by_bucket(nbuckets);
+//   int b = by_bucket.rem(hash);
+//
+// The divisor is checked once, in the constructor, and the division
+// is replaced with a multiplication by a precomputed reciprocal and
+// shifts (the method of Granlund-Montgomery, in the variant used
+// by libdivide), or with a single shift for a power of 2.
+//
+// Results and errors are exactly those of xx_div(ddnd, dvsr) and
+// xx_rem(ddnd, dvsr) for the same Mode, with the result type of
+// ddnd / dvsr (int for narrower T):
+//   mode::cx: the constructor throws std::domain_error on 0;
+//     div() and rem() throw as cx_div/cx_rem on MIN / -1.
+//   mode::cf: div(ddnd, &flag) as cf_div(ddnd, dvsr, &flag);
+//     div(ddnd) returns cf_result, as cf_div(ddnd, dvsr).
+//   mode::tr, mode::sr: as tr_div, sr_div.
+// The same for rem() and divrem() (both at once; for cf_result,
+// one flag for both).
+// Divisors 0 and -1 simply use the scalar functions.
+//
+// div_n(dst, src, n), rem_n(dst, src, n): array forms, the same as
+// dst[i] = div(src[i]) in a loop; with mode::cf, the flag argument
+// is added. With mode::cx, the exception leaves the elements before
+// the failing one written.
+
+namespace sia80 {
+
+  namespace div_detail {
+
+    // Double width type, for the high half of a product and for
+    // computing the reciprocal.
+#if defined(__SIZEOF_INT128__)
+    template <typename W>
+    using wide_t = std::conditional_t<sizeof(W) <= 4,
+        std::conditional_t<std::is_signed<W>::value, std::int64_t, std::uint64_t>,
+        std::conditional_t<std::is_signed<W>::value, __int128, unsigned __int128>>;
+
+    template <typename W>
+    using uwide_t = std::conditional_t<sizeof(W) <= 4,
+        std::uint64_t, unsigned __int128>;
+
+    template <typename W>
+    constexpr bool has_wide = sizeof(W) <= 8;
+#else
+    template <typename W>
+    using wide_t = std::conditional_t<std::is_signed<W>::value,
+        std::int64_t, std::uint64_t>;
+
+    template <typename W>
+    using uwide_t = std::uint64_t;
+
+    template <typename W>
+    constexpr bool has_wide = sizeof(W) <= 4;
+#endif
+
+    template <typename W>
+    constexpr W mulhi(W a, W b)
+    {
+      using WW = wide_t<W>;
+      return W((WW(a) * WW(b)) >> (sizeof(W) * 8));
+    }
+
+    template <typename U>
+    constexpr unsigned floor_log2(U v)
+    {
+      if constexpr(sizeof(U) <= 4) {
+        return 31 - __builtin_clz(v);
+      }
+      else {
+        return 63 - __builtin_clzll(v);
+      }
+    }
+
+    // Types divider<> works on: the reciprocal needs a double width
+    // type, so not __int128 (which is std::is_integral with gnu++).
+    template <typename T>
+    constexpr bool divider_type = ia_is_integral<T>::value && sizeof(T) <= 8;
+
+    // Algorithm for a divisor.
+    enum { alg_special, alg_shift, alg_mul, alg_mul_add, alg_plain };
+
+  } // namespace div_detail
+
+  template <typename T>
+  struct divrem_result {
+    T quot;
+    T rem;
+  };
+
+  template <typename T, mode Mode>
+  class divider {
+    static_assert(div_detail::divider_type<T>,
+        "divider needs an integral type of at most 64 bits");
+
+  public:
+    using result_type = decltype(T() / T());
+
+  private:
+    using W = result_type;
+    using UW = std::make_unsigned_t<W>;
+    static constexpr unsigned wbits = sizeof(W) * 8;
+
+  public:
+
+    constexpr explicit divider(T dvsr)
+      : dvsr_(dvsr)
+    {
+      if constexpr(Mode == mode::cx) {
+        if (SIA80_UNLIKELY(dvsr == 0)) {
+          SIA80_CX_FAIL(domain_error, "divider divisor 0");
+        }
+      }
+      init();
+    }
+
+    constexpr T divisor() const { return dvsr_; }
+
+    constexpr auto div(T ddnd) const
+    {
+      if (SIA80_UNLIKELY(alg_ == div_detail::alg_special)) {
+        return special_div(ddnd);
+      }
+      if constexpr(Mode == mode::cf) {
+        return cf_result<W> { quot(ddnd), false };
+      }
+      else {
+        return quot(ddnd);
+      }
+    }
+
+    constexpr W div(T ddnd, int *flag) const
+    {
+      static_assert(Mode == mode::cf, "only mode::cf has the flag argument");
+      if (SIA80_UNLIKELY(alg_ == div_detail::alg_special)) {
+        return cf_div(ddnd, dvsr_, flag);
+      }
+      return quot(ddnd);
+    }
+
+    constexpr auto rem(T ddnd) const
+    {
+      if (SIA80_UNLIKELY(alg_ == div_detail::alg_special)) {
+        return special_rem(ddnd);
+      }
+      if constexpr(Mode == mode::cf) {
+        return cf_result<W> { remainder(ddnd, quot(ddnd)), false };
+      }
+      else {
+        return remainder(ddnd, quot(ddnd));
+      }
+    }
+
+    constexpr W rem(T ddnd, int *flag) const
+    {
+      static_assert(Mode == mode::cf, "only mode::cf has the flag argument");
+      if (SIA80_UNLIKELY(alg_ == div_detail::alg_special)) {
+        return cf_rem(ddnd, dvsr_, flag);
+      }
+      return remainder(ddnd, quot(ddnd));
+    }
+
+    constexpr auto divrem(T ddnd) const
+    {
+      if (SIA80_UNLIKELY(alg_ == div_detail::alg_special)) {
+        if constexpr(Mode == mode::cf) {
+          auto q = cf_div(ddnd, dvsr_);
+          auto r = cf_rem(ddnd, dvsr_);
+          return cf_result<divrem_result<W>> { { q.value, r.value }, q.overflowed };
+        }
+        else {
+          W q = special_div(ddnd);
+          return divrem_result<W> { q, special_rem(ddnd) };
+        }
+      }
+      W q = quot(ddnd);
+      if constexpr(Mode == mode::cf) {
+        return cf_result<divrem_result<W>> { { q, remainder(ddnd, q) }, false };
+      }
+      else {
+        return divrem_result<W> { q, remainder(ddnd, q) };
+      }
+    }
+
+    constexpr divrem_result<W> divrem(T ddnd, int *flag) const
+    {
+      static_assert(Mode == mode::cf, "only mode::cf has the flag argument");
+      auto r = divrem(ddnd);
+      if (SIA80_UNLIKELY(r.overflowed)) {
+        *flag = 1;
+      }
+      return r.value;
+    }
+
+    //-- array forms
+
+    void div_n(W *dst, const T *src, std::size_t n) const
+    {
+      static_assert(Mode != mode::cf, "mode::cf needs the flag argument");
+      apply_n<false>(dst, src, n, nullptr);
+    }
+
+    void div_n(W *dst, const T *src, std::size_t n, int *flag) const
+    {
+      static_assert(Mode == mode::cf, "only mode::cf has the flag argument");
+      apply_n<false>(dst, src, n, flag);
+    }
+
+    void rem_n(W *dst, const T *src, std::size_t n) const
+    {
+      static_assert(Mode != mode::cf, "mode::cf needs the flag argument");
+      apply_n<true>(dst, src, n, nullptr);
+    }
+
+    void rem_n(W *dst, const T *src, std::size_t n, int *flag) const
+    {
+      static_assert(Mode == mode::cf, "only mode::cf has the flag argument");
+      apply_n<true>(dst, src, n, flag);
+    }
+
+  private:
+    T dvsr_;
+    int alg_ = div_detail::alg_plain;
+    // For alg_shift, only shift_ and neg_ are used.
+    W magic_ = 0;
+    unsigned shift_ = 0;
+    bool neg_ = false;
+
+    constexpr void init()
+    {
+      using div_detail::alg_special;
+      using div_detail::alg_shift;
+      using div_detail::alg_mul;
+      using div_detail::alg_mul_add;
+      if (dvsr_ == 0 || (std::is_signed<T>::value && dvsr_ == T(-1))) {
+        alg_ = alg_special;
+        return;
+      }
+      const UW ud = UW(W(dvsr_));
+      const UW absd = dvsr_ < 0 ? UW(0) - ud : ud;
+      const unsigned l = div_detail::floor_log2(absd);
+      neg_ = dvsr_ < 0;
+      if ((absd & (absd - 1)) == 0) {
+        alg_ = alg_shift;
+        shift_ = l;
+        return;
+      }
+      if constexpr(!div_detail::has_wide<W>) {
+        return; // alg_plain
+      }
+      else {
+        // The reciprocal is 2**(wbits+l)/absd for unsigned, and
+        // 2**(wbits-1+l)/absd for signed, rounded up; if it doesn't
+        // fit into W with the shift by l, one more bit is added
+        // with the "add" step.
+        using UWW = div_detail::uwide_t<W>;
+        constexpr unsigned sbit = std::is_signed<W>::value ? 1 : 0;
+        const UWW num = UWW(1) << (wbits - sbit + l);
+        UW m = UW(num / absd);
+        const UW rm = UW(num % absd);
+        const UW e = absd - rm;
+        if (e < (UW(1) << l)) {
+          alg_ = alg_mul;
+          shift_ = l - sbit;
+        }
+        else {
+          m += m;
+          const UW twice_rm = rm + rm;
+          if (twice_rm >= absd || twice_rm < rm) {
+            m += 1;
+          }
+          alg_ = alg_mul_add;
+          shift_ = l;
+        }
+        m += 1;
+        if (std::is_signed<W>::value && neg_) {
+          m = UW(0) - m;
+        }
+        magic_ = W(m);
+      }
+    }
+
+    // The quotient for an ordinary divisor (not 0 or -1).
+    template <int Alg>
+    constexpr W quot_alg(W n) const
+    {
+      if constexpr(Alg == div_detail::alg_plain) {
+        return n / W(dvsr_);
+      }
+      else if constexpr(std::is_signed<W>::value) {
+        const UW sign = UW(0) - UW(neg_);
+        if constexpr(Alg == div_detail::alg_shift) {
+          // Round toward 0: add divisor-1 to a negative dividend.
+          const UW mask = (UW(1) << shift_) - 1;
+          const UW uq = UW(n) + (UW(n >> (wbits - 1)) & mask);
+          const W q = W(uq) >> shift_;
+          return W((UW(q) ^ sign) - sign);
+        }
+        else {
+          UW uq = UW(div_detail::mulhi(magic_, n));
+          if constexpr(Alg == div_detail::alg_mul_add) {
+            uq += (UW(n) ^ sign) - sign;
+          }
+          W q = W(uq) >> shift_;
+          q += W(q < 0);
+          return q;
+        }
+      }
+      else {
+        if constexpr(Alg == div_detail::alg_shift) {
+          return n >> shift_;
+        }
+        else if constexpr(Alg == div_detail::alg_mul) {
+          return div_detail::mulhi(magic_, n) >> shift_;
+        }
+        else {
+          const W q = div_detail::mulhi(magic_, n);
+          return (((n - q) >> 1) + q) >> shift_;
+        }
+      }
+    }
+
+    constexpr W quot(W n) const
+    {
+      // Conditional branches, not a jump table: with an invariant
+      // divisor they are predicted perfectly.
+      if (alg_ == div_detail::alg_mul) {
+        return quot_alg<div_detail::alg_mul>(n);
+      }
+      if (alg_ == div_detail::alg_mul_add) {
+        return quot_alg<div_detail::alg_mul_add>(n);
+      }
+      if (alg_ == div_detail::alg_shift) {
+        return quot_alg<div_detail::alg_shift>(n);
+      }
+      return quot_alg<div_detail::alg_plain>(n);
+    }
+
+    constexpr W remainder(W n, W q) const
+    {
+      return W(UW(n) - UW(q) * UW(W(dvsr_)));
+    }
+
+    // Divisors 0 and -1.
+    constexpr auto special_div(T ddnd) const
+    {
+      if constexpr(Mode == mode::cx) {
+        return cx_div(ddnd, dvsr_);
+      }
+      else if constexpr(Mode == mode::cf) {
+        return cf_div(ddnd, dvsr_);
+      }
+      else if constexpr(Mode == mode::tr) {
+        return tr_div(ddnd, dvsr_);
+      }
+      else {
+        return sr_div(ddnd, dvsr_);
+      }
+    }
+
+    constexpr auto special_rem(T ddnd) const
+    {
+      if constexpr(Mode == mode::cx) {
+        return cx_rem(ddnd, dvsr_);
+      }
+      else if constexpr(Mode == mode::cf) {
+        return cf_rem(ddnd, dvsr_);
+      }
+      else if constexpr(Mode == mode::tr) {
+        return tr_rem(ddnd, dvsr_);
+      }
+      else {
+        return sr_rem(ddnd, dvsr_);
+      }
+    }
+
+    template <bool Rem, int Alg>
+    static void loop_n(const divider& d, W *dst, const T *src, std::size_t n)
+    {
+      for (std::size_t i = 0; i < n; ++i) {
+        const W q = d.quot_alg<Alg>(src[i]);
+        dst[i] = Rem ? d.remainder(src[i], q) : q;
+      }
+    }
+
+    template <bool Rem>
+    void apply_n(W *dst, const T *src, std::size_t n, int *flag) const
+    {
+      // A local copy: stores to dst (of the same type as magic_)
+      // would otherwise force reloading the members.
+      const divider d = *this;
+      switch (d.alg_) {
+        case div_detail::alg_special:
+          for (std::size_t i = 0; i < n; ++i) {
+            if constexpr(Mode == mode::cf) {
+              dst[i] = Rem ? d.rem(src[i], flag) : d.div(src[i], flag);
+            }
+            else {
+              dst[i] = Rem ? d.rem(src[i]) : d.div(src[i]);
+            }
+          }
+          break;
+        case div_detail::alg_shift:
+          loop_n<Rem, div_detail::alg_shift>(d, dst, src, n);
+          break;
+        case div_detail::alg_mul:
+          loop_n<Rem, div_detail::alg_mul>(d, dst, src, n);
+          break;
+        case div_detail::alg_mul_add:
+          loop_n<Rem, div_detail::alg_mul_add>(d, dst, src, n);
+          break;
+        default:
+          loop_n<Rem, div_detail::alg_plain>(d, dst, src, n);
+          break;
+      }
+    }
+  };
+
+} // namespace sia80
+// vim: ts=2 sts=2 sw=2 et :
@@ -0,0 +1,445 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <safe_int_bounded_80.hxx>
+#include <cstdint>
+
+// Checked expressions evaluated as a whole: an expression of + - * /
+// and unary - on operands marked with xv() is built as a tree at
+// compile time, evaluated in a wide type where no step can overflow,
+// and checked once, by the conversion to the result type.
+//
+//   // int32 prices: no check but the last, in int64
+//   std::int32_t total = sia80::cx_eval<std::int32_t>(
+//       sia80::xv(price) * qty + sia80::xv(fee) * lots);
+//   // a + 100% markup, [0, 255] * [100, 200] / 100: fits int32
+//   auto p = sia80::sr_eval<std::int32_t>(
+//       sia80::xv(byte_price) * (sia80::xc<100> + sia80::xv(pct)) / sia80::xc<100>);
+//
+// Compared with cx_add(cx_mul(a, b), cx_mul(c, d)), there is a single
+// check and branch instead of one per step (none if the range of the
+// expression fits the result type), and a result which fits is given
+// even if an intermediate value wouldn't fit the type of the step.
+// With int64 operands whose products need __int128, the one check
+// comes with the 128-bit arithmetic, and a chain of cx_xxx on int64
+// may still be faster (see bench_ia expr/).
+//
+// Operands:
+//   xv(v): v of any integer type of 64 bits at most, with the range
+//     of its type; xv(b) of a bounded<T, Lo, Hi, Mode>, with [Lo, Hi].
+//   xc<V>: the constant V, with the range [V, V].
+//   A plain integer with a node on the other side is as xv() of it.
+// Evaluation: xx_eval<T>(e) gives the value of e computed exactly
+// (each / truncates toward zero, as on plain values), converted to T
+// as by xx_conv<T>: cx_eval fails as cx_conv, cf_eval sets the flag
+// (or returns cf_result) with the truncated value, tr_eval truncates,
+// sr_eval saturates.
+//
+// The wide type: the ranges of all nodes are computed at compile time
+// as for bounded (bd_detail::span); the expression is evaluated in
+// int64 if all of them fit it, otherwise in __int128 if they fit that.
+// Then + - * / are plain, but / by a divisor whose range has 0,
+// which is xx_div. Each node is in the narrowest of them that holds
+// it and all below (a product of int64 in __int128 is one imul); a
+// root of + - * which alone needs __int128, to a type within 64 bits,
+// is __builtin_xxx_overflow of its int64 children into that type: the
+// step and the check of the conversion are one overflow flag.
+// If no wide type holds all of them (e.g. a product of three int64),
+// each step is xx_add, xx_sub... in the widest type (the fallback):
+// a step which overflows there fails in cx_eval, sets the flag in
+// cf_eval, saturates in sr_eval and wraps in tr_eval.
+// xp_width<E>: 64, 128, or 0 for the fallback.
+
+namespace sia80 {
+
+  namespace xp_detail {
+
+    using bd_detail::span;
+    using bd_detail::wide;
+
+    // Base of the nodes, to find the operators.
+    struct node {};
+
+    template <typename T>
+    constexpr bool is_node = std::is_base_of<node, T>::value;
+
+    enum class op { add, sub, mul, div };
+
+    // The range of a / b; a divisor range with 0 gives that of
+    // -|a| .. |a| (the division by 0 is checked when evaluated).
+    constexpr span div(span a, span b)
+    {
+      if (b.lo > 0 || b.hi < 0) {
+        return bd_detail::div(a.lo, a.hi, b.lo, b.hi);
+      }
+      const wide m = -a.lo > a.hi ? -a.lo : a.hi;
+      return { -m, m, a.lo > ia_limits<wide>::min() };
+    }
+
+    template <op Op>
+    constexpr span range_of(span a, span b)
+    {
+      const span s = Op == op::add ? bd_detail::add(a.lo, a.hi, b.lo, b.hi) :
+          Op == op::sub ? bd_detail::sub(a.lo, a.hi, b.lo, b.hi) :
+          Op == op::mul ? bd_detail::mul(a.lo, a.hi, b.lo, b.hi) : div(a, b);
+      return { s.lo, s.hi, s.ok && a.ok && b.ok };
+    }
+
+    // One step in the Mode, for the fallback and division; cf ORs
+    // its flag into ovf.
+    template <op Op, mode Mode, typename W>
+    constexpr W step(W a, W b, bool& ovf)
+    {
+      if constexpr(Mode == mode::cf) {
+        const cf_result<W> r = Op == op::add ? cf_add(a, b) :
+            Op == op::sub ? cf_sub(a, b) : Op == op::mul ? cf_mul(a, b) : cf_div(a, b);
+        ovf |= r.overflowed;
+        return r.value;
+      }
+      else if constexpr(Mode == mode::cx) {
+        return Op == op::add ? cx_add(a, b) : Op == op::sub ? cx_sub(a, b) :
+            Op == op::mul ? cx_mul(a, b) : cx_div(a, b);
+      }
+      else if constexpr(Mode == mode::tr) {
+        return Op == op::add ? tr_add(a, b) : Op == op::sub ? tr_sub(a, b) :
+            Op == op::mul ? tr_mul(a, b) : tr_div(a, b);
+      }
+      else {
+        return Op == op::add ? sr_add(a, b) : Op == op::sub ? sr_sub(a, b) :
+            Op == op::mul ? sr_mul(a, b) : sr_div(a, b);
+      }
+    }
+
+    // The narrowest wide type for all below E.
+    template <typename E>
+    using wide_t = std::conditional_t<E::template fits<std::int64_t>, std::int64_t, wide>;
+
+    // The type a child of a node evaluated in W is evaluated in: its own
+    // wide type (a product of int64 in __int128 is a single imul), but W
+    // when stepping.
+    template <bool Step, typename E, typename W>
+    using sub_t = std::conditional_t<Step, W, wide_t<E>>;
+
+    template <typename T, T Lo, T Hi>
+    struct leaf : node {
+      static_assert(bd_detail::wide_enough<T> && ia_limits<T>::digits <= 64,
+          "xv: the type is too wide");
+      static constexpr span range = { wide(Lo), wide(Hi), true };
+      template <typename W>
+      static constexpr bool fits = bd_detail::fits<W>(range);
+      static constexpr bool div0 = false;
+
+      T v;
+
+      constexpr explicit leaf(T x) : v(x) {}
+
+      template <bool Step, mode Mode, typename W>
+      constexpr W eval(bool&) const
+      {
+        return W(v);
+      }
+    };
+
+    template <op Op, typename L, typename R>
+    struct bin : node {
+      static constexpr op oper = Op;
+      using lhs = L;
+      using rhs = R;
+      static constexpr span range = range_of<Op>(L::range, R::range);
+      // This and all below.
+      template <typename W>
+      static constexpr bool fits = bd_detail::fits<W>(range) &&
+          L::template fits<W> && R::template fits<W>;
+      // A division by a divisor whose range has 0 here or below: its
+      // value may be out of the range (that of xx_div by 0).
+      static constexpr bool div0 = L::div0 || R::div0 ||
+          (Op == op::div && R::range.lo <= 0 && R::range.hi >= 0);
+
+      L l;
+      R r;
+
+      constexpr bin(L a, R b) : l(a), r(b) {}
+
+      template <bool Step, mode Mode, typename W>
+      constexpr W eval(bool& ovf) const
+      {
+        const W a = W(l.template eval<Step, Mode, sub_t<Step, L, W>>(ovf));
+        const W b = W(r.template eval<Step, Mode, sub_t<Step, R, W>>(ovf));
+        if constexpr(Step || (Op == op::div && R::range.lo <= 0 && R::range.hi >= 0)) {
+          return step<Op, Mode>(a, b, ovf);
+        }
+        else {
+          return Op == op::add ? W(a + b) : Op == op::sub ? W(a - b) :
+              Op == op::mul ? W(a * b) : W(a / b);
+        }
+      }
+
+      // This as the root, to T (see root_fold): the exact value of the
+      // int64 children converted to T, with a single overflow flag;
+      // neg is set to the sign of the exact value on overflow (which
+      // fits __int128). If no value in the range, wrapped to int64,
+      // falls into T, the step wraps and the conversion checks (that
+      // is shorter); otherwise the builtin gives both at once.
+      template <typename T, mode Mode>
+      constexpr T eval_to(bool& ovf, bool& wrap, bool& neg) const
+      {
+        const std::int64_t a = l.template eval<false, Mode, std::int64_t>(ovf);
+        const std::int64_t b = r.template eval<false, Mode, std::int64_t>(ovf);
+        T t = 0;
+        if constexpr(wraps_out_of<T>()) {
+          const std::uint64_t ua = std::uint64_t(a);
+          const std::uint64_t ub = std::uint64_t(b);
+          const std::int64_t w = std::int64_t(Op == op::add ? ua + ub :
+              Op == op::sub ? ua - ub : ua * ub);
+          t = T(w);
+          wrap = w != std::int64_t(t);
+        }
+        else {
+          wrap = Op == op::add ? __builtin_add_overflow(a, b, &t) :
+              Op == op::sub ? __builtin_sub_overflow(a, b, &t) :
+              __builtin_mul_overflow(a, b, &t);
+        }
+        if constexpr(Mode == mode::sr) {
+          if (SIA80_UNLIKELY(wrap)) {
+            neg = Op == op::add ? wide(a) + b < 0 : Op == op::sub ? wide(a) - b < 0 :
+                (a < 0) != (b < 0);
+          }
+        }
+        return t;
+      }
+
+      // Whether the range, wrapped to int64 (by 2^64), stays out of T.
+      template <typename T>
+      static constexpr bool wraps_out_of()
+      {
+        if constexpr(ia_limits<wide>::digits > 64) {
+          const wide m = wide(1) << 64;
+          return range.ok && ia_limits<T>::digits <= 63 &&
+              range.hi - m < wide(ia_limits<T>::min()) &&
+              range.lo + m > wide(ia_limits<T>::max());
+        }
+        else {
+          return false;
+        }
+      }
+    };
+
+    template <typename E>
+    struct is_bin : std::false_type {};
+    template <op Op, typename L, typename R>
+    struct is_bin<bin<Op, L, R>> : std::true_type {};
+
+    // A root of + - * which alone needs __int128, to T within 64 bits:
+    // the root operation on the int64 children and the conversion to
+    // T are one __builtin_xxx_overflow into T, so one check for the
+    // expression (e.g. a * b + c * d of int32 to int32).
+    template <typename T, typename E>
+    constexpr bool root_fold = [] {
+      if constexpr(is_bin<E>::value) {
+        return E::oper != op::div && !E::template fits<std::int64_t> &&
+            E::lhs::template fits<std::int64_t> && E::rhs::template fits<std::int64_t> &&
+            ia_limits<T>::digits <= 64;
+      }
+      else {
+        return false;
+      }
+    }();
+
+    template <typename E>
+    struct neg : node {
+      static constexpr span range = range_of<op::sub>({ 0, 0, true }, E::range);
+      template <typename W>
+      static constexpr bool fits = bd_detail::fits<W>(range) && E::template fits<W>;
+      static constexpr bool div0 = E::div0;
+
+      E e;
+
+      constexpr explicit neg(E x) : e(x) {}
+
+      template <bool Step, mode Mode, typename W>
+      constexpr W eval(bool& ovf) const
+      {
+        const W a = W(e.template eval<Step, Mode, sub_t<Step, E, W>>(ovf));
+        if constexpr(Step) {
+          return step<op::sub, Mode>(W(0), a, ovf);
+        }
+        else {
+          return W(-a);
+        }
+      }
+    };
+
+    template <typename T>
+    constexpr auto as_node(T v)
+    {
+      if constexpr(is_node<T>) {
+        return v;
+      }
+      else {
+        return leaf<T, ia_limits<T>::min(), ia_limits<T>::max()>(v);
+      }
+    }
+
+    template <typename T, T Lo, T Hi, mode Mode>
+    constexpr auto as_node(bounded<T, Lo, Hi, Mode> b)
+    {
+      return leaf<T, Lo, Hi>(b.value());
+    }
+
+    template <typename T>
+    using node_t = decltype(as_node(std::declval<T>()));
+
+    template <typename T>
+    struct is_bounded : std::false_type {};
+    template <typename T, T Lo, T Hi, mode Mode>
+    struct is_bounded<bounded<T, Lo, Hi, Mode>> : std::true_type {};
+
+    // An operand: a node, an integer or a bounded.
+    template <typename T>
+    constexpr bool is_operand = is_node<T> || ia_is_integral<T>::value ||
+        is_bounded<T>::value;
+
+    // Either side a node, the other any operand.
+    template <typename A, typename B>
+    constexpr bool binary_ok = (is_node<A> || is_node<B>) &&
+        is_operand<A> && is_operand<B>;
+
+#define SIA80_XP_BINARY(oper, o)                                              \
+    template <typename A, typename B,                                         \
+        std::enable_if_t<binary_ok<A, B>, bool> = true>                       \
+    constexpr auto operator oper(A a, B b)                                    \
+    {                                                                         \
+      return bin<op::o, node_t<A>, node_t<B>>(as_node(a), as_node(b));        \
+    }
+
+    SIA80_XP_BINARY(+, add)
+    SIA80_XP_BINARY(-, sub)
+    SIA80_XP_BINARY(*, mul)
+    SIA80_XP_BINARY(/, div)
+
+#undef SIA80_XP_BINARY
+
+    template <typename E, std::enable_if_t<is_node<E>, bool> = true>
+    constexpr neg<E> operator-(E e)
+    {
+      return neg<E>(e);
+    }
+
+    template <typename T, mode Mode, typename E>
+    constexpr T eval(const E& e, bool& ovf)
+    {
+      using W = wide_t<E>;
+      if constexpr(E::template fits<W> && !E::div0 && bd_detail::fits<T>(E::range)) {
+        // The range fits T: nothing to check.
+        return T(e.template eval<false, Mode, W>(ovf));
+      }
+      else if constexpr(root_fold<T, E>) {
+        bool wrap = false;
+        bool neg = false;
+        const T t = e.template eval_to<T, Mode>(ovf, wrap, neg);
+        if constexpr(Mode == mode::cf) {
+          ovf |= wrap;
+        }
+        else if constexpr(Mode == mode::cx) {
+          if (SIA80_UNLIKELY(wrap)) {
+            SIA80_CX_FAIL(range_error, "cx_conv");
+          }
+        }
+        else if constexpr(Mode == mode::sr) {
+          if (SIA80_UNLIKELY(wrap)) {
+            return neg ? ia_limits<T>::min() : ia_limits<T>::max();
+          }
+        }
+        return t;
+      }
+      else {
+        const W w = e.template eval<!E::template fits<W>, Mode, W>(ovf);
+        if constexpr(Mode == mode::cf) {
+          const cf_result<T> r = cf_conv<T>(w);
+          ovf |= r.overflowed;
+          return r.value;
+        }
+        else if constexpr(Mode == mode::cx) {
+          return cx_conv<T>(w);
+        }
+        else if constexpr(Mode == mode::tr) {
+          return tr_conv<T>(w);
+        }
+        else {
+          return sr_conv<T>(w);
+        }
+      }
+    }
+
+  } // namespace xp_detail
+
+  template <typename T,
+      std::enable_if_t<xp_detail::is_operand<T> && !xp_detail::is_node<T>, bool> = true>
+  constexpr auto xv(T v)
+  {
+    return xp_detail::as_node(v);
+  }
+
+  template <auto V>
+  inline constexpr xp_detail::leaf<decltype(V), V, V> xc { V };
+
+  template <typename E, std::enable_if_t<xp_detail::is_node<E>, bool> = true>
+  inline constexpr int xp_width = E::template fits<std::int64_t> ? 64 :
+      E::template fits<xp_detail::wide> && ia_limits<xp_detail::wide>::digits > 64 ? 128 : 0;
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<xp_detail::is_node<E>, bool> = true>
+  constexpr T cx_eval(const E& e)
+  {
+    bool ovf = false;
+    return xp_detail::eval<T, mode::cx>(e, ovf);
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<xp_detail::is_node<E>, bool> = true>
+  constexpr T cf_eval(const E& e, int *flag)
+  {
+    bool ovf = false;
+    const T r = xp_detail::eval<T, mode::cf>(e, ovf);
+    if (SIA80_UNLIKELY(ovf)) {
+      *flag = 1;
+    }
+    return r;
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<xp_detail::is_node<E>, bool> = true>
+  constexpr cf_result<T> cf_eval(const E& e)
+  {
+    bool ovf = false;
+    const T r = xp_detail::eval<T, mode::cf>(e, ovf);
+    return { r, ovf };
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<xp_detail::is_node<E>, bool> = true>
+  constexpr T tr_eval(const E& e)
+  {
+    bool ovf = false;
+    return xp_detail::eval<T, mode::tr>(e, ovf);
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<xp_detail::is_node<E>, bool> = true>
+  constexpr T sr_eval(const E& e)
+  {
+    bool ovf = false;
+    return xp_detail::eval<T, mode::sr>(e, ovf);
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
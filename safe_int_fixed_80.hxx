@@ -0,0 +1,282 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed point in Q format on plain integers: a value v of type T with
+// F fraction bits stands for v / 2^F. Q16.16 is int32_t with F = 16,
+// Q32.32 is int64_t with F = 32. Addition, subtraction and comparison
+// are those of the integers (xx_add, xx_sub); multiplication needs
+// the shift back, done here in a double width type.
+//
+// rounding: how a right shift drops the fraction bits.
+//   floor: toward minus infinity, as >>.
+//   trunc: toward zero, as / (and tr_shrx).
+//   ceil: toward plus infinity.
+//   nearest: to the nearest, ties toward plus infinity (add a half,
+//     then floor); the usual one for fixed point.
+//   even: to the nearest, ties to even (banker's rounding); no bias
+//     on sums of many rounded values.
+//
+// shr_round<R>(v, n): v / 2^n rounded by R, exactly; never overflows.
+//   Any n: for n of the width of T and more, the result is what
+//   the infinitely precise quotient rounds to (0, -1 or 1).
+//
+// xx_qmul<F, R>(a, b): Q multiplication, a * b / 2^F rounded by R
+//   (nearest by default), in the modes of the scalar functions:
+//   cx_qmul throws std::overflow_error if the result doesn't fit T,
+//   cf_qmul sets the flag (or returns cf_result) with the truncated
+//   value, tr_qmul truncates, sr_qmul saturates.
+//   The product is exact in the double width type (int64_t for int32_t,
+//   __int128 for int64_t), so it doesn't overflow before the shift.
+//   T is any integer type of 64 bits at most (32 bits without
+//   __int128); F is at most the width of T. With telemetry, events
+//   are those of the final xx_conv, attributed to the caller.
+//
+// xx_qmul_n<F, R>(dst, a, b, n): dst[i] = xx_qmul<F, R>(a[i], b[i])
+//   for i in [0, n). There are no branches on the values, so the loop
+//   can be vectorized: sr_ saturates by compare and select, cf_ merges
+//   the flag and stores it once. cx_qmul_n throws after the loop, with
+//   all dst elements written as by tr_qmul. dst may be the same as a
+//   or b; other overlaps are not allowed.
+//   With GCC -O3 -mavx2, the loops on 8..32 bit elements are
+//   vectorized; 64 bit ones have no vector type for the __int128
+//   product and stay scalar, without branches.
+
+namespace sia80 {
+
+  enum class rounding { floor, trunc, ceil, nearest, even };
+
+  namespace fx_detail {
+
+    // Rounding for n >= width of T: the quotient is in (-1, 1) (signed)
+    // or [0, 1) (unsigned); only a positive value rounded up, or a half
+    // or more of an unsigned value at n == width, can round to 1.
+    template <rounding R, typename T>
+    constexpr T shr_round_big(T v, unsigned n)
+    {
+      constexpr unsigned width = sizeof(T) * 8;
+      if constexpr(R == rounding::ceil) {
+        return T(v > 0);
+      }
+      else if constexpr(ia_is_signed<T>::value) {
+        return R == rounding::floor && v < 0 ? T(-1) : T(0);
+      }
+      else {
+        const T half = T(T(1) << (width - 1));
+        if (n == width &&
+            ((R == rounding::nearest && v >= half) ||
+             (R == rounding::even && v > half)))
+        {
+          return 1;
+        }
+        return 0;
+      }
+    }
+
+    template <typename T>
+    using wide_t = std::conditional_t<(sizeof(T) <= 2),
+        std::conditional_t<ia_is_signed<T>::value, std::int32_t, std::uint32_t>,
+#if defined(__SIZEOF_INT128__)
+        std::conditional_t<(sizeof(T) <= 4),
+            std::conditional_t<ia_is_signed<T>::value, std::int64_t, std::uint64_t>,
+            std::conditional_t<ia_is_signed<T>::value, __int128, unsigned __int128>>>;
+#else
+        std::conditional_t<ia_is_signed<T>::value, std::int64_t, std::uint64_t>>;
+#endif
+
+    template <typename T, unsigned F>
+    constexpr bool q_ok = ia_is_integral<T>::value &&
+        sizeof(T) <= sizeof(wide_t<T>) / 2 && F <= sizeof(T) * 8;
+
+  } // namespace fx_detail
+
+  template <rounding R, typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr T shr_round(T v, unsigned n)
+  {
+    constexpr unsigned width = sizeof(T) * 8;
+    if (n == 0) {
+      return v;
+    }
+    if (SIA80_UNLIKELY(n >= width)) {
+      return fx_detail::shr_round_big<R>(v, n);
+    }
+    // Floor quotient and remainder (0 <= r < 2^n); an increment
+    // of q never overflows as |q| <= max / 2.
+    using U = ia_make_unsigned_t<T>;
+    const T q = T(v >> n);
+    const U r = U(v) & U((U(1) << n) - 1);
+    const U half = U(U(1) << (n - 1));
+    if constexpr(R == rounding::floor) {
+      return q;
+    }
+    else if constexpr(R == rounding::trunc) {
+      return T(q + T((v < 0) & (r != 0)));
+    }
+    else if constexpr(R == rounding::ceil) {
+      return T(q + T(r != 0));
+    }
+    else if constexpr(R == rounding::nearest) {
+      return T(q + T(r >= half));
+    }
+    else {
+      return T(q + T((r > half) | ((r == half) & (q & 1))));
+    }
+  }
+
+  namespace fx_detail {
+
+    // The product is at most 2^(2w-2) in magnitude (signed w bit T)
+    // or below 2^(2w) - 2^(w+1) (unsigned); adding less than 2^w
+    // doesn't overflow W. So rounding is an addition before a single
+    // shift (as shr_round gives), which vectorizes well.
+    template <unsigned F, rounding R, typename T>
+    constexpr wide_t<T> qprod(T a, T b)
+    {
+      using W = wide_t<T>;
+      const W p = W(W(a) * W(b));
+      if constexpr(F == 0 || R == rounding::floor) {
+        return W(p >> F);
+      }
+      else if constexpr(R == rounding::trunc) {
+        constexpr W mask = W((W(1) << F) - 1);
+        return W((p + (p < 0 ? mask : W(0))) >> F);
+      }
+      else if constexpr(R == rounding::ceil) {
+        return W((p + ((W(1) << F) - 1)) >> F);
+      }
+      else if constexpr(R == rounding::nearest) {
+        return W((p + (W(1) << (F - 1))) >> F);
+      }
+      else {
+        // Ties go up only if the quotient is odd.
+        return W((p + (W(1) << (F - 1)) - 1 + ((p >> F) & 1)) >> F);
+      }
+    }
+
+  } // namespace fx_detail
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  constexpr T cx_qmul(T a, T b)
+  {
+    T result = 0;
+    if (SIA80_UNLIKELY(__builtin_add_overflow(fx_detail::qprod<F, R>(a, b), 0, &result))) {
+      SIA80_CX_FAIL(overflow_error, "cx_qmul");
+    }
+    return result;
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  constexpr T cf_qmul(T a, T b, int *flag SIA80_TM_SITE)
+  {
+    return cf_conv<T>(fx_detail::qprod<F, R>(a, b), flag SIA80_TM_PASS);
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  constexpr cf_result<T> cf_qmul(T a, T b SIA80_TM_SITE)
+  {
+    return cf_conv<T>(fx_detail::qprod<F, R>(a, b) SIA80_TM_PASS);
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  constexpr T tr_qmul(T a, T b)
+  {
+    return tr_conv<T>(fx_detail::qprod<F, R>(a, b));
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  constexpr T sr_qmul(T a, T b SIA80_TM_SITE)
+  {
+    return sr_conv<T>(fx_detail::qprod<F, R>(a, b) SIA80_TM_PASS);
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  constexpr T sr_qmul(T a, T b, branchless_t SIA80_TM_SITE)
+  {
+    return sr_conv<T>(fx_detail::qprod<F, R>(a, b), branchless SIA80_TM_PASS);
+  }
+
+  //-- arrays --------------------------------------------------
+
+  // The loops use plain compares and selects on the wide product
+  // instead of xx_conv (whose __builtin_add_overflow the vectorizer
+  // doesn't take); not for 64 bit T, where the scalar xx_conv on
+  // __int128 is cheaper.
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  inline void tr_qmul_n(T *dst, const T *a, const T *b, std::size_t n)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      dst[i] = tr_qmul<F, R>(a[i], b[i]);
+    }
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  inline void sr_qmul_n(T *dst, const T *a, const T *b, std::size_t n)
+  {
+    using W = fx_detail::wide_t<T>;
+    const W lo = ia_limits<T>::min();
+    const W hi = ia_limits<T>::max();
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(sizeof(T) == 8) {
+        dst[i] = sr_qmul<F, R>(a[i], b[i], branchless);
+      }
+      else {
+        const W p = fx_detail::qprod<F, R>(a[i], b[i]);
+        dst[i] = T(p < lo ? lo : p > hi ? hi : p);
+      }
+    }
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  inline void cf_qmul_n(T *dst, const T *a, const T *b, std::size_t n, int *flag)
+  {
+    // Not bool: OR-ing into an integer lets the loop be vectorized.
+    using W = fx_detail::wide_t<T>;
+    unsigned ovf = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      if constexpr(sizeof(T) == 8) {
+        cf_result<T> r = cf_qmul<F, R>(a[i], b[i]);
+        dst[i] = r.value;
+        ovf |= r.overflowed;
+      }
+      else {
+        const W p = fx_detail::qprod<F, R>(a[i], b[i]);
+        const T v = T(p);
+        dst[i] = v;
+        ovf |= W(v) != p;
+      }
+    }
+    if (ovf) {
+      *flag = 1;
+    }
+  }
+
+  template <unsigned F, rounding R = rounding::nearest, typename T,
+      std::enable_if_t<fx_detail::q_ok<T, F>, bool> = true>
+  inline void cx_qmul_n(T *dst, const T *a, const T *b, std::size_t n)
+  {
+    int flag = 0;
+    cf_qmul_n<F, R>(dst, a, b, n, &flag);
+    if (SIA80_UNLIKELY(flag)) {
+      SIA80_CX_FAIL(overflow_error, "cx_qmul_n");
+    }
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
@@ -0,0 +1,508 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <stdexcept>
+
+// Negation, absolute value, power, gcd and lcm in the four modes,
+// and midpoint. As for the scalar functions, the result is that
+// of the infinitely precise value: cx_xxx throws std::overflow_error
+// if it doesn't fit the result type, cf_xxx sets the flag (or returns
+// cf_result) with the truncated value, tr_xxx truncates, sr_xxx
+// saturates.
+//
+//   std::int64_t v = sia80::cx_pow(base, 12);
+//   auto [l, ovf] = sia80::cf_lcm(period_a, period_b);
+//
+// xx_neg(v): -v, in the type of -v (int for narrower types).
+//   Overflows for the minimum of a signed type, and for any non-zero
+//   value of an unsigned one.
+// xx_abs(v): |v|, in the type of +v; overflows for the minimum
+//   of a signed type.
+// uabs(v): |v| in the unsigned type of the same width as +v; never
+//   overflows.
+// xx_pow(base, exp): base^exp, in the type of +base; exp is of any
+//   integer type. 0^0 is 1. A negative exp is 1 / base^-exp rounded
+//   toward zero, as by xx_div: 0 unless base is 1 or -1, and division
+//   by zero for base 0 (cx_pow throws std::domain_error, cf_pow and
+//   tr_pow give ~0 as cf_div, sr_pow the maximum).
+//   An exp wider than the bit width of digits overflows for any |base|
+//   >= 2 and isn't multiplied out (except for the truncated value).
+//   Other exps are done by squaring in that fixed number of steps,
+//   with no branches on the bits of exp, and the overflow checks of
+//   the multiplications ORed together.
+// xx_gcd(a, b): greatest common divisor of |a| and |b|, in the type of
+//   a + b; gcd(0, 0) is 0. Binary (Stein's) algorithm, with ctz.
+//   Overflows only if it is 2^digits of a signed type (min and min,
+//   min and 0).
+// xx_lcm(a, b): least common multiple of |a| and |b|, in the type of
+//   a + b; 0 if any is 0. Computed as |a| / gcd * |b|, with the check
+//   of cf_mul on the product.
+// midpoint(a, b): (a + b) / 2 rounded toward a, for a and b of the
+//   same type, as std::midpoint; never overflows.
+// These have no telemetry events.
+
+namespace sia80 {
+
+  namespace mt_detail {
+
+    // The truncated result, whether the exact one doesn't fit, and
+    // its sign (the bound to saturate to). dom: division by zero.
+    template <typename TR>
+    struct res {
+      TR value;
+      bool ovf;
+      bool neg;
+      bool dom;
+    };
+
+    template <typename TR>
+    constexpr TR cx_take(res<TR> r, const char *what)
+    {
+      if (SIA80_UNLIKELY(r.ovf)) {
+        if (r.dom) {
+          SIA80_CX_FAIL(domain_error, what);
+        }
+        SIA80_CX_FAIL(overflow_error, what);
+      }
+      return r.value;
+    }
+
+    template <typename TR>
+    constexpr TR cf_take(res<TR> r, int *flag)
+    {
+      if (SIA80_UNLIKELY(r.ovf)) {
+        *flag = 1;
+      }
+      return r.value;
+    }
+
+    template <typename TR>
+    constexpr TR sr_take(res<TR> r)
+    {
+      if (SIA80_UNLIKELY(r.ovf)) {
+        return bl_detail::sat_bound<TR>(r.neg);
+      }
+      return r.value;
+    }
+
+    // |v| in UTR, at least as wide as T.
+    template <typename UTR, typename T>
+    constexpr UTR magnitude(T v)
+    {
+      if constexpr(ia_is_signed<T>::value) {
+        return v < 0 ? UTR(UTR(0) - UTR(v)) : UTR(v);
+      }
+      else {
+        return UTR(v);
+      }
+    }
+
+    template <typename U>
+    constexpr int ctz(U v)
+    {
+      if constexpr(sizeof(U) <= sizeof(unsigned)) {
+        return __builtin_ctz(v);
+      }
+      else if constexpr(sizeof(U) <= sizeof(unsigned long long)) {
+        return __builtin_ctzll(v);
+      }
+      else {
+        const unsigned long long lo = (unsigned long long) v;
+        return lo != 0 ? __builtin_ctzll(lo) : 64 + __builtin_ctzll((unsigned long long) (v >> 64));
+      }
+    }
+
+    constexpr int bit_width(unsigned v)
+    {
+      return v == 0 ? 0 : int(sizeof(unsigned) * 8) - __builtin_clz(v);
+    }
+
+    template <typename T>
+    constexpr res<decltype(-T())> neg(T v)
+    {
+      using TR = decltype(-v);
+      using UTR = ia_make_unsigned_t<TR>;
+      const TR value = ia_bit_cast<TR>(UTR(UTR(0) - UTR(TR(v))));
+      if constexpr(ia_is_signed<TR>::value) {
+        return { value, TR(v) == ia_limits<TR>::min(), false, false };
+      }
+      else {
+        return { value, v != 0, true, false };
+      }
+    }
+
+    template <typename T>
+    constexpr res<decltype(+T())> abs(T v)
+    {
+      using TR = decltype(+v);
+      if constexpr(ia_is_signed<TR>::value) {
+        const res<TR> n = neg(TR(v));
+        return v < 0 ? n : res<TR>{ TR(v), false, false, false };
+      }
+      else {
+        return { TR(v), false, false, false };
+      }
+    }
+
+    // gcd of magnitudes; Stein's algorithm.
+    template <typename U>
+    constexpr U ugcd(U a, U b)
+    {
+      if (a == 0) {
+        return b;
+      }
+      if (b == 0) {
+        return a;
+      }
+      const int k = ctz(U(a | b));
+      a >>= ctz(a);
+      do {
+        // Both odd; a = min, b = |b - a|, with a mask and not a branch
+        // (which would be mispredicted half of the time).
+        b >>= ctz(b);
+        const U d = U(b - a);
+        const U m = U(U(0) - U(b < a));
+        a = U(a + (d & m));
+        b = U((d ^ m) - m);
+      } while (b != 0);
+      return U(a << k);
+    }
+
+    // A non-negative magnitude in TR.
+    template <typename TR, typename UTR>
+    constexpr res<TR> from_magnitude(UTR m, bool ovf)
+    {
+      return { ia_bit_cast<TR>(m), ovf || m > UTR(ia_limits<TR>::max()), false, false };
+    }
+
+    template <typename T1, typename T2>
+    constexpr res<decltype(T1() + T2())> gcd(T1 a, T2 b)
+    {
+      using TR = decltype(a + b);
+      using UTR = ia_make_unsigned_t<TR>;
+      return from_magnitude<TR>(ugcd(magnitude<UTR>(a), magnitude<UTR>(b)), false);
+    }
+
+    template <typename T1, typename T2>
+    constexpr res<decltype(T1() + T2())> lcm(T1 a, T2 b)
+    {
+      using TR = decltype(a + b);
+      using UTR = ia_make_unsigned_t<TR>;
+      const UTR ua = magnitude<UTR>(a);
+      const UTR ub = magnitude<UTR>(b);
+      if (ua == 0 || ub == 0) {
+        return { 0, false, false, false };
+      }
+      const cf_result<UTR> p = cf_mul(UTR(ua / ugcd(ua, ub)), ub);
+      return from_magnitude<TR>(p.value, p.overflowed);
+    }
+
+    // x^e by squaring, wrapping.
+    template <typename U, typename E>
+    constexpr U upow(U x, E e)
+    {
+      U r = 1;
+      for (;;) {
+        r = U(r * ((e & 1) ? x : U(1)));
+        e >>= 1;
+        if (e == 0) {
+          return r;
+        }
+        x = U(x * x);
+      }
+    }
+
+    // x^e by squaring, with the overflow checks, for e < 2^Steps: a
+    // fixed number of steps, without branches on the bits of e. The
+    // squarings which aren't used any more don't count.
+    template <int Steps, typename U>
+    constexpr U upow_checked(U x, unsigned e, bool& ovf)
+    {
+      U r = 1;
+      for (int i = 0; i < Steps; ++i) {
+        ovf |= __builtin_mul_overflow(r, (e & 1) ? x : U(1), &r);
+        e >>= 1;
+        ovf |= __builtin_mul_overflow(x, x, &x) & (e != 0);
+      }
+      return r;
+    }
+
+    // pow for a negative exp, and for one wider than steps bits (see
+    // pow), out of the hot path.
+    template <typename TR, typename E>
+    [[gnu::cold]] constexpr res<TR> pow_rare(TR b, E exp)
+    {
+      using UTR = ia_make_unsigned_t<TR>;
+      if (exp < 0) {
+        if (b == 0) {
+          return { TR(~TR(0)), true, false, true };
+        }
+        if (b == 1 || (ia_is_signed<TR>::value && b == TR(-1))) {
+          return { TR(b != 1 && (exp & 1) ? TR(-1) : TR(1)), false, false, false };
+        }
+        return { 0, false, false, false };
+      }
+      const bool neg = b < 0 && (exp & 1);
+      if (magnitude<UTR>(b) <= 1) {
+        return { TR(b == 0 ? TR(0) : neg ? TR(-1) : TR(1)), false, false, false };
+      }
+      return { ia_bit_cast<TR>(upow(UTR(b), exp)), true, neg, false };
+    }
+
+    template <typename T, typename E>
+    constexpr res<decltype(+T())> pow(T base, E exp)
+    {
+      using TR = decltype(+base);
+      using UTR = ia_make_unsigned_t<TR>;
+      using UE = ia_make_unsigned_t<decltype(+exp)>;
+      const TR b = base;
+      // Any |base| >= 2 overflows with an exp wider than digits.
+      constexpr int digits = ia_limits<TR>::digits;
+      constexpr int steps = bit_width(unsigned(digits));
+      const UE ue = UE(exp);
+      if (SIA80_UNLIKELY((ue >> steps) != 0)) {
+        return pow_rare(b, +exp);
+      }
+      const bool neg = b < 0 && (ue & 1);
+      bool ovf = false;
+      const UTR mag = upow_checked<steps>(magnitude<UTR>(b), unsigned(ue), ovf);
+      // The truncated mag is that of the truncated result; a negative
+      // result may be down to -2^digits.
+      ovf |= mag > UTR(UTR(ia_limits<TR>::max()) + UTR(neg));
+      return { ia_bit_cast<TR>(neg ? UTR(UTR(0) - mag) : mag), ovf, neg, false };
+    }
+
+  } // namespace mt_detail
+
+  //-- neg
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto cx_neg(T v) -> decltype(-v)
+  {
+    return mt_detail::cx_take(mt_detail::neg(v), "cx_neg overflow");
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto cf_neg(T v, int *flag) -> decltype(-v)
+  {
+    return mt_detail::cf_take(mt_detail::neg(v), flag);
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto cf_neg(T v) -> cf_result<decltype(-v)>
+  {
+    const auto r = mt_detail::neg(v);
+    return { r.value, r.ovf };
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto tr_neg(T v) -> decltype(-v)
+  {
+    return mt_detail::neg(v).value;
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto sr_neg(T v) -> decltype(-v)
+  {
+    return mt_detail::sr_take(mt_detail::neg(v));
+  }
+
+  //-- abs
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto cx_abs(T v) -> decltype(+v)
+  {
+    return mt_detail::cx_take(mt_detail::abs(v), "cx_abs overflow");
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto cf_abs(T v, int *flag) -> decltype(+v)
+  {
+    return mt_detail::cf_take(mt_detail::abs(v), flag);
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto cf_abs(T v) -> cf_result<decltype(+v)>
+  {
+    const auto r = mt_detail::abs(v);
+    return { r.value, r.ovf };
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto tr_abs(T v) -> decltype(+v)
+  {
+    return mt_detail::abs(v).value;
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto sr_abs(T v) -> decltype(+v)
+  {
+    return mt_detail::sr_take(mt_detail::abs(v));
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr auto uabs(T v) -> ia_make_unsigned_t<decltype(+v)>
+  {
+    return mt_detail::magnitude<ia_make_unsigned_t<decltype(+v)>>(v);
+  }
+
+  //-- pow
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<E>::value, bool> = true>
+  constexpr auto cx_pow(T base, E exp) -> decltype(+base)
+  {
+    return mt_detail::cx_take(mt_detail::pow(base, exp), "cx_pow overflow");
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<E>::value, bool> = true>
+  constexpr auto cf_pow(T base, E exp, int *flag) -> decltype(+base)
+  {
+    return mt_detail::cf_take(mt_detail::pow(base, exp), flag);
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<E>::value, bool> = true>
+  constexpr auto cf_pow(T base, E exp) -> cf_result<decltype(+base)>
+  {
+    const auto r = mt_detail::pow(base, exp);
+    return { r.value, r.ovf };
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<E>::value, bool> = true>
+  constexpr auto tr_pow(T base, E exp) -> decltype(+base)
+  {
+    return mt_detail::pow(base, exp).value;
+  }
+
+  template <typename T, typename E,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<E>::value, bool> = true>
+  constexpr auto sr_pow(T base, E exp) -> decltype(+base)
+  {
+    return mt_detail::sr_take(mt_detail::pow(base, exp));
+  }
+
+  //-- gcd
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_gcd(T1 a, T2 b) -> decltype(a + b)
+  {
+    return mt_detail::cx_take(mt_detail::gcd(a, b), "cx_gcd overflow");
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_gcd(T1 a, T2 b, int *flag) -> decltype(a + b)
+  {
+    return mt_detail::cf_take(mt_detail::gcd(a, b), flag);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_gcd(T1 a, T2 b) -> cf_result<decltype(a + b)>
+  {
+    const auto r = mt_detail::gcd(a, b);
+    return { r.value, r.ovf };
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_gcd(T1 a, T2 b) -> decltype(a + b)
+  {
+    return mt_detail::gcd(a, b).value;
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_gcd(T1 a, T2 b) -> decltype(a + b)
+  {
+    return mt_detail::sr_take(mt_detail::gcd(a, b));
+  }
+
+  //-- lcm
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cx_lcm(T1 a, T2 b) -> decltype(a + b)
+  {
+    return mt_detail::cx_take(mt_detail::lcm(a, b), "cx_lcm overflow");
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_lcm(T1 a, T2 b, int *flag) -> decltype(a + b)
+  {
+    return mt_detail::cf_take(mt_detail::lcm(a, b), flag);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto cf_lcm(T1 a, T2 b) -> cf_result<decltype(a + b)>
+  {
+    const auto r = mt_detail::lcm(a, b);
+    return { r.value, r.ovf };
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto tr_lcm(T1 a, T2 b) -> decltype(a + b)
+  {
+    return mt_detail::lcm(a, b).value;
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto sr_lcm(T1 a, T2 b) -> decltype(a + b)
+  {
+    return mt_detail::sr_take(mt_detail::lcm(a, b));
+  }
+
+  //-- midpoint
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr T midpoint(T a, T b)
+  {
+    // The difference is exact in U; half of it fits T.
+    using U = ia_make_unsigned_t<T>;
+    if (a > b) {
+      return T(a - T(U(U(a) - U(b)) / 2));
+    }
+    return T(a + T(U(U(b) - U(a)) / 2));
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
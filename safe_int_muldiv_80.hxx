@@ -0,0 +1,372 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <safe_int_fixed_80.hxx>
+#include <safe_int_math_80.hxx>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+// a * b / c in one step, for rates and proration (bytes * now / period,
+// price * qty / lot), where cx_div(cx_mul(a, b), c) throws on the
+// product even if the quotient fits.
+//
+//   std::uint64_t part = sia80::cx_muldiv(bytes, elapsed, period);
+//   std::int64_t cost = sia80::sr_muldiv<sia80::rounding::ceil>(price, qty, lot);
+//
+// xx_muldiv<R>(a, b, c): a * b / c rounded by R (see safe_int_fixed_80.hxx;
+//   trunc, as /, by default), for a, b, c of one integer type T of 64
+//   bits at most (32 bits without __int128); the result is in T. The
+//   product is exact in the double width type, so the only failures
+//   are a quotient which doesn't fit T, and c == 0:
+//   cx_muldiv throws std::overflow_error (std::domain_error for c == 0);
+//   cf_muldiv sets the flag (or returns cf_result) with the truncated
+//     value; ~0 for c == 0, as cf_div;
+//   tr_muldiv truncates; ~0 for c == 0;
+//   sr_muldiv saturates; for c == 0, to the bound of the sign of a * b
+//     (the maximum for 0), as sr_div.
+//   The division is of magnitudes, so all the roundings cost the same:
+//   a compare of the remainder with the divisor and an increment.
+//   For 32 and 64 bit T, the product is divided with a single 64/32 or
+//   128/64 division (divl, divq on x86) when the quotient fits the half
+//   width, which is whenever the result can fit; otherwise by the
+//   double width division of the compiler (for 128 bits, a library
+//   call), only for the truncated value of tr and cf.
+//
+// xx_muldiv_n<R>(dst, a, b, c, n): dst[i] = xx_muldiv<R>(a[i], b[i], c)
+//   for i in [0, n), with one divisor. For 64 bit T without divq, the
+//   division by c is replaced with a multiplication by its reciprocal,
+//   computed once (Moller and Granlund, "Improved division by invariant
+//   integers", 2011): two multiplications and a correction without a
+//   branch per element. With divq, it is the faster one (measured on
+//   the muldiv benchmark), as is the 64 bit division for narrower T
+//   (against divider<std::uint64_t>).
+//   As for xx_qmul_n: cf_muldiv_n merges the flag and stores it once;
+//   cx_muldiv_n throws after the loop, with all dst elements written
+//   as by tr_muldiv (std::domain_error if c is 0 and n isn't). dst may
+//   be the same as a or b; other overlaps are not allowed.
+// These have no telemetry events.
+
+namespace sia80 {
+
+  namespace md_detail {
+
+    template <typename T>
+    constexpr bool md_ok = ia_is_integral<T>::value &&
+        sizeof(T) <= sizeof(fx_detail::wide_t<T>) / 2;
+
+    // The magnitude of the product, in the double width unsigned type.
+    template <typename T>
+    using prod_t = fx_detail::wide_t<ia_make_unsigned_t<T>>;
+
+    // Whether the quotient q (with the remainder r of the division by
+    // d) is rounded up in magnitude; neg is the sign of the quotient.
+    template <rounding R, typename P>
+    constexpr bool round_up(P q, P r, P d, bool neg)
+    {
+      if constexpr(R == rounding::trunc) {
+        return false;
+      }
+      else if constexpr(R == rounding::floor) {
+        return neg && r != 0;
+      }
+      else if constexpr(R == rounding::ceil) {
+        return !neg && r != 0;
+      }
+      // r > d - r, or r == d - r for a tie rounded up; one compare, as
+      // the halves are equally likely (r + 1 <= d doesn't wrap).
+      else if constexpr(R == rounding::nearest) {
+        // Ties toward plus infinity: up in magnitude if positive.
+        return P(r + P(!neg)) > P(d - r);
+      }
+      else {
+        return P(r + P(q & 1)) > P(d - r);
+      }
+    }
+
+    // The result of T from the rounded magnitude of the quotient.
+    template <typename T, typename P>
+    constexpr mt_detail::res<T> finish(P q, bool neg)
+    {
+      using U = ia_make_unsigned_t<T>;
+      // -q for neg, without a branch: the sign is as likely as not.
+      const P m = P(P(0) - P(neg));
+      const U v = U(P(q ^ m) - m);
+      // A negative result may be down to -2^digits.
+      const bool ovf = q > P(P(ia_limits<T>::max()) + P(neg));
+      return { ia_bit_cast<T>(v), ovf, neg, false };
+    }
+
+    template <typename T>
+    constexpr mt_detail::res<T> zero_div(T a, T b)
+    {
+      const bool neg = a != 0 && b != 0 && (a < 0) != (b < 0);
+      return { T(~T(0)), true, neg, true };
+    }
+
+    template <typename T>
+    constexpr bool quot_neg(T a, T b, T c)
+    {
+      if constexpr(ia_is_signed<T>::value) {
+        return ((a < 0) != (b < 0)) != (c < 0);
+      }
+      else {
+        return false;
+      }
+    }
+
+    // hi:lo / d for hi < d, with the remainder in r: one divl or divq,
+    // where the compiler would call its library for the double width.
+#if defined(__x86_64__) || defined(__i386__)
+    inline std::uint32_t div_hw(std::uint32_t hi, std::uint32_t lo,
+        std::uint32_t d, std::uint32_t& r)
+    {
+      std::uint32_t q;
+      asm("divl %4" : "=a"(q), "=d"(r) : "a"(lo), "d"(hi), "rm"(d) : "cc");
+      return q;
+    }
+#endif
+#if defined(__x86_64__)
+    inline std::uint64_t div_hw(std::uint64_t hi, std::uint64_t lo,
+        std::uint64_t d, std::uint64_t& r)
+    {
+      std::uint64_t q;
+      asm("divq %4" : "=a"(q), "=d"(r) : "a"(lo), "d"(hi), "rm"(d) : "cc");
+      return q;
+    }
+#endif
+
+    template <typename H>
+    constexpr bool has_div_hw =
+#if defined(__x86_64__)
+        true;
+#elif defined(__i386__)
+        sizeof(H) == 4;
+#else
+        false;
+#endif
+
+    template <rounding R, typename T>
+    constexpr mt_detail::res<T> muldiv(T a, T b, T c)
+    {
+      using P = prod_t<T>;
+      if (SIA80_UNLIKELY(c == 0)) {
+        return zero_div(a, b);
+      }
+      const bool neg = quot_neg(a, b, c);
+      using U = ia_make_unsigned_t<T>;
+      const P d = mt_detail::magnitude<U>(c);
+      const P p = P(P(mt_detail::magnitude<U>(a)) * mt_detail::magnitude<U>(b));
+      if constexpr(sizeof(P) >= 8) {
+        // The halves of the product.
+        using H = std::conditional_t<sizeof(P) == 16, std::uint64_t, std::uint32_t>;
+        constexpr unsigned hbits = sizeof(H) * 8;
+        const H hi = H(p >> hbits);
+        const H lo = H(p);
+        const H dh = H(d);
+        if (SIA80_UNLIKELY(hi >= dh)) {
+          // The quotient is 2^hbits or more: an overflow anyway, and the
+          // division is only for the truncated value (dead for sr).
+          const P q = P(p / d);
+          const P r = P(p % d);
+          const mt_detail::res<T> big = finish<T>(P(q + P(round_up<R>(q, r, d, neg))), neg);
+          return { big.value, true, neg, false };
+        }
+        // The quotient fits H: the rest is in H too.
+        H q = 0;
+        H r = 0;
+        if constexpr(has_div_hw<H>) {
+          if (!__builtin_is_constant_evaluated()) {
+            q = div_hw(hi, lo, dh, r);
+          }
+          else {
+            q = H(p / d);
+            r = H(p % d);
+          }
+        }
+        else {
+          q = H(p / d);
+          r = H(p % d);
+        }
+        return finish<T>(P(P(q) + P(round_up<R>(q, r, dh, neg))), neg);
+      }
+      else {
+        const P q = P(p / d);
+        return finish<T>(P(q + P(round_up<R>(q, P(p % d), d, neg))), neg);
+      }
+    }
+
+#if defined(__SIZEOF_INT128__)
+
+    // Division of n1:n0 by a divisor d with n1 < d, by the reciprocal
+    // of d normalized (the top bit set): udiv_qrnnd_preinv of GMP.
+    class recip64 {
+    public:
+      explicit recip64(std::uint64_t d)
+        : shift_(unsigned(__builtin_clzll(d))),
+          d_(d << shift_),
+          v_(std::uint64_t(((u128(~d_) << 64) | ~std::uint64_t(0)) / d_))
+      {
+      }
+
+      // The quotient (which fits as n1 < d), and the remainder in r.
+      std::uint64_t div(std::uint64_t n1, std::uint64_t n0, std::uint64_t& r) const
+      {
+        // (n0 >> 1) >> (63 - s): n0 >> (64 - s) also for s == 0.
+        n1 = (n1 << shift_) | ((n0 >> 1) >> (63 - shift_));
+        n0 <<= shift_;
+        const u128 qq = u128(v_) * n1 + ((u128(n1 + 1) << 64) | n0);
+        std::uint64_t q = std::uint64_t(qq >> 64);
+        std::uint64_t rr = n0 - q * d_;
+        // Taken about half of the time: a mask, not a branch.
+        const std::uint64_t mask = std::uint64_t(0) - std::uint64_t(rr > std::uint64_t(qq));
+        q += mask;
+        rr += mask & d_;
+        if (SIA80_UNLIKELY(rr >= d_)) {
+          rr -= d_;
+          ++q;
+        }
+        r = rr >> shift_;
+        return q;
+      }
+
+    private:
+      using u128 = unsigned __int128;
+      unsigned shift_;
+      std::uint64_t d_;
+      std::uint64_t v_;
+    };
+
+    // muldiv by the reciprocal of d = |c| (not 0).
+    template <rounding R, typename T>
+    inline mt_detail::res<T> muldiv_recip(T a, T b, T c, const recip64& rc)
+    {
+      using P = prod_t<T>;
+      const bool neg = quot_neg(a, b, c);
+      using U = ia_make_unsigned_t<T>;
+      const P d = mt_detail::magnitude<U>(c);
+      const P p = P(P(mt_detail::magnitude<U>(a)) * mt_detail::magnitude<U>(b));
+      std::uint64_t hi = 0;
+      if constexpr(sizeof(P) == 16) {
+        hi = std::uint64_t(p >> 64);
+        if (SIA80_UNLIKELY(hi >= std::uint64_t(d))) {
+          return muldiv<R>(a, b, c);
+        }
+      }
+      std::uint64_t r = 0;
+      const P q = P(rc.div(hi, std::uint64_t(p), r));
+      return finish<T>(P(q + P(round_up<R>(q, P(r), d, neg))), neg);
+    }
+
+#endif
+
+    // The loop of xx_muldiv_n; returns whether any element overflowed.
+    template <rounding R, mode Mode, typename T>
+    inline bool muldiv_n(T *dst, const T *a, const T *b, T c, std::size_t n)
+    {
+      // Not bool: OR-ing into an integer keeps the loop without branches.
+      unsigned ovf = 0;
+#if defined(__SIZEOF_INT128__) && !defined(__x86_64__)
+      // Without divq, the 128/64 division is a library call.
+      if constexpr(sizeof(prod_t<T>) == 16) {
+        if (c != 0) {
+          const recip64 rc(mt_detail::magnitude<ia_make_unsigned_t<T>>(c));
+          for (std::size_t i = 0; i < n; ++i) {
+            const mt_detail::res<T> r = muldiv_recip<R>(a[i], b[i], c, rc);
+            dst[i] = Mode == mode::sr ? mt_detail::sr_take(r) : r.value;
+            ovf |= r.ovf;
+          }
+          return ovf != 0;
+        }
+      }
+#endif
+      for (std::size_t i = 0; i < n; ++i) {
+        const mt_detail::res<T> r = muldiv<R>(a[i], b[i], c);
+        dst[i] = Mode == mode::sr ? mt_detail::sr_take(r) : r.value;
+        ovf |= r.ovf;
+      }
+      return ovf != 0;
+    }
+
+  } // namespace md_detail
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  constexpr T cx_muldiv(T a, T b, T c)
+  {
+    return mt_detail::cx_take(md_detail::muldiv<R>(a, b, c), "cx_muldiv");
+  }
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  constexpr T cf_muldiv(T a, T b, T c, int *flag)
+  {
+    return mt_detail::cf_take(md_detail::muldiv<R>(a, b, c), flag);
+  }
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  constexpr cf_result<T> cf_muldiv(T a, T b, T c)
+  {
+    const mt_detail::res<T> r = md_detail::muldiv<R>(a, b, c);
+    return { r.value, r.ovf };
+  }
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  constexpr T tr_muldiv(T a, T b, T c)
+  {
+    return md_detail::muldiv<R>(a, b, c).value;
+  }
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  constexpr T sr_muldiv(T a, T b, T c)
+  {
+    return mt_detail::sr_take(md_detail::muldiv<R>(a, b, c));
+  }
+
+  //-- arrays --------------------------------------------------
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  inline void tr_muldiv_n(T *dst, const T *a, const T *b, T c, std::size_t n)
+  {
+    md_detail::muldiv_n<R, mode::tr>(dst, a, b, c, n);
+  }
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  inline void sr_muldiv_n(T *dst, const T *a, const T *b, T c, std::size_t n)
+  {
+    md_detail::muldiv_n<R, mode::sr>(dst, a, b, c, n);
+  }
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  inline void cf_muldiv_n(T *dst, const T *a, const T *b, T c, std::size_t n, int *flag)
+  {
+    if (md_detail::muldiv_n<R, mode::cf>(dst, a, b, c, n)) {
+      *flag = 1;
+    }
+  }
+
+  template <rounding R = rounding::trunc, typename T,
+      std::enable_if_t<md_detail::md_ok<T>, bool> = true>
+  inline void cx_muldiv_n(T *dst, const T *a, const T *b, T c, std::size_t n)
+  {
+    const bool ovf = md_detail::muldiv_n<R, mode::cx>(dst, a, b, c, n);
+    if (SIA80_UNLIKELY(ovf)) {
+      if (c == 0) {
+        SIA80_CX_FAIL(domain_error, "cx_muldiv_n");
+      }
+      SIA80_CX_FAIL(overflow_error, "cx_muldiv_n");
+    }
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
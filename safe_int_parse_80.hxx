@@ -0,0 +1,284 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Parsing of integers in text, with the range check of Mode:
+//
+//   auto r = sia80::parse<std::int32_t>(buf, buf_end);
+//   // r.value, r.ptr - after the last digit
+//   auto s = sia80::parse<std::uint16_t, sia80::mode::sr>("70000"); // 65535
+//
+// parse<T, Mode>(first, last, base = 10), parse<T, Mode>(string_view,
+// base): an optional '-' and digits in base (2..36; letters in any
+// case), as std::from_chars, but in one pass for any T: the value is
+// that of the digits, then it is fitted to T as by the scalar
+// functions of Mode:
+//   mode::cx (default): std::range_error if it doesn't fit T,
+//     std::invalid_argument if there are no digits (or a bad base);
+//   mode::cf: overflowed is set, the value is truncated;
+//   mode::tr: the value is truncated (modulo 2^N, also for numbers
+//     of any length);
+//   mode::sr: the value is saturated.
+// '-' is allowed for unsigned T too: "-0" is 0, other negative values
+// don't fit. Without digits, ptr is first and the value is 0.
+// The result has overflowed set in all modes but cx.
+//
+// Base 10 and 16 take 8 characters at a time: a word is loaded,
+// its digits are recognized by SWAR range checks on all bytes and
+// converted with 3 multiplications (decimal) or shifts (hex).
+// Overflow is not checked per digit: digits are accumulated modulo
+// 2^64 (2^128 for __int128), and the result is known to be exact
+// from the number of significant digits, with a comparison with
+// the maximal string only for the longest ones. Then one bound check
+// for T is done. Other bases are parsed a digit at a time.
+
+namespace sia80 {
+
+  template <typename T>
+  struct parse_result {
+    T value;
+    // The first character not parsed.
+    const char *ptr;
+    // Didn't fit T (not with mode::cx, which throws instead).
+    bool overflowed;
+  };
+
+  namespace parse_detail {
+
+    constexpr std::uint64_t ones = 0x0101010101010101ull;
+    constexpr std::uint64_t highs = ones * 0x80;
+
+    // Up to 8 characters from p, zero-filled past last; the first
+    // character in the lowest byte.
+    constexpr std::uint64_t load8(const char *p, const char *last)
+    {
+      const std::size_t avail = std::size_t(last - p);
+      std::uint64_t x = 0;
+      if (__builtin_is_constant_evaluated()) {
+        for (std::size_t i = 0; i < 8 && i < avail; ++i) {
+          x |= std::uint64_t((unsigned char) p[i]) << (8 * i);
+        }
+        return x;
+      }
+      if (avail >= 8) {
+        std::memcpy(&x, p, 8);
+      }
+      else {
+        std::memcpy(&x, p, avail);
+      }
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      x = __builtin_bswap64(x);
+#endif
+      return x;
+    }
+
+    // 0x80 in each byte of x which is in [lo, hi], 0 in the others
+    // (lo <= hi < 0x80). The sums are done on 7 bits of each byte,
+    // so nothing carries into the next one.
+    constexpr std::uint64_t bytes_in(std::uint64_t x, unsigned lo, unsigned hi)
+    {
+      const std::uint64_t low7 = x & ~highs;
+      const std::uint64_t ge_lo = low7 + ones * (0x80 - lo);
+      const std::uint64_t gt_hi = low7 + ones * (0x7F - hi);
+      return ge_lo & ~gt_hi & ~x & highs;
+    }
+
+    // Number of leading bytes (from the first character) in mask.
+    constexpr unsigned run_length(std::uint64_t mask)
+    {
+      const std::uint64_t other = ~mask & highs;
+      return other == 0 ? 8 : unsigned(__builtin_ctzll(other)) / 8;
+    }
+
+    // 8 decimal digit values (0..9 per byte, the first one lowest)
+    // to the number.
+    constexpr std::uint32_t dec8(std::uint64_t v)
+    {
+      v = v * 10 + (v >> 8);
+      v = ((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) +
+          ((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+      return std::uint32_t(v);
+    }
+
+    // The same for 8 hex digit values.
+    constexpr std::uint32_t hex8(std::uint64_t v)
+    {
+      v = ((v << 4) | (v >> 8)) & 0x00FF00FF00FF00FFull;
+      v = ((v << 8) | (v >> 16)) & 0x0000FFFF0000FFFFull;
+      return std::uint32_t((v << 16) | (v >> 32));
+    }
+
+    constexpr std::uint64_t pow10[] = {
+      1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+    };
+
+    // The maximal value of U in decimal.
+    template <typename U>
+    constexpr const char *max_dec()
+    {
+      if constexpr(sizeof(U) == 8) {
+        return "18446744073709551615";
+      }
+      else {
+        return "340282366920938463463374607431768211455";
+      }
+    }
+
+    template <typename U>
+    constexpr std::size_t max_dec_len = sizeof(U) == 8 ? 20 : 39;
+
+    template <typename U>
+    struct magnitude_t {
+      U mag; // modulo 2^N of U
+      const char *ptr;
+      bool any; // there are digits
+      bool big; // doesn't fit U
+    };
+
+    constexpr int digit_value(char c)
+    {
+      if (c >= '0' && c <= '9') {
+        return c - '0';
+      }
+      if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 10;
+      }
+      if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 10;
+      }
+      return 99;
+    }
+
+    // Base 2..36, a digit at a time.
+    template <typename U>
+    constexpr magnitude_t<U> magnitude_any(const char *p, const char *last, int base)
+    {
+      const char *start = p;
+      U acc = 0;
+      bool big = false;
+      for (; p != last; ++p) {
+        const int d = digit_value(*p);
+        if (d >= base) {
+          break;
+        }
+        big |= __builtin_mul_overflow(acc, U(base), &acc);
+        big |= __builtin_add_overflow(acc, U(d), &acc);
+      }
+      return { acc, p, p != start, big };
+    }
+
+    // Base 10 and 16, 8 characters at a time.
+    template <typename U, int Base>
+    constexpr magnitude_t<U> magnitude(const char *p, const char *last)
+    {
+      const char *start = p;
+      U acc = 0;
+      // Leading zeros don't count in the length.
+      while (p != last && *p == '0') {
+        ++p;
+      }
+      const char *sig = p;
+      while (p != last) {
+        const std::uint64_t x = load8(p, last);
+        unsigned k = 0;
+        if constexpr(Base == 10) {
+          k = run_length(bytes_in(x, '0', '9'));
+          if (k == 0) {
+            break;
+          }
+          // The digits to the top: missing ones become leading zeros.
+          const std::uint64_t v = (x & (ones * 0x0F)) << (8 * (8 - k));
+          acc = U(acc * U(pow10[k]) + dec8(v));
+        }
+        else {
+          const std::uint64_t letters = bytes_in(x | (ones * 0x20), 'a', 'f');
+          k = run_length(bytes_in(x, '0', '9') | letters);
+          if (k == 0) {
+            break;
+          }
+          const std::uint64_t v = ((x & (ones * 0x0F)) + (letters >> 7) * 9) << (8 * (8 - k));
+          acc = U((acc << (4 * k)) | hex8(v));
+        }
+        p += k;
+        if (k < 8) {
+          break;
+        }
+      }
+      const std::size_t nd = std::size_t(p - sig);
+      bool big = nd > 2 * sizeof(U);
+      if constexpr(Base == 10) {
+        big = nd > max_dec_len<U>;
+        if (SIA80_UNLIKELY(nd == max_dec_len<U>)) {
+          const char *m = max_dec<U>();
+          std::size_t i = 0;
+          while (i < nd && sig[i] == m[i]) {
+            ++i;
+          }
+          big = i < nd && sig[i] > m[i];
+        }
+      }
+      return { acc, p, p != start, big };
+    }
+
+  } // namespace parse_detail
+
+  template <typename T, mode Mode = mode::cx,
+      std::enable_if_t<ia_is_integral<T>::value && !std::is_same<T, bool>::value, bool> = true>
+  constexpr parse_result<T> parse(const char *first, const char *last, int base = 10)
+  {
+    // Accumulator: 64 bits, or 128 for __int128.
+    using U = std::conditional_t<(sizeof(T) > 8), ia_make_unsigned_t<T>, std::uint64_t>;
+    using UT = ia_make_unsigned_t<T>;
+    if (SIA80_UNLIKELY(base < 2 || base > 36)) {
+      if constexpr(Mode == mode::cx) {
+        SIA80_CX_FAIL(invalid_argument, "parse: bad base");
+      }
+      return { 0, first, false };
+    }
+    const bool neg = first != last && *first == '-';
+    const parse_detail::magnitude_t<U> r =
+        base == 10 ? parse_detail::magnitude<U, 10>(first + neg, last) :
+        base == 16 ? parse_detail::magnitude<U, 16>(first + neg, last) :
+        parse_detail::magnitude_any<U>(first + neg, last, base);
+    if (SIA80_UNLIKELY(!r.any)) {
+      if constexpr(Mode == mode::cx) {
+        SIA80_CX_FAIL(invalid_argument, "parse: no digits");
+      }
+      return { 0, first, false };
+    }
+    // One bound check: the maximum, or the magnitude of the minimum
+    // for a negative value.
+    constexpr U tmax = U(UT(ia_limits<T>::max()));
+    const U limit = neg ? (ia_is_signed<T>::value ? U(tmax + 1) : U(0)) : tmax;
+    const bool ovf = r.big || r.mag > limit;
+    T value = ia_bit_cast<T>(UT(neg ? U(U(0) - r.mag) : r.mag));
+    if constexpr(Mode == mode::cx) {
+      if (SIA80_UNLIKELY(ovf)) {
+        SIA80_CX_FAIL(range_error, "parse: out of range");
+      }
+    }
+    else if constexpr(Mode == mode::sr) {
+      if (SIA80_UNLIKELY(ovf)) {
+        value = neg ? ia_limits<T>::min() : ia_limits<T>::max();
+      }
+    }
+    return { value, r.ptr, ovf };
+  }
+
+  template <typename T, mode Mode = mode::cx,
+      std::enable_if_t<ia_is_integral<T>::value && !std::is_same<T, bool>::value, bool> = true>
+  constexpr parse_result<T> parse(std::string_view s, int base = 10)
+  {
+    return parse<T, Mode>(s.data(), s.data() + s.size(), base);
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
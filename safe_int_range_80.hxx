@@ -0,0 +1,172 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <cstddef>
+
+// Range proofs for index expressions: check once, before a loop,
+// that an affine index can't overflow for any index in the loop
+// range, then compute it inside the loop with tr_xxx, without checks.
+//
+//   // out[i] = base + i * stride for i in [0, n)
+//   auto ix = sia80::cx_prove_affine(base, stride, n);
+//   for (std::size_t i = 0; i < n; ++i) {
+//     out[i] = ix(i);
+//   }
+//
+//   // a 5 point stencil on a rows x cols grid with leading dimension
+//   // ld: all of (i -+ 1) * ld + (j -+ 1) for i in [1, rows - 2],
+//   // j in [1, cols - 2]
+//   auto g = sia80::cx_prove_index(0, sia80::index_range<int>{ 0, rows - 1, ld },
+//       sia80::index_range<int>{ 0, cols - 1, 1 });
+//   ... in[g(i - 1, j)] + in[g(i, j + 1)] ...
+//
+// index_range<T>{first, last, stride}: an index in [first, last]
+//   (inclusive, first <= last; indices may be negative for signed T)
+//   with its stride.
+// cx_prove_index(base, ranges...): proven_index<T, D> for
+//   base + i0 * stride0 + i1 * stride1 + ... . Each term is monotone
+//   in its index, so its extremes are at first and last; the minimal
+//   and maximal sums are computed with cx_mul and cx_add (and cx_conv
+//   for types narrower than int), term by term in the order of
+//   evaluation. So it throws std::overflow_error if any combination
+//   of indices in the ranges overflows T. The partial sums need not
+//   lie between the final extremes (base 0, terms in [-10, -10] and
+//   [100, 100]: -10 is out of [90, 90]), but the k-th partial sum
+//   lies between the minimal and maximal sums of the first k terms,
+//   which were checked on the way; so tr_add never wraps there.
+// cx_prove_affine(base, stride, n): the same for one index in [0, n)
+//   (any integer type n; std::range_error if n - 1 doesn't fit T).
+//   n == 0 proves nothing to be used.
+// cx_prove_2d(rows, cols, ld) and cx_prove_3d(nz, ny, nx, ldy, ldz):
+//   row major offsets j + i * ld (and + k * ldz) for indices in
+//   [0, extent); base 0, strides 1, ld (, ldz).
+//
+// proven_index<T, D>: the token. It is made only by the cx_prove_xxx
+//   functions. ix(i0, ..., iD-1) computes the expression with tr_mul
+//   and tr_add, in the order of the ranges; the indices must be in
+//   the proven ranges (not checked: that is the point). ix.min() and
+//   ix.max() are the extremes; ix.checked(...) is the same with
+//   checks, std::out_of_range for an index out of its range (also
+//   one of any integer type which doesn't fit T, e.g. -1 for unsigned).
+
+namespace sia80 {
+
+  template <typename T>
+  struct index_range {
+    T first;
+    T last;
+    T stride;
+  };
+
+  template <typename T, std::size_t D>
+  class proven_index {
+  public:
+    template <typename... I>
+    constexpr T operator()(I... idx) const
+    {
+      static_assert(sizeof...(I) == D, "proven_index: wrong number of indices");
+      const T v[D] = { T(idx)... };
+      T off = base_;
+      for (std::size_t k = 0; k < D; ++k) {
+        off = T(tr_add(off, T(tr_mul(v[k], stride_[k]))));
+      }
+      return off;
+    }
+
+    template <typename... I>
+    constexpr T checked(I... idx) const
+    {
+      static_assert(sizeof...(I) == D, "proven_index: wrong number of indices");
+      // An index which doesn't fit T is out of its range as well.
+      T v[D] = {};
+      bool outside[D] = {};
+      std::size_t n = 0;
+      ((outside[n] = __builtin_add_overflow(idx, 0, &v[n]), ++n), ...);
+      for (std::size_t k = 0; k < D; ++k) {
+        if (SIA80_UNLIKELY(outside[k] || v[k] < first_[k] || v[k] > last_[k])) {
+          SIA80_CX_FAIL(out_of_range, "proven_index: index out of the proven range");
+        }
+      }
+      return (*this)(idx...);
+    }
+
+    constexpr T min() const { return min_; }
+    constexpr T max() const { return max_; }
+
+  private:
+    constexpr proven_index() = default;
+
+    T base_ = 0;
+    T stride_[D] = {};
+    T first_[D] = {};
+    T last_[D] = {};
+    T min_ = 0;
+    T max_ = 0;
+
+    template <typename T1, typename... R>
+    friend constexpr proven_index<T1, sizeof...(R)> cx_prove_index(T1 base, R... ranges);
+  };
+
+  template <typename T, typename... R>
+  constexpr proven_index<T, sizeof...(R)> cx_prove_index(T base, R... ranges)
+  {
+    static_assert(ia_is_integral<T>::value, "cx_prove_index needs an integral type");
+    static_assert((std::is_same<R, index_range<T>>::value && ...),
+        "cx_prove_index: ranges are index_range<T>");
+    proven_index<T, sizeof...(R)> ix;
+    const index_range<T> r[] = { ranges... };
+    ix.base_ = base;
+    ix.min_ = base;
+    ix.max_ = base;
+    for (std::size_t k = 0; k < sizeof...(R); ++k) {
+      if (SIA80_UNLIKELY(r[k].first > r[k].last)) {
+        SIA80_CX_FAIL(out_of_range, "cx_prove_index: empty range");
+      }
+      ix.stride_[k] = r[k].stride;
+      ix.first_[k] = r[k].first;
+      ix.last_[k] = r[k].last;
+      // The term at both ends; as the term is monotone, these are
+      // its extremes.
+      const T a = cx_conv<T>(cx_mul(r[k].first, r[k].stride));
+      const T b = cx_conv<T>(cx_mul(r[k].last, r[k].stride));
+      ix.min_ = cx_conv<T>(cx_add(ix.min_, a < b ? a : b));
+      ix.max_ = cx_conv<T>(cx_add(ix.max_, a < b ? b : a));
+    }
+    return ix;
+  }
+
+  template <typename T, typename N,
+      std::enable_if_t<ia_is_integral<T>::value && ia_is_integral<N>::value, bool> = true>
+  constexpr proven_index<T, 1> cx_prove_affine(T base, T stride, N n)
+  {
+    const T last = n > 0 ? cx_conv<T>(n - 1) : T(0);
+    return cx_prove_index(base, index_range<T>{ T(0), last, stride });
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr proven_index<T, 2> cx_prove_2d(T rows, T cols, T ld)
+  {
+    const T one = T(rows > 0) & T(cols > 0);
+    return cx_prove_index(T(0),
+        index_range<T>{ T(0), T(one ? rows - 1 : 0), ld },
+        index_range<T>{ T(0), T(one ? cols - 1 : 0), T(1) });
+  }
+
+  template <typename T,
+      std::enable_if_t<ia_is_integral<T>::value, bool> = true>
+  constexpr proven_index<T, 3> cx_prove_3d(T nz, T ny, T nx, T ldy, T ldz)
+  {
+    const T one = T(nz > 0) & T(ny > 0) & T(nx > 0);
+    return cx_prove_index(T(0),
+        index_range<T>{ T(0), T(one ? nz - 1 : 0), ldz },
+        index_range<T>{ T(0), T(one ? ny - 1 : 0), ldy },
+        index_range<T>{ T(0), T(one ? nx - 1 : 0), T(1) });
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
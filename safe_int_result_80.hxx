@@ -0,0 +1,174 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+
+// Checked operations without exceptions: ex_xxx checks the same
+// conditions as cx_xxx, but returns result<T> with the value and
+// the kind of the error instead of throwing. A throw allocates,
+// formats and unwinds, microseconds on each failure; this is a pair
+// in registers. It doesn't depend on SIA80_CX_POLICY: with
+// -fno-exceptions, cx_xxx trap, and ex_xxx still report.
+//
+//   sia80::result<std::int32_t> r = sia80::ex_mul(price, qty);
+//   if (!r) {
+//     return reject(sia80::errc_name(r.error));
+//   }
+//   total = r.value;
+//
+// ex_add, ex_sub, ex_mul, ex_div, ex_rem, ex_shl, ex_shr, ex_shrx,
+// ex_conv<T>, ex_ufit, ex_sfit: the types as of cx_xxx. On error,
+// value is that of cf_xxx (the truncated result).
+// errc, and what cx_xxx throws instead:
+//   overflow: the result doesn't fit (add, sub, mul, shl;
+//     std::overflow_error).
+//   div_by_zero: div and rem by 0 (std::domain_error).
+//   div_min_neg: div and rem of the minimum by -1 (std::overflow_error).
+//   bad_shift: shift count negative or not below the digits of the
+//     result type (std::out_of_range).
+//   inexact: shrx shifted out non-zero bits (std::range_error).
+//   too_big, too_small: conv, ufit, sfit above or below the target
+//     range (std::range_error); sfit to 0 bits by the sign of the value.
+// The check is that of cf_xxx; the kind is found only on failure.
+// With telemetry, the events are counted as of cf_xxx.
+
+namespace sia80 {
+
+  enum class errc : unsigned char {
+    ok, overflow, div_by_zero, div_min_neg, bad_shift, inexact,
+    too_big, too_small
+  };
+
+  constexpr const char *errc_name(errc e)
+  {
+    constexpr const char *names[] = {
+      "ok", "overflow", "div_by_zero", "div_min_neg", "bad_shift",
+      "inexact", "too_big", "too_small"
+    };
+    return names[unsigned(e)];
+  }
+
+  template <typename T>
+  struct result {
+    T value;
+    errc error;
+
+    constexpr bool ok() const { return error == errc::ok; }
+    constexpr explicit operator bool() const { return ok(); }
+    constexpr T value_or(T dflt) const { return ok() ? value : dflt; }
+  };
+
+  namespace ex_detail {
+
+    template <typename T>
+    constexpr result<T> of(cf_result<T> r, errc e)
+    {
+      return { r.value, r.overflowed ? e : errc::ok };
+    }
+
+    // Outside of the target range: below it only if negative.
+    template <typename T1, typename T2>
+    constexpr result<T1> range(cf_result<T1> r, T2 ival)
+    {
+      return of(r, ival < 0 ? errc::too_small : errc::too_big);
+    }
+
+  } // namespace ex_detail
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_add(T1 v1, T2 v2 SIA80_TM_SITE) -> result<decltype(v1+v2)>
+  {
+    return ex_detail::of(cf_add(v1, v2 SIA80_TM_PASS), errc::overflow);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_sub(T1 v1, T2 v2 SIA80_TM_SITE) -> result<decltype(v1-v2)>
+  {
+    return ex_detail::of(cf_sub(v1, v2 SIA80_TM_PASS), errc::overflow);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_mul(T1 v1, T2 v2 SIA80_TM_SITE) -> result<decltype(v1*v2)>
+  {
+    return ex_detail::of(cf_mul(v1, v2 SIA80_TM_PASS), errc::overflow);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_div(T1 ddnd, T2 dvsr SIA80_TM_SITE) -> result<decltype(ddnd/dvsr)>
+  {
+    return ex_detail::of(cf_div(ddnd, dvsr SIA80_TM_PASS),
+        dvsr == 0 ? errc::div_by_zero : errc::div_min_neg);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_rem(T1 ddnd, T2 dvsr SIA80_TM_SITE) -> result<decltype(ddnd%dvsr)>
+  {
+    return ex_detail::of(cf_rem(ddnd, dvsr SIA80_TM_PASS),
+        dvsr == 0 ? errc::div_by_zero : errc::div_min_neg);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_shl(T1 v1, T2 shcnt SIA80_TM_SITE) -> result<decltype(v1 << shcnt)>
+  {
+    using TR = decltype(v1 << shcnt);
+    return ex_detail::of(cf_shl(v1, shcnt SIA80_TM_PASS),
+        shrx_detail::bad_count<TR>(shcnt) ? errc::bad_shift : errc::overflow);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_shr(T1 v1, T2 shcnt SIA80_TM_SITE) -> result<decltype(v1 >> shcnt)>
+  {
+    return ex_detail::of(cf_shr(v1, shcnt SIA80_TM_PASS), errc::bad_shift);
+  }
+
+  template <typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr auto ex_shrx(T1 v1, T2 shcnt SIA80_TM_SITE) -> result<decltype(v1 >> shcnt)>
+  {
+    using TR = decltype(v1 >> shcnt);
+    return ex_detail::of(cf_shrx(v1, shcnt SIA80_TM_PASS),
+        shrx_detail::bad_count<TR>(shcnt) ? errc::bad_shift : errc::inexact);
+  }
+
+  template<typename T1, typename T2,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true,
+      std::enable_if_t<ia_is_integral<T2>::value, bool> = true>
+  constexpr result<T1> ex_conv(T2 ival SIA80_TM_SITE)
+  {
+    return ex_detail::range(cf_conv<T1>(ival SIA80_TM_PASS), ival);
+  }
+
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr result<T1> ex_ufit(T1 ival, unsigned nbits SIA80_TM_SITE)
+  {
+    return ex_detail::range(cf_ufit(ival, nbits SIA80_TM_PASS), ival);
+  }
+
+  template<typename T1,
+      std::enable_if_t<ia_is_integral<T1>::value, bool> = true>
+  constexpr result<T1> ex_sfit(T1 ival, unsigned nbits SIA80_TM_SITE)
+  {
+    return ex_detail::range(cf_sfit(ival, nbits SIA80_TM_PASS), ival);
+  }
+
+} // namespace sia80
+
+// vim: ts=2 sts=2 sw=2 et :
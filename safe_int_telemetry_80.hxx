@@ -0,0 +1,295 @@
+// Copyright (C) 2020-2024 Valentin Nechayev.
+// In public domain.
+
+#pragma once
+
+// Overflow telemetry: counts of cf_xxx flag events and sr_xxx
+// saturations, per call site.
+//
+// Compiled in only with SIA80_TELEMETRY defined to 1 (for the whole
+// program, e.g. -DSIA80_TELEMETRY=1). Then cf_xxx and sr_xxx get a
+// trailing defaulted parameter, the call site (file and line, taken
+// with __builtin_FILE/__builtin_LINE), and each event is counted by
+// (op, mode, file, line). Without the macro, nothing of this is
+// included and the generated code is unchanged.
+//
+// What is counted:
+//   cf_xxx: each call that sets the flag (or returns overflowed);
+//   sr_xxx: each call that returns a bound instead of the exact
+//     result (also with branchless); sr_rem and sr_shr, which are
+//     tr_rem and tr_shr, aren't counted.
+// Calls in constant evaluation aren't counted. Calls made by
+// overflow_sticky are attributed to its caller; calls made by other
+// headers (divider, batch) are attributed to those headers.
+//
+// Counters are per thread: a thread owns a block of slots (an open
+// addressing table by site), aligned to a cache line; the owner
+// updates a counter with a plain relaxed load and store, without
+// a locked instruction. Blocks are never freed: at thread exit a block
+// is released, with its counts, for reuse by a next new thread.
+// Events that don't find a free slot are counted as unplaced.
+//
+//   tm_snapshot s = sia80::tm_collect();  // while threads run
+//   s.merge(other);                       // e.g. from another process
+//   sia80::tm_dump(s);                    // to stderr
+//
+// tm_collect() doesn't stop the counting threads: each counter is
+// read atomically, but counters are not read at the same instant,
+// so a snapshot is consistent per counter only.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace sia80 {
+
+  // Defined in safe_int_arith_80.hxx.
+  enum class mode;
+
+  enum class tm_op : unsigned char {
+    add, sub, mul, div, rem, shl, shr, shrx, conv, ufit, sfit
+  };
+
+  inline const char *tm_op_name(tm_op op)
+  {
+    static const char *const names[] = {
+      "add", "sub", "mul", "div", "rem", "shl", "shr", "shrx", "conv", "ufit", "sfit"
+    };
+    return names[unsigned(op)];
+  }
+
+  inline const char *tm_mode_name(mode md)
+  {
+    static const char *const names[] = { "cx", "cf", "tr", "sr" };
+    return names[unsigned(md)];
+  }
+
+  // Call site; the default argument of current() is the place where
+  // it is called (or where the enclosing default argument is used).
+  struct tm_site {
+    const char *file;
+    unsigned line;
+
+    static constexpr tm_site current(
+        const char *file = __builtin_FILE(),
+        unsigned line = __builtin_LINE())
+    {
+      return { file, line };
+    }
+  };
+
+  struct tm_record {
+    tm_op op;
+    mode md;
+    const char *file;
+    unsigned line;
+    std::uint64_t count;
+  };
+
+  // Sorted by (file, line, op, mode), one record per key.
+  struct tm_snapshot {
+    std::vector<tm_record> records;
+    std::uint64_t unplaced = 0;
+
+    void merge(const tm_snapshot& other);
+    std::uint64_t total() const;
+  };
+
+  namespace tm_detail {
+
+    // Slots per thread; a power of 2.
+    constexpr unsigned nslots = 512;
+
+    struct slot {
+      // Published last (release); the key fields don't change after.
+      std::atomic<const char *> file { nullptr };
+      unsigned line = 0;
+      unsigned char op = 0;
+      unsigned char md = 0;
+      std::atomic<std::uint64_t> count { 0 };
+    };
+
+    struct alignas(64) block {
+      slot slots[nslots];
+      std::atomic<std::uint64_t> unplaced { 0 };
+      // Set while a live thread owns the block.
+      alignas(64) std::atomic<bool> owned { true };
+      block *next = nullptr;
+    };
+
+    inline std::atomic<block *> blocks { nullptr };
+    inline thread_local block *own_block = nullptr;
+
+    // Increment by the only writer: no locked instruction.
+    [[gnu::always_inline]] inline void bump(std::atomic<std::uint64_t>& c)
+    {
+      c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    struct releaser {
+      ~releaser()
+      {
+        if (own_block) {
+          own_block->owned.store(false, std::memory_order_release);
+          own_block = nullptr;
+        }
+      }
+    };
+
+    [[gnu::noinline]] inline block *attach()
+    {
+      static thread_local releaser rel;
+      (void) rel;
+      block *b = blocks.load(std::memory_order_acquire);
+      for (; b; b = b->next) {
+        bool expected = false;
+        if (!b->owned.load(std::memory_order_relaxed) &&
+            b->owned.compare_exchange_strong(expected, true,
+                std::memory_order_acquire))
+        {
+          break;
+        }
+      }
+      if (!b) {
+        b = new block;
+        b->next = blocks.load(std::memory_order_relaxed);
+        while (!blocks.compare_exchange_weak(b->next, b,
+              std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+      }
+      own_block = b;
+      return b;
+    }
+
+    // Not cold: that would also make it optimized for size.
+    [[gnu::noinline]]
+    inline void record(tm_op op, mode md, tm_site site) noexcept
+    {
+      block *b = own_block;
+      if (__builtin_expect(b == nullptr, 0)) {
+        b = attach();
+      }
+      std::uint64_t h = std::uint64_t(reinterpret_cast<std::uintptr_t>(site.file)) ^
+          (std::uint64_t(site.line) << 8) ^
+          (unsigned(op) << 2) ^ unsigned(md);
+      h *= 0x9e3779b97f4a7c15ull;
+      unsigned idx = unsigned(h >> 32);
+      for (unsigned probe = 0; probe < nslots; ++probe, ++idx) {
+        slot& s = b->slots[idx & (nslots - 1)];
+        const char *file = s.file.load(std::memory_order_relaxed);
+        if (file == site.file && s.line == site.line &&
+            s.op == unsigned(op) && s.md == unsigned(md))
+        {
+          bump(s.count);
+          return;
+        }
+        if (file == nullptr) {
+          s.line = site.line;
+          s.op = (unsigned char) op;
+          s.md = (unsigned char) md;
+          s.count.store(1, std::memory_order_relaxed);
+          s.file.store(site.file, std::memory_order_release);
+          return;
+        }
+      }
+      bump(b->unplaced);
+    }
+
+    // The hook in cf_xxx and sr_xxx.
+    constexpr void event(bool happened, tm_op op, mode md, tm_site site)
+    {
+      if (__builtin_expect(long(happened), 0) && !__builtin_is_constant_evaluated()) {
+        record(op, md, site);
+      }
+    }
+
+    inline bool key_less(const tm_record& a, const tm_record& b)
+    {
+      if (a.file != b.file) {
+        int c = std::strcmp(a.file, b.file);
+        if (c != 0) {
+          return c < 0;
+        }
+      }
+      if (a.line != b.line) {
+        return a.line < b.line;
+      }
+      if (a.op != b.op) {
+        return a.op < b.op;
+      }
+      return a.md < b.md;
+    }
+
+    // Sort and sum records of the same key: the same file name
+    // can come as different pointers from different translation units.
+    inline void combine(std::vector<tm_record>& recs)
+    {
+      std::sort(recs.begin(), recs.end(), key_less);
+      std::size_t out = 0;
+      for (std::size_t i = 0; i < recs.size(); ++i) {
+        if (out > 0 && !key_less(recs[out - 1], recs[i])) {
+          recs[out - 1].count += recs[i].count;
+        }
+        else {
+          recs[out++] = recs[i];
+        }
+      }
+      recs.resize(out);
+    }
+
+  } // namespace tm_detail
+
+  inline void tm_snapshot::merge(const tm_snapshot& other)
+  {
+    records.insert(records.end(), other.records.begin(), other.records.end());
+    tm_detail::combine(records);
+    unplaced += other.unplaced;
+  }
+
+  inline std::uint64_t tm_snapshot::total() const
+  {
+    std::uint64_t sum = unplaced;
+    for (const tm_record& r : records) {
+      sum += r.count;
+    }
+    return sum;
+  }
+
+  // Counts of all threads, live and exited, since the program start.
+  inline tm_snapshot tm_collect()
+  {
+    tm_snapshot snap;
+    for (tm_detail::block *b = tm_detail::blocks.load(std::memory_order_acquire);
+        b; b = b->next)
+    {
+      for (const tm_detail::slot& s : b->slots) {
+        const char *file = s.file.load(std::memory_order_acquire);
+        if (file) {
+          snap.records.push_back({ tm_op(s.op), mode(s.md), file, s.line,
+              s.count.load(std::memory_order_relaxed) });
+        }
+      }
+      snap.unplaced += b->unplaced.load(std::memory_order_relaxed);
+    }
+    tm_detail::combine(snap.records);
+    return snap;
+  }
+
+  // One line per record: "file:line: sr_add 12".
+  inline void tm_dump(const tm_snapshot& snap, std::FILE *out = stderr)
+  {
+    for (const tm_record& r : snap.records) {
+      std::fprintf(out, "%s:%u: %s_%s %llu\n", r.file, r.line,
+          tm_mode_name(r.md), tm_op_name(r.op), (unsigned long long) r.count);
+    }
+    if (snap.unplaced) {
+      std::fprintf(out, "(unplaced): %llu\n", (unsigned long long) snap.unplaced);
+    }
+  }
+
+} // namespace sia80
+// vim: ts=2 sts=2 sw=2 et :
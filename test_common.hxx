@@ -1,6 +1,7 @@
 #pragma once
 
 #include <safe_int_arith_80.hxx>
+#include <cstdint>
 #include <stdexcept>
 
 #if WITH_VOLATILE
@@ -12,6 +13,19 @@
 #define ASSERT_ALWAYS(expr) \
   do { if (!(expr)) { throw std::runtime_error(#expr); } } while(0)
 
+// Test data: the MMIX linear congruential generator. next() returns
+// the new state; its low bits have short periods, so take the high
+// ones.
+struct rng {
+  std::uint64_t x;
+
+  std::uint64_t next()
+  {
+    x = x * 6364136223846793005ull + 1442695040888963407ull;
+    return x;
+  }
+};
+
 void test_cx_add_signed();
 void test_sr_add_signed();
 void test_cx_div_signed();
@@ -19,3 +33,27 @@ void test_cx_ufit_signed();
 void test_cx_ufit_unsigned();
 void test_cx_sfit_signed();
 void test_cx_sfit_unsigned();
+void test_fit_modes();
+void test_sr_batch();
+void test_sum();
+void test_cf_pair();
+void test_constexpr();
+void test_divider();
+void test_sr_branchless();
+void test_conv_batch();
+void test_bitpack();
+void test_batch_isa();
+void test_int128();
+void test_telemetry();
+void test_fixed();
+void test_parse();
+void test_arena();
+void test_range();
+void test_bounded();
+void test_atomic();
+void test_math();
+void test_muldiv();
+void test_result();
+// In a translation unit without exceptions; the number of failures.
+int test_result_noexc();
+void test_expr();
@@ -0,0 +1,229 @@
+#include "test_common.hxx"
+#include <safe_int_arena_80.hxx>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// arena: alignment and disjointness of allocations, overflowing sizes
+// (which must throw, not wrap into small ones), the initial buffer,
+// chunk accounting against a counting upstream, and the pmr use.
+
+namespace {
+
+  // Upstream that counts what is outstanding.
+  class counting_resource : public std::pmr::memory_resource {
+  public:
+    std::size_t outstanding = 0;
+    std::size_t calls = 0;
+
+  protected:
+    void *do_allocate(std::size_t bytes, std::size_t align) override
+    {
+      outstanding += bytes;
+      ++calls;
+      return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t align) override
+    {
+      outstanding -= bytes;
+      std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+      return this == &other;
+    }
+  };
+
+  struct flex_head {
+    std::uint16_t count;
+  };
+
+} // namespace
+
+static void report(const char *label, std::size_t a, std::size_t b)
+{
+  std::cerr << "test_arena: " << label << ": mismatch for: a=" << a
+          << "; b=" << b << "\n";
+  throw std::runtime_error("Assertion failed: arena mismatch");
+}
+
+template <class T>
+static bool array_throws(sia80::arena& a, std::size_t n)
+{
+  try {
+    a.alloc_array<T>(n);
+  }
+  catch (std::bad_array_new_length&) {
+    return true;
+  }
+  return false;
+}
+
+static void check_overflow()
+{
+  counting_resource up;
+  sia80::arena a(4096, &up);
+  INPUT std::size_t big = SIZE_MAX;
+  // Room in the chunk, so wrapped sizes would take the fast path.
+  a.alloc(1, 1);
+  // Products that wrap to small values.
+  for (std::size_t n : { std::size_t(big), big / 2 + 1, big / 4 + 2, big / 8 + 1 }) {
+    if (!array_throws<std::uint64_t>(a, n)) {
+      report("alloc_array<uint64_t> no throw", n, 8);
+    }
+  }
+  if (!array_throws<char[3]>(a, big / 3 + 1)) {
+    report("alloc_array<char[3]> no throw", big / 3 + 1, 3);
+  }
+  // Fits size_t, but not with the chunk header.
+  bool excepted = false;
+  try {
+    a.alloc(big - 8, 1);
+  }
+  catch (std::bad_array_new_length&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  excepted = false;
+  try {
+    a.alloc_flex<flex_head, std::uint32_t>(big / 4);
+  }
+  catch (std::bad_array_new_length&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  // Nothing more was taken from upstream on the way.
+  ASSERT_ALWAYS(up.calls == 1);
+  // A large, valid size which the upstream refuses.
+  sia80::arena b(4096, std::pmr::null_memory_resource());
+  excepted = false;
+  try {
+    b.alloc_array<int>(1000);
+  }
+  catch (std::bad_array_new_length&) {
+  }
+  catch (std::bad_alloc&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+}
+
+static void check_layout()
+{
+  counting_resource up;
+  {
+    sia80::arena a(256, &up);
+    struct span { char *p; std::size_t n; unsigned char fill; };
+    std::vector<span> spans;
+    rng r { 99 };
+    for (int i = 0; i < 5000; ++i) {
+      const std::uint64_t x = r.next();
+      const std::size_t align = std::size_t(1) << ((x >> 20) % 8); // 1..128
+      // Mostly small, sometimes larger than a chunk.
+      std::size_t n = (x >> 40) % 97 == 0 ? (x >> 24) % 20000 : (x >> 30) % 70;
+      char *p;
+      switch ((x >> 50) % 3) {
+      case 0:
+        p = static_cast<char *>(a.alloc(n, align));
+        break;
+      case 1:
+        p = reinterpret_cast<char *>(a.alloc_array<std::uint32_t>(n / 4));
+        n = n / 4 * 4;
+        if (reinterpret_cast<std::uintptr_t>(p) % alignof(std::uint32_t) != 0) {
+          report("alloc_array alignment", reinterpret_cast<std::uintptr_t>(p), 4);
+        }
+        break;
+      default:
+        p = static_cast<char *>(a.allocate(n, align));
+        break;
+      }
+      if (p == nullptr) {
+        report("null", n, align);
+      }
+      if ((x >> 50) % 3 != 1 && reinterpret_cast<std::uintptr_t>(p) % align != 0) {
+        report("alignment", reinterpret_cast<std::uintptr_t>(p), align);
+      }
+      const unsigned char fill = (unsigned char) (x >> 8);
+      std::memset(p, fill, n);
+      spans.push_back({ p, n, fill });
+    }
+    // Disjoint: every span still holds its own fill.
+    for (const span& s : spans) {
+      for (std::size_t i = 0; i < s.n; ++i) {
+        if ((unsigned char) s.p[i] != s.fill) {
+          report("overlap", i, s.n);
+        }
+      }
+    }
+    if (a.upstream_bytes() != up.outstanding) {
+      report("upstream_bytes", a.upstream_bytes(), up.outstanding);
+    }
+    a.release();
+    ASSERT_ALWAYS(up.outstanding == 0);
+    ASSERT_ALWAYS(a.upstream_bytes() == 0);
+    // Usable again after release, and returned on destruction.
+    ASSERT_ALWAYS(a.alloc_array<double>(10) != nullptr);
+    ASSERT_ALWAYS(up.outstanding != 0);
+  }
+  ASSERT_ALWAYS(up.outstanding == 0);
+}
+
+static void check_buffer()
+{
+  counting_resource up;
+  alignas(16) char buf[256];
+  sia80::arena a(buf, sizeof(buf), &up);
+  char *p = a.alloc_array<char>(200);
+  ASSERT_ALWAYS(p == buf);
+  int *q = a.alloc_array<int>(8);
+  ASSERT_ALWAYS(reinterpret_cast<char *>(q) >= buf + 200 &&
+      reinterpret_cast<char *>(q + 8) <= buf + sizeof(buf));
+  ASSERT_ALWAYS(up.calls == 0);
+  // Doesn't fit the rest of the buffer.
+  char *r = a.alloc_array<char>(100);
+  ASSERT_ALWAYS(up.calls == 1);
+  ASSERT_ALWAYS(r < buf || r >= buf + sizeof(buf));
+  a.release();
+  ASSERT_ALWAYS(up.outstanding == 0);
+  ASSERT_ALWAYS(a.alloc_array<char>(10) == buf);
+  // alloc(0) and alloc_array(0) are valid pointers, also at the start.
+  sia80::arena e(4096, &up);
+  ASSERT_ALWAYS(e.alloc(0, 1) != nullptr);
+  ASSERT_ALWAYS(e.alloc_array<int>(0) != nullptr);
+}
+
+static void check_flex_pmr()
+{
+  counting_resource up;
+  sia80::arena a(1024, &up);
+  flex_head *h = a.alloc_flex<flex_head, std::uint64_t>(5);
+  std::uint64_t *tail = sia80::arena::flex_tail<flex_head, std::uint64_t>(h);
+  ASSERT_ALWAYS(reinterpret_cast<std::uintptr_t>(tail) % alignof(std::uint64_t) == 0);
+  ASSERT_ALWAYS(reinterpret_cast<char *>(tail) >= reinterpret_cast<char *>(h + 1));
+  h->count = 5;
+  for (int i = 0; i < 5; ++i) {
+    tail[i] = std::uint64_t(i);
+  }
+  std::pmr::vector<int> v(&a);
+  for (int i = 0; i < 10000; ++i) {
+    v.push_back(i);
+  }
+  long long sum = 0;
+  for (int e : v) {
+    sum += e;
+  }
+  ASSERT_ALWAYS(sum == 49995000LL);
+  ASSERT_ALWAYS(h->count == 5 && tail[4] == 4);
+  ASSERT_ALWAYS(a.is_equal(a) && !a.is_equal(up));
+}
+
+void test_arena()
+{
+  check_overflow();
+  check_layout();
+  check_buffer();
+  check_flex_pmr();
+}
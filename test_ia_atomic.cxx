@@ -0,0 +1,234 @@
+#include "test_common.hxx"
+#include <safe_int_atomic_80.hxx>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Atomic xx_fetch_xxx: in one thread, all values and operands of 8 bit
+// types against the exact results (the stored value, the returned one,
+// the flag, the exception with the value unchanged); in several threads,
+// that no add is lost or wraps: saturation stays at the bound, cx_
+// admits exactly the adds which fit, cf_ flags exactly the wraps.
+// sharded_counter: exact sums and saturation at the limit, on both
+// paths of add().
+
+using i128 = __int128;
+
+static void report(const char *label, long long a, long long b,
+    long long got, long long expected)
+{
+  std::cerr << "test_atomic: " << label << ": mismatch for: a=" << a
+          << "; b=" << b << "; result=" << got
+          << ", expected " << expected << "\n";
+  throw std::runtime_error("Assertion failed: atomic mismatch");
+}
+
+enum class aop { add, sub, mul };
+
+template <aop Op, class T>
+static T do_cx(std::atomic<T>& a, T v)
+{
+  if constexpr(Op == aop::add) { return sia80::cx_fetch_add(a, v); }
+  else if constexpr(Op == aop::sub) { return sia80::cx_fetch_sub(a, v); }
+  else { return sia80::cx_fetch_mul(a, v); }
+}
+
+template <aop Op, class T>
+static T do_cf(std::atomic<T>& a, T v, int *flag)
+{
+  if constexpr(Op == aop::add) { return sia80::cf_fetch_add(a, v, flag); }
+  else if constexpr(Op == aop::sub) { return sia80::cf_fetch_sub(a, v, flag); }
+  else { return sia80::cf_fetch_mul(a, v, flag); }
+}
+
+template <aop Op, class T>
+static sia80::cf_result<T> do_cfp(std::atomic<T>& a, T v)
+{
+  if constexpr(Op == aop::add) { return sia80::cf_fetch_add(a, v); }
+  else if constexpr(Op == aop::sub) { return sia80::cf_fetch_sub(a, v); }
+  else { return sia80::cf_fetch_mul(a, v); }
+}
+
+template <aop Op, class T>
+static T do_sr(std::atomic<T>& a, T v)
+{
+  if constexpr(Op == aop::add) { return sia80::sr_fetch_add(a, v); }
+  else if constexpr(Op == aop::sub) { return sia80::sr_fetch_sub(a, v); }
+  else { return sia80::sr_fetch_mul(a, v); }
+}
+
+template <aop Op, class T>
+static void check_single()
+{
+  const long long lo = std::numeric_limits<T>::min();
+  const long long hi = std::numeric_limits<T>::max();
+  for (long long x = lo; x <= hi; ++x) {
+    for (long long y = lo; y <= hi; ++y) {
+      const i128 e = Op == aop::add ? i128(x) + y : Op == aop::sub ? i128(x) - y : i128(x) * y;
+      const bool fits = e >= lo && e <= hi;
+      const T trunc = T(e);
+      const T sat = e < lo ? T(lo) : e > hi ? T(hi) : T(e);
+      INPUT T iy = T(y);
+      std::atomic<T> a { T(x) };
+      bool excepted = false;
+      try {
+        if (do_cx<Op>(a, T(iy)) != T(x)) {
+          report("cx old", x, y, 0, x);
+        }
+      }
+      catch (std::overflow_error&) {
+        excepted = true;
+      }
+      if (excepted == fits || a.load() != (fits ? trunc : T(x))) {
+        report("cx", x, y, a.load(), (long long) e);
+      }
+      a = T(x);
+      int flag = 0;
+      if (do_cf<Op>(a, T(iy), &flag) != T(x) || a.load() != trunc || flag != !fits) {
+        report("cf", x, y, a.load(), flag);
+      }
+      a = T(x);
+      const sia80::cf_result<T> r = do_cfp<Op>(a, T(iy));
+      if (r.value != T(x) || a.load() != trunc || r.overflowed == fits) {
+        report("cfp", x, y, a.load(), r.overflowed);
+      }
+      a = T(x);
+      if (do_sr<Op>(a, T(iy)) != T(x) || a.load() != sat) {
+        report("sr", x, y, a.load(), sat);
+      }
+    }
+  }
+}
+
+// Run fn(t) in nthreads threads.
+template <class F>
+static void in_threads(int nthreads, F fn)
+{
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthreads; ++t) {
+    threads.emplace_back([&fn, t] { fn(t); });
+  }
+  for (std::thread& th : threads) {
+    th.join();
+  }
+}
+
+constexpr int nthreads = 4;
+
+static void check_threads()
+{
+  // Saturation: never wraps past the bound, and comes back exactly.
+  std::atomic<std::int32_t> s { INT32_MAX - 1000 };
+  in_threads(nthreads, [&s](int) {
+    for (int i = 0; i < 100000; ++i) {
+      sia80::sr_fetch_add(s, 1);
+    }
+  });
+  ASSERT_ALWAYS(s.load() == INT32_MAX);
+  in_threads(nthreads, [&s](int) {
+    for (int i = 0; i < 100000; ++i) {
+      sia80::sr_fetch_sub(s, 1, std::memory_order_relaxed);
+    }
+  });
+  ASSERT_ALWAYS(s.load() == INT32_MAX - nthreads * 100000);
+  // cx: exactly the adds which fit succeed.
+  std::atomic<std::uint16_t> c { 0 };
+  std::atomic<long> ok { 0 };
+  std::atomic<long> failed { 0 };
+  in_threads(nthreads, [&](int) {
+    for (int i = 0; i < 30000; ++i) {
+      try {
+        sia80::cx_fetch_add(c, 1);
+        ok.fetch_add(1);
+      }
+      catch (std::overflow_error&) {
+        failed.fetch_add(1);
+      }
+    }
+  });
+  if (c.load() != 65535 || ok.load() != 65535 || failed.load() != nthreads * 30000 - 65535) {
+    report("cx threads", ok.load(), failed.load(), c.load(), 65535);
+  }
+  // cf: the wrapping adds are flagged, each once.
+  std::atomic<std::uint16_t> w { 0 };
+  std::atomic<int> flags { 0 };
+  in_threads(nthreads, [&](int) {
+    int flag = 0;
+    for (int i = 0; i < 50000; ++i) {
+      flag = 0;
+      sia80::cf_fetch_add(w, 3, &flag);
+      flags.fetch_add(flag);
+    }
+  });
+  const long total = long(nthreads) * 50000 * 3;
+  if (w.load() != total % 65536 || flags.load() != total / 65536) {
+    report("cf threads", w.load(), flags.load(), total % 65536, total / 65536);
+  }
+}
+
+static void check_sharded()
+{
+  bool excepted = false;
+  try {
+    sia80::sharded_counter<std::uint32_t> bad(UINT32_MAX / 2 + 1);
+  }
+  catch (std::domain_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  ASSERT_ALWAYS(sia80::sharded_counter<std::uint32_t>(100, 3).shards() == 4);
+  // Below the limit: exact, also with shards shared by threads.
+  for (unsigned shards : { 1u, 2u, 16u }) {
+    sia80::sharded_counter<std::uint64_t> c(UINT64_MAX / 2, shards);
+    in_threads(nthreads, [&c](int t) {
+      for (int i = 0; i < 100000; ++i) {
+        c.add(std::uint64_t(t + 1));
+      }
+    });
+    if (c.value() != 100000u * (1 + 2 + 3 + 4) || c.saturated()) {
+      report("sharded sum", shards, 0, (long long) c.value(), 1000000);
+    }
+    c.reset();
+    ASSERT_ALWAYS(c.value() == 0);
+  }
+  // At the limit, by small and by large adds.
+  sia80::sharded_counter<std::uint32_t> q(250000, 2);
+  in_threads(nthreads, [&q](int) {
+    for (int i = 0; i < 100000; ++i) {
+      q.add(1);
+    }
+  });
+  if (q.value() != 250000 || !q.saturated()) {
+    report("sharded limit", 0, 0, q.value(), 250000);
+  }
+  sia80::sharded_counter<std::uint32_t> big;
+  INPUT std::uint32_t step = UINT32_MAX / 16;
+  in_threads(nthreads, [&big, &step](int) {
+    for (int i = 0; i < 5; ++i) {
+      big.add(step);
+    }
+  });
+  if (big.value() != UINT32_MAX / 2) {
+    report("sharded large", step, 0, big.value(), UINT32_MAX / 2);
+  }
+  // One small add on top of a shard at the limit is clamped back.
+  sia80::sharded_counter<std::uint32_t> one(1000, 1);
+  one.add(999);
+  one.add(5);
+  one.add(UINT32_MAX / 4);
+  ASSERT_ALWAYS(one.value() == 1000);
+}
+
+void test_atomic()
+{
+  check_single<aop::add, std::int8_t>();
+  check_single<aop::sub, std::int8_t>();
+  check_single<aop::mul, std::int8_t>();
+  check_single<aop::add, std::uint8_t>();
+  check_single<aop::sub, std::uint8_t>();
+  check_single<aop::mul, std::uint8_t>();
+  check_threads();
+  check_sharded();
+}
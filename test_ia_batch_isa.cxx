@@ -0,0 +1,35 @@
+#include "test_common.hxx"
+#include <safe_int_batch_80.hxx>
+
+// Every batch kernel which the CPU can run shall match the scalar
+// functions: the batch tests are repeated with each of them forced.
+
+void test_batch_isa()
+{
+  using sia80::batch_isa;
+  const batch_isa initial = sia80::batch_current_isa();
+  ASSERT_ALWAYS(sia80::batch_isa_supported(initial));
+  const batch_isa all[] = {
+    batch_isa::scalar, batch_isa::sse2, batch_isa::avx2, batch_isa::avx512bw
+  };
+  int nrun = 0;
+  for (batch_isa isa : all) {
+    if (!sia80::batch_force_isa(isa)) {
+      ASSERT_ALWAYS(!sia80::batch_isa_supported(isa));
+      ASSERT_ALWAYS(sia80::batch_current_isa() != isa);
+      continue;
+    }
+    ASSERT_ALWAYS(sia80::batch_current_isa() == isa);
+    test_sr_batch();
+    test_conv_batch();
+    test_bitpack();
+    test_sum();
+    ++nrun;
+  }
+  ASSERT_ALWAYS(nrun >= 1);
+  ASSERT_ALWAYS(sia80::batch_force_isa(initial));
+#if SIA80_BATCH_DISPATCH
+  // At least the scalar loop and SSE2.
+  ASSERT_ALWAYS(nrun >= 2);
+#endif
+}
@@ -0,0 +1,273 @@
+#include "test_common.hxx"
+#include <safe_int_bitpack_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// bitpack_ufit/sfit and bitunpack_u/s against a model in __int128:
+// fields are xx_ufit or xx_sfit of each element, decoded fields are
+// xx_conv of the value of the bits. All types of 8..64 bits, widths
+// 0..64, all modes; arrays of values which fit and of values which
+// don't, with the one out of range at several positions.
+
+namespace {
+
+  using sia80::mode;
+
+  using U128 = unsigned __int128;
+
+  U128 mask_of(unsigned nbits)
+  {
+    return (U128(1) << nbits) - 1;
+  }
+
+  // A field in two words at once.
+  std::uint64_t model_field(const std::vector<std::uint64_t>& s, std::size_t i, unsigned nbits)
+  {
+    if (nbits == 0) {
+      return 0;
+    }
+    const std::size_t k = i * nbits;
+    const std::size_t w = k / 64;
+    const U128 two = s[w] | (w + 1 < s.size() ? U128(s[w + 1]) << 64 : 0);
+    return std::uint64_t((two >> (k % 64)) & mask_of(nbits));
+  }
+
+  template <mode Mode, bool Sfit, typename T>
+  T model_fit(T x, unsigned nbits)
+  {
+    if constexpr(Mode == mode::sr) {
+      return Sfit ? sia80::sr_sfit(x, nbits) : sia80::sr_ufit(x, nbits);
+    }
+    else {
+      return Sfit ? sia80::tr_sfit(x, nbits) : sia80::tr_ufit(x, nbits);
+    }
+  }
+
+  template <mode Mode, typename T, typename W>
+  T model_conv(W v, bool& ovf)
+  {
+    const sia80::cf_result<T> r = sia80::cf_conv<T>(v);
+    ovf |= r.overflowed;
+    if constexpr(Mode == mode::sr) {
+      return sia80::sr_conv<T>(v);
+    }
+    return r.value;
+  }
+
+  template <typename T>
+  [[noreturn]] void fail(const char *label, const char *what, std::size_t n, unsigned nbits, std::size_t i)
+  {
+    std::cerr << "test_bitpack: " << label << ": " << what << ": n=" << n
+            << "; nbits=" << nbits << "; i=" << i << "\n";
+    throw std::runtime_error("Assertion failed: bitpack mismatch");
+  }
+
+  template <mode Mode, bool Sfit, typename T>
+  void check_pack(const char *label, const std::vector<T>& src, unsigned arg_nbits)
+  {
+    INPUT unsigned nbits = arg_nbits;
+    const std::size_t n = src.size();
+    const std::size_t nw = sia80::bitpack_words(n, nbits);
+    ASSERT_ALWAYS(nw == (n * nbits + 63) / 64);
+    // The model stream and whether all fit.
+    std::vector<std::uint64_t> e(nw + 1, 0);
+    bool e_ovf = false;
+    for (std::size_t i = 0; i < n; ++i) {
+      const sia80::cf_result<T> r = Sfit ? sia80::cf_sfit(src[i], nbits) :
+          sia80::cf_ufit(src[i], nbits);
+      e_ovf |= r.overflowed;
+      const U128 v = U128(std::uint64_t(model_fit<Mode, Sfit>(src[i], nbits))) & mask_of(nbits);
+      const std::size_t k = i * nbits;
+      if (nbits != 0) {
+        const U128 sh = v << (k % 64);
+        e[k / 64] |= std::uint64_t(sh);
+        e[k / 64 + 1] |= std::uint64_t(sh >> 64);
+      }
+    }
+    // One word more than needed, to see it untouched.
+    const std::uint64_t guard = 0x5A5A5A5A5A5A5A5Aull;
+    std::vector<std::uint64_t> r(nw + 1, guard);
+    e[nw] = guard;
+    bool r_ovf = false;
+    bool excepted = false;
+    try {
+      r_ovf = Sfit ? sia80::bitpack_sfit<Mode>(r.data(), src.data(), n, nbits) :
+          sia80::bitpack_ufit<Mode>(r.data(), src.data(), n, nbits);
+    }
+    catch (std::range_error&) {
+      excepted = true;
+    }
+    if (Mode == mode::cx) {
+      if (excepted != e_ovf) {
+        fail<T>(label, "cx exception", n, nbits, 0);
+      }
+      if (excepted) {
+        // Nothing written.
+        for (std::size_t k = 0; k <= nw; ++k) {
+          if (r[k] != guard) {
+            fail<T>(label, "written on exception", n, nbits, k);
+          }
+        }
+        return;
+      }
+    }
+    else if (r_ovf != e_ovf) {
+      fail<T>(label, "overflowed", n, nbits, 0);
+    }
+    for (std::size_t k = 0; k <= nw; ++k) {
+      if (r[k] != e[k]) {
+        fail<T>(label, "packed word", n, nbits, k);
+      }
+    }
+  }
+
+  template <mode Mode, bool Sfit, typename T>
+  void check_unpack(const char *label, const std::vector<std::uint64_t>& s,
+      std::size_t n, unsigned nbits)
+  {
+    using W = std::conditional_t<Sfit, std::int64_t, std::uint64_t>;
+    std::vector<T> e(n);
+    bool e_ovf = false;
+    for (std::size_t i = 0; i < n; ++i) {
+      std::uint64_t v = model_field(s, i, nbits);
+      if (Sfit && nbits != 0 && nbits < 64 && (v >> (nbits - 1)) != 0) {
+        v |= ~std::uint64_t(0) << nbits;
+      }
+      e[i] = model_conv<Mode, T>(W(v), e_ovf);
+    }
+    std::vector<T> r(n);
+    bool r_ovf = false;
+    bool excepted = false;
+    try {
+      r_ovf = Sfit ? sia80::bitunpack_s<Mode>(r.data(), s.data(), n, nbits) :
+          sia80::bitunpack_u<Mode>(r.data(), s.data(), n, nbits);
+    }
+    catch (std::range_error&) {
+      excepted = true;
+    }
+    if (Mode == mode::cx) {
+      if (excepted != e_ovf) {
+        fail<T>(label, "unpack cx exception", n, nbits, 0);
+      }
+      if (excepted) {
+        return;
+      }
+    }
+    else if (r_ovf != e_ovf) {
+      fail<T>(label, "unpack overflowed", n, nbits, 0);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      if (r[i] != e[i]) {
+        fail<T>(label, "unpacked value", n, nbits, i);
+      }
+    }
+  }
+
+  // Values of up to nbits (as signed for sfit of signed T), or of
+  // any bits.
+  template <typename T>
+  std::vector<T> make_input(std::size_t n, unsigned nbits, bool any, bool sgn, std::uint64_t seed)
+  {
+    std::vector<T> v(n);
+    rng r { seed };
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t x = r.next();
+      const unsigned k = any ? unsigned(x >> 58) + 1 : nbits;
+      const std::uint64_t y = x ^ (x << 29);
+      v[i] = k == 0 ? T(0) : T(k >= 64 ? y : ((x >> 63) && sgn ?
+          std::uint64_t(std::int64_t(y << (64 - k)) >> (64 - k)) : y >> (64 - k)));
+    }
+    return v;
+  }
+
+  template <mode Mode, bool Sfit, typename T>
+  void check_mode(const char *label)
+  {
+    for (unsigned nbits = 0; nbits <= 64; ++nbits) {
+      // Fitting: the signed field needs a bit more.
+      const unsigned fb = Sfit && !std::is_signed<T>::value ? nbits - (nbits != 0) : nbits;
+      constexpr bool sgn = Sfit && std::is_signed<T>::value;
+      const std::size_t sizes[] = { 0, 1, 2, 3, 31, 63, 64, 65, 127, 129, 257, 1000 };
+      for (std::size_t n : sizes) {
+        check_pack<Mode, Sfit>(label, make_input<T>(n, fb, false, sgn, n + nbits), nbits);
+        const std::vector<T> any = make_input<T>(n, 0, true, true, 3 * n + nbits);
+        check_pack<Mode, Sfit>(label, any, nbits);
+        // Streams of any bits.
+        std::vector<std::uint64_t> s(sia80::bitpack_words(n, nbits));
+        for (std::size_t k = 0; k < s.size(); ++k) {
+          s[k] = std::uint64_t(any[k % (n ? n : 1)]) * 0x9E3779B97F4A7C15ull + k;
+        }
+        if (!s.empty()) {
+          // As the packer leaves them.
+          const unsigned tail = unsigned(n * nbits % 64);
+          if (tail != 0) {
+            s.back() &= (std::uint64_t(1) << tail) - 1;
+          }
+        }
+        check_unpack<Mode, Sfit, T>(label, s, n, nbits);
+      }
+      // All in range but one: in the first, the last, an unrolled
+      // and a single vector of the widest kernel, and the tail.
+      if (nbits < 64) {
+        std::vector<T> v = make_input<T>(200, fb, false, sgn, 5 + nbits);
+        for (std::size_t k : { 0, 1, 62, 63, 64, 65, 127, 128, 129, 191, 192, 199 }) {
+          const T keep = v[k];
+          v[k] = T(std::uint64_t(1) << nbits);
+          check_pack<Mode, Sfit>(label, v, nbits);
+          v[k] = std::numeric_limits<T>::min();
+          check_pack<Mode, Sfit>(label, v, nbits);
+          v[k] = keep;
+        }
+      }
+    }
+  }
+
+  template <typename T>
+  void check_type(const char *label)
+  {
+    check_mode<mode::cx, false, T>(label);
+    check_mode<mode::cf, false, T>(label);
+    check_mode<mode::tr, false, T>(label);
+    check_mode<mode::sr, false, T>(label);
+    check_mode<mode::cx, true, T>(label);
+    check_mode<mode::cf, true, T>(label);
+    check_mode<mode::tr, true, T>(label);
+    check_mode<mode::sr, true, T>(label);
+  }
+
+  void check_round_trip()
+  {
+    std::int16_t src[5] = { -3, 7, -8, 0, 5 };
+    std::uint64_t buf[1] = { 0 };
+    ASSERT_ALWAYS(!sia80::bitpack_sfit(buf, src, 5, 4));
+    ASSERT_ALWAYS(buf[0] == 0x5087Dull);
+    std::int16_t dst[5];
+    ASSERT_ALWAYS(!sia80::bitunpack_s(dst, buf, 5, 4));
+    for (int i = 0; i < 5; ++i) {
+      ASSERT_ALWAYS(dst[i] == src[i]);
+    }
+    bool excepted = false;
+    try {
+      sia80::bitpack_ufit(buf, src, 5, 65);
+    }
+    catch (std::invalid_argument&) {
+      excepted = true;
+    }
+    ASSERT_ALWAYS(excepted);
+  }
+
+} // namespace
+
+void test_bitpack()
+{
+  check_round_trip();
+  check_type<std::int8_t>("int8_t");
+  check_type<std::uint8_t>("uint8_t");
+  check_type<std::int16_t>("int16_t");
+  check_type<std::uint16_t>("uint16_t");
+  check_type<std::int32_t>("int32_t");
+  check_type<std::uint32_t>("uint32_t");
+  check_type<std::int64_t>("int64_t");
+  check_type<std::uint64_t>("uint64_t");
+}
@@ -0,0 +1,210 @@
+#include "test_common.hxx"
+#include <safe_int_bounded_80.hxx>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+
+// bounded: result types and ranges at compile time, and all values
+// of the operand ranges against the exact results (in __int128), for
+// ranges which fit the result type (tr_xxx) and which don't (cx_xxx
+// must throw and sr_xxx saturate exactly when the exact result is out
+// of the result type).
+
+using sia80::bounded;
+using sia80::bconst;
+using sia80::mode;
+using i128 = __int128;
+
+using pct = bounded<int, 0, 100>;
+using byte = bounded<unsigned, 0, 255>;
+
+static_assert(std::is_same<decltype(pct(1) * pct(1)), bounded<int, 0, 10000>>::value);
+static_assert(std::is_same<decltype(byte(1) * pct(1) / bconst<100>),
+    bounded<unsigned, 0, 255>>::value);
+static_assert(std::is_same<decltype(-pct(1)), bounded<int, -100, 0>>::value);
+static_assert(std::is_same<decltype(bounded<std::int8_t, -128, 127>(1) - bounded<std::int8_t, -128, 127>(1)),
+    bounded<int, -255, 255>>::value);
+static_assert(std::is_same<decltype(byte(1) << bounded<int, 0, 20>(1)),
+    bounded<unsigned, 0, 255u << 20>>::value);
+// Fallbacks: clamped to the result type.
+static_assert(std::is_same<decltype(byte(1) << bounded<int, 0, 31>(1)),
+    bounded<unsigned, 0, ~0u>>::value);
+static_assert(std::is_same<decltype(byte(1) - byte(1)), bounded<unsigned, 0, 255>>::value);
+static_assert(std::is_same<decltype(pct(1) / bounded<int, -1, 1>(1)),
+    bounded<int, INT_MIN, INT_MAX>>::value);
+static_assert((byte(200) * pct(50) / bconst<100>).value() == 100);
+static_assert(std::is_same<decltype(bounded<int, -3, -1>(-3) / bounded<unsigned, 5, 5>(5)),
+    bounded<unsigned, (0u - 3u) / 5u, (0u - 1u) / 5u>>::value);
+static_assert((bounded<int, -10, 10>(-10) / bounded<unsigned, 1, 3>(1)).value() == 0u - 10u);
+static_assert(pct(3) < byte(4) && bounded<int, -5, 5>(-1) < byte(0));
+// Implicit from a narrower range.
+static_assert(bounded<long, -1000, 1000>(pct(7)).value() == 7);
+static_assert(!std::is_convertible<bounded<int, 0, 101>, pct>::value);
+
+static void report(const char *label, long long a, long long b,
+    long long got, long long expected)
+{
+  std::cerr << "test_bounded: " << label << ": mismatch for: a=" << a
+          << "; b=" << b << "; result=" << got
+          << ", expected " << expected << "\n";
+  throw std::runtime_error("Assertion failed: bounded mismatch");
+}
+
+enum class bop { add, sub, mul, div, shl };
+
+template <bop Op, class A, class B>
+static auto apply(A a, B b)
+{
+  if constexpr(Op == bop::add) { return a + b; }
+  else if constexpr(Op == bop::sub) { return a - b; }
+  else if constexpr(Op == bop::mul) { return a * b; }
+  else if constexpr(Op == bop::div) { return a / b; }
+  else { return a << b; }
+}
+
+// Exact result; ok == false if it is not defined (division by 0,
+// a bad shift count).
+template <bop Op, class TR>
+static i128 exact(i128 a, i128 b, bool& ok)
+{
+  ok = true;
+  switch (Op) {
+  case bop::add: return a + b;
+  case bop::sub: return a - b;
+  case bop::mul: return a * b;
+  case bop::div:
+    // On the operands converted to TR, as C++ divides.
+    a = i128(TR(a));
+    b = i128(TR(b));
+    ok = b != 0;
+    return ok ? a / b : 0;
+  default:
+    ok = b >= 0 && b < std::numeric_limits<TR>::digits;
+    return ok ? a * (i128(1) << b) : 0;
+  }
+}
+
+template <bop Op, class T1, T1 L1, T1 H1, class T2, T2 L2, T2 H2, mode M>
+static void check_op()
+{
+  using A = bounded<T1, L1, H1, M>;
+  using B = bounded<T2, L2, H2, M>;
+  using R = decltype(apply<Op>(A(), B()));
+  using TR = typename R::value_type;
+  static_assert(std::is_same<TR, decltype(T1() + T2())>::value ||
+      Op == bop::shl);
+  for (long long a = L1; a <= (long long) H1; ++a) {
+    for (long long b = L2; b <= (long long) H2; ++b) {
+      bool ok;
+      const i128 e = exact<Op, TR>(a, b, ok);
+      const bool in_tr = ok && e >= i128(std::numeric_limits<TR>::min()) &&
+          e <= i128(std::numeric_limits<TR>::max());
+      INPUT T1 ia = T1(a);
+      INPUT T2 ib = T2(b);
+      if constexpr(M == mode::cx) {
+        bool excepted = false;
+        TR got = 0;
+        try {
+          got = apply<Op>(A(T1(ia)), B(T2(ib))).value();
+        }
+        catch (std::overflow_error&) {
+          excepted = true;
+        }
+        catch (std::domain_error&) {
+          excepted = true;
+        }
+        catch (std::out_of_range&) {
+          excepted = true;
+        }
+        if (excepted == in_tr || (in_tr && i128(got) != e)) {
+          report("cx", a, b, (long long) got, (long long) e);
+        }
+      }
+      else {
+        const TR got = apply<Op>(A(T1(ia)), B(T2(ib))).value();
+        // Bad divisors and counts: as sr_div and sr_shl.
+        const i128 sat = !ok ? i128(Op == bop::div ? sia80::sr_div(T1(a), T2(b)) :
+            sia80::sr_shl(T1(a), T2(b))) :
+            e < i128(std::numeric_limits<TR>::min()) ? i128(std::numeric_limits<TR>::min()) :
+            e > i128(std::numeric_limits<TR>::max()) ? i128(std::numeric_limits<TR>::max()) : e;
+        if (i128(got) != sat) {
+          report("sr", a, b, (long long) got, (long long) sat);
+        }
+      }
+      // The result is within the range of its type.
+      if (in_tr && (e < i128(R::lo) || e > i128(R::hi))) {
+        report("range", a, b, (long long) e, (long long) R::hi);
+      }
+    }
+  }
+}
+
+template <mode M>
+static void check_mode()
+{
+  // Fit the result type: tr_xxx.
+  check_op<bop::add, std::int8_t, -128, 127, std::int8_t, -128, 127, M>();
+  check_op<bop::mul, int, -100, 100, unsigned char, 0, 255, M>();
+  check_op<bop::mul, int, -100, 50, int, -7, 3, M>();
+  check_op<bop::div, int, -300, 300, int, 1, 7, M>();
+  check_op<bop::div, int, -300, 300, int, -7, -1, M>();
+  check_op<bop::shl, int, -20, 20, int, 0, 25, M>();
+  // Mixed signs: division on the operands converted to unsigned.
+  check_op<bop::div, int, -10, 10, unsigned, 1, 3, M>();
+  check_op<bop::div, int, -3, -1, unsigned, 5, 5, M>();
+  check_op<bop::div, unsigned, 0, 300, int, -2, -1, M>();
+  check_op<bop::div, int, -300, 300, unsigned char, 1, 7, M>();
+  // Don't fit: the fallbacks, near the limits of the result type.
+  check_op<bop::add, int, INT_MAX - 40, INT_MAX, int, 0, 50, M>();
+  check_op<bop::sub, int, INT_MIN, INT_MIN + 30, int, -5, 40, M>();
+  check_op<bop::sub, unsigned, 0, 20, unsigned, 0, 30, M>();
+  check_op<bop::mul, std::int64_t, INT64_MAX / 7 - 20, INT64_MAX / 7 + 20, int, -8, 8, M>();
+  check_op<bop::mul, std::uint64_t, UINT64_MAX / 5 - 10, UINT64_MAX / 5 + 10, unsigned, 0, 6, M>();
+  check_op<bop::div, int, INT_MIN, INT_MIN + 3, int, -3, 3, M>();
+  check_op<bop::shl, int, -300, 300, int, 20, 31, M>();
+  check_op<bop::shl, int, 0, 0, int, 0, 31, M>();
+  check_op<bop::shl, std::uint64_t, 0, 300, int, 50, 64, M>();
+}
+
+void test_bounded()
+{
+  check_mode<mode::cx>();
+  check_mode<mode::sr>();
+  // Construction from plain values.
+  INPUT int v = 101;
+  bool excepted = false;
+  try {
+    pct p(v);
+  }
+  catch (std::range_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  INPUT long long lv = -1;
+  excepted = false;
+  try {
+    byte p(lv);
+  }
+  catch (std::range_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  ASSERT_ALWAYS((bounded<int, 0, 100, mode::sr>(v).value() == 100));
+  ASSERT_ALWAYS((bounded<unsigned, 5, 255, mode::sr>(lv).value() == 5));
+  ASSERT_ALWAYS((bounded<std::uint64_t, 0, UINT64_MAX>(UINT64_MAX).value() == UINT64_MAX));
+  // Unary minus.
+  for (int x = -128; x <= 127; ++x) {
+    INPUT int ix = x;
+    const auto n = -bounded<std::int8_t, -128, 127>(ix);
+    ASSERT_ALWAYS(n.value() == -x);
+  }
+  excepted = false;
+  try {
+    -bounded<int, INT_MIN, 0>(INT_MIN + int(v) - 101);
+  }
+  catch (std::overflow_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  ASSERT_ALWAYS((-bounded<int, INT_MIN, 0, mode::sr>(INT_MIN + int(v) - 101)).value() == INT_MAX);
+}
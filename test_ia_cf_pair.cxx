@@ -0,0 +1,106 @@
+#include "test_common.hxx"
+#include <iostream>
+
+// Pair-returning cf_xxx shall give the same value and flag
+// as the versions with the flag pointer.
+
+template <class R, class T>
+static void want_same(R pair_result, T flag_value, int flag,
+        const char *exc_label, long long arg1, long long arg2)
+{
+  if (pair_result.value != flag_value || pair_result.overflowed != (flag != 0)) {
+    std::cerr << "test_cf_pair: " << exc_label
+            << ": mismatch for: arg1=" << arg1
+            << "; arg2=" << arg2
+            << "; value=" << (pair_result.value+0) << "/" << (flag_value+0)
+            << "; flag=" << pair_result.overflowed << "/" << flag
+            << "\n";
+    throw std::runtime_error("Assertion failed: cf pair mismatch");
+  }
+}
+
+#define CHECK_BINARY(op, a, b) \
+  do { \
+    int flag = 0; \
+    auto fv = sia80::op(a, b, &flag); \
+    want_same(sia80::op(a, b), fv, flag, #op, a, b); \
+  } while(0)
+
+template <class T>
+static void check_type()
+{
+  const T values[] = {
+    T(0), T(1), T(2), T(3), T(-1), T(-2), T(100),
+    std::numeric_limits<T>::max(), std::numeric_limits<T>::min(),
+    T(std::numeric_limits<T>::max() / 2 + 1),
+  };
+  const int shifts[] = { -1, 0, 1, 7, 30, 31, 32, 63, 64, 100 };
+  for (T v1 : values) {
+    INPUT T a = v1;
+    for (T v2 : values) {
+      INPUT T b = v2;
+      CHECK_BINARY(cf_add, a, b);
+      CHECK_BINARY(cf_sub, a, b);
+      CHECK_BINARY(cf_mul, a, b);
+      CHECK_BINARY(cf_div, a, b);
+      CHECK_BINARY(cf_rem, a, b);
+    }
+    for (int sh : shifts) {
+      INPUT int b = sh;
+      CHECK_BINARY(cf_shl, a, b);
+      CHECK_BINARY(cf_shr, a, b);
+    }
+    for (unsigned nbits = 0; nbits <= 70; ++nbits) {
+      int flag = 0;
+      T fv = sia80::cf_ufit(T(a), nbits, &flag);
+      want_same(sia80::cf_ufit(T(a), nbits), fv, flag, "cf_ufit", a, nbits);
+    }
+    {
+      int flag = 0;
+      signed char fv = sia80::cf_conv<signed char>(a, &flag);
+      want_same(sia80::cf_conv<signed char>(a), fv, flag, "cf_conv", a, 0);
+    }
+  }
+}
+
+static void test_overflow_sticky()
+{
+  constexpr int imax = std::numeric_limits<int>::max();
+  sia80::overflow_sticky ovf;
+  INPUT int a = 1000, b = 1000;
+  int x = ovf.add(ovf.mul(a, b), 1);
+  ASSERT_ALWAYS(x == 1000001);
+  ASSERT_ALWAYS(!ovf);
+  // Once set, the flag stays.
+  INPUT int c = imax;
+  int y = ovf.add(c, 1);
+  ASSERT_ALWAYS(y == std::numeric_limits<int>::min());
+  ASSERT_ALWAYS(ovf);
+  ASSERT_ALWAYS(ovf.sub(x, 1) == 1000000);
+  ASSERT_ALWAYS(ovf.overflowed());
+  ovf.reset();
+  ASSERT_ALWAYS(!ovf);
+  ASSERT_ALWAYS(ovf.conv<unsigned char>(a) == (unsigned char) 1000);
+  ASSERT_ALWAYS(ovf);
+  ovf.reset();
+  ASSERT_ALWAYS(ovf.div(a, 0) == ~0);
+  ASSERT_ALWAYS(ovf);
+  ovf.reset();
+  ASSERT_ALWAYS(ovf.take(sia80::cf_ufit(a, 10)) == 1000);
+  ASSERT_ALWAYS(ovf.shl(a, 3) == 8000);
+  ASSERT_ALWAYS(ovf.shr(a, 3) == 125);
+  ASSERT_ALWAYS(ovf.rem(a, 7) == 6);
+  ASSERT_ALWAYS(!ovf);
+  ASSERT_ALWAYS(ovf.ufit(a, 9) == 1000 - 512);
+  ASSERT_ALWAYS(ovf);
+}
+
+void test_cf_pair()
+{
+  check_type<int>();
+  check_type<unsigned>();
+  check_type<long>();
+  check_type<unsigned long>();
+  check_type<short>();
+  test_overflow_sticky();
+}
@@ -0,0 +1,116 @@
+#include "test_common.hxx"
+#include <climits>
+#include <cstdint>
+
+// All functions shall be usable in constant expressions,
+// and a cx_xxx error shall make the expression non-constant.
+
+static_assert(sia80::cx_add(INT_MAX - 1, 1) == INT_MAX);
+static_assert(sia80::cx_sub(INT_MIN + 1, 1) == INT_MIN);
+static_assert(sia80::cx_mul(4096, 4096) == 1 << 24);
+static_assert(sia80::cx_div(-7, 2) == -3);
+static_assert(sia80::cx_rem(-7, 2) == -1);
+static_assert(sia80::cx_shl(1, 30) == 1 << 30);
+static_assert(sia80::cx_shl(-2, 30) == INT_MIN);
+static_assert(sia80::cx_shl(std::uint64_t(1), 63) == std::uint64_t(1) << 63);
+static_assert(sia80::cx_shr(-16, 2) == -4);
+static_assert(sia80::cx_conv<std::uint8_t>(255) == 255);
+static_assert(sia80::cx_ufit(255, 8) == 255);
+static_assert(sia80::cx_sfit(-128, 8) == -128);
+static_assert(sia80::cx_sfit(127u, 8) == 127u);
+
+static_assert(sia80::tr_add(INT_MAX, 1) == INT_MIN);
+static_assert(sia80::tr_sub(0u, 1u) == UINT_MAX);
+static_assert(sia80::tr_mul(0x10000, 0x10000) == 0);
+static_assert(sia80::tr_div(INT_MIN, -1) == INT_MIN);
+static_assert(sia80::tr_div(5, 0) == -1);
+static_assert(sia80::tr_rem(INT_MIN, -1) == 0);
+static_assert(sia80::tr_shl(0x7777777, 5) == -0x11111120);
+static_assert(sia80::tr_shl(1, 100) == 0);
+static_assert(sia80::tr_shr(-1, 100) == -1);
+static_assert(sia80::tr_conv<std::int8_t>(200) == -56);
+static_assert(sia80::tr_ufit(0x1ff, 8) == 0xff);
+static_assert(sia80::tr_sfit(0x1ff, 8) == -1);
+
+static_assert(sia80::sr_add(INT_MAX, 1) == INT_MAX);
+static_assert(sia80::sr_sub(0u, 1u) == 0u);
+static_assert(sia80::sr_mul(-0x10000, 0x10000) == INT_MIN);
+static_assert(sia80::sr_div(INT_MIN, -1) == INT_MAX);
+static_assert(sia80::sr_rem(7, 0) == 0);
+static_assert(sia80::sr_shl(-3, 31) == INT_MIN);
+static_assert(sia80::sr_shl(3, 30) == INT_MAX);
+static_assert(sia80::sr_shr(-8, 1) == -4);
+static_assert(sia80::sr_conv<std::uint8_t>(-5) == 0);
+static_assert(sia80::sr_conv<std::int8_t>(1000) == 127);
+static_assert(sia80::sr_ufit(1000, 8) == 255);
+static_assert(sia80::sr_sfit(-1000, 8) == -128);
+
+constexpr int cf_flag_of_mul(int a, int b)
+{
+  int flag = 0;
+  sia80::cf_mul(a, b, &flag);
+  return flag;
+}
+
+static_assert(cf_flag_of_mul(1000, 1000) == 0);
+static_assert(cf_flag_of_mul(100000, 100000) == 1);
+static_assert(sia80::cf_add(INT_MAX, 1).overflowed);
+static_assert(sia80::cf_add(INT_MAX, 1).value == INT_MIN);
+static_assert(!sia80::cf_shl(1, 4).overflowed);
+static_assert(sia80::cf_conv<std::uint16_t>(70000).overflowed);
+static_assert(sia80::cf_ufit(-1, 4).overflowed);
+static_assert(sia80::cf_sfit(15u, 4).overflowed);
+
+constexpr bool sticky_overflowed(int a, int b)
+{
+  sia80::overflow_sticky ovf;
+  ovf.add(ovf.mul(a, b), 1);
+  return ovf.overflowed();
+}
+
+static_assert(!sticky_overflowed(1000, 1000));
+static_assert(sticky_overflowed(46341, 46341));
+
+// Detection of a non-constant expression: it is a substitution
+// failure in the partial specialization.
+template <int A, int B, class = void>
+struct cx_mul_folds : std::false_type {};
+template <int A, int B>
+struct cx_mul_folds<A, B,
+    std::void_t<std::integral_constant<int, sia80::cx_mul(A, B)>>>
+  : std::true_type {};
+
+template <int A, int B, class = void>
+struct cx_shl_folds : std::false_type {};
+template <int A, int B>
+struct cx_shl_folds<A, B,
+    std::void_t<std::integral_constant<int, sia80::cx_shl(A, B)>>>
+  : std::true_type {};
+
+template <int A, int B, class = void>
+struct cx_div_folds : std::false_type {};
+template <int A, int B>
+struct cx_div_folds<A, B,
+    std::void_t<std::integral_constant<int, sia80::cx_div(A, B)>>>
+  : std::true_type {};
+
+static_assert(cx_mul_folds<46340, 46340>::value);
+static_assert(!cx_mul_folds<46341, 46341>::value);
+static_assert(cx_shl_folds<1, 30>::value);
+static_assert(!cx_shl_folds<1, 31>::value);
+static_assert(!cx_shl_folds<1, -1>::value);
+static_assert(cx_div_folds<INT_MIN, 1>::value);
+static_assert(!cx_div_folds<INT_MIN, -1>::value);
+static_assert(!cx_div_folds<1, 0>::value);
+
+void test_constexpr()
+{
+  // The same functions at run time.
+  INPUT int a = 46341;
+  int flag = 0;
+  ASSERT_ALWAYS(sia80::cf_mul(a, a, &flag) == sia80::tr_mul(46341, 46341));
+  ASSERT_ALWAYS(flag == 1);
+  ASSERT_ALWAYS(sticky_overflowed(a, a));
+  INPUT int sh = 31;
+  ASSERT_ALWAYS(sia80::cf_shl(1, sh).overflowed);
+}
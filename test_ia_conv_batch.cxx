@@ -0,0 +1,114 @@
+#include "test_common.hxx"
+#include <safe_int_batch_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// sr_conv_n and cf_conv_n shall match sr_conv and cf_conv element by
+// element, for all pairs of 8..64 bit types (the narrowing ones are
+// vectorized, the rest are not). Inputs are the bounds of both types
+// and their neighbours among pseudo-random values; for the first
+// failure, one value out of range at each position of an array.
+
+template <class To, class From>
+static std::vector<From> make_input(std::size_t n, std::uint64_t seed)
+{
+  // Wrapping, in the width of From.
+  auto near = [](To v, int d) { return From(std::uint64_t(From(v)) + std::uint64_t(d)); };
+  const From edges[] = {
+    From(0), From(1), From(-1), From(-2),
+    std::numeric_limits<From>::max(), std::numeric_limits<From>::min(),
+    near(std::numeric_limits<To>::max(), 0), near(std::numeric_limits<To>::max(), 1),
+    near(std::numeric_limits<To>::max(), -1),
+    near(std::numeric_limits<To>::min(), 0), near(std::numeric_limits<To>::min(), -1),
+  };
+  constexpr std::size_t nedges = sizeof(edges) / sizeof(edges[0]);
+  std::vector<From> v(n);
+  rng r { seed };
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint64_t x = r.next();
+    if ((x >> 60) < 4) {
+      v[i] = edges[(x >> 32) % nedges];
+    }
+    else {
+      // Mostly in the range of To, as in real buffers.
+      const unsigned bits = (x >> 59) & 1 ? 64 : sizeof(To) * 8 - 1;
+      v[i] = From(std::int64_t(x << 5) >> (64 - bits));
+    }
+  }
+  return v;
+}
+
+template <class To, class From>
+static void check_one(const char *label, const std::vector<From>& src)
+{
+  const std::size_t n = src.size();
+  std::vector<To> r_sr(n), r_cf(n);
+  sia80::sr_conv_n(r_sr.data(), src.data(), n);
+  const std::size_t first = sia80::cf_conv_n(r_cf.data(), src.data(), n);
+  std::size_t e_first = n;
+  for (std::size_t i = 0; i < n; ++i) {
+    INPUT From x = src[i];
+    const To e_sr = sia80::sr_conv<To>(From(x));
+    const sia80::cf_result<To> e_cf = sia80::cf_conv<To>(From(x));
+    if (e_cf.overflowed && e_first == n) {
+      e_first = i;
+    }
+    if (r_sr[i] != e_sr || r_cf[i] != e_cf.value) {
+      std::cerr << "test_conv_batch: " << label << ": mismatch: n=" << n
+              << "; i=" << i << "; x=" << (long long) src[i]
+              << "; sr=" << (long long) r_sr[i] << "/" << (long long) e_sr
+              << "; cf=" << (long long) r_cf[i] << "/" << (long long) e_cf.value
+              << "\n";
+      throw std::runtime_error("Assertion failed: conv batch mismatch");
+    }
+  }
+  if (first != e_first) {
+    std::cerr << "test_conv_batch: " << label << ": first failure: n=" << n
+            << "; got " << first << ", expected " << e_first << "\n";
+    throw std::runtime_error("Assertion failed: conv batch mismatch");
+  }
+}
+
+template <class To, class From>
+static void check_pair(const char *label)
+{
+  for (std::size_t n = 0; n <= 140; ++n) {
+    check_one<To>(label, make_input<To, From>(n, 1 + n));
+  }
+  check_one<To>(label, make_input<To, From>(10007, 77));
+  // All in range but one (at each position of 3 vectors and a tail),
+  // then the lower bound of To there.
+  for (std::size_t k = 0; k < 200; ++k) {
+    std::vector<From> v(200, From(std::numeric_limits<To>::max() / 2));
+    v[k] = std::numeric_limits<From>::max();
+    check_one<To>(label, v);
+    v[k] = From(std::numeric_limits<To>::min());
+    check_one<To>(label, v);
+  }
+}
+
+template <class From>
+static void check_from(const char *label)
+{
+  check_pair<std::int8_t, From>(label);
+  check_pair<std::uint8_t, From>(label);
+  check_pair<std::int16_t, From>(label);
+  check_pair<std::uint16_t, From>(label);
+  check_pair<std::int32_t, From>(label);
+  check_pair<std::uint32_t, From>(label);
+  check_pair<std::int64_t, From>(label);
+  check_pair<std::uint64_t, From>(label);
+}
+
+void test_conv_batch()
+{
+  check_from<std::int8_t>("conv batch from int8_t");
+  check_from<std::uint8_t>("conv batch from uint8_t");
+  check_from<std::int16_t>("conv batch from int16_t");
+  check_from<std::uint16_t>("conv batch from uint16_t");
+  check_from<std::int32_t>("conv batch from int32_t");
+  check_from<std::uint32_t>("conv batch from uint32_t");
+  check_from<std::int64_t>("conv batch from int64_t");
+  check_from<std::uint64_t>("conv batch from uint64_t");
+}
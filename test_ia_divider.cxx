@@ -0,0 +1,237 @@
+#include "test_common.hxx"
+#include <safe_int_div_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// divider<T, Mode> shall give the same results and errors
+// as the scalar xx_div and xx_rem.
+
+static_assert(sia80::divider<int, sia80::mode::cx>(7).div(-50) == -7);
+static_assert(sia80::divider<unsigned, sia80::mode::sr>(10).rem(1234) == 4);
+
+template <class T>
+static void report(const char *label, T ddnd, T dvsr)
+{
+  std::cerr << "test_divider: " << label
+          << ": mismatch for: ddnd=" << (ddnd+0)
+          << "; dvsr=" << (dvsr+0)
+          << "\n";
+  throw std::runtime_error("Assertion failed: divider mismatch");
+}
+
+// Outcome of a cx_ call: the value or the exception type.
+struct cx_outcome {
+  long long value;
+  int exc; // 0 - none, 1 - domain_error, 2 - overflow_error
+  bool operator!=(const cx_outcome& o) const
+  {
+    return exc != o.exc || (exc == 0 && value != o.value);
+  }
+};
+
+template <class F>
+static cx_outcome cx_call(F f)
+{
+  try {
+    return { (long long) f(), 0 };
+  }
+  catch (std::domain_error&) {
+    return { 0, 1 };
+  }
+  catch (std::overflow_error&) {
+    return { 0, 2 };
+  }
+}
+
+template <class T>
+static void check_one(T dvsr, T ddnd)
+{
+  using namespace sia80;
+  INPUT T a = ddnd;
+  // cx: the divisor 0 is rejected by the constructor.
+  if (dvsr == 0) {
+    bool excepted = false;
+    try {
+      divider<T, mode::cx> d(dvsr);
+    }
+    catch (std::domain_error&) {
+      excepted = true;
+    }
+    if (!excepted) {
+      report("cx divisor 0", ddnd, dvsr);
+    }
+  }
+  else {
+    divider<T, mode::cx> d(dvsr);
+    if (cx_call([&] { return d.div(a); }) != cx_call([&] { return cx_div(a, dvsr); })) {
+      report("cx_div", ddnd, dvsr);
+    }
+    if (cx_call([&] { return d.rem(a); }) != cx_call([&] { return cx_rem(a, dvsr); })) {
+      report("cx_rem", ddnd, dvsr);
+    }
+    cx_outcome q = cx_call([&] { return d.divrem(a).quot; });
+    cx_outcome r = cx_call([&] { return d.divrem(a).rem; });
+    if (q != cx_call([&] { return cx_div(a, dvsr); }) ||
+        r != cx_call([&] { return cx_rem(a, dvsr); }))
+    {
+      report("cx divrem", ddnd, dvsr);
+    }
+  }
+  {
+    divider<T, mode::cf> d(dvsr);
+    int f1 = 0, f2 = 0;
+    auto v1 = d.div(a, &f1);
+    auto v2 = cf_div(a, dvsr, &f2);
+    auto p = d.div(a);
+    if (v1 != v2 || f1 != f2 || p.value != v2 || p.overflowed != (f2 != 0)) {
+      report("cf_div", ddnd, dvsr);
+    }
+    f1 = f2 = 0;
+    v1 = d.rem(a, &f1);
+    v2 = cf_rem(a, dvsr, &f2);
+    p = d.rem(a);
+    if (v1 != v2 || f1 != f2 || p.value != v2 || p.overflowed != (f2 != 0)) {
+      report("cf_rem", ddnd, dvsr);
+    }
+    int f3 = 0;
+    auto qr = d.divrem(a, &f3);
+    if (qr.quot != cf_div(a, dvsr).value || qr.rem != v2 || f3 != f2) {
+      report("cf divrem", ddnd, dvsr);
+    }
+  }
+  {
+    divider<T, mode::tr> d(dvsr);
+    if (d.div(a) != tr_div(a, dvsr) || d.rem(a) != tr_rem(a, dvsr)) {
+      report("tr", ddnd, dvsr);
+    }
+  }
+  {
+    divider<T, mode::sr> d(dvsr);
+    auto qr = d.divrem(a);
+    if (d.div(a) != sr_div(a, dvsr) || d.rem(a) != sr_rem(a, dvsr) ||
+        qr.quot != sr_div(a, dvsr) || qr.rem != sr_rem(a, dvsr))
+    {
+      report("sr", ddnd, dvsr);
+    }
+  }
+}
+
+template <class T>
+static std::vector<T> interesting_values()
+{
+  constexpr T tmax = std::numeric_limits<T>::max();
+  constexpr T tmin = std::numeric_limits<T>::min();
+  std::vector<T> v = { T(0), T(1), T(2), T(3), T(5), T(6), T(7), T(10),
+      T(-1), T(-2), T(-3), T(-7), T(-10), T(100), T(641), T(-641),
+      tmax, T(tmax - 1), T(tmax / 2), T(tmax / 3), T(tmax / 2 + 1),
+      tmin, T(tmin + 1), T(tmin / 2), T(tmin / 3) };
+  // Powers of 2 and their neighbours.
+  for (unsigned sh = 1; sh < sizeof(T) * 8; ++sh) {
+    T p = T(T(1) << sh);
+    v.push_back(p);
+    v.push_back(T(p + 1));
+    v.push_back(T(p - 1));
+    v.push_back(T(-p));
+  }
+  // Pseudorandom of all magnitudes.
+  rng r { 1 };
+  for (int i = 0; i < 200; ++i) {
+    const std::uint64_t x = r.next();
+    v.push_back(T(x >> (i % 64)));
+  }
+  return v;
+}
+
+template <class T>
+static void check_type()
+{
+  const std::vector<T> values = interesting_values<T>();
+  for (T dvsr : values) {
+    for (T ddnd : values) {
+      check_one(dvsr, ddnd);
+    }
+  }
+}
+
+// Divisors with the low 32 bits zero use the 64-bit floor_log2.
+template <class T>
+static void check_wide_divisors()
+{
+  using namespace sia80;
+  constexpr unsigned nbits = sizeof(T) * 8 - std::is_signed<T>::value;
+  const T ddnds[] = { T(0), T(1), T(12345), std::numeric_limits<T>::max(),
+      std::numeric_limits<T>::min() };
+  for (unsigned k = 0; k < nbits; ++k) {
+    for (T dvsr : { T(T(1) << k), T((T(1) << k) + 1) }) {
+      divider<T, mode::sr> d(dvsr);
+      for (T ddnd : ddnds) {
+        ASSERT_ALWAYS(d.div(ddnd) == sr_div(ddnd, dvsr));
+        ASSERT_ALWAYS(d.rem(ddnd) == sr_rem(ddnd, dvsr));
+      }
+    }
+  }
+}
+
+template <class T>
+static void check_batch()
+{
+  using namespace sia80;
+  using R = typename divider<T, mode::sr>::result_type;
+  const std::vector<T> values = interesting_values<T>();
+  std::vector<R> q(values.size()), r(values.size());
+  for (T dvsr : values) {
+    divider<T, mode::sr> d(dvsr);
+    d.div_n(q.data(), values.data(), values.size());
+    d.rem_n(r.data(), values.data(), values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      if (q[i] != sr_div(values[i], dvsr) || r[i] != sr_rem(values[i], dvsr)) {
+        report("sr div_n/rem_n", values[i], dvsr);
+      }
+    }
+    divider<T, mode::cf> dcf(dvsr);
+    int flag = 0, eflag = 0;
+    dcf.div_n(q.data(), values.data(), values.size(), &flag);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      if (q[i] != cf_div(values[i], dvsr, &eflag)) {
+        report("cf div_n", values[i], dvsr);
+      }
+    }
+    ASSERT_ALWAYS(flag == eflag);
+  }
+  // cx: stops at MIN / -1 with the preceding elements done.
+  // (Not for narrower types: MIN / -1 fits into int.)
+  if constexpr(std::is_signed<T>::value && sizeof(T) >= sizeof(int)) {
+    const T src[] = { T(5), T(-7), std::numeric_limits<T>::min(), T(9) };
+    R dst[4] = { 0, 0, 0, 0 };
+    divider<T, mode::cx> d(T(-1));
+    bool excepted = false;
+    try {
+      d.div_n(dst, src, 4);
+    }
+    catch (std::overflow_error&) {
+      excepted = true;
+    }
+    ASSERT_ALWAYS(excepted);
+    ASSERT_ALWAYS(dst[0] == -5 && dst[1] == 7 && dst[3] == 0);
+  }
+}
+
+void test_divider()
+{
+  check_type<std::int8_t>();
+  check_type<std::uint8_t>();
+  check_type<std::int16_t>();
+  check_type<std::uint16_t>();
+  check_type<std::int32_t>();
+  check_type<std::uint32_t>();
+  check_type<std::int64_t>();
+  check_type<std::uint64_t>();
+  check_wide_divisors<std::int64_t>();
+  check_wide_divisors<std::uint64_t>();
+  check_batch<std::int8_t>();
+  check_batch<std::int32_t>();
+  check_batch<std::uint32_t>();
+  check_batch<std::int64_t>();
+  check_batch<std::uint64_t>();
+}
@@ -0,0 +1,13 @@
+#include <safe_int_div_80.hxx>
+#include <type_traits>
+
+// Built with -std=gnu++17 (see Makefile): there, std::is_integral
+// is true for __int128, but divider<> shall still refuse it.
+
+#if defined(__SIZEOF_INT128__)
+#if !defined(__STRICT_ANSI__)
+static_assert(std::is_integral<__int128>::value);
+#endif
+static_assert(!sia80::div_detail::divider_type<__int128>);
+static_assert(!sia80::div_detail::divider_type<unsigned __int128>);
+#endif
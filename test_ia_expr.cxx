@@ -0,0 +1,237 @@
+#include "test_common.hxx"
+#include <safe_int_expr_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// xx_eval against the exact value of the formula computed in __int128:
+// cx_eval throws iff it doesn't fit the result type, cf_eval gives
+// the flag and the truncated value, tr_eval and sr_eval are
+// tr_conv and sr_conv of it. Division by 0 is as of xx_div. Formulas
+// of each wide type (int64, __int128), with xc<> constants and bounded
+// operands, and the fallback, against the steps done by hand.
+
+namespace {
+
+  using W = __int128;
+
+  // The reference: exact in W; ovf if it doesn't fit there, to skip
+  // those (they are in check_fallback).
+  struct R {
+    W v;
+    bool ovf;
+
+    R(W x, bool o = false) : v(x), ovf(o) {}
+  };
+
+#define TEST_R_OP(oper, builtin) \
+  R operator oper(R a, R b) \
+  { \
+    W r = 0; \
+    const bool ovf = builtin(a.v, b.v, &r); \
+    return { r, a.ovf || b.ovf || ovf }; \
+  }
+
+  TEST_R_OP(+, __builtin_add_overflow)
+  TEST_R_OP(-, __builtin_sub_overflow)
+  TEST_R_OP(*, __builtin_mul_overflow)
+
+#undef TEST_R_OP
+
+  R operator/(R a, R b) { return { b.v == 0 ? a.v : a.v / b.v, a.ovf || b.ovf }; }
+  R operator-(R a) { return R(0) - a; }
+
+  template <typename T>
+  [[noreturn]] void fail(const char *label, const char *what, W ref)
+  {
+    std::cerr << "test_expr: " << label << ": " << what << ": ref="
+            << (long long) (ref >> 64) << ":" << (unsigned long long) ref << "\n";
+    throw std::runtime_error("Assertion failed: xx_eval mismatch");
+  }
+
+  // ref: the exact value; div0: a division by 0, with the dividend
+  // of the sign of ref.
+  template <typename T, typename E>
+  void check(const char *label, const E& e, R rref, bool div0 = false)
+  {
+    if (rref.ovf) {
+      if (sia80::xp_width<E> != 0) {
+        fail<T>(label, "not a fallback", 0);
+      }
+      return;
+    }
+    const W ref = rref.v;
+    const bool fits = !div0 && ref >= W(sia80::ia_limits<T>::min()) &&
+        ref <= W(sia80::ia_limits<T>::max());
+    bool excepted = false;
+    bool domain = false;
+    try {
+      if (sia80::cx_eval<T>(e) != T(ref)) {
+        fail<T>(label, "cx_eval value", ref);
+      }
+    }
+    catch (std::range_error&) {
+      excepted = true;
+    }
+    catch (std::domain_error&) {
+      excepted = domain = true;
+    }
+    if (excepted == fits || domain != div0) {
+      fail<T>(label, "cx_eval exception", ref);
+    }
+    const T e_tr = div0 ? T(~T(0)) : sia80::tr_conv<T>(ref);
+    const T e_sr = div0 ? (ref < 0 ? sia80::ia_limits<T>::min() : sia80::ia_limits<T>::max()) :
+        sia80::sr_conv<T>(ref);
+    const sia80::cf_result<T> r = sia80::cf_eval<T>(e);
+    int flag = 0;
+    const T rf = sia80::cf_eval<T>(e, &flag);
+    if (r.value != e_tr || r.overflowed == fits || rf != e_tr || flag != !fits) {
+      fail<T>(label, "cf_eval", ref);
+    }
+    if (sia80::tr_eval<T>(e) != e_tr) {
+      fail<T>(label, "tr_eval", ref);
+    }
+    if (sia80::sr_eval<T>(e) != e_sr) {
+      fail<T>(label, "sr_eval", ref);
+    }
+  }
+
+  template <typename T>
+  std::vector<T> values()
+  {
+    using L = sia80::ia_limits<T>;
+    std::vector<T> v = { T(0), T(1), T(-1), T(2), T(100), T(-100),
+        L::max(), L::min(), T(L::max() - 1), T(L::min() + 1), T(L::max() / 2) };
+    rng r { 99 };
+    for (int i = 0; i < 6; ++i) {
+      const std::uint64_t x = r.next();
+      v.push_back(T(x >> (x >> 60)));
+    }
+    return v;
+  }
+
+  // Four operands of A, the result in T.
+  template <typename A, typename T>
+  void check_formulas(const char *label)
+  {
+    using sia80::xv;
+    using sia80::xc;
+    const std::vector<A> vs = values<A>();
+    for (A a : vs) {
+      for (A b : vs) {
+        INPUT A ia = a;
+        INPUT A ib = b;
+        const R ra = W(a), rb = W(b);
+        check<T>(label, xv(ia) * ib, ra * rb);
+        check<T>(label, xv(ia) * (xc<100> + xv(ib)) / xc<100>, ra * (R(100) + rb) / R(100));
+        check<T>(label, -xv(ia) / ib, -ra / rb, b == 0);
+        check<T>(label, xv(ia) * ia + xv(ib) * ib, ra * ra + rb * rb);
+        for (A c : { vs[3], vs[6], vs[7], vs[10] }) {
+          for (A d : vs) {
+            INPUT A ic = c;
+            INPUT A id = d;
+            const R rc = W(c), rd = W(d);
+            check<T>(label, xv(ia) * ib + xv(ic) * id, ra * rb + rc * rd);
+            check<T>(label, xv(ia) * ib - xv(ic) * id, ra * rb - rc * rd);
+            check<T>(label, (xv(ia) - ib) * (xv(ic) + id) / xc<7>,
+                (ra - rb) * (rc + rd) / R(7));
+          }
+        }
+      }
+    }
+  }
+
+  // Products of three int64 and of two uint64 don't fit __int128:
+  // the steps are checked there.
+  void check_fallback()
+  {
+    using sia80::xv;
+    const std::vector<std::int64_t> vs = values<std::int64_t>();
+    for (std::int64_t a : vs) {
+      for (std::int64_t b : vs) {
+        for (std::int64_t c : vs) {
+          INPUT std::int64_t ia = a, ib = b, ic = c;
+          const auto e = xv(ia) * ib * ic;
+          static_assert(sia80::xp_width<decltype(e)> == 0, "xp_width: fallback");
+          const R rref = R(a) * R(b) * R(c);
+          const W ref = rref.v;
+          if (!rref.ovf) {
+            check<std::int64_t>("fallback", e, rref);
+            continue;
+          }
+          bool excepted = false;
+          try {
+            sia80::cx_eval<std::int64_t>(e);
+          }
+          catch (std::overflow_error&) {
+            excepted = true;
+          }
+          const sia80::cf_result<std::int64_t> r = sia80::cf_eval<std::int64_t>(e);
+          ASSERT_ALWAYS(excepted);
+          ASSERT_ALWAYS(r.overflowed && r.value == std::int64_t(ref));
+          ASSERT_ALWAYS(sia80::tr_eval<std::int64_t>(e) == std::int64_t(ref));
+          ASSERT_ALWAYS(sia80::sr_eval<std::int64_t>(e) ==
+              (((a < 0) != (b < 0)) != (c < 0) ? INT64_MIN : INT64_MAX));
+        }
+      }
+    }
+    INPUT std::uint64_t u = UINT64_MAX;
+    const auto eu = xv(u) * u - xv(u);
+    static_assert(sia80::xp_width<decltype(eu)> == 0, "xp_width: fallback");
+    ASSERT_ALWAYS(sia80::sr_eval<std::uint64_t>(eu) == UINT64_MAX);
+    ASSERT_ALWAYS(sia80::cf_eval<std::uint64_t>(xv(u) - u + 1).value == 1);
+  }
+
+  void check_bounded()
+  {
+    using sia80::xv;
+    using byte = sia80::bounded<int, 0, 255>;
+    using pct = sia80::bounded<int, 0, 100>;
+    for (int v : { 0, 1, 254, 255 }) {
+      for (int p : { 0, 50, 100 }) {
+        const auto e = xv(byte(v)) * (sia80::xc<100> + xv(pct(p))) / sia80::xc<100>;
+        static_assert(sia80::xp_width<decltype(e)> == 64, "xp_width: bounded");
+        check<std::uint8_t>("bounded", e, R(W(v) * (100 + p) / 100));
+        // The divisor can't be 0.
+        using nz = sia80::bounded<int, 1, 100>;
+        check<std::int16_t>("bounded", xv(v) / xv(nz(p + 1 > 100 ? 100 : p + 1)),
+            R(W(v) / (p + 1 > 100 ? 100 : p + 1)));
+      }
+    }
+  }
+
+  // The wide types.
+  using i16 = std::int16_t;
+  using i32 = std::int32_t;
+  using u32 = std::uint32_t;
+  using i64 = std::int64_t;
+  using sia80::xv;
+  static_assert(sia80::xp_width<decltype(xv(i16()) * i16() + xv(i16()) * i16())> == 64, "");
+  static_assert(sia80::xp_width<decltype(xv(i32()) * i32() - xv(i32()) * i32())> == 64, "");
+  // (-2^31)^2 * 2 is 2^63.
+  static_assert(sia80::xp_width<decltype(xv(i32()) * i32() + xv(i32()) * i32())> == 128, "");
+  static_assert(sia80::xp_width<decltype(xv(u32()) * u32())> == 128, "");
+  static_assert(sia80::xp_width<decltype(xv(u32()) * i32())> == 64, "");
+  static_assert(sia80::xp_width<decltype(xv(i64()) * i64() - xv(i64()) * i64())> == 128, "");
+  static_assert(sia80::xp_width<decltype(xv(i64()) * i64() + xv(i64()) * i64())> == 0, "");
+  static_assert(sia80::xp_width<decltype(xv(i64()) * i64() * 2)> == 0, "");
+  // The intermediate doesn't fit int32; the result does.
+  static_assert(sia80::cx_eval<i32>(xv(1 << 30) * 3 / sia80::xc<4>) == 805306368, "");
+  static_assert(sia80::sr_eval<i16>(xv(300) * 300) == INT16_MAX, "");
+
+} // namespace
+
+void test_expr()
+{
+  check_formulas<std::int8_t, std::int8_t>("int8");
+  check_formulas<std::int16_t, std::int32_t>("int16");
+  check_formulas<std::int32_t, std::int32_t>("int32");
+  check_formulas<std::int32_t, std::int64_t>("int32 to int64");
+  check_formulas<std::int32_t, std::uint32_t>("int32 to uint32");
+  check_formulas<std::uint32_t, std::int32_t>("uint32");
+  check_formulas<std::int64_t, std::int64_t>("int64");
+  check_formulas<std::uint64_t, std::uint64_t>("uint64");
+  check_formulas<std::uint64_t, std::int64_t>("uint64 to int64");
+  check_fallback();
+  check_bounded();
+}
@@ -0,0 +1,146 @@
+#include "test_common.hxx"
+#include <cstdint>
+#include <iostream>
+
+// cf_, tr_ and sr_ of ufit and sfit for 8..64 bit types and widths
+// 0..70, against a reference computed in __int128 from the range of
+// the field: [0, 2^nbits) for ufit, [-2^(nbits-1), 2^(nbits-1)) for
+// sfit (empty for 0 bits). cx_ of both is in test_ia_cx_*fit_*.cxx.
+
+namespace {
+
+  using W = __int128;
+
+  struct field {
+    W lo;
+    W hi;
+    bool empty;
+  };
+
+  field ufield(unsigned nbits)
+  {
+    return { 0, (W(1) << (nbits < 100 ? nbits : 100)) - 1, false };
+  }
+
+  field sfield(unsigned nbits)
+  {
+    if (nbits == 0) {
+      return { 0, 0, true };
+    }
+    const W h = W(1) << (nbits - 1 < 100 ? nbits - 1 : 100);
+    return { -h, h - 1, false };
+  }
+
+  template <typename T>
+  void want(bool ok, const char *what, T x, unsigned nbits, const char *label)
+  {
+    if (!ok) {
+      std::cerr << "test_fit_modes: " << label << ": " << what
+              << ": x=" << (long long) x << "; nbits=" << nbits << "\n";
+      throw std::runtime_error("Assertion failed: fit mode mismatch");
+    }
+  }
+
+  template <typename T>
+  void check_one(T arg_x, unsigned arg_nbits, const char *label)
+  {
+    using sia80::ia_limits;
+    INPUT T x = arg_x;
+    INPUT unsigned nbits = arg_nbits;
+    constexpr unsigned digits = ia_limits<T>::digits;
+    const W wx = W(T(x));
+
+    // ufit: tr_ keeps the low nbits below the width of T.
+    {
+      const field f = ufield(nbits);
+      const bool fits = wx >= f.lo && wx <= f.hi;
+      const T e_tr = nbits >= digits ? T(x) : T(wx & f.hi);
+      const T e_sr = fits ? T(x) : wx < 0 ? T(0) : T(f.hi);
+      int flag = 0;
+      const T r_cf = sia80::cf_ufit(T(x), nbits, &flag);
+      const sia80::cf_result<T> r_cfp = sia80::cf_ufit(T(x), nbits);
+      want(sia80::tr_ufit(T(x), nbits) == e_tr, "tr_ufit", T(x), nbits, label);
+      want(sia80::sr_ufit(T(x), nbits) == e_sr, "sr_ufit", T(x), nbits, label);
+      want(r_cf == e_tr && flag == !fits, "cf_ufit", T(x), nbits, label);
+      want(r_cfp.value == e_tr && r_cfp.overflowed == !fits, "cf_ufit pair", T(x), nbits, label);
+    }
+
+    // sfit: tr_ sign-extends the low nbits.
+    {
+      const field f = sfield(nbits);
+      const bool fits = !f.empty && wx >= f.lo && wx <= f.hi;
+      T e_tr = T(x);
+      if (nbits == 0) {
+        e_tr = 0;
+      }
+      else if (nbits <= digits) {
+        const W m = (W(1) << nbits) - 1;
+        const W low = wx & m;
+        e_tr = T(low > f.hi ? low - m - 1 : low);
+      }
+      const T e_sr = f.empty ? T(0) : wx < f.lo ? T(f.lo) : wx > f.hi ? T(f.hi) : T(x);
+      int flag = 0;
+      const T r_cf = sia80::cf_sfit(T(x), nbits, &flag);
+      const sia80::cf_result<T> r_cfp = sia80::cf_sfit(T(x), nbits);
+      want(sia80::tr_sfit(T(x), nbits) == e_tr, "tr_sfit", T(x), nbits, label);
+      want(sia80::sr_sfit(T(x), nbits) == e_sr, "sr_sfit", T(x), nbits, label);
+      want(r_cf == e_tr && flag == !fits, "cf_sfit", T(x), nbits, label);
+      want(r_cfp.value == e_tr && r_cfp.overflowed == !fits, "cf_sfit pair", T(x), nbits, label);
+      bool excepted = false;
+      try {
+        want(sia80::cx_sfit(T(x), nbits) == T(x), "cx_sfit", T(x), nbits, label);
+      }
+      catch (std::range_error&) {
+        excepted = true;
+      }
+      want(excepted == !fits, "cx_sfit throws", T(x), nbits, label);
+    }
+  }
+
+  template <typename T>
+  void check_type(const char *label)
+  {
+    using L = sia80::ia_limits<T>;
+    for (unsigned nbits = 0; nbits <= 70; ++nbits) {
+      // Bounds of the field and their neighbours, bounds of T.
+      for (unsigned k = 0; k <= 64; ++k) {
+        const std::uint64_t p = k < 64 ? std::uint64_t(1) << k : 0;
+        const std::uint64_t near[] = { p, p - 1, p + 1, 0 - p, 0 - p - 1, 0 - p + 1 };
+        for (std::uint64_t v : near) {
+          check_one(T(v), nbits, label);
+        }
+      }
+      check_one(L::min(), nbits, label);
+      check_one(L::max(), nbits, label);
+      rng r { 7 + nbits };
+      for (int i = 0; i < 64; ++i) {
+        const std::uint64_t x = r.next();
+        check_one(T(std::int64_t(x) >> (x >> 58)), nbits, label);
+      }
+    }
+  }
+
+  void check_sticky()
+  {
+    sia80::overflow_sticky ovf;
+    INPUT int a = -100;
+    ASSERT_ALWAYS(ovf.sfit(a, 8) == -100);
+    ASSERT_ALWAYS(!ovf);
+    ASSERT_ALWAYS(ovf.sfit(a, 7) == 28);
+    ASSERT_ALWAYS(ovf);
+  }
+
+} // namespace
+
+void test_fit_modes()
+{
+  check_type<std::int8_t>("int8_t");
+  check_type<std::uint8_t>("uint8_t");
+  check_type<std::int16_t>("int16_t");
+  check_type<std::uint16_t>("uint16_t");
+  check_type<std::int32_t>("int32_t");
+  check_type<std::uint32_t>("uint32_t");
+  check_type<std::int64_t>("int64_t");
+  check_type<std::uint64_t>("uint64_t");
+  check_sticky();
+}
@@ -0,0 +1,342 @@
+#include "test_common.hxx"
+#include <safe_int_fixed_80.hxx>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// shr_round, xx_qmul and xx_qmul_n against a reference in __int128:
+// the exact value is rounded there and converted by the mode.
+// xx_shrx against the division by 2^n.
+
+using sia80::rounding;
+
+static_assert(sia80::shr_round<rounding::nearest>(-3, 1) == -1);
+static_assert(sia80::shr_round<rounding::even>(-3, 1) == -2);
+static_assert(sia80::shr_round<rounding::even>(5, 1) == 2);
+static_assert(sia80::shr_round<rounding::trunc>(-5, 1) == -2);
+static_assert(sia80::shr_round<rounding::ceil>(-5, 1) == -2);
+static_assert(sia80::shr_round<rounding::ceil>(5, 1) == 3);
+static_assert(sia80::cx_qmul<16>(3 << 16, 5 << 15) == 15 << 15);
+static_assert(sia80::cx_shrx(-96, 5) == -3);
+static_assert(sia80::tr_shrx(-97, 5) == -3);
+
+using i128 = __int128;
+
+static const char *rounding_name(rounding r)
+{
+  switch (r) {
+  case rounding::floor: return "floor";
+  case rounding::trunc: return "trunc";
+  case rounding::ceil: return "ceil";
+  case rounding::nearest: return "nearest";
+  default: return "even";
+  }
+}
+
+// v / 2^n rounded by r; n < 126.
+static i128 ref_round(i128 v, unsigned n, rounding r)
+{
+  const i128 d = i128(1) << n;
+  i128 q = v >= 0 ? v / d : -((-v + d - 1) / d); // floor
+  const i128 rem = v - q * d; // 0 <= rem < d
+  switch (r) {
+  case rounding::floor:
+    return q;
+  case rounding::trunc:
+    return q + (v < 0 && rem != 0);
+  case rounding::ceil:
+    return q + (rem != 0);
+  case rounding::nearest:
+    return q + (2 * rem >= d);
+  default:
+    return q + (2 * rem > d || (2 * rem == d && (q & 1) != 0));
+  }
+}
+
+// The same for non-negative values up to 2^128 - 1 (products of
+// uint64_t); trunc is floor there.
+static unsigned __int128 ref_round_u(unsigned __int128 v, unsigned n, rounding r)
+{
+  using u128 = unsigned __int128;
+  const u128 d = u128(1) << n;
+  const u128 q = v >> n;
+  const u128 rem = v & (d - 1);
+  switch (r) {
+  case rounding::floor:
+  case rounding::trunc:
+    return q;
+  case rounding::ceil:
+    return q + (rem != 0);
+  case rounding::nearest:
+    return q + (rem >= d - rem);
+  default:
+    return q + (rem > d - rem || (rem == d - rem && (q & 1) != 0));
+  }
+}
+
+static void report(const char *label, rounding r, long long a, long long b,
+    long long got, long long expected)
+{
+  std::cerr << "test_fixed: " << label << " (" << rounding_name(r)
+          << "): mismatch for: a=" << a << "; b=" << b
+          << "; result=" << got << ", expected " << expected
+          << "\n";
+  throw std::runtime_error("Assertion failed: fixed mismatch");
+}
+
+template <rounding R, class T>
+static void check_shr_round_type()
+{
+  for (long long v = (long long) std::numeric_limits<T>::min();
+      v <= (long long) std::numeric_limits<T>::max(); ++v)
+  {
+    for (unsigned n = 0; n <= 20; ++n) {
+      INPUT T iv = T(v);
+      T got = sia80::shr_round<R>(T(iv), n);
+      i128 expected = ref_round(v, n, R);
+      if (got != expected) {
+        report("shr_round", R, v, n, got, (long long) expected);
+      }
+    }
+  }
+}
+
+template <rounding R>
+static void check_shr_round()
+{
+  check_shr_round_type<R, std::int8_t>();
+  check_shr_round_type<R, std::uint8_t>();
+  check_shr_round_type<R, std::int16_t>();
+  // Wide: extremes, ties and neighbours.
+  const std::int64_t vals[] = { 0, 1, -1, 2, -2, 3, -3, 5, -5, 6, -6,
+    INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1,
+    std::int64_t(1) << 40, -(std::int64_t(1) << 40),
+    (std::int64_t(3) << 39), -(std::int64_t(3) << 39) };
+  for (std::int64_t v : vals) {
+    for (unsigned n = 0; n <= 70; ++n) {
+      INPUT std::int64_t iv = v;
+      std::int64_t got = sia80::shr_round<R>(std::int64_t(iv), n);
+      if (got != ref_round(v, n, R)) {
+        report("shr_round int64", R, v, n, got, (long long) ref_round(v, n, R));
+      }
+      INPUT std::uint64_t iu = std::uint64_t(v);
+      std::uint64_t ugot = sia80::shr_round<R>(std::uint64_t(iu), n);
+      i128 uexp = ref_round(i128(std::uint64_t(v)), n, R);
+      if (ugot != uexp) {
+        report("shr_round uint64", R, v, n, (long long) ugot, (long long) uexp);
+      }
+    }
+  }
+}
+
+// Every mode of xx_qmul<F, R> for a and b.
+template <unsigned F, rounding R, class T>
+static void check_qmul_one(T a, T b)
+{
+  using namespace sia80;
+  T etr, esr;
+  bool fits;
+  if constexpr(std::is_signed<T>::value) {
+    const i128 e = ref_round(i128(a) * i128(b), F, R);
+    fits = e >= i128(std::numeric_limits<T>::min()) &&
+        e <= i128(std::numeric_limits<T>::max());
+    etr = T((unsigned __int128) e);
+    esr = fits ? etr : e < 0 ? std::numeric_limits<T>::min() :
+        std::numeric_limits<T>::max();
+  }
+  else {
+    const unsigned __int128 e = ref_round_u((unsigned __int128) a * b, F, R);
+    fits = e <= std::numeric_limits<T>::max();
+    etr = T(e);
+    esr = fits ? etr : std::numeric_limits<T>::max();
+  }
+  INPUT T ia = a;
+  INPUT T ib = b;
+  bool excepted = false;
+  T cxv = 0;
+  try {
+    cxv = cx_qmul<F, R>(T(ia), T(ib));
+  }
+  catch (std::overflow_error&) {
+    excepted = true;
+  }
+  if (excepted == fits || (fits && cxv != etr)) {
+    report("cx_qmul", R, (long long) a, (long long) b, (long long) cxv, (long long) etr);
+  }
+  int flag = 0;
+  T cfv = cf_qmul<F, R>(T(ia), T(ib), &flag);
+  if (cfv != etr || flag != !fits) {
+    report("cf_qmul", R, (long long) a, (long long) b, (long long) cfv, (long long) etr);
+  }
+  cf_result<T> p = cf_qmul<F, R>(T(ia), T(ib));
+  if (p.value != etr || p.overflowed != !fits) {
+    report("cf_qmul pair", R, (long long) a, (long long) b, (long long) p.value, (long long) etr);
+  }
+  if (tr_qmul<F, R>(T(ia), T(ib)) != etr) {
+    report("tr_qmul", R, (long long) a, (long long) b,
+        (long long) tr_qmul<F, R>(T(ia), T(ib)), (long long) etr);
+  }
+  if (sr_qmul<F, R>(T(ia), T(ib)) != esr) {
+    report("sr_qmul", R, (long long) a, (long long) b,
+        (long long) sr_qmul<F, R>(T(ia), T(ib)), (long long) esr);
+  }
+  if (sr_qmul<F, R>(T(ia), T(ib), branchless) != esr) {
+    report("sr_qmul branchless", R, (long long) a, (long long) b,
+        (long long) sr_qmul<F, R>(T(ia), T(ib), branchless), (long long) esr);
+  }
+}
+
+template <unsigned F, rounding R, class T>
+static void check_qmul()
+{
+  std::vector<T> vals;
+  const T tmin = std::numeric_limits<T>::min();
+  const T tmax = std::numeric_limits<T>::max();
+  const T one = T(T(1) << (F < sizeof(T) * 8 - 1 ? F : 0));
+  for (T v : { T(0), T(1), T(2), T(3), tmin, T(tmin + 1), tmax, T(tmax - 1),
+      one, T(one + 1), T(one / 2), T(one * 3 / 2) })
+  {
+    vals.push_back(v);
+    vals.push_back(T(-v));
+  }
+  rng r { 12345 };
+  for (int i = 0; i < 60; ++i) {
+    const std::uint64_t x = r.next();
+    // Various magnitudes, so that some products fit and some don't.
+    vals.push_back(T(T(x >> 11) >> ((x >> 3) % (sizeof(T) * 8))));
+  }
+  for (T a : vals) {
+    for (T b : vals) {
+      check_qmul_one<F, R>(a, b);
+    }
+  }
+  // Arrays: the same as element-wise.
+  const std::size_t n = vals.size();
+  std::vector<T> b(vals.rbegin(), vals.rend()), dst(n), ref(n);
+  bool any_ovf = false;
+  for (std::size_t i = 0; i < n; ++i) {
+    int flag = 0;
+    sia80::cf_qmul<F, R>(vals[i], b[i], &flag);
+    any_ovf |= flag != 0;
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    ref[i] = sia80::sr_qmul<F, R>(vals[i], b[i]);
+  }
+  sia80::sr_qmul_n<F, R>(dst.data(), vals.data(), b.data(), n);
+  ASSERT_ALWAYS(dst == ref);
+  for (std::size_t i = 0; i < n; ++i) {
+    ref[i] = sia80::tr_qmul<F, R>(vals[i], b[i]);
+  }
+  sia80::tr_qmul_n<F, R>(dst.data(), vals.data(), b.data(), n);
+  ASSERT_ALWAYS(dst == ref);
+  int flag = 0;
+  dst.assign(n, 0);
+  sia80::cf_qmul_n<F, R>(dst.data(), vals.data(), b.data(), n, &flag);
+  ASSERT_ALWAYS(dst == ref);
+  ASSERT_ALWAYS(flag == any_ovf);
+  bool excepted = false;
+  try {
+    sia80::cx_qmul_n<F, R>(dst.data(), vals.data(), b.data(), n);
+  }
+  catch (std::overflow_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted == any_ovf);
+  // In place, and no overflow from halves.
+  std::vector<T> halves(n, T(T(1) << (F - 1)));
+  dst = vals;
+  sia80::cx_qmul_n<F, R>(dst.data(), dst.data(), halves.data(), n);
+  for (std::size_t i = 0; i < n; ++i) {
+    ASSERT_ALWAYS(dst[i] == ref_round(vals[i], 1, R));
+  }
+}
+
+template <rounding R>
+static void check_qmul_all()
+{
+  check_qmul<16, R, std::int32_t>();
+  check_qmul<16, R, std::uint32_t>();
+  check_qmul<31, R, std::int32_t>();
+  check_qmul<32, R, std::uint32_t>();
+  check_qmul<32, R, std::int64_t>();
+  check_qmul<32, R, std::uint64_t>();
+  check_qmul<8, R, std::int16_t>();
+  check_qmul<4, R, std::int8_t>();
+}
+
+// xx_shrx for all values of T and counts around the valid range.
+template <class T>
+static void check_shrx_type()
+{
+  using namespace sia80;
+  for (long long v = (long long) std::numeric_limits<T>::min();
+      v <= (long long) std::numeric_limits<T>::max(); ++v)
+  {
+    for (int n = -2; n <= 34; ++n) {
+      INPUT T iv = T(v);
+      const bool bad = n < 0 || n >= 31; // promoted to int
+      const long long eq = bad ? 0 : v / (1ll << n);
+      const bool inexact = bad || v % (1ll << n) != 0;
+      bool excepted = false;
+      int cxv = 0;
+      try {
+        cxv = cx_shrx(T(iv), n);
+      }
+      catch (std::out_of_range&) {
+        excepted = bad;
+        if (!bad) {
+          report("cx_shrx count", rounding::trunc, v, n, 0, eq);
+        }
+      }
+      catch (std::range_error&) {
+        excepted = !bad;
+      }
+      if (excepted != inexact || (!inexact && cxv != eq)) {
+        report("cx_shrx", rounding::trunc, v, n, cxv, eq);
+      }
+      int flag = 0;
+      int cfv = cf_shrx(T(iv), n, &flag);
+      cf_result<int> p = cf_shrx(T(iv), n);
+      if (cfv != eq || flag != inexact || p.value != eq || p.overflowed != inexact) {
+        report("cf_shrx", rounding::trunc, v, n, cfv, eq);
+      }
+      if (tr_shrx(T(iv), n) != eq || sr_shrx(T(iv), n) != eq) {
+        report("tr_shrx", rounding::trunc, v, n, tr_shrx(T(iv), n), eq);
+      }
+    }
+  }
+}
+
+static void check_shrx()
+{
+  using namespace sia80;
+  check_shrx_type<std::int8_t>();
+  check_shrx_type<std::uint8_t>();
+  check_shrx_type<std::int16_t>();
+  // Wide types: the sign bit and the top count.
+  ASSERT_ALWAYS(cx_shrx(INT64_MIN, 62) == -2);
+  ASSERT_ALWAYS(tr_shrx(INT64_MIN + 1, 62) == -1);
+  ASSERT_ALWAYS(cx_shrx(UINT64_MAX - 1, 1) == UINT64_MAX / 2);
+  ASSERT_ALWAYS(cx_shrx(std::uint64_t(1) << 63, 63) == 1);
+  ASSERT_ALWAYS(cf_shrx(std::int64_t(-1), 63).overflowed);
+  ASSERT_ALWAYS(tr_shrx(std::int64_t(-1), 63) == 0);
+  overflow_sticky ovf;
+  ASSERT_ALWAYS(ovf.shrx(-64, 3) == -8 && !ovf);
+  ASSERT_ALWAYS(ovf.shrx(-65, 3) == -8 && ovf);
+}
+
+void test_fixed()
+{
+  check_shr_round<rounding::floor>();
+  check_shr_round<rounding::trunc>();
+  check_shr_round<rounding::ceil>();
+  check_shr_round<rounding::nearest>();
+  check_shr_round<rounding::even>();
+  check_qmul_all<rounding::floor>();
+  check_qmul_all<rounding::trunc>();
+  check_qmul_all<rounding::ceil>();
+  check_qmul_all<rounding::nearest>();
+  check_qmul_all<rounding::even>();
+  check_shrx();
+}
@@ -0,0 +1,257 @@
+#include "test_common.hxx"
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// __int128 and unsigned __int128 shall work in all functions and
+// modes, also in strict -std=c++17. The multiply by 64-bit halves shall
+// give the same result and overflow as __builtin_mul_overflow.
+
+#if defined(__SIZEOF_INT128__)
+
+using i128 = __int128;
+using u128 = unsigned __int128;
+
+static_assert(sia80::ia_is_integral<i128>::value);
+static_assert(sia80::ia_limits<i128>::digits == 127);
+static_assert(sia80::cx_add(i128(1) << 100, i128(1) << 100) == i128(1) << 101);
+static_assert(sia80::sr_mul(i128(1) << 64, -(i128(1) << 64)) == sia80::ia_limits<i128>::min());
+static_assert(sia80::tr_mul(u128(1) << 64, u128(1) << 64) == 0);
+static_assert(sia80::cx_mul_wide(INT64_MIN, INT64_MIN) == i128(1) << 126);
+static_assert(sia80::cx_mul_wide(UINT64_MAX, UINT64_MAX) ==
+    ~u128(0) - (u128(UINT64_MAX) << 1));
+
+static std::string str128(u128 v, bool neg)
+{
+  std::string s;
+  do {
+    s.insert(s.begin(), char('0' + int(v % 10)));
+    v /= 10;
+  } while (v != 0);
+  return neg ? "-" + s : s;
+}
+
+template <class T>
+static std::string str128(T v)
+{
+  return v < 0 ? str128(u128(0) - u128(v), true) : str128(u128(v), false);
+}
+
+template <class T1, class T2>
+static void report(const char *label, T1 a, T2 b)
+{
+  std::cerr << "test_int128: " << label
+          << ": mismatch for: arg1=" << str128(a)
+          << "; arg2=" << str128(b)
+          << "\n";
+  throw std::runtime_error("Assertion failed: int128 mismatch");
+}
+
+template <class T>
+static std::vector<T> values()
+{
+  const T tmax = sia80::ia_limits<T>::max();
+  const T tmin = sia80::ia_limits<T>::min();
+  std::vector<T> v = { T(0), T(1), T(2), T(3), T(-1), T(-2), T(-3),
+      tmax, T(tmax - 1), T(tmax / 2), T(tmax / 3), tmin, T(tmin + 1), T(tmin / 2) };
+  for (int sh = 31; sh < int(sizeof(T) * 8) - 1; sh += 16) {
+    for (int d = -1; d <= 1; ++d) {
+      v.push_back(T((T(1) << sh) + d));
+      v.push_back(T(-(T(1) << sh) + d));
+    }
+  }
+  // Near the square roots of 2^127 and 2^128.
+  if constexpr(sizeof(T) == 16) {
+    const T roots[] = { T(0xB504F333F9DE6484ull), T(T(1) << 64) };
+    for (T root : roots) {
+      for (int d = -2; d <= 2; ++d) {
+        v.push_back(T(root + d));
+        v.push_back(T(-root + d));
+      }
+    }
+  }
+  rng r { 1 };
+  for (int i = 0; i < 100; ++i) {
+    const std::uint64_t x = r.next();
+    u128 r = (u128(x) << 64) | (x * 0x9E3779B97F4A7C15ull);
+    v.push_back(T(r >> (i % 128)));
+  }
+  return v;
+}
+
+template <class T1, class T2>
+static void check_mul()
+{
+  using TR = decltype(T1() * T2());
+  for (T1 a : values<T1>()) {
+    for (T2 b : values<T2>()) {
+      INPUT T1 va = a;
+      INPUT T2 vb = b;
+      TR eres = 0;
+      const bool eovf = __builtin_mul_overflow(a, b, &eres);
+      TR res = 0;
+      const bool ovf = sia80::mul_detail::mul128_halves(T1(va), T2(vb), &res);
+      if (res != eres || ovf != eovf) {
+        report("mul128_halves", a, b);
+      }
+      int flag = 0;
+      if (sia80::cf_mul(va, vb, &flag) != eres || flag != int(eovf)) {
+        report("cf_mul", a, b);
+      }
+      auto p = sia80::cf_mul(va, vb);
+      if (p.value != eres || p.overflowed != eovf) {
+        report("cf_mul pair", a, b);
+      }
+      if (sia80::tr_mul(va, vb) != eres) {
+        report("tr_mul", a, b);
+      }
+      bool excepted = false;
+      try {
+        if (sia80::cx_mul(va, vb) != eres) {
+          report("cx_mul", a, b);
+        }
+      }
+      catch (std::overflow_error&) {
+        excepted = true;
+      }
+      if (excepted != eovf) {
+        report("cx_mul exception", a, b);
+      }
+      TR esat = eres;
+      if (eovf) {
+        esat = (a < 0) != (b < 0) ? sia80::ia_limits<TR>::min() : sia80::ia_limits<TR>::max();
+      }
+      if (sia80::sr_mul(va, vb) != esat || sia80::sr_mul(va, vb, sia80::branchless) != esat) {
+        report("sr_mul", a, b);
+      }
+    }
+  }
+}
+
+template <class T>
+static bool cx_throws(T (*f)())
+{
+  try {
+    f();
+  }
+  catch (std::exception&) {
+    return true;
+  }
+  return false;
+}
+
+static void check_other_ops()
+{
+  using namespace sia80;
+  const i128 imax = ia_limits<i128>::max();
+  const i128 imin = ia_limits<i128>::min();
+  const u128 umax = ia_limits<u128>::max();
+  INPUT i128 big = imax;
+  INPUT i128 small = imin;
+  INPUT u128 ubig = umax;
+  INPUT int one = 1;
+  // add, sub
+  ASSERT_ALWAYS(cx_throws<i128>([] { INPUT i128 x = ia_limits<i128>::max(); return cx_add(x, 1); }));
+  ASSERT_ALWAYS(cx_add(big, -1) == imax - 1);
+  ASSERT_ALWAYS(sr_add(big, big) == imax && sr_add(small, small) == imin);
+  ASSERT_ALWAYS(sr_add(big, big, branchless) == imax);
+  ASSERT_ALWAYS(tr_add(big, one) == imin);
+  ASSERT_ALWAYS(cf_add(ubig, one).overflowed && cf_add(ubig, one).value == 0);
+  ASSERT_ALWAYS(sr_sub(u128(0), ubig) == 0);
+  ASSERT_ALWAYS(sr_sub(small, one) == imin && cf_sub(small, one).overflowed);
+  // Mixed with narrower types.
+  ASSERT_ALWAYS(sr_add(std::int64_t(-1), ubig) == umax - 1);
+  ASSERT_ALWAYS(cf_add(std::int64_t(-2), u128(1)).overflowed);
+  // div, rem
+  ASSERT_ALWAYS(cx_throws<i128>([] { INPUT i128 x = ia_limits<i128>::min(); return cx_div(x, -1); }));
+  ASSERT_ALWAYS(cx_throws<i128>([] { INPUT i128 x = 5; return cx_rem(x, 0); }));
+  ASSERT_ALWAYS(sr_div(small, -1) == imax && tr_div(small, -1) == imin);
+  ASSERT_ALWAYS(sr_div(big, 0) == imax && tr_rem(small, -1) == 0);
+  ASSERT_ALWAYS(cx_div(big, i128(1) << 64) == imax >> 64);
+  ASSERT_ALWAYS(cf_div(ubig, u128(0)).overflowed);
+  // shl, shr
+  INPUT int sh = 126;
+  ASSERT_ALWAYS(cx_shl(i128(1), sh) == i128(1) << 126);
+  ASSERT_ALWAYS(cx_throws<i128>([] { INPUT int s = 127; return cx_shl(i128(1), s); }));
+  ASSERT_ALWAYS(cx_throws<i128>([] { INPUT int s = 128; return cx_shl(i128(0), s); }));
+  ASSERT_ALWAYS(cx_shl(u128(1), sh + 1) == u128(1) << 127);
+  ASSERT_ALWAYS(sr_shl(i128(-3), sh) == imin && sr_shl(i128(3), sh) == imax);
+  ASSERT_ALWAYS(sr_shl(i128(3), sh, branchless) == imax);
+  ASSERT_ALWAYS(sr_shl(u128(3), 200) == umax);
+  ASSERT_ALWAYS(tr_shl(big, one) == i128(-2));
+  ASSERT_ALWAYS(cf_shl(ubig, one).overflowed);
+  ASSERT_ALWAYS(cx_shr(small, sh) == -2 && tr_shr(small, 200) == -1);
+  ASSERT_ALWAYS(sr_shr(ubig, sh + 1) == 1);
+  // conv
+  ASSERT_ALWAYS(cx_throws<std::int64_t>([] { INPUT i128 x = i128(1) << 64; return cx_conv<std::int64_t>(x); }));
+  ASSERT_ALWAYS(sr_conv<std::int64_t>(small) == INT64_MIN);
+  ASSERT_ALWAYS(sr_conv<std::uint64_t>(big) == UINT64_MAX);
+  ASSERT_ALWAYS(sr_conv<i128>(ubig) == imax && sr_conv<u128>(small) == 0);
+  ASSERT_ALWAYS(sr_conv<i128>(ubig, branchless) == imax);
+  ASSERT_ALWAYS(tr_conv<std::int32_t>(big) == -1);
+  ASSERT_ALWAYS(cf_conv<u128>(INT64_MIN).overflowed);
+  ASSERT_ALWAYS(cx_conv<i128>(UINT64_MAX) == i128(UINT64_MAX));
+  // ufit, sfit
+  INPUT unsigned nb = 100;
+  ASSERT_ALWAYS(cx_ufit(i128(1) << 99, nb) == i128(1) << 99);
+  ASSERT_ALWAYS(cx_throws<i128>([] { INPUT unsigned n = 100; return cx_ufit(i128(1) << 100, n); }));
+  ASSERT_ALWAYS(cx_ufit(ubig, 128) == umax);
+  ASSERT_ALWAYS(cf_ufit(ubig, nb).overflowed && cf_ufit(ubig, nb).value == (u128(1) << 100) - 1);
+  ASSERT_ALWAYS(tr_ufit(big, nb) == (i128(1) << 100) - 1);
+  ASSERT_ALWAYS(cx_sfit(-(i128(1) << 99), nb) == -(i128(1) << 99));
+  ASSERT_ALWAYS(cx_throws<i128>([] { INPUT unsigned n = 100; return cx_sfit(i128(1) << 99, n); }));
+  ASSERT_ALWAYS(cx_sfit(small, 128) == imin);
+  ASSERT_ALWAYS(cx_sfit(u128(1) << 98, nb) == u128(1) << 98);
+  ASSERT_ALWAYS(cx_throws<u128>([] { INPUT unsigned n = 128; return cx_sfit(ia_limits<u128>::max(), n); }));
+}
+
+static void check_mul_wide()
+{
+  const std::int64_t iv[] = { 0, 1, -1, INT64_MAX, INT64_MIN, 0x123456789, -0x7654321 };
+  const std::uint64_t uv[] = { 0, 1, UINT64_MAX, UINT64_MAX / 3, 0x8000000000000000ull };
+  for (std::int64_t a : iv) {
+    for (std::int64_t b : iv) {
+      INPUT std::int64_t va = a;
+      if (sia80::cx_mul_wide(va, b) != sia80::cx_mul(i128(a), b)) {
+        report("cx_mul_wide signed", a, b);
+      }
+    }
+    for (std::uint64_t b : uv) {
+      INPUT std::int64_t va = a;
+      if (sia80::cx_mul_wide(va, b) != sia80::cx_mul(i128(a), i128(b))) {
+        report("cx_mul_wide mixed", a, b);
+      }
+    }
+  }
+  for (std::uint64_t a : uv) {
+    for (std::uint64_t b : uv) {
+      INPUT std::uint64_t va = a;
+      if (sia80::cx_mul_wide(va, b) != sia80::cx_mul(u128(a), b)) {
+        report("cx_mul_wide unsigned", a, b);
+      }
+    }
+  }
+  static_assert(std::is_same<decltype(sia80::cx_mul_wide(1u, 2u)), u128>::value);
+  static_assert(std::is_same<decltype(sia80::cx_mul_wide(1u, 2)), i128>::value);
+}
+
+void test_int128()
+{
+  check_mul<i128, i128>();
+  check_mul<u128, u128>();
+  check_mul<i128, u128>();
+  check_mul<u128, i128>();
+  check_mul<std::int64_t, u128>();
+  check_mul<std::uint64_t, i128>();
+  check_mul<i128, std::int32_t>();
+  check_other_ops();
+  check_mul_wide();
+}
+
+#else
+
+void test_int128()
+{
+}
+
+#endif
@@ -26,6 +26,10 @@ void test_tr_shl_signed()
   //
   sw = -100;
   ASSERT_ALWAYS(sia80::tr_shl(iia, sw) == 0);
+  // Narrow types are promoted to int.
+  INPUT signed char sca = -3;
+  sw = 4;
+  ASSERT_ALWAYS(sia80::tr_shl(sca, sw) == -48);
 }
 
 int main()
@@ -65,21 +69,32 @@ int main()
   test_cx_ufit_signed();
   test_cx_ufit_unsigned();
   // TODO test_cx_ufit_unsigned
-  // TODO test_cf_ufit_signed
-  // TODO test_cf_ufit_unsigned
-  // TODO test_tr_ufit_signed
-  // TODO test_tr_ufit_unsigned
-  // TODO test_sr_ufit_signed
-  // TODO test_sr_ufit_unsigned
   // TODO test_cx_ufit_signed
   test_cx_sfit_signed();
   test_cx_sfit_unsigned();
-  // TODO test_cf_sfit_signed
-  // TODO test_cf_sfit_unsigned
-  // TODO test_tr_sfit_signed
-  // TODO test_tr_sfit_unsigned
-  // TODO test_sr_sfit_signed
-  // TODO test_sr_sfit_unsigned
+  // cf_, tr_, sr_ of ufit and sfit.
+  test_fit_modes();
+  test_sr_batch();
+  test_conv_batch();
+  test_bitpack();
+  test_sum();
+  test_cf_pair();
+  test_constexpr();
+  test_divider();
+  test_sr_branchless();
+  test_batch_isa();
+  test_int128();
+  test_telemetry();
+  test_fixed();
+  test_parse();
+  test_arena();
+  test_range();
+  test_bounded();
+  test_atomic();
+  test_math();
+  test_muldiv();
+  test_result();
+  test_expr();
 
 #if 0
   volatile int numr1 = -2147483647-1;
@@ -0,0 +1,249 @@
+#include "test_common.hxx"
+#include <safe_int_math_80.hxx>
+#include <cstdint>
+#include <iostream>
+
+// neg, abs, pow, gcd, lcm in the four modes against exact results in
+// __int128 (the truncated value, the overflow, the saturated value),
+// on edge values and pseudo-random ones; pow over all small bases and
+// exponents on each side of the overflow bound; midpoint on all pairs
+// of 8 bit values.
+
+using i128 = __int128;
+using u128 = unsigned __int128;
+
+static_assert(sia80::cx_pow(3, 4) == 81);
+static_assert(sia80::cx_pow(-2, 31) == INT32_MIN);
+static_assert(sia80::cx_pow(7, -1) == 0 && sia80::cx_pow(-1, -3) == -1);
+static_assert(sia80::cx_gcd(-12, 18) == 6 && sia80::cx_lcm(4, -6) == 12);
+static_assert(sia80::cx_neg(INT32_MIN + 1) == INT32_MAX);
+static_assert(sia80::midpoint(INT32_MIN, INT32_MAX) == -1);
+static_assert(std::is_same<decltype(sia80::cx_neg(std::uint8_t(1))), int>::value);
+static_assert(std::is_same<decltype(sia80::cx_gcd(1, 1u)), unsigned>::value);
+
+static void report(const char *label, long long a, long long b,
+    long long got, long long expected)
+{
+  std::cerr << "test_math: " << label << ": mismatch for: a=" << a
+          << "; b=" << b << "; result=" << got
+          << ", expected " << expected << "\n";
+  throw std::runtime_error("Assertion failed: math mismatch");
+}
+
+// Exact values out of this are "big" (for 64 bit types, far beyond).
+constexpr i128 big = i128(1) << 100;
+
+// All modes of one op against the exact value e (or big for beyond),
+// with wrapped the truncated value. TR is the result type.
+template <class TR, class FCx, class FCf, class FCfp, class FTr, class FSr>
+static void check_modes(const char *label, long long a, long long b,
+    i128 e, TR wrapped, FCx fcx, FCf fcf, FCfp fcfp, FTr ftr, FSr fsr)
+{
+  const i128 lo = std::numeric_limits<TR>::min();
+  const i128 hi = std::numeric_limits<TR>::max();
+  const bool fits = e >= lo && e <= hi;
+  bool excepted = false;
+  TR got = 0;
+  try {
+    got = fcx();
+  }
+  catch (std::overflow_error&) {
+    excepted = true;
+  }
+  if (excepted == fits || (fits && i128(got) != e)) {
+    report(label, a, b, (long long) got, (long long) e);
+  }
+  int flag = 0;
+  if (fcf(&flag) != wrapped || flag != !fits) {
+    report(label, a, b, flag, fits);
+  }
+  const sia80::cf_result<TR> r = fcfp();
+  if (r.value != wrapped || r.overflowed == fits) {
+    report(label, a, b, r.overflowed, fits);
+  }
+  if (ftr() != wrapped) {
+    report(label, a, b, (long long) ftr(), (long long) wrapped);
+  }
+  const TR sat = e < lo ? TR(lo) : e > hi ? TR(hi) : TR(e);
+  if (fsr() != sat) {
+    report(label, a, b, (long long) fsr(), (long long) sat);
+  }
+}
+
+#define MODES(op, ...) \
+  [&] { return sia80::cx_##op(__VA_ARGS__); }, \
+  [&](int *flag) { return sia80::cf_##op(__VA_ARGS__, flag); }, \
+  [&] { return sia80::cf_##op(__VA_ARGS__); }, \
+  [&] { return sia80::tr_##op(__VA_ARGS__); }, \
+  [&] { return sia80::sr_##op(__VA_ARGS__); }
+
+template <class T>
+static void check_neg_abs(T v)
+{
+  using TR = decltype(-v);
+  INPUT T iv = v;
+  const i128 e = -i128(v);
+  check_modes<TR>("neg", (long long) v, 0, e, TR(u128(0) - u128(v)), MODES(neg, T(iv)));
+  const i128 ea = v < 0 ? e : i128(v);
+  check_modes<TR>("abs", (long long) v, 0, ea, TR(ea), MODES(abs, T(iv)));
+  if (u128(sia80::uabs(T(iv))) != u128(ea)) {
+    report("uabs", (long long) v, 0, (long long) sia80::uabs(v), (long long) ea);
+  }
+}
+
+template <class T, class E>
+static void check_pow(T b, E x)
+{
+  using TR = decltype(+b);
+  using UTR = std::make_unsigned_t<TR>;
+  i128 e = 1;
+  UTR wrapped = 1;
+  if (x < 0) {
+    e = b == 1 ? 1 : i128(b) == -1 ? (x % 2 ? -1 : 1) : 0;
+    wrapped = UTR(e);
+  }
+  else {
+    for (E k = 0; k < x; ++k) {
+      wrapped = UTR(wrapped * UTR(b));
+      // Beyond big, only the sign is kept.
+      if (e > -big && e < big) {
+        e *= b;
+      }
+      else if (i128(b) < 0) {
+        e = -e;
+      }
+    }
+  }
+  INPUT T ib = b;
+  INPUT E ix = x;
+  if (x < 0 && b == 0) {
+    bool excepted = false;
+    try {
+      sia80::cx_pow(T(ib), E(ix));
+    }
+    catch (std::domain_error&) {
+      excepted = true;
+    }
+    ASSERT_ALWAYS(excepted);
+    ASSERT_ALWAYS(sia80::sr_pow(T(ib), E(ix)) == std::numeric_limits<TR>::max());
+    return;
+  }
+  check_modes<TR>("pow", (long long) b, (long long) x, e, TR(wrapped), MODES(pow, T(ib), E(ix)));
+}
+
+template <class T>
+static void check_pow_type()
+{
+  for (long long b = -40; b <= 40; ++b) {
+    if (!std::is_signed<T>::value && b < 0) {
+      continue;
+    }
+    for (int x = -3; x <= 70; ++x) {
+      check_pow(T(b), x);
+    }
+  }
+  // Large bases: powers of 2 and their neighbours, at the bound.
+  for (int k = 2; k < std::numeric_limits<T>::digits; ++k) {
+    for (long long d : { -1, 0, 1 }) {
+      const T b = T((T(1) << k) + d);
+      const int bound = std::numeric_limits<T>::digits / k;
+      for (int x : { bound - 1, bound, bound + 1 }) {
+        check_pow(b, unsigned(x));
+        if (std::is_signed<T>::value) {
+          check_pow(T(-b), x);
+        }
+      }
+    }
+  }
+  // Huge exponents.
+  for (long long b : { 0, 1, 2, 3 }) {
+    ASSERT_ALWAYS((sia80::cf_pow(T(b), UINT64_MAX).overflowed == (b > 1)));
+    ASSERT_ALWAYS(sia80::sr_pow(T(b), UINT64_MAX) == (b > 1 ? std::numeric_limits<T>::max() : T(b)));
+  }
+}
+
+template <class T1, class T2>
+static void check_gcd_lcm(T1 a, T2 b)
+{
+  using TR = decltype(a + b);
+  u128 x = a < 0 ? u128(0) - u128(i128(a)) : u128(a);
+  u128 y = b < 0 ? u128(0) - u128(i128(b)) : u128(b);
+  const u128 ux = x, uy = y;
+  while (y != 0) {
+    const u128 t = x % y;
+    x = y;
+    y = t;
+  }
+  const i128 g = i128(x);
+  INPUT T1 ia = a;
+  INPUT T2 ib = b;
+  check_modes<TR>("gcd", (long long) a, (long long) b, g, TR(g), MODES(gcd, T1(ia), T2(ib)));
+  const u128 l = ux == 0 || uy == 0 ? 0 : ux / x * uy;
+  const i128 el = l > u128(big) ? big : i128(l);
+  check_modes<TR>("lcm", (long long) a, (long long) b, el, TR(l), MODES(lcm, T1(ia), T2(ib)));
+}
+
+template <class T>
+static void check_midpoint()
+{
+  const long long lo = std::numeric_limits<T>::min();
+  const long long hi = std::numeric_limits<T>::max();
+  for (long long a = lo; a <= hi; ++a) {
+    for (long long b = lo; b <= hi; ++b) {
+      INPUT T ia = T(a);
+      // Toward a: floor if a < b, ceiling otherwise.
+      const long long s = a + b;
+      const long long e = a <= b ? (s >= 0 ? s / 2 : -((-s + 1) / 2)) :
+          (s >= 0 ? (s + 1) / 2 : -((-s) / 2));
+      if (sia80::midpoint(T(ia), T(b)) != e) {
+        report("midpoint", a, b, sia80::midpoint(T(a), T(b)), e);
+      }
+    }
+  }
+}
+
+template <class T>
+static void check_edges()
+{
+  const T edges[] = { std::numeric_limits<T>::min(), T(std::numeric_limits<T>::min() + 1),
+      T(-1), 0, 1, 2, 6, T(std::numeric_limits<T>::max() / 2 + 1),
+      T(std::numeric_limits<T>::max() - 1), std::numeric_limits<T>::max() };
+  for (T a : edges) {
+    check_neg_abs(a);
+    for (T b : edges) {
+      check_gcd_lcm(a, b);
+    }
+  }
+}
+
+void test_math()
+{
+  check_edges<std::int32_t>();
+  check_edges<std::uint32_t>();
+  check_edges<std::int64_t>();
+  check_edges<std::uint64_t>();
+  check_neg_abs(std::int8_t(-128));
+  check_neg_abs(std::uint16_t(65535));
+  rng r { 12345 };
+  for (int i = 0; i < 20000; ++i) {
+    // Common factors of small primes, on both sides of the bound.
+    const std::uint64_t f = std::uint64_t(1) << (r.next() >> 58);
+    const std::uint64_t a = (r.next() >> (r.next() >> 58)) * f;
+    const std::uint64_t b = (r.next() >> (r.next() >> 58)) * f * 3;
+    check_gcd_lcm(std::int64_t(a), std::int64_t(b));
+    check_gcd_lcm(a, b);
+    check_gcd_lcm(std::int32_t(a), std::uint32_t(b));
+    check_gcd_lcm(std::int32_t(a), std::int16_t(b));
+    check_neg_abs(std::int64_t(a));
+  }
+  check_pow_type<std::int32_t>();
+  check_pow_type<std::uint32_t>();
+  check_pow_type<std::int64_t>();
+  check_pow_type<std::uint64_t>();
+  check_pow(std::int8_t(-3), std::int8_t(5));
+  check_pow(std::uint16_t(300), 3u);
+  check_midpoint<std::int8_t>();
+  check_midpoint<std::uint8_t>();
+  ASSERT_ALWAYS(sia80::midpoint(INT64_MAX, INT64_MIN) == 0);
+  ASSERT_ALWAYS(sia80::midpoint(UINT64_MAX, std::uint64_t(0)) == UINT64_MAX / 2 + 1);
+}
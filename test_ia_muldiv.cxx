@@ -0,0 +1,354 @@
+#include "test_common.hxx"
+#include <safe_int_muldiv_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// xx_muldiv<R> in all modes and roundings against the exact quotient
+// (the truncated value, the overflow, the saturated value): all 8 bit
+// values by a set of multipliers and divisors, and pseudo-random values of
+// all magnitudes for 32 and 64 bit types; division by zero; the
+// array forms and the reciprocal against the scalar ones, and the
+// divisor 0.
+
+using sia80::rounding;
+using i128 = __int128;
+using u128 = unsigned __int128;
+
+static_assert(sia80::cx_muldiv(std::uint64_t(1) << 62, std::uint64_t(12), std::uint64_t(16)) ==
+    (std::uint64_t(3) << 60));
+static_assert(sia80::cx_muldiv(INT32_MAX, INT32_MAX, INT32_MAX) == INT32_MAX);
+static_assert(sia80::cx_muldiv<rounding::ceil>(7, 3, 2) == 11);
+static_assert(sia80::cx_muldiv<rounding::floor>(-7, 3, 2) == -11);
+static_assert(sia80::cx_muldiv<rounding::nearest>(-7, 1, 2) == -3);
+static_assert(sia80::cx_muldiv<rounding::even>(-7, 1, -2) == 4);
+static_assert(sia80::sr_muldiv(-5, 3, 0) == INT32_MIN);
+
+static const char *rounding_name(rounding r)
+{
+  switch (r) {
+  case rounding::floor: return "floor";
+  case rounding::trunc: return "trunc";
+  case rounding::ceil: return "ceil";
+  case rounding::nearest: return "nearest";
+  default: return "even";
+  }
+}
+
+static void report(const char *label, rounding r, long long a, long long b,
+    long long c, long long got, long long expected)
+{
+  std::cerr << "test_muldiv: " << label << " (" << rounding_name(r)
+          << "): mismatch for: a=" << a << "; b=" << b << "; c=" << c
+          << "; result=" << got << ", expected " << expected << "\n";
+  throw std::runtime_error("Assertion failed: muldiv mismatch");
+}
+
+// n / d rounded by r, d != 0; |n| < 2^127.
+static i128 ref_div(i128 n, i128 d, rounding r)
+{
+  if (d < 0) {
+    n = -n;
+    d = -d;
+  }
+  i128 q = n / d;
+  if (n % d != 0 && n < 0) {
+    --q; // floor
+  }
+  const i128 rem = n - q * d; // 0 <= rem < d
+  switch (r) {
+  case rounding::floor:
+    return q;
+  case rounding::trunc:
+    return q + (n < 0 && rem != 0);
+  case rounding::ceil:
+    return q + (rem != 0);
+  case rounding::nearest:
+    return q + (2 * rem >= d);
+  default:
+    return q + (2 * rem > d || (2 * rem == d && (q & 1) != 0));
+  }
+}
+
+// The same for unsigned n up to 2^128 - 1.
+static u128 ref_div_u(u128 n, u128 d, rounding r)
+{
+  const u128 q = n / d;
+  const u128 rem = n % d;
+  switch (r) {
+  case rounding::floor:
+  case rounding::trunc:
+    return q;
+  case rounding::ceil:
+    return q + (rem != 0);
+  case rounding::nearest:
+    return q + (rem >= d - rem);
+  default:
+    return q + (rem > d - rem || (rem == d - rem && (q & 1) != 0));
+  }
+}
+
+template <rounding R, class T>
+static void check_one(T a, T b, T c)
+{
+  using namespace sia80;
+  T etr, esr;
+  bool fits;
+  if (c == 0) {
+    fits = false;
+    etr = T(~T(0));
+    const bool neg = i128(a) * i128(b) < 0;
+    esr = neg ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+  }
+  else if constexpr(std::is_signed<T>::value) {
+    const i128 e = ref_div(i128(a) * i128(b), c, R);
+    fits = e >= i128(std::numeric_limits<T>::min()) &&
+        e <= i128(std::numeric_limits<T>::max());
+    etr = T(u128(e));
+    esr = fits ? etr : e < 0 ? std::numeric_limits<T>::min() :
+        std::numeric_limits<T>::max();
+  }
+  else {
+    const u128 e = ref_div_u(u128(a) * b, c, R);
+    fits = e <= std::numeric_limits<T>::max();
+    etr = T(e);
+    esr = fits ? etr : std::numeric_limits<T>::max();
+  }
+  INPUT T ia = a;
+  INPUT T ib = b;
+  INPUT T ic = c;
+  bool excepted = false;
+  T cxv = 0;
+  try {
+    cxv = cx_muldiv<R>(T(ia), T(ib), T(ic));
+  }
+  catch (std::overflow_error&) {
+    excepted = c != 0;
+  }
+  catch (std::domain_error&) {
+    excepted = c == 0;
+  }
+  if (excepted == fits || (fits && cxv != etr)) {
+    report("cx_muldiv", R, (long long) a, (long long) b, (long long) c, (long long) cxv, (long long) etr);
+  }
+  int flag = 0;
+  const T cfv = cf_muldiv<R>(T(ia), T(ib), T(ic), &flag);
+  if (cfv != etr || flag != !fits) {
+    report("cf_muldiv", R, (long long) a, (long long) b, (long long) c, (long long) cfv, (long long) etr);
+  }
+  const cf_result<T> p = cf_muldiv<R>(T(ia), T(ib), T(ic));
+  if (p.value != etr || p.overflowed != !fits) {
+    report("cf_muldiv pair", R, (long long) a, (long long) b, (long long) c,
+        (long long) p.value, (long long) etr);
+  }
+  const T trv = tr_muldiv<R>(T(ia), T(ib), T(ic));
+  if (trv != etr) {
+    report("tr_muldiv", R, (long long) a, (long long) b, (long long) c, (long long) trv, (long long) etr);
+  }
+  const T srv = sr_muldiv<R>(T(ia), T(ib), T(ic));
+  if (srv != esr) {
+    report("sr_muldiv", R, (long long) a, (long long) b, (long long) c, (long long) srv, (long long) esr);
+  }
+}
+
+template <rounding R, class T>
+static void check_small()
+{
+  const long long lo = std::numeric_limits<T>::min();
+  const long long hi = std::numeric_limits<T>::max();
+  const long long divs[] = { 0, 1, -1, 2, -3, 7, -128, 255 };
+  for (long long c : divs) {
+    if (c < lo || c > hi) {
+      continue;
+    }
+    for (long long a = lo; a <= hi; ++a) {
+      for (long long b : { 0, 1, -1, 2, -2, 3, 5, -7, 11, 16, -16, 63, -64, 100, 127, -128, 128, 255 }) {
+        if (b >= lo && b <= hi) {
+          check_one<R>(T(a), T(b), T(c));
+        }
+      }
+    }
+  }
+}
+
+// Values of all magnitudes, with extremes; some quotients fit, some
+// don't.
+template <class T>
+static std::vector<T> wide_values()
+{
+  std::vector<T> vals;
+  const T tmin = std::numeric_limits<T>::min();
+  const T tmax = std::numeric_limits<T>::max();
+  for (T v : { T(0), T(1), T(2), T(3), tmin, T(tmin + 1), tmax, T(tmax - 1), T(tmax / 2),
+      T(tmax / 2 + 1) })
+  {
+    vals.push_back(v);
+    vals.push_back(T(-v));
+  }
+  rng r { 777 };
+  for (int i = 0; i < 16; ++i) {
+    const std::uint64_t x = r.next();
+    vals.push_back(T(T(x >> 11) >> ((x >> 3) % (sizeof(T) * 8))));
+  }
+  return vals;
+}
+
+template <rounding R, class T>
+static void check_wide()
+{
+  const std::vector<T> vals = wide_values<T>();
+  for (T a : vals) {
+    for (T b : vals) {
+      for (T c : vals) {
+        check_one<R>(a, b, c);
+      }
+    }
+  }
+}
+
+// The array forms are the scalar ones, for one divisor.
+template <rounding R, class T>
+static void check_arrays()
+{
+  const std::vector<T> a = wide_values<T>();
+  const std::vector<T> b(a.rbegin(), a.rend());
+  const std::size_t n = a.size();
+  for (T c : a) {
+    std::vector<T> dst(n), ref(n);
+    bool any_ovf = false;
+    for (std::size_t i = 0; i < n; ++i) {
+      const sia80::cf_result<T> r = sia80::cf_muldiv<R>(a[i], b[i], c);
+      ref[i] = r.value;
+      any_ovf |= r.overflowed;
+    }
+    sia80::tr_muldiv_n<R>(dst.data(), a.data(), b.data(), c, n);
+    if (dst != ref) {
+      report("tr_muldiv_n", R, 0, 0, (long long) c, 0, 0);
+    }
+    int flag = 0;
+    dst.assign(n, 0);
+    sia80::cf_muldiv_n<R>(dst.data(), a.data(), b.data(), c, n, &flag);
+    if (dst != ref || flag != any_ovf) {
+      report("cf_muldiv_n", R, 0, 0, (long long) c, flag, any_ovf);
+    }
+    bool excepted = false;
+    dst.assign(n, 0);
+    try {
+      sia80::cx_muldiv_n<R>(dst.data(), a.data(), b.data(), c, n);
+    }
+    catch (std::overflow_error&) {
+      excepted = c != 0;
+    }
+    catch (std::domain_error&) {
+      excepted = c == 0;
+    }
+    if (dst != ref || excepted != any_ovf) {
+      report("cx_muldiv_n", R, 0, 0, (long long) c, excepted, any_ovf);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      ref[i] = sia80::sr_muldiv<R>(a[i], b[i], c);
+    }
+    // In place.
+    dst = a;
+    sia80::sr_muldiv_n<R>(dst.data(), dst.data(), b.data(), c, n);
+    if (dst != ref) {
+      report("sr_muldiv_n", R, 0, 0, (long long) c, 0, 0);
+    }
+  }
+}
+
+// Many products per divisor, for the rare corrections of the
+// reciprocal (tested directly, as on x86-64 the arrays don't use it);
+// and the products just out of reach (a * b == |c| * 2^64).
+template <rounding R, class T>
+static void check_arrays_random()
+{
+  constexpr std::size_t n = 512;
+  rng r { 4242 };
+  std::vector<T> a(n), b(n), dst(n), ref(n);
+  for (int k = 0; k < 24; ++k) {
+    T c = T(r.next() >> (r.next() >> 58));
+    c = c == 0 ? T(1) : c;
+    const std::uint64_t uc = sia80::uabs(c);
+    for (std::size_t i = 0; i < n; ++i) {
+      a[i] = T(r.next() >> (r.next() >> 58));
+      // Every other b below |c|: the product is in reach of the
+      // reciprocal, and the quotient mostly fits.
+      b[i] = i % 2 ? T(r.next() >> (r.next() >> 58)) : T(r.next() % uc);
+    }
+    // |2c| * 2^63 (for signed, 2^63 is |T min|).
+    if (uc < (std::uint64_t(1) << 62)) {
+      a[7] = T(uc * 2);
+      b[7] = T(std::uint64_t(1) << 63);
+    }
+    bool any_ovf = false;
+    for (std::size_t i = 0; i < n; ++i) {
+      const sia80::cf_result<T> r = sia80::cf_muldiv<R>(a[i], b[i], c);
+      ref[i] = r.value;
+      any_ovf |= r.overflowed;
+    }
+#if defined(__SIZEOF_INT128__)
+    // The reciprocal, which the arrays use only without divq.
+    const sia80::md_detail::recip64 rc(sia80::uabs(c));
+    for (std::size_t i = 0; i < n; ++i) {
+      const sia80::cf_result<T> e = sia80::cf_muldiv<R>(a[i], b[i], c);
+      const auto r = sia80::md_detail::muldiv_recip<R>(a[i], b[i], c, rc);
+      if (r.value != e.value || r.ovf != e.overflowed) {
+        report("muldiv_recip", R, (long long) a[i], (long long) b[i], (long long) c,
+            (long long) r.value, (long long) e.value);
+      }
+    }
+#endif
+    int flag = 0;
+    sia80::cf_muldiv_n<R>(dst.data(), a.data(), b.data(), c, n, &flag);
+    for (std::size_t i = 0; i < n; ++i) {
+      if (dst[i] != ref[i]) {
+        report("cf_muldiv_n", R, (long long) a[i], (long long) b[i], (long long) c,
+            (long long) dst[i], (long long) ref[i]);
+      }
+    }
+    if (flag != any_ovf) {
+      report("cf_muldiv_n flag", R, 0, 0, (long long) c, flag, any_ovf);
+    }
+    sia80::sr_muldiv_n<R>(dst.data(), a.data(), b.data(), c, n);
+    for (std::size_t i = 0; i < n; ++i) {
+      const T e = sia80::sr_muldiv<R>(a[i], b[i], c);
+      if (dst[i] != e) {
+        report("sr_muldiv_n", R, (long long) a[i], (long long) b[i], (long long) c,
+            (long long) dst[i], (long long) e);
+      }
+    }
+  }
+}
+
+template <rounding R>
+static void check_all()
+{
+  check_small<R, std::int8_t>();
+  check_small<R, std::uint8_t>();
+  check_wide<R, std::int16_t>();
+  check_wide<R, std::int32_t>();
+  check_wide<R, std::uint32_t>();
+  check_wide<R, std::int64_t>();
+  check_wide<R, std::uint64_t>();
+  check_arrays<R, std::int32_t>();
+  check_arrays<R, std::uint32_t>();
+  check_arrays<R, std::int64_t>();
+  check_arrays<R, std::uint64_t>();
+  check_arrays_random<R, std::int64_t>();
+  check_arrays_random<R, std::uint64_t>();
+}
+
+void test_muldiv()
+{
+  check_all<rounding::floor>();
+  check_all<rounding::trunc>();
+  check_all<rounding::ceil>();
+  check_all<rounding::nearest>();
+  check_all<rounding::even>();
+  // The quotient fits even though the product doesn't.
+  ASSERT_ALWAYS(sia80::cx_muldiv(UINT64_MAX, UINT64_MAX - 1, UINT64_MAX) == UINT64_MAX - 1);
+  ASSERT_ALWAYS(sia80::cx_muldiv(INT64_MIN, INT64_MAX, INT64_MAX) == INT64_MIN);
+  ASSERT_ALWAYS(sia80::cx_muldiv(INT64_MIN, INT64_MIN, INT64_MIN) == INT64_MIN);
+  ASSERT_ALWAYS(sia80::cf_muldiv(INT64_MIN, std::int64_t(-1), std::int64_t(1)).overflowed);
+}
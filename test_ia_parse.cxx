@@ -0,0 +1,227 @@
+#include "test_common.hxx"
+#include <safe_int_parse_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// parse<T, Mode> against a digit by digit reference in unsigned
+// __int128: all values of 8 and 16 bit types, the limits of wider
+// ones with neighbours, random strings of any length in several
+// bases, trailing characters and strings without digits.
+
+using sia80::mode;
+using u128 = unsigned __int128;
+
+static_assert(sia80::parse<int>("-123").value == -123);
+static_assert(sia80::parse<std::uint8_t, mode::sr>("300").value == 255);
+static_assert(sia80::parse<std::int8_t, mode::tr>("-129").value == 127);
+static_assert(sia80::parse<std::uint32_t>("dEadBeef", 16).value == 0xDEADBEEFu);
+static_assert(sia80::parse<std::int64_t>("000000000012345678901").value == 12345678901);
+
+static std::string to_text(u128 v, int base, bool upper = false)
+{
+  std::string s;
+  do {
+    const int d = int(v % unsigned(base));
+    s.insert(s.begin(), char(d < 10 ? '0' + d : (upper ? 'A' : 'a') + d - 10));
+    v /= unsigned(base);
+  } while (v != 0);
+  return s;
+}
+
+struct ref_t {
+  u128 mag; // modulo 2^128
+  std::size_t len; // parsed, with '-'
+  bool neg;
+  bool any;
+  bool big;
+};
+
+static ref_t ref_parse(const std::string& s, int base)
+{
+  ref_t r{ 0, 0, false, false, false };
+  std::size_t i = 0;
+  if (!s.empty() && s[0] == '-') {
+    r.neg = true;
+    i = 1;
+  }
+  for (; i < s.size(); ++i) {
+    const char c = s[i];
+    int d = c >= '0' && c <= '9' ? c - '0' :
+        c >= 'a' && c <= 'z' ? c - 'a' + 10 :
+        c >= 'A' && c <= 'Z' ? c - 'A' + 10 : 99;
+    if (d >= base) {
+      break;
+    }
+    r.big |= __builtin_mul_overflow(r.mag, u128(base), &r.mag);
+    r.big |= __builtin_add_overflow(r.mag, u128(d), &r.mag);
+    r.any = true;
+  }
+  r.len = r.any ? i : 0;
+  return r;
+}
+
+static void report(const char *label, const std::string& s, int base,
+    long long got, long long expected)
+{
+  std::cerr << "test_parse: " << label << ": mismatch for: \"" << s
+          << "\" base " << base << "; result=" << got
+          << ", expected " << expected << "\n";
+  throw std::runtime_error("Assertion failed: parse mismatch");
+}
+
+template <class T>
+static void check_one(const std::string& s, int base)
+{
+  using namespace sia80;
+  using UT = ia_make_unsigned_t<T>;
+  const ref_t r = ref_parse(s, base);
+  const u128 tmax = u128(UT(ia_limits<T>::max()));
+  const u128 limit = r.neg ? (ia_is_signed<T>::value ? tmax + 1 : 0) : tmax;
+  const bool fits = !r.big && r.mag <= limit;
+  const T etr = r.any ? T(UT(r.neg ? u128(0) - r.mag : r.mag)) : T(0);
+  const T esr = fits || !r.any ? etr :
+      r.neg ? ia_limits<T>::min() : ia_limits<T>::max();
+  const char *first = s.data();
+  const char *last = first + s.size();
+  const char *eptr = first + r.len;
+  INPUT int ibase = base;
+
+  bool excepted = false;
+  T cxv = 0;
+  try {
+    cxv = parse<T>(first, last, ibase).value;
+  }
+  catch (std::range_error&) {
+    excepted = r.any;
+  }
+  catch (std::invalid_argument&) {
+    excepted = !r.any;
+  }
+  if (excepted == (fits && r.any) || (!excepted && cxv != etr)) {
+    report("cx", s, base, (long long) cxv, (long long) etr);
+  }
+  const parse_result<T> cf = parse<T, mode::cf>(first, last, ibase);
+  if (cf.value != etr || cf.ptr != eptr || cf.overflowed != (r.any && !fits)) {
+    report("cf", s, base, (long long) cf.value, (long long) etr);
+  }
+  const parse_result<T> tr = parse<T, mode::tr>(first, last, ibase);
+  if (tr.value != etr || tr.ptr != eptr) {
+    report("tr", s, base, (long long) tr.value, (long long) etr);
+  }
+  const parse_result<T> sr = parse<T, mode::sr>(std::string_view(s), ibase);
+  if (sr.value != esr || sr.ptr != eptr) {
+    report("sr", s, base, (long long) sr.value, (long long) esr);
+  }
+}
+
+template <class T>
+static void check_all(const std::string& s, int base)
+{
+  check_one<T>(s, base);
+  check_one<T>(s + "x", base);
+  check_one<T>("000" + s, base);
+}
+
+static void check_every_type(const std::string& s, int base)
+{
+  check_all<std::int8_t>(s, base);
+  check_all<std::uint8_t>(s, base);
+  check_all<std::int16_t>(s, base);
+  check_all<std::uint16_t>(s, base);
+  check_all<std::int32_t>(s, base);
+  check_all<std::uint32_t>(s, base);
+  check_all<std::int64_t>(s, base);
+  check_all<std::uint64_t>(s, base);
+  check_all<__int128>(s, base);
+  check_all<unsigned __int128>(s, base);
+}
+
+// The limits of T and their neighbours, as text.
+template <class T>
+static void check_limits()
+{
+  using UT = sia80::ia_make_unsigned_t<T>;
+  const u128 tmax = u128(UT(sia80::ia_limits<T>::max()));
+  const u128 amin = std::is_signed<T>::value ? tmax + 1 : 0;
+  for (int base : { 10, 16, 2, 36 }) {
+    for (u128 d : { u128(0), u128(1), u128(2) }) {
+      check_every_type(to_text(tmax - d, base), base);
+      check_every_type(to_text(tmax + d, base), base);
+      check_every_type("-" + to_text(amin + d, base), base);
+      if (amin >= d) {
+        check_every_type("-" + to_text(amin - d, base), base);
+      }
+    }
+  }
+}
+
+void test_parse()
+{
+  // All 16 bit values and some more, in all types.
+  for (long long v = -70000; v <= 70000; v += (v > -300 && v < 300) ? 1 : 7) {
+    const std::string s = to_text(u128(v < 0 ? -v : v), 10);
+    check_every_type(v < 0 ? "-" + s : s, 10);
+    const std::string h = to_text(u128(v < 0 ? -v : v), 16, (v & 1) != 0);
+    check_every_type(v < 0 ? "-" + h : h, 16);
+  }
+  check_limits<std::int8_t>();
+  check_limits<std::uint8_t>();
+  check_limits<std::int16_t>();
+  check_limits<std::uint16_t>();
+  check_limits<std::int32_t>();
+  check_limits<std::uint32_t>();
+  check_limits<std::int64_t>();
+  check_limits<std::uint64_t>();
+  check_limits<__int128>();
+  check_limits<unsigned __int128>();
+  // The longest decimal strings against the maximal ones, digit by digit.
+  for (const char *m : { "18446744073709551615", "340282366920938463463374607431768211455" }) {
+    std::string s = m;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+      std::string t = s;
+      for (char c : { '0', '9' }) {
+        t[i] = c;
+        check_every_type(t, 10);
+        check_every_type("-" + t, 10);
+      }
+    }
+  }
+  // Random strings: lengths across the 8 character chunks, characters
+  // next to digits in the code table.
+  const char *junk[] = { "", "/", ":", "@", "G", "g", "`", " 1", "-1", "\x80" };
+  rng r { 4242 };
+  for (int i = 0; i < 30000; ++i) {
+    const std::uint64_t x = r.next();
+    const int bases[] = { 10, 10, 16, 16, 2, 8, 36 };
+    const int base = bases[(x >> 20) % 7];
+    const std::size_t len = (x >> 30) % 50;
+    std::string s = (x >> 40) % 3 == 0 ? "-" : "";
+    rng ry { x };
+    for (std::size_t k = 0; k < len; ++k) {
+      const std::uint64_t y = ry.next();
+      const int d = int((y >> 33) % unsigned(base));
+      s += char(d < 10 ? '0' + d : ((y >> 50) & 1 ? 'a' : 'A') + d - 10);
+    }
+    s += junk[(x >> 45) % 10];
+    check_every_type(s, base);
+  }
+  // No digits, bad bases.
+  for (const char *s : { "", "-", "x", "-x", "+1", " 1", "--1" }) {
+    check_every_type(s, 10);
+    check_every_type(s, 16);
+  }
+  bool excepted = false;
+  try {
+    INPUT int ibase = 37;
+    sia80::parse<int>("1", ibase);
+  }
+  catch (std::invalid_argument&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  const sia80::parse_result<int> bad = sia80::parse<int, mode::sr>("1", 1);
+  ASSERT_ALWAYS(bad.value == 0 && !bad.overflowed);
+  // Unsigned: "-0" is 0, without overflow.
+  ASSERT_ALWAYS((!sia80::parse<unsigned, mode::cf>("-0").overflowed));
+}
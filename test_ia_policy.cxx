@@ -0,0 +1,169 @@
+#include <safe_int_arena_80.hxx>
+#include <safe_int_arith_80.hxx>
+#include <safe_int_atomic_80.hxx>
+#include <safe_int_bitpack_80.hxx>
+#include <safe_int_bounded_80.hxx>
+#include <safe_int_div_80.hxx>
+#include <safe_int_fixed_80.hxx>
+#include <safe_int_math_80.hxx>
+#include <safe_int_muldiv_80.hxx>
+#include <safe_int_parse_80.hxx>
+#include <safe_int_range_80.hxx>
+#include <csetjmp>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// The cx_xxx failure policies other than throw, without exceptions:
+// this is built once per policy (test_ia_policy_trap, _handler, _hook;
+// see Makefile), as a policy is for the whole program.
+// handler, hook: each failing form reports its kind and message,
+// and the test longjmps back; trap: each failing form, run in a child
+// process, dies by the trap. The forms that don't fail return as usual.
+
+namespace {
+
+  using sia80::cx_fail;
+
+  int nfailed = 0;
+
+#if SIA80_CX_POLICY != SIA80_CX_TRAP
+  std::jmp_buf back;
+  cx_fail got_kind;
+  const char *got_what;
+
+  [[noreturn]] void on_failure(cx_fail kind, const char *what)
+  {
+    got_kind = kind;
+    got_what = what;
+    std::longjmp(back, 1);
+  }
+#endif
+
+  void want(bool ok, const char *label)
+  {
+    if (!ok) {
+      std::fprintf(stderr, "test_ia_policy: %s\n", label);
+      ++nfailed;
+    }
+  }
+
+  template <typename F>
+  void want_fail(const char *label, cx_fail kind, const char *what, F fn)
+  {
+#if SIA80_CX_POLICY == SIA80_CX_TRAP
+    (void) kind;
+    (void) what;
+    std::fflush(nullptr);
+    const pid_t pid = fork();
+    if (pid == 0) {
+      const rlimit no_core = { 0, 0 };
+      setrlimit(RLIMIT_CORE, &no_core);
+      fn();
+      _exit(0);
+    }
+    int st = 0;
+    waitpid(pid, &st, 0);
+    want(WIFSIGNALED(st) && (WTERMSIG(st) == SIGILL || WTERMSIG(st) == SIGTRAP), label);
+#else
+    if (setjmp(back) == 0) {
+      fn();
+      want(false, label);
+    }
+    else {
+      want(got_kind == kind && std::strcmp(got_what, what) == 0, label);
+    }
+#endif
+  }
+
+  volatile std::int32_t i32_max = INT32_MAX;
+  volatile int zero = 0;
+  volatile int forty = 40;
+  sia80::arena ar;
+
+} // namespace
+
+#if SIA80_CX_POLICY == SIA80_CX_HANDLER
+void sia80::cx_failure(cx_fail kind, const char *what)
+{
+  on_failure(kind, what);
+}
+#endif
+
+int main()
+{
+#if SIA80_CX_POLICY == SIA80_CX_HOOK
+  want(sia80::set_cx_hook(on_failure) == nullptr, "set_cx_hook");
+#endif
+  want(sia80::cx_add(i32_max, -1) == INT32_MAX - 1, "cx_add fits");
+  want(sia80::cx_shl(1, forty - 10) == 1 << 30, "cx_shl fits");
+  want(sia80::parse<int>("123", "123" + 3).value == 123, "parse fits");
+  want_fail("cx_add", cx_fail::overflow_error, "cx_add", [] {
+    sia80::cx_add(i32_max, 1);
+  });
+  want_fail("cx_mul", cx_fail::overflow_error, "cx_mul", [] {
+    sia80::cx_mul(i32_max, 2);
+  });
+  want_fail("cx_div", cx_fail::domain_error, "cx_div divisor 0", [] {
+    sia80::cx_div(1, zero);
+  });
+  want_fail("cx_div min", cx_fail::overflow_error, "cx_div min neg", [] {
+    sia80::cx_div(-i32_max - 1, -1);
+  });
+  want_fail("cx_shl", cx_fail::out_of_range, "cx_shl shift count", [] {
+    sia80::cx_shl(1, forty);
+  });
+  want_fail("cx_shrx", cx_fail::range_error, "cx_shrx: inexact", [] {
+    sia80::cx_shrx(i32_max, 1);
+  });
+  want_fail("cx_conv", cx_fail::range_error, "cx_conv", [] {
+    sia80::cx_conv<std::int8_t>(i32_max);
+  });
+  want_fail("cx_sfit", cx_fail::range_error, "cx_sfit: nbits==0", [] {
+    sia80::cx_sfit(i32_max, 0);
+  });
+  want_fail("cx_pow", cx_fail::overflow_error, "cx_pow overflow", [] {
+    sia80::cx_pow(i32_max, 2);
+  });
+  want_fail("cx_qmul", cx_fail::overflow_error, "cx_qmul", [] {
+    sia80::cx_qmul<16>(i32_max, i32_max);
+  });
+  want_fail("cx_muldiv_n", cx_fail::domain_error, "cx_muldiv_n", [] {
+    const std::int32_t a[1] = { 1 };
+    std::int32_t d[1];
+    sia80::cx_muldiv_n(d, a, a, std::int32_t(zero), 1);
+  });
+  want_fail("cx_fetch_add", cx_fail::overflow_error, "cx_fetch_add overflow", [] {
+    std::atomic<std::int32_t> a { i32_max };
+    sia80::cx_fetch_add(a, 1);
+  });
+  want_fail("parse", cx_fail::range_error, "parse: out of range", [] {
+    sia80::parse<std::int8_t>("300", "300" + 3);
+  });
+  want_fail("bounded", cx_fail::range_error, "bounded: value out of range", [] {
+    sia80::bounded<int, 0, 100> b(i32_max);
+    (void) b;
+  });
+  want_fail("divider", cx_fail::domain_error, "divider divisor 0", [] {
+    sia80::divider<int, sia80::mode::cx> d(zero);
+    (void) d;
+  });
+  want_fail("bitpack", cx_fail::invalid_argument, "bitpack: nbits > 64", [] {
+    const std::int32_t a[1] = { 1 };
+    std::uint64_t d[2];
+    sia80::bitpack_ufit(d, a, 1, unsigned(forty) * 2);
+  });
+  want_fail("arena", cx_fail::bad_array_new_length, "arena: size overflow", [] {
+    ar.alloc_array<std::uint64_t>(SIZE_MAX / 4);
+  });
+  if (nfailed != 0) {
+    return 1;
+  }
+  std::printf("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include "test_common.hxx"
+#include <safe_int_range_80.hxx>
+#include <cstdint>
+#include <iostream>
+
+// cx_prove_xxx against a brute force over all index combinations (in
+// __int128): the proof fails exactly when some value or partial sum
+// doesn't fit T, and a proven index equals the exact expression.
+
+using sia80::index_range;
+using i128 = __int128;
+
+static_assert(sia80::cx_prove_affine(10, 3, 5)(4) == 22);
+static_assert(sia80::cx_prove_2d(4, 5, 8)(3, 4) == 28);
+static_assert(sia80::cx_prove_2d(4, 5, 8).max() == 28);
+
+static void report(const char *label, long long a, long long b,
+    long long got, long long expected)
+{
+  std::cerr << "test_range: " << label << ": mismatch for: a=" << a
+          << "; b=" << b << "; result=" << got
+          << ", expected " << expected << "\n";
+  throw std::runtime_error("Assertion failed: range mismatch");
+}
+
+template <class T>
+static bool in_t(i128 v)
+{
+  return v >= i128(std::numeric_limits<T>::min()) &&
+      v <= i128(std::numeric_limits<T>::max());
+}
+
+// 1D: all bases, strides and lengths of small types.
+template <class T>
+static void check_affine()
+{
+  const long long lo = std::numeric_limits<T>::min();
+  const long long hi = std::numeric_limits<T>::max();
+  for (long long base = lo; base <= hi; base += 3) {
+    for (long long stride = lo; stride <= hi; stride += 5) {
+      for (int n : { 0, 1, 2, 3, 7, 100 }) {
+        bool fits = n == 0 || in_t<T>(n - 1);
+        for (int i = 0; i < n && fits; ++i) {
+          fits = in_t<T>(i128(base) + i128(i) * stride) && in_t<T>(i128(i) * stride);
+        }
+        INPUT T ib = T(base);
+        INPUT T is = T(stride);
+        bool excepted = false;
+        try {
+          auto ix = sia80::cx_prove_affine(T(ib), T(is), n);
+          for (int i = 0; i < n; ++i) {
+            if (ix(i) != base + i * stride) {
+              report("affine value", base, stride, ix(i), base + i * stride);
+            }
+          }
+        }
+        catch (std::overflow_error&) {
+          excepted = true;
+        }
+        catch (std::range_error&) {
+          excepted = true;
+        }
+        if (excepted == fits) {
+          report("affine proof", base, stride, excepted, n);
+        }
+      }
+    }
+  }
+}
+
+// 2D with negative ranges: a stencil with a halo.
+template <class T>
+static void check_2d(long long first0, long long last0, long long s0,
+    long long first1, long long last1, long long s1, long long base)
+{
+  bool fits = true;
+  for (long long i = first0; i <= last0; ++i) {
+    for (long long j = first1; j <= last1; ++j) {
+      const i128 t0 = i128(i) * s0;
+      const i128 t1 = i128(j) * s1;
+      fits = fits && in_t<T>(t0) && in_t<T>(t1) && in_t<T>(base + t0) &&
+          in_t<T>(base + t0 + t1);
+    }
+  }
+  bool excepted = false;
+  try {
+    auto ix = sia80::cx_prove_index(T(base),
+        index_range<T>{ T(first0), T(last0), T(s0) },
+        index_range<T>{ T(first1), T(last1), T(s1) });
+    for (long long i = first0; i <= last0; ++i) {
+      for (long long j = first1; j <= last1; ++j) {
+        const long long e = base + i * s0 + j * s1;
+        if (ix(T(i), T(j)) != e || ix.checked(i, j) != e) {
+          report("2d value", i, j, ix(T(i), T(j)), e);
+        }
+      }
+    }
+    bool out = false;
+    try {
+      ix.checked(last0 + 1, first1);
+    }
+    catch (std::out_of_range&) {
+      out = true;
+    }
+    ASSERT_ALWAYS(out);
+  }
+  catch (std::overflow_error&) {
+    excepted = true;
+  }
+  catch (std::range_error&) {
+    excepted = true;
+  }
+  if (excepted == fits) {
+    report("2d proof", s0, s1, excepted, base);
+  }
+}
+
+void test_range()
+{
+  check_affine<std::int8_t>();
+  check_affine<std::uint8_t>();
+  rng r { 777 };
+  for (int k = 0; k < 20000; ++k) {
+    const std::uint64_t x = r.next();
+    auto pick = [&](int bits) {
+      return (long long) ((r.next() >> 33) % (1u << bits)) - (1ll << (bits - 1));
+    };
+    const long long f0 = pick(4), f1 = pick(4);
+    check_2d<std::int8_t>(f0, f0 + (x >> 60) % 4, pick(6), f1, f1 + (x >> 58) % 4, pick(4), pick(8));
+    check_2d<std::int16_t>(f0, f0 + (x >> 60) % 4, pick(14), f1, f1 + (x >> 58) % 4, pick(12), pick(16));
+  }
+  // Wide types: the extremes only.
+  const std::int64_t big = INT64_MAX / 4;
+  auto ok = sia80::cx_prove_2d<std::int64_t>(4, big, big);
+  ASSERT_ALWAYS(ok.max() == 3 * big + big - 1);
+  bool excepted = false;
+  try {
+    sia80::cx_prove_2d<std::int64_t>(5, big + 1, big + 1);
+  }
+  catch (std::overflow_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  excepted = false;
+  try {
+    sia80::cx_prove_3d<std::int32_t>(2049, 1024, 1024, 1024, 1 << 20);
+  }
+  catch (std::overflow_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  auto g3 = sia80::cx_prove_3d<std::int32_t>(2047, 1024, 1024, 1024, 1 << 20);
+  ASSERT_ALWAYS(g3(2046, 1023, 1023) == INT32_MAX - (1 << 20));
+  // Counts which don't fit T.
+  excepted = false;
+  try {
+    sia80::cx_prove_affine(std::int8_t(0), std::int8_t(1), 200u);
+  }
+  catch (std::range_error&) {
+    excepted = true;
+  }
+  ASSERT_ALWAYS(excepted);
+  // Indices which don't fit T are out of the range, not range_error.
+  auto u = sia80::cx_prove_2d<std::uint16_t>(4, 5, 8);
+  for (long long i : { -1ll, 65536ll + 1 }) {
+    excepted = false;
+    try {
+      u.checked(i, 0);
+    }
+    catch (std::out_of_range&) {
+      excepted = true;
+    }
+    ASSERT_ALWAYS(excepted);
+  }
+  ASSERT_ALWAYS(u.checked(3ll, 4u) == 28);
+}
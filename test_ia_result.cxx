@@ -0,0 +1,147 @@
+#include "test_common.hxx"
+#include <safe_int_result_80.hxx>
+#include <iostream>
+
+// ex_xxx shall fail where cx_xxx throws, with the error kind matching
+// the exception, and give the value of cf_xxx. Also, ex_xxx from
+// a translation unit built with -fno-exceptions.
+
+namespace {
+
+  using sia80::errc;
+
+  // What cx_xxx says, as errc; overflow_error and range_error as ovf
+  // and range, which depend on the op.
+  template <typename F>
+  errc cx_errc(F fn, errc ovf, errc range)
+  {
+    try {
+      fn();
+    }
+    catch (std::domain_error&) {
+      return errc::div_by_zero;
+    }
+    catch (std::out_of_range&) {
+      return errc::bad_shift;
+    }
+    catch (std::overflow_error&) {
+      return ovf;
+    }
+    catch (std::range_error&) {
+      return range;
+    }
+    return errc::ok;
+  }
+
+  template <typename R, typename C>
+  void want(R r, C c, errc e, const char *label, long long a, long long b)
+  {
+    if (r.error != e || r.value != c.value || r.ok() != (e == errc::ok) ||
+        bool(r) != r.ok()) {
+      std::cerr << "test_result: " << label << ": a=" << a << "; b=" << b
+              << "; error=" << sia80::errc_name(r.error) << "/" << sia80::errc_name(e)
+              << "; value=" << (long long) r.value << "/" << (long long) c.value << "\n";
+      throw std::runtime_error("Assertion failed: ex_ mismatch");
+    }
+  }
+
+  template <typename T>
+  errc sign_range(T v)
+  {
+    return v < 0 ? errc::too_small : errc::too_big;
+  }
+
+#define CHECK_EX(op, a, b, ovf, range) \
+  want(sia80::ex_##op(a, b), sia80::cf_##op(a, b), \
+      cx_errc([&] { sia80::cx_##op(a, b); }, ovf, range), #op, a, b)
+
+  template <typename T1, typename T2>
+  void check_pair()
+  {
+    const T1 v1s[] = {
+      T1(0), T1(1), T1(2), T1(3), T1(-1), T1(-2), T1(100),
+      std::numeric_limits<T1>::max(), std::numeric_limits<T1>::min(),
+      T1(std::numeric_limits<T1>::max() / 2 + 1),
+    };
+    const T2 v2s[] = {
+      T2(0), T2(1), T2(2), T2(3), T2(-1), T2(-2), T2(100),
+      std::numeric_limits<T2>::max(), std::numeric_limits<T2>::min(),
+      T2(std::numeric_limits<T2>::max() / 2 + 1),
+    };
+    const int shifts[] = { -1, 0, 1, 7, 30, 31, 32, 63, 64, 100 };
+    for (T1 x1 : v1s) {
+      INPUT T1 a = x1;
+      for (T2 x2 : v2s) {
+        INPUT T2 b = x2;
+        CHECK_EX(add, a, b, errc::overflow, errc::ok);
+        CHECK_EX(sub, a, b, errc::overflow, errc::ok);
+        CHECK_EX(mul, a, b, errc::overflow, errc::ok);
+        CHECK_EX(div, a, b, errc::div_min_neg, errc::ok);
+        CHECK_EX(rem, a, b, errc::div_min_neg, errc::ok);
+      }
+      for (int x2 : shifts) {
+        INPUT int s = x2;
+        CHECK_EX(shl, a, s, errc::overflow, errc::ok);
+        CHECK_EX(shr, a, s, errc::ok, errc::ok);
+        CHECK_EX(shrx, a, s, errc::ok, errc::inexact);
+      }
+      want(sia80::ex_conv<T2>(a), sia80::cf_conv<T2>(a),
+          cx_errc([&] { sia80::cx_conv<T2>(a); }, errc::ok, sign_range(a)), "conv", a, 0);
+    }
+  }
+
+  template <typename T>
+  void check_fits()
+  {
+    using L = std::numeric_limits<T>;
+    const T vs[] = { T(0), T(1), T(-1), T(5), T(-5), T(127), T(-128), T(128),
+        L::max(), L::min() };
+    for (T x : vs) {
+      INPUT T a = x;
+      for (unsigned nbits = 0; nbits <= 65; ++nbits) {
+        want(sia80::ex_ufit(a, nbits), sia80::cf_ufit(a, nbits),
+            cx_errc([&] { sia80::cx_ufit(a, nbits); }, errc::ok, sign_range(a)), "ufit", a, nbits);
+        want(sia80::ex_sfit(a, nbits), sia80::cf_sfit(a, nbits),
+            cx_errc([&] { sia80::cx_sfit(a, nbits); }, errc::ok, sign_range(a)), "sfit", a, nbits);
+      }
+    }
+  }
+
+  template <typename T1>
+  void check_type()
+  {
+    check_pair<T1, std::int8_t>();
+    check_pair<T1, std::uint8_t>();
+    check_pair<T1, std::int16_t>();
+    check_pair<T1, std::uint16_t>();
+    check_pair<T1, std::int32_t>();
+    check_pair<T1, std::uint32_t>();
+    check_pair<T1, std::int64_t>();
+    check_pair<T1, std::uint64_t>();
+    check_fits<T1>();
+  }
+
+  constexpr sia80::result<int> r_min_neg = sia80::ex_div(-2147483647 - 1, -1);
+  static_assert(r_min_neg.error == errc::div_min_neg, "");
+  static_assert(sia80::ex_rem(7, 0).error == errc::div_by_zero, "");
+  static_assert(sia80::ex_shrx(7, 1).error == errc::inexact, "");
+  static_assert(sia80::ex_shrx(7, 32).error == errc::bad_shift, "");
+  static_assert(sia80::ex_conv<std::uint8_t>(-1).error == errc::too_small, "");
+  static_assert(sia80::ex_sfit(0, 0).error == errc::too_big, "");
+  static_assert(sia80::ex_add(2, 3).value_or(0) == 5, "");
+  static_assert(sia80::ex_mul(1 << 20, 1 << 20).value_or(-1) == -1, "");
+
+} // namespace
+
+void test_result()
+{
+  check_type<std::int8_t>();
+  check_type<std::uint8_t>();
+  check_type<std::int16_t>();
+  check_type<std::uint16_t>();
+  check_type<std::int32_t>();
+  check_type<std::uint32_t>();
+  check_type<std::int64_t>();
+  check_type<std::uint64_t>();
+  ASSERT_ALWAYS(test_result_noexc() == 0);
+}
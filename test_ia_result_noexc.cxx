@@ -0,0 +1,30 @@
+#include <safe_int_result_80.hxx>
+#include <cstdint>
+
+// Built with -fno-exceptions (see Makefile): ex_xxx are usable there.
+// Returns the number of the wrong results, as it can't throw.
+
+int test_result_noexc()
+{
+  using sia80::errc;
+  volatile std::int32_t big = 0x7FFFFFFF;
+  volatile std::int64_t wide = -300;
+  volatile int zero = 0, neg1 = -1, cnt = 40;
+  int bad = 0;
+  bad += sia80::ex_add(big, 1).error != errc::overflow;
+  bad += sia80::ex_add(big, -1).value != 0x7FFFFFFE;
+  bad += sia80::ex_sub(-big, 2).error != errc::overflow;
+  bad += sia80::ex_mul(big, 2).error != errc::overflow;
+  bad += sia80::ex_div(big, zero).error != errc::div_by_zero;
+  bad += sia80::ex_div(-big - 1, neg1).error != errc::div_min_neg;
+  bad += sia80::ex_rem(big, neg1).error != errc::ok;
+  bad += sia80::ex_shl(big, cnt).error != errc::bad_shift;
+  bad += sia80::ex_shl(big, 1).error != errc::overflow;
+  bad += sia80::ex_shr(big, neg1).error != errc::bad_shift;
+  bad += sia80::ex_shrx(big, 1).error != errc::inexact;
+  bad += sia80::ex_conv<std::int8_t>(wide).error != errc::too_small;
+  bad += sia80::ex_conv<std::uint16_t>(wide).error != errc::too_small;
+  bad += sia80::ex_ufit(std::int64_t(-wide), 8).error != errc::too_big;
+  bad += sia80::ex_sfit(std::int64_t(wide), 10).value_or(0) != -300;
+  return bad;
+}
@@ -38,8 +38,20 @@ void test_sr_add_signed_int()
   want_ok(imin, int(-1), imin, exc_label);
 }
 
+void test_sr_add_signed_mixed()
+{
+  // Unsigned result type: a negative operand means going below 0.
+  const char *exc_label = "sr_add signed+unsigned";
+  constexpr unsigned umax = std::numeric_limits<unsigned>::max();
+  want_ok(0u, int(-1), 0u, exc_label);
+  want_ok(int(-5), 3u, 0u, exc_label);
+  want_ok(umax, int(1), umax, exc_label);
+  want_ok(umax, int(-1), umax - 1, exc_label);
+}
+
 void test_sr_add_signed()
 {
   test_sr_add_signed_int();
+  test_sr_add_signed_mixed();
   // TODO More cases
 }
@@ -0,0 +1,86 @@
+#include "test_common.hxx"
+#include <safe_int_batch_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// Batch forms shall match the scalar ones bit for bit.
+// Inputs are a mix of edge values and pseudo-random ones,
+// array lengths cover vector bodies, tails and empty arrays.
+
+template <class T>
+static std::vector<T> make_input(std::size_t n, std::uint64_t seed)
+{
+  const T edges[] = {
+    T(0), T(1), T(2), T(-1), T(-2),
+    std::numeric_limits<T>::max(), T(std::numeric_limits<T>::max() - 1),
+    std::numeric_limits<T>::min(), T(std::numeric_limits<T>::min() + 1),
+    T(std::numeric_limits<T>::max() / 2), T(std::numeric_limits<T>::min() / 2),
+  };
+  constexpr std::size_t nedges = sizeof(edges) / sizeof(edges[0]);
+  std::vector<T> v(n);
+  rng r { seed };
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint64_t x = r.next();
+    if ((x >> 60) < 6) {
+      v[i] = edges[(x >> 32) % nedges];
+    }
+    else {
+      // Small values are also interesting for mul.
+      v[i] = T((x >> 59) & 1 ? (x >> 7) : (x >> 7) % 300);
+    }
+  }
+  return v;
+}
+
+template <class T>
+static void check_one(const char *exc_label, std::size_t n)
+{
+  std::vector<T> a = make_input<T>(n, 1 + n);
+  std::vector<T> b = make_input<T>(n, 1000 + n);
+  std::vector<T> r_add(n), r_sub(n), r_mul(n);
+  sia80::sr_add_n(r_add.data(), a.data(), b.data(), n);
+  sia80::sr_sub_n(r_sub.data(), a.data(), b.data(), n);
+  sia80::sr_mul_n(r_mul.data(), a.data(), b.data(), n);
+  for (std::size_t i = 0; i < n; ++i) {
+    INPUT T x = a[i];
+    INPUT T y = b[i];
+    T e_add = sia80::sr_conv<T>(sia80::sr_add(x, y));
+    T e_sub = sia80::sr_conv<T>(sia80::sr_sub(x, y));
+    T e_mul = sia80::sr_conv<T>(sia80::sr_mul(x, y));
+    if (r_add[i] != e_add || r_sub[i] != e_sub || r_mul[i] != e_mul) {
+      std::cerr << "test_sr_batch: " << exc_label
+              << ": mismatch: n=" << n << "; i=" << i
+              << "; a=" << (a[i]+0) << "; b=" << (b[i]+0)
+              << "; add=" << (r_add[i]+0) << "/" << (e_add+0)
+              << "; sub=" << (r_sub[i]+0) << "/" << (e_sub+0)
+              << "; mul=" << (r_mul[i]+0) << "/" << (e_mul+0)
+              << "\n";
+      throw std::runtime_error("Assertion failed: batch mismatch");
+    }
+  }
+  // In-place operation.
+  sia80::sr_add_n(a.data(), a.data(), b.data(), n);
+  ASSERT_ALWAYS(a == r_add);
+}
+
+template <class T>
+static void check_type(const char *exc_label)
+{
+  for (std::size_t n = 0; n <= 260; ++n) {
+    check_one<T>(exc_label, n);
+  }
+  check_one<T>(exc_label, 10007);
+}
+
+void test_sr_batch()
+{
+  check_type<std::int8_t>("sr batch int8_t");
+  check_type<std::uint8_t>("sr batch uint8_t");
+  check_type<std::int16_t>("sr batch int16_t");
+  check_type<std::uint16_t>("sr batch uint16_t");
+  check_type<std::int32_t>("sr batch int32_t");
+  check_type<std::uint32_t>("sr batch uint32_t");
+  check_type<std::int64_t>("sr batch int64_t");
+  check_type<std::uint64_t>("sr batch uint64_t");
+}
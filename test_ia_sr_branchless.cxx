@@ -0,0 +1,77 @@
+#include "test_common.hxx"
+#include <climits>
+#include <cstdint>
+#include <iostream>
+
+// sr_xxx(..., branchless) shall give the same as sr_xxx.
+
+template <class T>
+static const T edge_values[] = {
+  T(0), T(1), T(2), T(-1), T(-2), T(100), T(-100),
+  std::numeric_limits<T>::max(), T(std::numeric_limits<T>::max() - 1),
+  std::numeric_limits<T>::min(), T(std::numeric_limits<T>::min() + 1),
+  T(std::numeric_limits<T>::max() / 2), T(std::numeric_limits<T>::max() / 2 + 1),
+  T(std::numeric_limits<T>::min() / 2), T(std::numeric_limits<T>::min() / 2 - 1),
+};
+
+template <class R>
+static void want_same(R bl, R plain, const char *label,
+    long long arg1, long long arg2)
+{
+  if (bl != plain) {
+    std::cerr << "test_sr_branchless: " << label
+            << ": mismatch for: arg1=" << arg1
+            << "; arg2=" << arg2
+            << "; result=" << (bl+0) << "/" << (plain+0)
+            << "\n";
+    throw std::runtime_error("Assertion failed: branchless mismatch");
+  }
+}
+
+template <class T1, class T2>
+static void check_pair()
+{
+  using sia80::branchless;
+  for (T1 v1 : edge_values<T1>) {
+    INPUT T1 a = v1;
+    for (T2 v2 : edge_values<T2>) {
+      INPUT T2 b = v2;
+      want_same(sia80::sr_add(a, b, branchless), sia80::sr_add(a, b), "sr_add", a, b);
+      want_same(sia80::sr_sub(a, b, branchless), sia80::sr_sub(a, b), "sr_sub", a, b);
+      want_same(sia80::sr_mul(a, b, branchless), sia80::sr_mul(a, b), "sr_mul", a, b);
+    }
+    for (int sh = -2; sh <= 70; ++sh) {
+      INPUT int b = sh;
+      want_same(sia80::sr_shl(a, b, branchless), sia80::sr_shl(a, b), "sr_shl", a, b);
+    }
+    want_same(sia80::sr_conv<T2>(a, branchless), sia80::sr_conv<T2>(a), "sr_conv", a, 0);
+  }
+}
+
+template <class T>
+static void check_with_all()
+{
+  check_pair<T, std::int8_t>();
+  check_pair<T, std::uint8_t>();
+  check_pair<T, std::int16_t>();
+  check_pair<T, std::uint16_t>();
+  check_pair<T, std::int32_t>();
+  check_pair<T, std::uint32_t>();
+  check_pair<T, std::int64_t>();
+  check_pair<T, std::uint64_t>();
+}
+
+void test_sr_branchless()
+{
+  check_with_all<std::int8_t>();
+  check_with_all<std::uint8_t>();
+  check_with_all<std::int16_t>();
+  check_with_all<std::uint16_t>();
+  check_with_all<std::int32_t>();
+  check_with_all<std::uint32_t>();
+  check_with_all<std::int64_t>();
+  check_with_all<std::uint64_t>();
+  static_assert(sia80::sr_add(INT_MAX, 1, sia80::branchless) == INT_MAX);
+  static_assert(sia80::sr_shl(-1, 40, sia80::branchless) == INT_MIN);
+  static_assert(sia80::sr_shl(0, 40, sia80::branchless) == 0);
+}
@@ -0,0 +1,114 @@
+#include "test_common.hxx"
+#include <safe_int_batch_80.hxx>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+// Sums shall behave exactly as chained xx_add() calls:
+// the same result, flag, exception type and message.
+
+template <class T>
+static std::vector<T> make_input(std::size_t n, std::uint64_t seed, unsigned spikes)
+{
+  std::vector<T> v(n);
+  rng r { seed };
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::uint64_t x = r.next();
+    if ((x >> 54) < spikes) {
+      v[i] = ((x >> 40) & 1) ? std::numeric_limits<T>::max() : std::numeric_limits<T>::min();
+    }
+    else {
+      v[i] = T((x >> 33) % 2001) - T(1000);
+    }
+  }
+  return v;
+}
+
+template <class T>
+static void check_one(const char *exc_label, const std::vector<T>& v)
+{
+  using TR = decltype(v[0] + v[0]);
+  // cx
+  std::string e_exc, r_exc;
+  TR e_cx = 0, r_cx = 0;
+  try {
+    for (T x : v) {
+      e_cx = sia80::cx_add(e_cx, x);
+    }
+  }
+  catch(std::exception& exc) {
+    e_exc = std::string(typeid(exc).name()) + ":" + exc.what();
+  }
+  try {
+    r_cx = sia80::cx_sum(v);
+  }
+  catch(std::exception& exc) {
+    r_exc = std::string(typeid(exc).name()) + ":" + exc.what();
+  }
+  // cf
+  int e_flag = 0, r_flag = 0;
+  TR e_cf = 0;
+  for (T x : v) {
+    e_cf = sia80::cf_add(e_cf, x, &e_flag);
+  }
+  TR r_cf = sia80::cf_sum(v, &r_flag);
+  // sr
+  TR e_sr = 0;
+  for (T x : v) {
+    e_sr = sia80::sr_add(e_sr, x);
+  }
+  TR r_sr = sia80::sr_sum(v);
+  if (e_exc != r_exc || (e_exc.empty() && e_cx != r_cx) ||
+      e_cf != r_cf || e_flag != r_flag || e_sr != r_sr)
+  {
+    std::cerr << "test_sum: " << exc_label
+            << ": mismatch: n=" << v.size()
+            << "; cx=" << (r_cx+0) << "/" << (e_cx+0)
+            << "; exc=" << r_exc << "/" << e_exc
+            << "; cf=" << (r_cf+0) << "/" << (e_cf+0)
+            << "; flag=" << r_flag << "/" << e_flag
+            << "; sr=" << (r_sr+0) << "/" << (e_sr+0)
+            << "\n";
+    throw std::runtime_error("Assertion failed: sum mismatch");
+  }
+}
+
+template <class T>
+static void check_type(const char *exc_label)
+{
+  const std::size_t sizes[] = { 0, 1, 7, 1023, 1024, 1025, 5000, 20000 };
+  const unsigned spike_rates[] = { 0, 1, 30 };
+  for (std::size_t n : sizes) {
+    for (unsigned spikes : spike_rates) {
+      check_one<T>(exc_label, make_input<T>(n, n * 31 + spikes, spikes));
+    }
+  }
+  // Intermediate overflow with the final sum in range.
+  constexpr T tmax = std::numeric_limits<T>::max();
+  std::vector<T> v(3000, T(0));
+  v[10] = tmax;
+  v[2000] = tmax;
+  v[2999] = std::numeric_limits<T>::min();
+  check_one<T>(exc_label, v);
+  v[2000] = T(1);
+  v[2001] = T(-1);
+  check_one<T>(exc_label, v);
+}
+
+void test_sum()
+{
+  check_type<std::int8_t>("sum int8_t");
+  check_type<std::uint8_t>("sum uint8_t");
+  check_type<std::int16_t>("sum int16_t");
+  check_type<std::uint16_t>("sum uint16_t");
+  check_type<std::int32_t>("sum int32_t");
+  check_type<std::uint32_t>("sum uint32_t");
+  check_type<std::int64_t>("sum int64_t");
+  check_type<std::uint64_t>("sum uint64_t");
+  // Integral promotion for narrow types can make overflow
+  // possible only on long arrays: 2^31 / 255 elements for uint8_t.
+  std::vector<std::uint8_t> big((std::size_t(1) << 31) / 255 + 1000, 255);
+  check_one<std::uint8_t>("sum uint8_t long", big);
+}
@@ -0,0 +1,184 @@
+// Only this file is built with telemetry: the instrumented cf_xxx
+// and sr_xxx have another signature, so they don't clash with
+// the plain ones of the other files.
+#define SIA80_TELEMETRY 1
+#include "test_common.hxx"
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Events are counted per call site, only when they happen, from all
+// threads, and can be collected while the threads run.
+
+static_assert(sia80::sr_add(INT_MAX, 1) == INT_MAX);
+static_assert(sia80::cf_add(INT_MAX, 1).overflowed);
+
+using sia80::mode;
+using sia80::tm_op;
+
+static std::uint64_t count_at(const sia80::tm_snapshot& snap,
+    tm_op op, mode md, unsigned line)
+{
+  for (const sia80::tm_record& r : snap.records) {
+    if (r.op == op && r.md == md && r.line == line &&
+        std::strcmp(r.file, __FILE__) == 0)
+    {
+      return r.count;
+    }
+  }
+  return 0;
+}
+
+// Count of the events between two snapshots.
+static void want_count(const sia80::tm_snapshot& before,
+    const sia80::tm_snapshot& after,
+    tm_op op, mode md, unsigned line, std::uint64_t expected)
+{
+  std::uint64_t got = count_at(after, op, md, line) - count_at(before, op, md, line);
+  if (got != expected) {
+    std::cerr << "test_telemetry: " << sia80::tm_mode_name(md)
+            << "_" << sia80::tm_op_name(op)
+            << " at line " << line
+            << ": count " << got << ", expected " << expected
+            << "\n";
+    throw std::runtime_error("Assertion failed: telemetry count");
+  }
+}
+
+static void check_sites()
+{
+  using namespace sia80;
+  const tm_snapshot before = tm_collect();
+  INPUT int big = INT_MAX - 1;
+  int acc = 0;
+  int flag = 0;
+  for (int i = 0; i < 5; ++i) {
+    // Most of them overflow with i >= 2.
+    const unsigned l_add = __LINE__; acc += sr_add(big, i);
+    const unsigned l_bl = __LINE__; acc += sr_sub(-big, i, branchless);
+    const unsigned l_mul = __LINE__; acc += cf_mul(big, i, &flag);
+    const unsigned l_pair = __LINE__; acc += cf_add(big, i).value;
+    overflow_sticky ovf;
+    const unsigned l_sticky = __LINE__; acc += ovf.add(ovf.mul(big, 1), i);
+    // Shifts of 0 never saturate, also by a bad count.
+    const unsigned l_shl0 = __LINE__; acc += sr_shl(0, 40 + i);
+    const unsigned l_conv = __LINE__; acc += sr_conv<std::int8_t>(big);
+    // Negative, with a count to mask and without: one event per call.
+    const unsigned l_ufit = __LINE__; acc += cf_ufit(-i, 4).value + cf_ufit(-i, 40).value;
+    const unsigned l_ufitf = __LINE__; acc += cf_ufit(-i, 4, &flag) + cf_ufit(-i, 40, &flag);
+    if (i == 4) {
+      const tm_snapshot after = tm_collect();
+      want_count(before, after, tm_op::add, mode::sr, l_add, 3);
+      want_count(before, after, tm_op::sub, mode::sr, l_bl, 2);
+      want_count(before, after, tm_op::mul, mode::cf, l_mul, 3);
+      want_count(before, after, tm_op::add, mode::cf, l_pair, 3);
+      want_count(before, after, tm_op::add, mode::cf, l_sticky, 3);
+      want_count(before, after, tm_op::mul, mode::cf, l_sticky, 0);
+      want_count(before, after, tm_op::shl, mode::sr, l_shl0, 0);
+      want_count(before, after, tm_op::conv, mode::sr, l_conv, 5);
+      want_count(before, after, tm_op::ufit, mode::cf, l_ufit, 8);
+      want_count(before, after, tm_op::ufit, mode::cf, l_ufitf, 8);
+      // Nothing else from this file.
+      std::uint64_t here = 0;
+      for (const tm_record& r : after.records) {
+        if (std::strcmp(r.file, __FILE__) == 0) {
+          here += r.count;
+        }
+      }
+      for (const tm_record& r : before.records) {
+        if (std::strcmp(r.file, __FILE__) == 0) {
+          here -= r.count;
+        }
+      }
+      ASSERT_ALWAYS(here == 3 + 2 + 3 + 3 + 3 + 5 + 16);
+    }
+  }
+  ASSERT_ALWAYS(flag == 1);
+  (void) acc;
+}
+
+constexpr int nevents = 200000;
+
+// The site is passed explicitly, as a wrapper would do to attribute
+// the events to its caller.
+static long worker(int limit, sia80::tm_site site)
+{
+  long sum = 0;
+  for (int i = 0; i < nevents; ++i) {
+    sum += sia80::sr_add(limit, i + 1, site);
+  }
+  return sum;
+}
+
+static void check_threads()
+{
+  using namespace sia80;
+  constexpr int nthreads = 4;
+  const tm_site site = tm_site::current();
+  const tm_snapshot before = tm_collect();
+  // Two rounds: blocks of the exited threads are reused, and their
+  // counts are kept.
+  for (int round = 1; round <= 2; ++round) {
+    std::vector<std::thread> threads;
+    std::vector<long> sums(nthreads);
+    INPUT int limit = INT_MAX;
+    for (int t = 0; t < nthreads; ++t) {
+      threads.emplace_back([&sums, &limit, site, t] { sums[t] = worker(limit, site); });
+    }
+    // Collecting while the workers count: never decreasing.
+    std::uint64_t last = 0;
+    for (int i = 0; i < 20; ++i) {
+      const tm_snapshot during = tm_collect();
+      std::uint64_t now = count_at(during, tm_op::add, mode::sr, site.line);
+      ASSERT_ALWAYS(now >= last);
+      last = now;
+    }
+    for (std::thread& th : threads) {
+      th.join();
+    }
+    ASSERT_ALWAYS(sums[0] == long(INT_MAX) * nevents);
+    const tm_snapshot after = tm_collect();
+    want_count(before, after, tm_op::add, mode::sr, site.line,
+        std::uint64_t(nevents) * nthreads * round);
+  }
+}
+
+static void check_merge_dump()
+{
+  using namespace sia80;
+  tm_snapshot a, b;
+  a.records.push_back({ tm_op::add, mode::sr, "x.cxx", 10, 5 });
+  a.records.push_back({ tm_op::mul, mode::cf, "x.cxx", 10, 1 });
+  // The same file name at another address.
+  static const char other_x[] = "x.cxx";
+  b.records.push_back({ tm_op::add, mode::sr, other_x, 10, 2 });
+  b.records.push_back({ tm_op::div, mode::sr, "a.cxx", 3, 7 });
+  b.unplaced = 1;
+  a.merge(b);
+  ASSERT_ALWAYS(a.records.size() == 3);
+  ASSERT_ALWAYS(std::strcmp(a.records[0].file, "a.cxx") == 0);
+  ASSERT_ALWAYS(a.records[1].op == tm_op::add && a.records[1].count == 7);
+  ASSERT_ALWAYS(a.total() == 5 + 1 + 2 + 7 + 1);
+  std::FILE *f = std::tmpfile();
+  ASSERT_ALWAYS(f != nullptr);
+  tm_dump(a, f);
+  std::rewind(f);
+  char buf[256] = {};
+  std::size_t len = std::fread(buf, 1, sizeof(buf) - 1, f);
+  std::fclose(f);
+  ASSERT_ALWAYS(len > 0 && std::strcmp(buf,
+      "a.cxx:3: sr_div 7\n"
+      "x.cxx:10: sr_add 7\n"
+      "x.cxx:10: cf_mul 1\n"
+      "(unplaced): 1\n") == 0);
+}
+
+void test_telemetry()
+{
+  check_sites();
+  check_threads();
+  check_merge_dump();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <safe_int_arith_80.hxx>
+#include <cstdint>
+#include <vector>
+
+#if !defined(__SIZEOF_INT128__)
+#error "verify_ia needs __int128 for the reference model"
+#endif
+
+// Exhaustive verification: a job checks items [lo, hi) of its space
+// (an item is usually one value of the first operand, checked with
+// all values of the second one). Jobs are split into chunks and run
+// on all cores by a work-stealing scheduler (verify_ia_main.cxx).
+
+struct verify_job {
+  const char *name;
+  // Number of items and checked cases per item, for the chunk size
+  // and the report.
+  std::uint64_t nitems;
+  std::uint64_t cases_per_item;
+  void (*fn)(std::uint64_t lo, std::uint64_t hi);
+};
+
+// All jobs, in verify_ia_ops.cxx.
+void verify_add_jobs(std::vector<verify_job>& jobs);
+
+// Report a mismatch of mode (cx, cf, ...) and op on the operand types;
+// for cx, got and expected are the exception kinds. Thread-safe; only
+// the first ones are printed, all are counted.
+void verify_fail(const char *mode, const char *op, const char *type1,
+    const char *type2, long long arg1, long long arg2,
+    long long got, long long expected);
@@ -0,0 +1,204 @@
+#include "verify_common.hxx"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Usage: verify_ia [-j nthreads] [filter...]
+// Runs the jobs whose name contains any of the filters (all without
+// filters), e.g. "binary/int8/" or "shift/". Exit code 1 on mismatch,
+// 2 on a bad option or when the filters select no job.
+//
+// Scheduling: each thread has a deque of chunks. A thread takes the
+// newest chunk of its own deque and, while it is bigger than the
+// grain, splits off the upper half back to its deque; so big ranges
+// are split only when there is a thief for them. An idle thread steals
+// the oldest (biggest) chunk of another deque.
+
+namespace {
+
+  struct chunk {
+    const verify_job *job;
+    std::uint64_t lo, hi;
+  };
+
+  struct alignas(64) worker_queue {
+    std::mutex lock;
+    std::deque<chunk> chunks;
+  };
+
+  std::atomic<unsigned long long> fail_count { 0 };
+  std::mutex fail_lock;
+  constexpr unsigned long long max_printed = 20;
+
+  class scheduler {
+  public:
+    explicit scheduler(unsigned nthreads)
+      : queues(nthreads)
+    {}
+
+    void add(const verify_job& job)
+    {
+      // Initial spread: equal ranges over the queues; stealing
+      // balances the rest.
+      const std::uint64_t n = queues.size();
+      for (std::uint64_t q = 0; q < n; ++q) {
+        std::uint64_t lo = job.nitems * q / n;
+        std::uint64_t hi = job.nitems * (q + 1) / n;
+        if (lo < hi) {
+          queues[q].chunks.push_back({ &job, lo, hi });
+        }
+      }
+      remaining += job.nitems;
+    }
+
+    void run()
+    {
+      std::vector<std::thread> threads;
+      for (unsigned t = 1; t < queues.size(); ++t) {
+        threads.emplace_back([this, t] { work(t); });
+      }
+      work(0);
+      for (std::thread& th : threads) {
+        th.join();
+      }
+    }
+
+    unsigned long long steals() const { return nsteals; }
+
+  private:
+    std::vector<worker_queue> queues;
+    std::atomic<std::uint64_t> remaining { 0 };
+    std::atomic<unsigned long long> nsteals { 0 };
+
+    // About 64K cases per chunk at least.
+    static std::uint64_t grain(const verify_job& job)
+    {
+      std::uint64_t g = (std::uint64_t(1) << 16) / job.cases_per_item;
+      return g ? g : 1;
+    }
+
+    bool pop_own(unsigned self, chunk& c)
+    {
+      worker_queue& q = queues[self];
+      std::lock_guard<std::mutex> guard(q.lock);
+      if (q.chunks.empty()) {
+        return false;
+      }
+      c = q.chunks.back();
+      q.chunks.pop_back();
+      return true;
+    }
+
+    bool steal(unsigned self, chunk& c)
+    {
+      const unsigned n = queues.size();
+      for (unsigned i = 1; i < n; ++i) {
+        worker_queue& q = queues[(self + i) % n];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (!q.chunks.empty()) {
+          c = q.chunks.front();
+          q.chunks.pop_front();
+          ++nsteals;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void work(unsigned self)
+    {
+      chunk c;
+      while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!pop_own(self, c) && !steal(self, c)) {
+          std::this_thread::yield();
+          continue;
+        }
+        const std::uint64_t g = grain(*c.job);
+        while (c.hi - c.lo > g) {
+          const std::uint64_t mid = c.lo + (c.hi - c.lo) / 2;
+          {
+            std::lock_guard<std::mutex> guard(queues[self].lock);
+            queues[self].chunks.push_back({ c.job, mid, c.hi });
+          }
+          c.hi = mid;
+        }
+        c.job->fn(c.lo, c.hi);
+        remaining.fetch_sub(c.hi - c.lo, std::memory_order_release);
+      }
+    }
+  };
+
+} // namespace
+
+void verify_fail(const char *mode, const char *op, const char *type1,
+    const char *type2, long long arg1, long long arg2,
+    long long got, long long expected)
+{
+  if (fail_count.fetch_add(1) < max_printed) {
+    std::lock_guard<std::mutex> guard(fail_lock);
+    std::fprintf(stderr, "verify_ia: %s %s %s/%s: mismatch for: arg1=%lld;"
+        " arg2=%lld; result=%lld, expected %lld\n",
+        mode, op, type1, type2, arg1, arg2, got, expected);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  unsigned nthreads = std::thread::hardware_concurrency();
+  std::vector<const char *> filters;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "-j") && i + 1 < argc) {
+      nthreads = unsigned(std::atoi(argv[++i]));
+    }
+    else if (argv[i][0] == '-') {
+      std::fprintf(stderr, "verify_ia: unknown option: %s\n"
+          "Usage: verify_ia [-j nthreads] [filter...]\n", argv[i]);
+      return 2;
+    }
+    else {
+      filters.push_back(argv[i]);
+    }
+  }
+  if (nthreads == 0) {
+    nthreads = 1;
+  }
+  std::vector<verify_job> all, jobs;
+  verify_add_jobs(all);
+  for (const verify_job& job : all) {
+    bool selected = filters.empty();
+    for (const char *f : filters) {
+      selected |= std::strstr(job.name, f) != nullptr;
+    }
+    if (selected) {
+      jobs.push_back(job);
+    }
+  }
+  if (jobs.empty()) {
+    std::fprintf(stderr, "verify_ia: no job matches the filters\n");
+    return 2;
+  }
+  scheduler sched(nthreads);
+  double ncases = 0;
+  for (const verify_job& job : jobs) {
+    sched.add(job);
+    ncases += double(job.nitems) * double(job.cases_per_item);
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  sched.run();
+  auto t1 = std::chrono::steady_clock::now();
+  double secs = std::chrono::duration<double>(t1 - t0).count();
+  std::printf("%zu jobs, %.0f cases, %u threads, %llu steals: %.1f s (%.1f M cases/s)\n",
+      jobs.size(), ncases, nthreads, sched.steals(), secs,
+      ncases / secs / 1e6);
+  if (fail_count > 0) {
+    std::printf("FAILED: %llu mismatches\n", fail_count.load());
+    return 1;
+  }
+  std::printf("All cases verified\n");
+  return 0;
+}
@@ -0,0 +1,450 @@
+#include "verify_common.hxx"
+#include <climits>
+#include <stdexcept>
+#include <string>
+
+// Every op in every mode against a reference model in __int128:
+// the exact result is computed there, and the expected outcome of
+// each mode is derived from it (fits or not, truncated, clamped).
+//
+// Jobs:
+//   binary/T1/T2: add, sub, mul, div, rem for all (a, b) pairs;
+//   shift/T1/TC: shl, shr, shrx for all a, with counts of type TC around
+//     the valid range (-3..34) and TC extremes;
+//   conv/T: all values to each of 8..64 bit types;
+//   fit/T: all values, nbits 0..40: ufit and sfit in all modes.
+// T1, T2, T are int8, uint8, int16, uint16; TC is int8, uint8, int.
+// NB 8 and 16 bit operands are promoted to int, so add, sub and mul
+// don't overflow there, but shl does, and the pairs of different
+// signedness and width check the promotion paths.
+
+namespace {
+
+  using i128 = __int128;
+  using u128 = unsigned __int128;
+  using sia80::ia_limits;
+
+  enum { exc_none, exc_overflow, exc_domain, exc_range, exc_out_of_range };
+
+  template <class T> const char *type_name();
+  template <> const char *type_name<std::int8_t>() { return "int8"; }
+  template <> const char *type_name<std::uint8_t>() { return "uint8"; }
+  template <> const char *type_name<std::int16_t>() { return "int16"; }
+  template <> const char *type_name<std::uint16_t>() { return "uint16"; }
+  template <> const char *type_name<std::int32_t>() { return "int32"; }
+  template <> const char *type_name<std::uint32_t>() { return "uint32"; }
+  template <> const char *type_name<std::int64_t>() { return "int64"; }
+  template <> const char *type_name<std::uint64_t>() { return "uint64"; }
+
+  template <class T>
+  constexpr bool ref_fits(i128 e)
+  {
+    return e >= i128(ia_limits<T>::min()) && e <= i128(ia_limits<T>::max());
+  }
+
+  template <class T>
+  constexpr T ref_wrap(i128 e)
+  {
+    return T(u128(e));
+  }
+
+  template <class T>
+  constexpr T ref_clamp(i128 e)
+  {
+    if (e < i128(ia_limits<T>::min())) {
+      return ia_limits<T>::min();
+    }
+    if (e > i128(ia_limits<T>::max())) {
+      return ia_limits<T>::max();
+    }
+    return T(e);
+  }
+
+  // Expected outcome: the cx_ exception (exc_none if it doesn't throw),
+  // the tr_ value (also of cf_, with the flag set iff exc != exc_none;
+  // and of cx_ without exception) and the sr_ value.
+  template <class TR>
+  struct expect {
+    int exc;
+    TR tr;
+    TR sr;
+  };
+
+  // From the exact value; exc is the exception if it doesn't fit.
+  template <class TR>
+  constexpr expect<TR> from_exact(i128 e, int exc)
+  {
+    return { ref_fits<TR>(e) ? exc_none : exc, ref_wrap<TR>(e), ref_clamp<TR>(e) };
+  }
+
+  template <class F>
+  int cx_outcome(F f, long long& value)
+  {
+    try {
+      value = (long long) f();
+      return exc_none;
+    }
+    catch (std::overflow_error&) {
+      return exc_overflow;
+    }
+    catch (std::domain_error&) {
+      return exc_domain;
+    }
+    catch (std::range_error&) {
+      return exc_range;
+    }
+    catch (std::out_of_range&) {
+      return exc_out_of_range;
+    }
+  }
+
+  // Each mode against the expected outcome. Any of cfp (pair-returning
+  // cf_), srb (branchless sr_) can be nullptr_t to skip.
+  template <class T1, class T2, class TR, class FCX, class FCF, class FCFP,
+      class FTR, class FSR, class FSRB>
+  inline void check_modes(const char *op, long long a1, long long a2,
+      const expect<TR>& e, FCX cx, FCF cf, FCFP cfp, FTR tr, FSR sr, FSRB srb)
+  {
+    const char *t1 = type_name<T1>();
+    const char *t2 = type_name<T2>();
+    long long cxv = 0;
+    int exc = cx_outcome(cx, cxv);
+    if (exc != e.exc) {
+      verify_fail("cx", op, t1, t2, a1, a2, exc, e.exc);
+    }
+    else if (exc == exc_none && cxv != (long long) e.tr) {
+      verify_fail("cx", op, t1, t2, a1, a2, cxv, e.tr);
+    }
+    int flag = 0;
+    TR cfv = cf(&flag);
+    if (cfv != e.tr || flag != (e.exc != exc_none)) {
+      verify_fail("cf", op, t1, t2, a1, a2, cfv, e.tr);
+    }
+    if constexpr(!std::is_same<FCFP, std::nullptr_t>::value) {
+      auto p = cfp();
+      if (p.value != e.tr || p.overflowed != (e.exc != exc_none)) {
+        verify_fail("cf pair", op, t1, t2, a1, a2, p.value, e.tr);
+      }
+    }
+    TR trv = tr();
+    if (trv != e.tr) {
+      verify_fail("tr", op, t1, t2, a1, a2, trv, e.tr);
+    }
+    TR srv = sr();
+    if (srv != e.sr) {
+      verify_fail("sr", op, t1, t2, a1, a2, srv, e.sr);
+    }
+    if constexpr(!std::is_same<FSRB, std::nullptr_t>::value) {
+      TR srbv = srb();
+      if (srbv != e.sr) {
+        verify_fail("sr branchless", op, t1, t2, a1, a2, srbv, e.sr);
+      }
+    }
+  }
+
+  template <class T>
+  constexpr std::uint64_t type_values = std::uint64_t(1) << (sizeof(T) * CHAR_BIT);
+
+  // The index-th value of T, from the minimum.
+  template <class T>
+  constexpr T nth_value(std::uint64_t index)
+  {
+    return T(i128(ia_limits<T>::min()) + i128(index));
+  }
+
+  //-- binary ------------------------------------------------
+
+  template <class T1, class T2>
+  void check_binary(T1 a, T2 b)
+  {
+    using namespace sia80;
+    using TR = decltype(a + b);
+    const i128 ea = a, eb = b;
+    check_modes<T1, T2>("add", a, b, from_exact<TR>(ea + eb, exc_overflow),
+        [&] { return cx_add(a, b); },
+        [&](int *flag) { return cf_add(a, b, flag); },
+        [&] { return cf_add(a, b); },
+        [&] { return tr_add(a, b); },
+        [&] { return sr_add(a, b); },
+        [&] { return sr_add(a, b, branchless); });
+    check_modes<T1, T2>("sub", a, b, from_exact<TR>(ea - eb, exc_overflow),
+        [&] { return cx_sub(a, b); },
+        [&](int *flag) { return cf_sub(a, b, flag); },
+        [&] { return cf_sub(a, b); },
+        [&] { return tr_sub(a, b); },
+        [&] { return sr_sub(a, b); },
+        [&] { return sr_sub(a, b, branchless); });
+    check_modes<T1, T2>("mul", a, b, from_exact<TR>(ea * eb, exc_overflow),
+        [&] { return cx_mul(a, b); },
+        [&](int *flag) { return cf_mul(a, b, flag); },
+        [&] { return cf_mul(a, b); },
+        [&] { return tr_mul(a, b); },
+        [&] { return sr_mul(a, b); },
+        [&] { return sr_mul(a, b, branchless); });
+    // Division by 0: tr and cf give ~0 (quotient) or 0 (remainder),
+    // sr saturates the quotient by the sign of the dividend.
+    expect<TR> ediv, erem;
+    if (eb == 0) {
+      ediv = { exc_domain, TR(~TR(0)), a < 0 ? ia_limits<TR>::min() : ia_limits<TR>::max() };
+      erem = { exc_domain, 0, 0 };
+    }
+    else {
+      // The quotient overflows only as MIN / -1 in TR (not for these
+      // types, but in general); the remainder is reported with it.
+      ediv = from_exact<TR>(ea / eb, exc_overflow);
+      erem = { ediv.exc, ref_wrap<TR>(ea % eb), ref_wrap<TR>(ea % eb) };
+    }
+    check_modes<T1, T2>("div", a, b, ediv,
+        [&] { return cx_div(a, b); },
+        [&](int *flag) { return cf_div(a, b, flag); },
+        [&] { return cf_div(a, b); },
+        [&] { return tr_div(a, b); },
+        [&] { return sr_div(a, b); },
+        nullptr);
+    check_modes<T1, T2>("rem", a, b, erem,
+        [&] { return cx_rem(a, b); },
+        [&](int *flag) { return cf_rem(a, b, flag); },
+        [&] { return cf_rem(a, b); },
+        [&] { return tr_rem(a, b); },
+        [&] { return sr_rem(a, b); },
+        nullptr);
+  }
+
+  template <class T1, class T2>
+  void job_binary(std::uint64_t lo, std::uint64_t hi)
+  {
+    for (std::uint64_t i = lo; i < hi; ++i) {
+      const T1 a = nth_value<T1>(i);
+      for (std::uint64_t j = 0; j < type_values<T2>; ++j) {
+        check_binary(a, nth_value<T2>(j));
+      }
+    }
+  }
+
+  //-- shift -------------------------------------------------
+
+  template <class TC>
+  std::vector<TC> shift_counts()
+  {
+    std::vector<TC> counts;
+    for (int c = -3; c <= 34; ++c) {
+      if (ref_fits<TC>(c)) {
+        counts.push_back(TC(c));
+      }
+    }
+    counts.push_back(ia_limits<TC>::max());
+    if (ia_limits<TC>::min() < 0) {
+      counts.push_back(ia_limits<TC>::min());
+    }
+    return counts;
+  }
+
+  template <class T1, class TC>
+  void check_shift(T1 a, TC cnt)
+  {
+    using namespace sia80;
+    using TR = decltype(a << cnt);
+    const bool bad = cnt < 0 || i128(cnt) >= ia_limits<TR>::digits;
+    const i128 ea = a;
+    expect<TR> eshl, eshr, eshrx;
+    if (bad) {
+      // A bad count gives 0 (shl) or the sign fill (shr); sr_shl
+      // saturates any non-zero value by its sign.
+      const TR fill = a < 0 ? TR(~TR(0)) : TR(0);
+      const TR sat = a < 0 ? ia_limits<TR>::min() : a == 0 ? TR(0) : ia_limits<TR>::max();
+      eshl = { exc_out_of_range, 0, sat };
+      eshr = { exc_out_of_range, fill, fill };
+      eshrx = { exc_out_of_range, 0, 0 };
+    }
+    else {
+      eshl = from_exact<TR>(ea * (i128(1) << int(cnt)), exc_overflow);
+      eshr = from_exact<TR>(ea >> int(cnt), exc_overflow);
+      // shrx: the quotient toward zero; inexact is an error.
+      const i128 d = i128(1) << int(cnt);
+      eshrx = { ea % d != 0 ? exc_range : exc_none, TR(ea / d), TR(ea / d) };
+    }
+    check_modes<T1, TC>("shl", a, cnt, eshl,
+        [&] { return cx_shl(a, cnt); },
+        [&](int *flag) { return cf_shl(a, cnt, flag); },
+        [&] { return cf_shl(a, cnt); },
+        [&] { return tr_shl(a, cnt); },
+        [&] { return sr_shl(a, cnt); },
+        [&] { return sr_shl(a, cnt, branchless); });
+    check_modes<T1, TC>("shr", a, cnt, eshr,
+        [&] { return cx_shr(a, cnt); },
+        [&](int *flag) { return cf_shr(a, cnt, flag); },
+        [&] { return cf_shr(a, cnt); },
+        [&] { return tr_shr(a, cnt); },
+        [&] { return sr_shr(a, cnt); },
+        nullptr);
+    check_modes<T1, TC>("shrx", a, cnt, eshrx,
+        [&] { return cx_shrx(a, cnt); },
+        [&](int *flag) { return cf_shrx(a, cnt, flag); },
+        [&] { return cf_shrx(a, cnt); },
+        [&] { return tr_shrx(a, cnt); },
+        [&] { return sr_shrx(a, cnt); },
+        nullptr);
+  }
+
+  template <class T1, class TC>
+  void job_shift(std::uint64_t lo, std::uint64_t hi)
+  {
+    static const std::vector<TC> counts = shift_counts<TC>();
+    for (std::uint64_t i = lo; i < hi; ++i) {
+      const T1 a = nth_value<T1>(i);
+      for (TC cnt : counts) {
+        check_shift(a, cnt);
+      }
+    }
+  }
+
+  //-- conv --------------------------------------------------
+
+  template <class T1, class T2>
+  void check_conv(T2 a)
+  {
+    using namespace sia80;
+    check_modes<T1, T2>("conv", a, 0, from_exact<T1>(a, exc_range),
+        [&] { return cx_conv<T1>(a); },
+        [&](int *flag) { return cf_conv<T1>(a, flag); },
+        [&] { return cf_conv<T1>(a); },
+        [&] { return tr_conv<T1>(a); },
+        [&] { return sr_conv<T1>(a); },
+        [&] { return sr_conv<T1>(a, branchless); });
+  }
+
+  template <class T2>
+  void job_conv(std::uint64_t lo, std::uint64_t hi)
+  {
+    for (std::uint64_t i = lo; i < hi; ++i) {
+      const T2 a = nth_value<T2>(i);
+      check_conv<std::int8_t>(a);
+      check_conv<std::uint8_t>(a);
+      check_conv<std::int16_t>(a);
+      check_conv<std::uint16_t>(a);
+      check_conv<std::int32_t>(a);
+      check_conv<std::uint32_t>(a);
+      check_conv<std::int64_t>(a);
+      check_conv<std::uint64_t>(a);
+    }
+  }
+
+  //-- fit ---------------------------------------------------
+
+  template <class T>
+  void check_fit(T a, unsigned nbits)
+  {
+    using namespace sia80;
+    const i128 ea = a;
+    // ufit: fits iff 0 <= a < 2^nbits; the value is masked to nbits
+    // unless nbits covers all value bits of T.
+    const bool ufits = ea >= 0 && ea < (i128(1) << nbits);
+    const T masked = nbits >= unsigned(ia_limits<T>::digits) ? a :
+        T(ea & ((i128(1) << nbits) - 1));
+    const expect<T> eufit = { ufits ? exc_none : exc_range, masked, masked };
+    long long cxv = 0;
+    int exc = cx_outcome([&] { return cx_ufit(a, nbits); }, cxv);
+    if (exc != eufit.exc || (exc == exc_none && cxv != ea)) {
+      verify_fail("cx", "ufit", type_name<T>(), "nbits", a, nbits, exc, eufit.exc);
+    }
+    int flag = 0;
+    T cfv = cf_ufit(a, nbits, &flag);
+    auto p = cf_ufit(a, nbits);
+    if (cfv != masked || flag != !ufits || p.value != masked || p.overflowed != !ufits) {
+      verify_fail("cf", "ufit", type_name<T>(), "nbits", a, nbits, cfv, masked);
+    }
+    T trv = tr_ufit(a, nbits);
+    if (trv != masked) {
+      verify_fail("tr", "ufit", type_name<T>(), "nbits", a, nbits, trv, masked);
+    }
+    // sr: 0 below, 2^nbits - 1 above (only for nbits below the digits).
+    const T ubound = ufits ? a : ea < 0 ? T(0) : T((i128(1) << nbits) - 1);
+    T srv = sr_ufit(a, nbits);
+    if (srv != ubound) {
+      verify_fail("sr", "ufit", type_name<T>(), "nbits", a, nbits, srv, ubound);
+    }
+    // sfit: fits iff -2^(nbits-1) <= a < 2^(nbits-1); nothing fits
+    // in 0 bits. The truncated value is the low nbits sign-extended
+    // (0 for 0 bits), converted back to T; sr saturates to the field
+    // range (0 for 0 bits).
+    const i128 half = nbits > 0 ? i128(1) << (nbits - 1) : 0;
+    const bool sfits = nbits > 0 && ea >= -half && ea < half;
+    i128 low = nbits > 0 ? ea & ((half << 1) - 1) : 0;
+    if (low >= half && nbits > 0) {
+      low -= half << 1;
+    }
+    const T sext = sfits ? a : T(low);
+    const T sbound = sfits ? a : nbits == 0 ? T(0) : ea < 0 ? T(-half) : T(half - 1);
+    exc = cx_outcome([&] { return cx_sfit(a, nbits); }, cxv);
+    if (exc != (sfits ? exc_none : exc_range) || (exc == exc_none && cxv != ea)) {
+      verify_fail("cx", "sfit", type_name<T>(), "nbits", a, nbits, exc, !sfits);
+    }
+    flag = 0;
+    cfv = cf_sfit(a, nbits, &flag);
+    p = cf_sfit(a, nbits);
+    if (cfv != sext || flag != !sfits || p.value != sext || p.overflowed != !sfits) {
+      verify_fail("cf", "sfit", type_name<T>(), "nbits", a, nbits, cfv, sext);
+    }
+    trv = tr_sfit(a, nbits);
+    if (trv != sext) {
+      verify_fail("tr", "sfit", type_name<T>(), "nbits", a, nbits, trv, sext);
+    }
+    srv = sr_sfit(a, nbits);
+    if (srv != sbound) {
+      verify_fail("sr", "sfit", type_name<T>(), "nbits", a, nbits, srv, sbound);
+    }
+  }
+
+  template <class T>
+  void job_fit(std::uint64_t lo, std::uint64_t hi)
+  {
+    for (std::uint64_t i = lo; i < hi; ++i) {
+      const T a = nth_value<T>(i);
+      for (unsigned nbits = 0; nbits <= 40; ++nbits) {
+        check_fit(a, nbits);
+      }
+    }
+  }
+
+  //-- registration ------------------------------------------
+
+  template <class T1, class T2>
+  void add_binary(std::vector<verify_job>& jobs)
+  {
+    static const std::string name = std::string("binary/") +
+        type_name<T1>() + "/" + type_name<T2>();
+    jobs.push_back({ name.c_str(), type_values<T1>, type_values<T2>,
+        job_binary<T1, T2> });
+  }
+
+  template <class T1>
+  void add_per_first(std::vector<verify_job>& jobs)
+  {
+    add_binary<T1, std::int8_t>(jobs);
+    add_binary<T1, std::uint8_t>(jobs);
+    add_binary<T1, std::int16_t>(jobs);
+    add_binary<T1, std::uint16_t>(jobs);
+    static const std::string shift8 = std::string("shift/") + type_name<T1>() + "/int8";
+    static const std::string shiftu8 = std::string("shift/") + type_name<T1>() + "/uint8";
+    static const std::string shift32 = std::string("shift/") + type_name<T1>() + "/int32";
+    static const std::string conv = std::string("conv/") + type_name<T1>();
+    static const std::string fit = std::string("fit/") + type_name<T1>();
+    jobs.push_back({ shift8.c_str(), type_values<T1>,
+        shift_counts<std::int8_t>().size(), job_shift<T1, std::int8_t> });
+    jobs.push_back({ shiftu8.c_str(), type_values<T1>,
+        shift_counts<std::uint8_t>().size(), job_shift<T1, std::uint8_t> });
+    jobs.push_back({ shift32.c_str(), type_values<T1>,
+        shift_counts<std::int32_t>().size(), job_shift<T1, std::int32_t> });
+    jobs.push_back({ conv.c_str(), type_values<T1>, 8, job_conv<T1> });
+    jobs.push_back({ fit.c_str(), type_values<T1>, 41, job_fit<T1> });
+  }
+
+} // namespace
+
+void verify_add_jobs(std::vector<verify_job>& jobs)
+{
+  add_per_first<std::int8_t>(jobs);
+  add_per_first<std::uint8_t>(jobs);
+  add_per_first<std::int16_t>(jobs);
+  add_per_first<std::uint16_t>(jobs);
+}